@@ -0,0 +1,188 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file   minmemory.h
+ * @brief  Accounting of memory allocated by the library.
+ */
+
+#pragma once
+#ifndef MINSBASE_MINMEMORY_H_INCLUDED
+#define MINSBASE_MINMEMORY_H_INCLUDED
+
+#include "crossplat.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @defgroup MinBase_MinMemory Memory Accounting
+ * @brief    The module counts memory allocated by the library. Image buffers
+ *           of minimgapi, temporary buffers of minimgapi functions and codec
+ *           buffers of minimgio are allocated through @c MinMemAlloc(), which
+ *           keeps current bytes, peak bytes and allocation counts per
+ *           subsystem, both globally and for the calling thread. An optional
+ *           budget limits the total amount of accounted memory: allocations
+ *           which would exceed it fail, and the library functions report
+ *           @c MR_ENV_ERROR (or @c NO_MEMORY in the old interface) instead of
+ *           running the process out of memory.
+ */
+
+
+/**
+ * @brief   Specifies subsystems which memory is accounted separately.
+ * @ingroup MinBase_MinMemory
+ */
+typedef enum MinMemTag {
+  MMT_IMAGE,          ///< Image buffers allocated by minimgapi.
+  MMT_SCRATCH,        ///< Temporary buffers of minimgapi functions.
+  MMT_CODEC,          ///< Buffers of minimgio codecs.
+
+  MINMEMTAG_COUNT,    ///< Count of subsystem tags.
+  MMT_TOTAL = MINMEMTAG_COUNT ///< All subsystems together (queries only).
+} MinMemTag;
+
+
+/**
+ * @brief   Memory counters of one subsystem.
+ * @ingroup MinBase_MinMemory
+ */
+typedef struct MinMemStats {
+  int64_t current_bytes;  ///< Bytes allocated and not yet freed.
+  int64_t peak_bytes;     ///< Maximum of @c current_bytes since the last reset.
+  int64_t alloc_count;    ///< Successful allocations since the last reset.
+  int64_t failed_count;   ///< Allocations refused by the budget or the system.
+} MinMemStats;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Allocates an accounted memory block.
+ * @param   size      Size of the block in bytes.
+ * @param   alignment Alignment of the block, a power of two (0 means 16).
+ * @param   tag       The subsystem the block is accounted to.
+ * @returns Pointer to the block or @c NULL if the system is out of memory,
+ *          the budget would be exceeded or the arguments are invalid.
+ * @details The block must be released with @c MinMemFree().
+ * @ingroup MinBase_MinMemory
+ */
+MINBASE_API void* MinMemAlloc(
+    size_t    size,
+    size_t    alignment,
+    MinMemTag tag);
+
+/**
+ * @brief   Frees a block allocated by @c MinMemAlloc(). @c NULL is ignored.
+ * @ingroup MinBase_MinMemory
+ */
+MINBASE_API void MinMemFree(
+    void* p_block);
+
+/**
+ * @brief   Returns memory counters of a subsystem.
+ * @param   p_stats     The counters.
+ * @param   tag         The subsystem or @c MMT_TOTAL.
+ * @param   this_thread If nonzero, returns the counters of the calling thread
+ *                      only. The thread counters account allocations and
+ *                      frees made by the thread, so a block freed by another
+ *                      thread stays in them.
+ * @returns @c NO_ERRORS on success or @c BAD_ARGS.
+ * @ingroup MinBase_MinMemory
+ */
+MINBASE_API int MinMemGetStats(
+    MinMemStats* p_stats,
+    MinMemTag    tag,
+    int          this_thread);
+
+/**
+ * @brief   Resets allocation counts and peaks (to the current values) of the
+ *          global counters and the counters of the calling thread.
+ * @ingroup MinBase_MinMemory
+ */
+MINBASE_API void MinMemResetStats(void);
+
+/**
+ * @brief   Sets the limit of total accounted memory in bytes.
+ * @param   budget The limit, zero or negative value removes it.
+ * @returns The previous limit.
+ * @ingroup MinBase_MinMemory
+ */
+MINBASE_API int64_t MinMemSetBudget(
+    int64_t budget);
+
+/**
+ * @brief   Returns the limit of total accounted memory (zero if not set).
+ * @ingroup MinBase_MinMemory
+ */
+MINBASE_API int64_t MinMemGetBudget(void);
+
+/**
+ * @brief   Sets the tag of image buffers allocated by the calling thread.
+ * @details minimgapi uses it to account its temporary images as
+ *          @c MMT_SCRATCH.
+ * @returns The previous tag.
+ * @ingroup MinBase_MinMemory
+ */
+MINBASE_API MinMemTag MinMemSetImageTag(
+    MinMemTag tag);
+
+/**
+ * @brief   Returns the tag of image buffers allocated by the calling thread.
+ * @ingroup MinBase_MinMemory
+ */
+MINBASE_API MinMemTag MinMemGetImageTag(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#ifdef __cplusplus
+/**
+ * @brief   Sets the image tag of the calling thread for the lifetime of the
+ *          object and restores the previous tag on destruction.
+ * @ingroup MinBase_MinMemory
+ */
+class MinMemImageTagScope {
+ public:
+  explicit MinMemImageTagScope(MinMemTag tag)
+      : prev_tag_(MinMemSetImageTag(tag)) {}
+  ~MinMemImageTagScope() { MinMemSetImageTag(prev_tag_); }
+
+ private:
+  MinMemImageTagScope(const MinMemImageTagScope &);
+  void operator =(const MinMemImageTagScope &);
+  MinMemTag prev_tag_;
+};
+#endif // __cplusplus
+
+#endif // #ifndef MINSBASE_MINMEMORY_H_INCLUDED
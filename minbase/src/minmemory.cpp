@@ -0,0 +1,224 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <minbase/minmemory.h>
+#include <minbase/minresult.h>
+
+#include <atomic>
+#include <cstring>
+
+namespace {
+
+// Prepended to every block, right before the returned pointer.
+struct BlockHeader {
+  uint64_t size;
+  uint32_t offset;
+  uint32_t tag;
+};
+
+const size_t kHeaderSpace = 16;
+static_assert(sizeof(BlockHeader) <= kHeaderSpace, "header does not fit");
+
+struct GlobalCounters {
+  std::atomic<int64_t> current[MINMEMTAG_COUNT + 1];
+  std::atomic<int64_t> peak[MINMEMTAG_COUNT + 1];
+  std::atomic<int64_t> allocs[MINMEMTAG_COUNT + 1];
+  std::atomic<int64_t> failed[MINMEMTAG_COUNT + 1];
+  std::atomic<int64_t> budget;
+};
+
+struct ThreadCounters {
+  int64_t current[MINMEMTAG_COUNT + 1];
+  int64_t peak[MINMEMTAG_COUNT + 1];
+  int64_t allocs[MINMEMTAG_COUNT + 1];
+  int64_t failed[MINMEMTAG_COUNT + 1];
+  MinMemTag image_tag;
+};
+
+// Zero-initialized before any dynamic initialization, so allocations made
+// from static constructors of other libraries are accounted correctly.
+GlobalCounters g_counters;
+thread_local ThreadCounters t_counters;
+
+void UpdatePeak(std::atomic<int64_t>& peak, int64_t value) {
+  int64_t prev = peak.load(std::memory_order_relaxed);
+  while (prev < value &&
+         !peak.compare_exchange_weak(prev, value, std::memory_order_relaxed))
+    ;
+}
+
+void CountFailure(int tag) {
+  g_counters.failed[tag].fetch_add(1, std::memory_order_relaxed);
+  g_counters.failed[MMT_TOTAL].fetch_add(1, std::memory_order_relaxed);
+  ++t_counters.failed[tag];
+  ++t_counters.failed[MMT_TOTAL];
+}
+
+void CountAlloc(int tag, int64_t size, int64_t total) {
+  UpdatePeak(g_counters.peak[MMT_TOTAL], total);
+  const int64_t current = g_counters.current[tag].fetch_add(
+      size, std::memory_order_relaxed) + size;
+  UpdatePeak(g_counters.peak[tag], current);
+  g_counters.allocs[tag].fetch_add(1, std::memory_order_relaxed);
+  g_counters.allocs[MMT_TOTAL].fetch_add(1, std::memory_order_relaxed);
+
+  ThreadCounters& t = t_counters;
+  const int idx[2] = {tag, MMT_TOTAL};
+  for (int i = 0; i < 2; ++i) {
+    t.current[idx[i]] += size;
+    if (t.peak[idx[i]] < t.current[idx[i]])
+      t.peak[idx[i]] = t.current[idx[i]];
+    ++t.allocs[idx[i]];
+  }
+}
+
+} // namespace
+
+
+MINBASE_API void* MinMemAlloc(
+    size_t    size,
+    size_t    alignment,
+    MinMemTag tag) {
+  if (tag < 0 || tag >= MINMEMTAG_COUNT)
+    return NULL;
+  if (!alignment)
+    alignment = 16;
+  if (alignment & (alignment - 1))
+    return NULL;
+
+  const size_t offset = alignment > kHeaderSpace ? alignment : kHeaderSpace;
+  if (size > static_cast<size_t>(INT64_MAX) - offset) {
+    CountFailure(tag);
+    return NULL;
+  }
+
+  // Reserve the bytes against the budget first, so concurrent allocations
+  // cannot exceed it together.
+  const int64_t bytes = static_cast<int64_t>(size);
+  const int64_t total = g_counters.current[MMT_TOTAL].fetch_add(
+      bytes, std::memory_order_relaxed) + bytes;
+  const int64_t budget = g_counters.budget.load(std::memory_order_relaxed);
+  uint8_t* p_buf = budget > 0 && total > budget
+      ? NULL
+      : static_cast<uint8_t*>(alignedmalloc(size + offset, offset));
+  if (!p_buf) {
+    g_counters.current[MMT_TOTAL].fetch_sub(bytes, std::memory_order_relaxed);
+    CountFailure(tag);
+    return NULL;
+  }
+
+  uint8_t* p_block = p_buf + offset;
+  BlockHeader& header = reinterpret_cast<BlockHeader*>(p_block)[-1];
+  header.size = size;
+  header.offset = static_cast<uint32_t>(offset);
+  header.tag = static_cast<uint32_t>(tag);
+  CountAlloc(tag, bytes, total);
+  return p_block;
+}
+
+
+MINBASE_API void MinMemFree(
+    void* p_block) {
+  if (!p_block)
+    return;
+  uint8_t* p = static_cast<uint8_t*>(p_block);
+  const BlockHeader header = reinterpret_cast<BlockHeader*>(p)[-1];
+  const int64_t bytes = static_cast<int64_t>(header.size);
+  g_counters.current[header.tag].fetch_sub(bytes, std::memory_order_relaxed);
+  g_counters.current[MMT_TOTAL].fetch_sub(bytes, std::memory_order_relaxed);
+  t_counters.current[header.tag] -= bytes;
+  t_counters.current[MMT_TOTAL] -= bytes;
+  alignedfree(p - header.offset);
+}
+
+
+MINBASE_API int MinMemGetStats(
+    MinMemStats* p_stats,
+    MinMemTag    tag,
+    int          this_thread) {
+  if (!p_stats || tag < 0 || tag > MMT_TOTAL)
+    return BAD_ARGS;
+  if (this_thread) {
+    const ThreadCounters& t = t_counters;
+    p_stats->current_bytes = t.current[tag];
+    p_stats->peak_bytes = t.peak[tag];
+    p_stats->alloc_count = t.allocs[tag];
+    p_stats->failed_count = t.failed[tag];
+  } else {
+    p_stats->current_bytes =
+        g_counters.current[tag].load(std::memory_order_relaxed);
+    p_stats->peak_bytes = g_counters.peak[tag].load(std::memory_order_relaxed);
+    p_stats->alloc_count =
+        g_counters.allocs[tag].load(std::memory_order_relaxed);
+    p_stats->failed_count =
+        g_counters.failed[tag].load(std::memory_order_relaxed);
+  }
+  return NO_ERRORS;
+}
+
+
+MINBASE_API void MinMemResetStats(void) {
+  for (int tag = 0; tag <= MMT_TOTAL; ++tag) {
+    g_counters.peak[tag].store(
+        g_counters.current[tag].load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    g_counters.allocs[tag].store(0, std::memory_order_relaxed);
+    g_counters.failed[tag].store(0, std::memory_order_relaxed);
+    t_counters.peak[tag] = t_counters.current[tag];
+    t_counters.allocs[tag] = 0;
+    t_counters.failed[tag] = 0;
+  }
+}
+
+
+MINBASE_API int64_t MinMemSetBudget(
+    int64_t budget) {
+  return g_counters.budget.exchange(budget > 0 ? budget : 0);
+}
+
+
+MINBASE_API int64_t MinMemGetBudget(void) {
+  return g_counters.budget.load();
+}
+
+
+MINBASE_API MinMemTag MinMemSetImageTag(
+    MinMemTag tag) {
+  const MinMemTag prev = t_counters.image_tag;
+  if (tag >= 0 && tag < MINMEMTAG_COUNT)
+    t_counters.image_tag = tag;
+  return prev;
+}
+
+
+MINBASE_API MinMemTag MinMemGetImageTag(void) {
+  return t_counters.image_tag;
+}
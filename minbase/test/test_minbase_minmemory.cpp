@@ -0,0 +1,129 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <minbase/minmemory.h>
+#include <minbase/minresult.h>
+
+
+static MinMemStats Stats(MinMemTag tag, int this_thread) {
+  MinMemStats stats = {};
+  EXPECT_EQ(NO_ERRORS, MinMemGetStats(&stats, tag, this_thread));
+  return stats;
+}
+
+
+TEST(TestMinbaseMinMemory, Counters) {
+  MinMemResetStats();
+  const MinMemStats before = Stats(MMT_CODEC, 0);
+
+  void* p_a = MinMemAlloc(1000, 64, MMT_CODEC);
+  void* p_b = MinMemAlloc(24, 0, MMT_SCRATCH);
+  ASSERT_NE(nullptr, p_a);
+  ASSERT_NE(nullptr, p_b);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p_a) % 64);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p_b) % 16);
+
+  EXPECT_EQ(before.current_bytes + 1000, Stats(MMT_CODEC, 0).current_bytes);
+  EXPECT_EQ(1000, Stats(MMT_CODEC, 1).current_bytes);
+  EXPECT_EQ(24, Stats(MMT_SCRATCH, 1).current_bytes);
+  EXPECT_EQ(1024, Stats(MMT_TOTAL, 1).current_bytes);
+  EXPECT_EQ(2, Stats(MMT_TOTAL, 1).alloc_count);
+
+  MinMemFree(p_a);
+  MinMemFree(p_b);
+  MinMemFree(nullptr);
+  const MinMemStats after = Stats(MMT_TOTAL, 1);
+  EXPECT_EQ(0, after.current_bytes);
+  EXPECT_EQ(1024, after.peak_bytes);
+
+  MinMemResetStats();
+  EXPECT_EQ(0, Stats(MMT_TOTAL, 1).peak_bytes);
+  EXPECT_EQ(0, Stats(MMT_TOTAL, 1).alloc_count);
+
+  MinMemStats stats = {};
+  EXPECT_EQ(BAD_ARGS, MinMemGetStats(nullptr, MMT_TOTAL, 0));
+  EXPECT_EQ(BAD_ARGS, MinMemGetStats(&stats, static_cast<MinMemTag>(-1), 0));
+  EXPECT_EQ(nullptr, MinMemAlloc(16, 3, MMT_CODEC));
+  EXPECT_EQ(nullptr, MinMemAlloc(16, 16, MMT_TOTAL));
+}
+
+
+TEST(TestMinbaseMinMemory, Threads) {
+  MinMemResetStats();
+  const int64_t global_allocs = Stats(MMT_IMAGE, 0).alloc_count;
+  std::thread worker([] {
+    void* p = MinMemAlloc(4096, 16, MMT_IMAGE);
+    EXPECT_EQ(4096, Stats(MMT_IMAGE, 1).peak_bytes);
+    MinMemFree(p);
+  });
+  worker.join();
+  EXPECT_EQ(0, Stats(MMT_IMAGE, 1).alloc_count);
+  EXPECT_EQ(global_allocs + 1, Stats(MMT_IMAGE, 0).alloc_count);
+  EXPECT_LE(4096, Stats(MMT_IMAGE, 0).peak_bytes);
+}
+
+
+TEST(TestMinbaseMinMemory, Budget) {
+  MinMemResetStats();
+  const int64_t current = Stats(MMT_TOTAL, 0).current_bytes;
+  EXPECT_EQ(0, MinMemSetBudget(current + 1000));
+  void* p_a = MinMemAlloc(600, 16, MMT_CODEC);
+  EXPECT_NE(nullptr, p_a);
+  EXPECT_EQ(nullptr, MinMemAlloc(600, 16, MMT_CODEC));
+  EXPECT_EQ(1, Stats(MMT_CODEC, 1).failed_count);
+  EXPECT_EQ(600, Stats(MMT_TOTAL, 1).current_bytes);
+  MinMemFree(p_a);
+  void* p_b = MinMemAlloc(600, 16, MMT_CODEC);
+  EXPECT_NE(nullptr, p_b);
+  MinMemFree(p_b);
+  EXPECT_EQ(current + 1000, MinMemSetBudget(0));
+  EXPECT_EQ(0, MinMemGetBudget());
+}
+
+
+TEST(TestMinbaseMinMemory, ImageTag) {
+  EXPECT_EQ(MMT_IMAGE, MinMemGetImageTag());
+  {
+    MinMemImageTagScope scope(MMT_SCRATCH);
+    EXPECT_EQ(MMT_SCRATCH, MinMemGetImageTag());
+  }
+  EXPECT_EQ(MMT_IMAGE, MinMemGetImageTag());
+}
+
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,458 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <benchmark/benchmark.h>
+#include <minimgapi/minimgapi.h>
+#include <minimgapi/test/minrandom.hpp>
+#include <tbb/global_control.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+// An image filled with random bytes. Aligned images come from AllocMinImage,
+// unaligned ones point into a buffer so that the first pixel and the stride
+// are both off by one byte.
+class BenchImage {
+public:
+  BenchImage() : image_() {}
+
+  ~BenchImage() {
+    FreeMinImage(&image_);
+  }
+
+  int Create(int width, int height, int channels, MinTyp type, bool aligned) {
+    FreeMinImage(&image_);
+    if (aligned) {
+      PROPAGATE_ERROR(NewMinImagePrototype(&image_, width, height, channels,
+                                           type));
+    } else {
+      PROPAGATE_ERROR(NewMinImagePrototype(&image_, width, height, channels,
+                                           type, 0, AO_EMPTY));
+      image_.stride = GetMinImageBytesPerLine(&image_) + 1;
+      buffer_.assign(static_cast<size_t>(image_.stride) * height + 1, 0);
+      image_.p_zero_line = &buffer_[1];
+    }
+    return ApplyLineFunctor(&image_, RandomBytes());
+  }
+
+  const MinImg *get() const {
+    return &image_;
+  }
+
+  int64_t bytes() const {
+    return static_cast<int64_t>(GetMinImageBytesPerLine(&image_)) *
+           image_.height;
+  }
+
+private:
+  BenchImage(const BenchImage &);
+  BenchImage &operator=(const BenchImage &);
+
+  MinImg               image_;
+  std::vector<uint8_t> buffer_;
+};
+
+
+#define FAIL_ON_ERROR(call) do { if ((call) != 0) { \
+  state.SkipWithError("min call failed: " #call); return; } } while (0)
+
+
+static const char *TypeName(int type) {
+  switch (type) {
+    case TYP_UINT1:  return "uint1";
+    case TYP_UINT8:  return "uint8";
+    case TYP_UINT16: return "uint16";
+    case TYP_REAL32: return "real32";
+    case TYP_REAL64: return "real64";
+    default:         return "other";
+  }
+}
+
+static std::string Label(int type, int channels, bool aligned) {
+  return std::string(TypeName(type)) + " c" + std::to_string(channels) +
+         (aligned ? " aligned" : " unaligned");
+}
+
+
+static const int kSizes[] = {64, 512, 2048, 8192};
+static const int kTypes[] = {TYP_UINT8, TYP_UINT16, TYP_REAL32, TYP_REAL64};
+static const int kChannels[] = {1, 3, 4};
+static const int64_t kMaxImageBytes = int64_t(1) << 28;
+
+static bool FitsMemory(int size, int type, int channels) {
+  static const int kTypeBytes[MINTYP_COUNT] = {1, 1, 2, 4, 8, 1, 2, 4, 8,
+                                               2, 4, 8};
+  return int64_t(size) * size * channels * kTypeBytes[type] <=
+         kMaxImageBytes;
+}
+
+// Args: {size, type, channels, aligned}, square images up to 8K.
+static void SweepArgs(benchmark::internal::Benchmark *b) {
+  b->ArgNames({"size", "type", "ch", "aligned"});
+  for (int size : kSizes)
+    for (int type : kTypes)
+      for (int channels : kChannels)
+        if (FitsMemory(size, type, channels))
+          for (int aligned = 1; aligned >= 0; --aligned)
+            b->Args({size, type, channels, aligned});
+}
+
+struct SweepParams {
+  int    size;
+  MinTyp type;
+  int    channels;
+  bool   aligned;
+
+  explicit SweepParams(benchmark::State &state)
+    : size(static_cast<int>(state.range(0))),
+      type(static_cast<MinTyp>(state.range(1))),
+      channels(static_cast<int>(state.range(2))),
+      aligned(state.range(3) != 0) {
+    state.SetLabel(Label(type, channels, aligned));
+  }
+};
+
+
+static void BM_CopyMinImage(benchmark::State &state) {
+  const SweepParams p(state);
+  BenchImage src, dst;
+  FAIL_ON_ERROR(src.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(dst.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(CopyMinImage(dst.get(), src.get()));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(CopyMinImage(dst.get(), src.get()));
+  state.SetBytesProcessed(int64_t(state.iterations()) * src.bytes());
+}
+BENCHMARK(BM_CopyMinImage)->Apply(SweepArgs);
+
+
+// Copies a bit image fragment, the source starts `bit_offset` bits into a
+// byte so the copy has to shift every byte.
+static void BM_CopyMinImageFragment(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  const bool aligned = state.range(1) != 0;
+  const int bit_offset = static_cast<int>(state.range(2));
+  state.SetLabel(Label(TYP_UINT1, 1, aligned));
+  BenchImage src, dst;
+  FAIL_ON_ERROR(src.Create(size, size, 1, TYP_UINT1, aligned));
+  FAIL_ON_ERROR(dst.Create(size, size, 1, TYP_UINT1, aligned));
+  const int width = size - 8;
+  FAIL_ON_ERROR(CopyMinImageFragment(dst.get(), src.get(), 0, 0,
+                                     bit_offset, 0, width, size));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(CopyMinImageFragment(dst.get(), src.get(), 0, 0,
+                                                  bit_offset, 0, width,
+                                                  size));
+  state.SetBytesProcessed(int64_t(state.iterations()) * width / 8 * size);
+}
+BENCHMARK(BM_CopyMinImageFragment)
+    ->ArgNames({"size", "aligned", "bit_offset"})
+    ->ArgsProduct({{64, 512, 2048, 8192}, {1, 0}, {0, 1, 3, 7}});
+
+
+static void BM_FillMinImage(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  const bool aligned = state.range(1) != 0;
+  const int value_size = static_cast<int>(state.range(2));
+  state.SetLabel(Label(TYP_UINT8, 1, aligned));
+  BenchImage image;
+  FAIL_ON_ERROR(image.Create(size, size, 1, TYP_UINT8, aligned));
+  uint8_t canvas[16];
+  for (int i = 0; i < 16; ++i)
+    canvas[i] = static_cast<uint8_t>(i * 37 + 1);
+  FAIL_ON_ERROR(FillMinImage(image.get(), canvas, value_size));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(FillMinImage(image.get(), canvas, value_size));
+  state.SetBytesProcessed(int64_t(state.iterations()) * image.bytes());
+}
+BENCHMARK(BM_FillMinImage)
+    ->ArgNames({"size", "aligned", "value_size"})
+    ->ArgsProduct({{64, 512, 2048, 8192}, {1, 0}, {1, 2, 3, 4, 8, 12, 16}});
+
+
+static void BM_FlipMinImage(benchmark::State &state,
+                            DirectionOption direction) {
+  const SweepParams p(state);
+  BenchImage src, dst;
+  FAIL_ON_ERROR(src.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(dst.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(FlipMinImage(dst.get(), src.get(), direction));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(FlipMinImage(dst.get(), src.get(), direction));
+  state.SetBytesProcessed(int64_t(state.iterations()) * src.bytes());
+}
+BENCHMARK_CAPTURE(BM_FlipMinImage, vertical, DO_VERTICAL)->Apply(SweepArgs);
+BENCHMARK_CAPTURE(BM_FlipMinImage, horizontal, DO_HORIZONTAL)
+    ->Apply(SweepArgs);
+BENCHMARK_CAPTURE(BM_FlipMinImage, both, DO_BOTH)->Apply(SweepArgs);
+
+
+static void BM_TransposeMinImage(benchmark::State &state) {
+  const SweepParams p(state);
+  BenchImage src, dst;
+  FAIL_ON_ERROR(src.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(dst.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(TransposeMinImage(dst.get(), src.get()));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(TransposeMinImage(dst.get(), src.get()));
+  state.SetBytesProcessed(int64_t(state.iterations()) * src.bytes());
+}
+BENCHMARK(BM_TransposeMinImage)->Apply(SweepArgs);
+
+
+// A solid 2:1 image transposed in place back and forth; square images are
+// swapped across the diagonal, others follow the permutation cycles.
+static void BM_TransposeMinImageInPlace(benchmark::State &state,
+                                        bool square) {
+  const int width = static_cast<int>(state.range(0));
+  const int height = square ? width : width / 2;
+  std::vector<uint8_t> buffer(static_cast<size_t>(width) * height);
+  MinImg image = {}, transposed = {};
+  FAIL_ON_ERROR(WrapAlignedBufferWithMinImage(&image, buffer.data(),
+      width, height, 1, TYP_UINT8, width));
+  FAIL_ON_ERROR(WrapAlignedBufferWithMinImage(&transposed, buffer.data(),
+      height, width, 1, TYP_UINT8, height));
+  const MinImg *p_images[2] = {&image, &transposed};
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(TransposeMinImage(p_images[1 - k], p_images[k]));
+    k = 1 - k;
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * buffer.size());
+}
+BENCHMARK_CAPTURE(BM_TransposeMinImageInPlace, square, true)
+    ->ArgName("size")->Arg(512)->Arg(2048);
+BENCHMARK_CAPTURE(BM_TransposeMinImageInPlace, cycles, false)
+    ->ArgName("size")->Arg(512)->Arg(2048);
+
+
+static void BM_RotateMinImageBy90(benchmark::State &state,
+                                  int num_rotations) {
+  const SweepParams p(state);
+  BenchImage src, dst;
+  FAIL_ON_ERROR(src.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(dst.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(RotateMinImageBy90(dst.get(), src.get(), num_rotations));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(RotateMinImageBy90(dst.get(), src.get(),
+                                                num_rotations));
+  state.SetBytesProcessed(int64_t(state.iterations()) * src.bytes());
+}
+BENCHMARK_CAPTURE(BM_RotateMinImageBy90, 90, 1)->Apply(SweepArgs);
+BENCHMARK_CAPTURE(BM_RotateMinImageBy90, 180, 2)->Apply(SweepArgs);
+BENCHMARK_CAPTURE(BM_RotateMinImageBy90, 270, 3)->Apply(SweepArgs);
+
+
+// Resamples to `scale_x2` / 2 of the size along both axes.
+static void BM_ResampleMinImage(benchmark::State &state, int scale_x2) {
+  const SweepParams p(state);
+  const int dst_size = p.size * scale_x2 / 2;
+  BenchImage src, dst;
+  FAIL_ON_ERROR(src.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(dst.Create(dst_size, dst_size, p.channels, p.type,
+                           p.aligned));
+  FAIL_ON_ERROR(ResampleMinImage(dst.get(), src.get()));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(ResampleMinImage(dst.get(), src.get()));
+  state.SetBytesProcessed(int64_t(state.iterations()) * dst.bytes());
+}
+BENCHMARK_CAPTURE(BM_ResampleMinImage, down2, 1)->Apply(SweepArgs);
+BENCHMARK_CAPTURE(BM_ResampleMinImage, up2, 4)
+    ->Apply([](benchmark::internal::Benchmark *b) {
+  b->ArgNames({"size", "type", "ch", "aligned"});
+  for (int size : kSizes)
+    for (int type : kTypes)
+      for (int channels : kChannels)
+        if (FitsMemory(size * 2, type, channels))
+          for (int aligned = 1; aligned >= 0; --aligned)
+            b->Args({size, type, channels, aligned});
+});
+
+
+// Args: {size, type, channels, aligned} with the planar side being
+// `channels` single-channel images.
+static void PlanarArgs(benchmark::internal::Benchmark *b) {
+  b->ArgNames({"size", "type", "ch", "aligned"});
+  for (int size : kSizes)
+    for (int type : kTypes)
+      for (int channels : {2, 3, 4})
+        if (FitsMemory(size, type, channels))
+          for (int aligned = 1; aligned >= 0; --aligned)
+            b->Args({size, type, channels, aligned});
+}
+
+
+static void BM_InterleaveMinImages(benchmark::State &state) {
+  const SweepParams p(state);
+  BenchImage planes[4], dst;
+  const MinImg *p_planes[4];
+  for (int c = 0; c < p.channels; ++c) {
+    FAIL_ON_ERROR(planes[c].Create(p.size, p.size, 1, p.type, p.aligned));
+    p_planes[c] = planes[c].get();
+  }
+  FAIL_ON_ERROR(dst.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(InterleaveMinImages(dst.get(), p_planes, p.channels));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(InterleaveMinImages(dst.get(), p_planes,
+                                                 p.channels));
+  state.SetBytesProcessed(int64_t(state.iterations()) * dst.bytes());
+}
+BENCHMARK(BM_InterleaveMinImages)->Apply(PlanarArgs);
+
+
+static void BM_DeinterleaveMinImage(benchmark::State &state) {
+  const SweepParams p(state);
+  BenchImage planes[4], src;
+  const MinImg *p_planes[4];
+  for (int c = 0; c < p.channels; ++c) {
+    FAIL_ON_ERROR(planes[c].Create(p.size, p.size, 1, p.type, p.aligned));
+    p_planes[c] = planes[c].get();
+  }
+  FAIL_ON_ERROR(src.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(DeinterleaveMinImage(p_planes, src.get(), p.channels));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(DeinterleaveMinImage(p_planes, src.get(),
+                                                  p.channels));
+  state.SetBytesProcessed(int64_t(state.iterations()) * src.bytes());
+}
+BENCHMARK(BM_DeinterleaveMinImage)->Apply(PlanarArgs);
+
+
+static void BM_HashMinImage(benchmark::State &state) {
+  const SweepParams p(state);
+  BenchImage src;
+  FAIL_ON_ERROR(src.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  uint64_t hash = 0;
+  FAIL_ON_ERROR(HashMinImage(&hash, src.get()));
+  for (auto _ : state) {
+    HashMinImage(&hash, src.get());
+    benchmark::DoNotOptimize(hash);
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * src.bytes());
+}
+BENCHMARK(BM_HashMinImage)->Apply(SweepArgs);
+
+
+// Equal images, so that the whole of both is read.
+static void BM_CompareMinImageContents(benchmark::State &state) {
+  const SweepParams p(state);
+  BenchImage src, dst;
+  FAIL_ON_ERROR(src.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(dst.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(CopyMinImage(dst.get(), src.get()));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(CompareMinImageContents(dst.get(), src.get()));
+  state.SetBytesProcessed(int64_t(state.iterations()) * 2 * src.bytes());
+}
+BENCHMARK(BM_CompareMinImageContents)->Apply(SweepArgs);
+
+
+static void BM_GetMinImagesDifference(benchmark::State &state) {
+  const SweepParams p(state);
+  BenchImage src, dst;
+  FAIL_ON_ERROR(src.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(dst.Create(p.size, p.size, p.channels, p.type, p.aligned));
+  FAIL_ON_ERROR(CopyMinImage(dst.get(), src.get()));
+  MinImgDiffStats stats = {};
+  for (auto _ : state) {
+    GetMinImagesDifference(&stats, dst.get(), src.get());
+    benchmark::DoNotOptimize(stats);
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * 2 * src.bytes());
+}
+BENCHMARK(BM_GetMinImagesDifference)->Apply(SweepArgs);
+
+
+// Copies three channels in reversed order, e.g. BGRA to RGB.
+static void BM_CopyMinImageChannels(benchmark::State &state) {
+  const SweepParams p(state);
+  BenchImage src, dst;
+  FAIL_ON_ERROR(src.Create(p.size, p.size, 4, p.type, p.aligned));
+  FAIL_ON_ERROR(dst.Create(p.size, p.size, 3, p.type, p.aligned));
+  const int dst_channels[3] = {0, 1, 2};
+  const int src_channels[3] = {2, 1, 0};
+  FAIL_ON_ERROR(CopyMinImageChannels(dst.get(), src.get(), dst_channels,
+                                     src_channels, 3));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(CopyMinImageChannels(dst.get(), src.get(),
+                                                  dst_channels, src_channels,
+                                                  3));
+  state.SetBytesProcessed(int64_t(state.iterations()) * dst.bytes());
+}
+BENCHMARK(BM_CopyMinImageChannels)->Apply([](benchmark::internal::Benchmark *b) {
+  b->ArgNames({"size", "type", "ch", "aligned"});
+  for (int size : kSizes)
+    for (int type : kTypes)
+      if (FitsMemory(size, type, 4))
+        for (int aligned = 1; aligned >= 0; --aligned)
+          b->Args({size, type, 4, aligned});
+});
+
+
+// Takes `--threads=N` out of the arguments and caps the TBB workers at N, so
+// the timings of the parallel kernels do not depend on the number of cores.
+// The cap is recorded in the report context as `tbb_threads`.
+static std::unique_ptr<tbb::global_control> PinTbbThreads(
+    int   &argc,
+    char **argv) {
+  static const char kFlag[] = "--threads=";
+  std::unique_ptr<tbb::global_control> control;
+  int kept = 1;
+  for (int k = 1; k < argc; ++k) {
+    if (std::strncmp(argv[k], kFlag, sizeof(kFlag) - 1) != 0) {
+      argv[kept++] = argv[k];
+      continue;
+    }
+    const int threads = std::max(1, std::atoi(argv[k] + sizeof(kFlag) - 1));
+    control.reset(new tbb::global_control(
+        tbb::global_control::max_allowed_parallelism,
+        static_cast<size_t>(threads)));
+    benchmark::AddCustomContext("tbb_threads", std::to_string(threads));
+  }
+  argc = kept;
+  argv[argc] = nullptr;
+  return control;
+}
+
+int main(int argc, char **argv) {
+  const std::unique_ptr<tbb::global_control> control =
+      PinTbbThreads(argc, argv);
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
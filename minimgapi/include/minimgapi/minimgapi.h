@@ -200,8 +200,11 @@ extern "C" {
 #ifdef MINIMGAPI_STOPWATCH_OLD_INTERFACE
 # define MINIMGAPI_DECLARE_STOPWATCH_CTL_OLD_INTERFACE(sw) \
     DECLARE_MINSTOPWATCH_CTL(sw)
+# define MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(sw, p_image) \
+    DECLARE_MINSTOPWATCH_CTL_EX(sw, p_image)
 #else
 # define MINIMGAPI_DECLARE_STOPWATCH_CTL_OLD_INTERFACE(sw)
+# define MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(sw, p_image)
 #endif
 
 
@@ -300,6 +303,29 @@ MINIMGAPI_API int AllocMinImage(
     MinImg *p_image,
     int     alignment IS_BY_DEFAULT(16));
 
+/**
+ * @brief   Allocates an image surrounded by guard margins.
+ * @param   p_image   The image to be allocated.
+ * @param   margin_x  The number of extra columns on the left and on the right.
+ * @param   margin_y  The number of extra lines above and below.
+ * @param   alignment Alignment for image rows and for the first visible pixel
+ *                    of every row, by default 16 bytes.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ *
+ * The function works as @c AllocMinImage(), but reserves @c margin_x pixels
+ * to the left and to the right of every line and @c margin_y lines above and
+ * below the image. The header still describes only the visible region, so the
+ * image can be used and freed as usual, while neighbourhood kernels may read
+ * up to the margins outside of it. Use @c FillMinImageBorders() to define the
+ * margin pixels. Images with less than 8 bits per pixel are not supported.
+ */
+MINIMGAPI_API int AllocMinImageWithBorders(
+    MinImg *p_image,
+    int     margin_x,
+    int     margin_y,
+    int     alignment IS_BY_DEFAULT(16));
+
 /**
  * @brief   Deallocates an image.
  * @param   p_image The image to be deallocated.
@@ -681,6 +707,246 @@ MINIMGAPI_API int SplitMinImageIntoRegions(
     const MinImg   *p_image,
     DirectionOption split_direction);
 
+/**
+ * @brief   Describes a tile passed to a @c #MinImgTileFunc callback.
+ * @ingroup MinImgAPI_API
+ */
+typedef struct MinImgTile {
+  int index;        ///< Tile index in row-major order of tiles.
+  int x0;           ///< The x-coordinate of the tile in the image.
+  int y0;           ///< The y-coordinate of the tile in the image.
+  int width;        ///< The width of the tile (without halo).
+  int height;       ///< The height of the tile (without halo).
+  int halo_left;    ///< Number of halo columns available to the left.
+  int halo_top;     ///< Number of halo lines available above.
+  int halo_right;   ///< Number of halo columns available to the right.
+  int halo_bottom;  ///< Number of halo lines available below.
+} MinImgTile;
+
+/**
+ * @brief   Per-tile callback of @c ForEachMinImageTile().
+ * @details @c p_src_tile is the source region of the tile extended by the
+ *          halo (clipped by the image borders), so the tile itself starts at
+ *          (@c halo_left, @c halo_top) of it. @c p_dst_tile is the region of
+ *          the destination image under the tile (without halo) or an empty
+ *          image if no destination image was given. The callback returns
+ *          @c NO_ERRORS on success or an error code otherwise.
+ * @ingroup MinImgAPI_API
+ */
+typedef int (*MinImgTileFunc)(
+    void             *p_context,
+    const MinImg     *p_dst_tile,
+    const MinImg     *p_src_tile,
+    const MinImgTile *p_tile);
+
+/**
+ * @brief   Computes the number of tiles @c ForEachMinImageTile() will visit.
+ * @param   p_num_tiles The number of tiles.
+ * @param   p_image     The image.
+ * @param   tile_width  The tile width (non-positive means the image width).
+ * @param   tile_height The tile height (non-positive means the image height).
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int GetMinImageTileCount(
+    int          *p_num_tiles,
+    const MinImg *p_image,
+    int           tile_width,
+    int           tile_height);
+
+/**
+ * @brief   Runs a callback for every tile of an image in parallel.
+ * @param   p_dst_image The destination image (may be @c NULL); it must have the
+ *                      same size as the source image.
+ * @param   p_src_image The source image.
+ * @param   tile_width  The tile width (non-positive means the image width).
+ * @param   tile_height The tile height (non-positive means the image height).
+ * @param   halo        Number of neighbouring pixels around each tile that are
+ *                      included into the source tile for neighbourhood
+ *                      kernels.
+ * @param   func        The callback.
+ * @param   p_context   The user data passed to the callback.
+ * @returns @c NO_ERRORS on success or the error code of the failed tile with
+ *          the lowest index otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ *
+ * The image is cut into a grid of tiles numbered in row-major order. Tiles
+ * are distributed over a work-stealing thread pool in contiguous runs of
+ * indices, so every thread walks neighbouring tiles. Every tile is visited
+ * exactly once even if some callbacks fail, which makes the result
+ * independent of scheduling: per-tile outputs can be stored by
+ * @c MinImgTile::index and merged in index order afterwards. Images with less
+ * than 8 bits per pixel require tile widths and halo that keep tiles byte
+ * aligned.
+ */
+MINIMGAPI_API int ForEachMinImageTile(
+    const MinImg  *p_dst_image,
+    const MinImg  *p_src_image,
+    int            tile_width,
+    int            tile_height,
+    int            halo,
+    MinImgTileFunc func,
+    void          *p_context);
+
+/**
+ * @brief   Running state of an incremental image hash.
+ * @details The fields are internal; initialize the state with
+ *          @c InitMinImageHash().
+ * @ingroup MinImgAPI_API
+ */
+typedef struct MinImgHashState {
+  uint64_t seed;        ///< The seed the hash was initialized with.
+  uint64_t sum;         ///< Sum of the hashes of the processed blocks.
+  int64_t  num_pixels;  ///< Number of processed pixels.
+  int      width;       ///< The width of the hashed image.
+  int      height;      ///< The height of the hashed image.
+  int      channels;    ///< The number of channels of the hashed image.
+  MinTyp   scalar_type; ///< The scalar type of the hashed image.
+} MinImgHashState;
+
+/**
+ * @brief   Computes a 64-bit hash of the visible pixels of an image.
+ * @param   p_hash  The hash.
+ * @param   p_image The image.
+ * @param   seed    The seed of the hash.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ *
+ * The hash depends on the size, the number of channels, the scalar type and
+ * the pixel values of the image only: stride padding and the unused bits of
+ * the last byte of @c TYP_UINT1 lines are ignored. Every line is cut into
+ * 64-byte blocks which are hashed independently with keys derived from their
+ * position, and large images are processed by several threads. The hash is
+ * not cryptographic; it is meant for deduplication and cache keys.
+ */
+MINIMGAPI_API int HashMinImage(
+    uint64_t     *p_hash,
+    const MinImg *p_image,
+    uint64_t      seed IS_BY_DEFAULT(0));
+
+/**
+ * @brief   Starts an incremental hash of an image processed by tiles.
+ * @param   p_state The state.
+ * @param   p_image The whole image (a prototype is enough).
+ * @param   seed    The seed of the hash.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int InitMinImageHash(
+    MinImgHashState *p_state,
+    const MinImg    *p_image,
+    uint64_t         seed IS_BY_DEFAULT(0));
+
+/**
+ * @brief   Adds a tile of the image to an incremental hash.
+ * @param   p_state The state.
+ * @param   p_tile  The tile.
+ * @param   x0      The x-coordinate of the tile in the image.
+ * @param   y0      The y-coordinate of the tile in the image.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ *
+ * Tiles may be added in any order. The tile must start at a multiple of 512
+ * bits of the image line, and its width in bits must be a multiple of 512
+ * unless it ends at the right border of the image, so that tiles consist of
+ * whole hash blocks. For byte-sized scalar types every tile width multiple of
+ * 64 pixels satisfies it. The state is not synchronized: parallel workers
+ * should hash into their own states and combine them with
+ * @c MergeMinImageHash().
+ */
+MINIMGAPI_API int UpdateMinImageHash(
+    MinImgHashState *p_state,
+    const MinImg    *p_tile,
+    int              x0,
+    int              y0);
+
+/**
+ * @brief   Adds the tiles hashed into @c p_src_state to @c p_dst_state.
+ * @details Both states must be initialized for the same image and seed.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int MergeMinImageHash(
+    MinImgHashState       *p_dst_state,
+    const MinImgHashState *p_src_state);
+
+/**
+ * @brief   Computes the hash of an image from an incremental state.
+ * @param   p_hash  The hash, equal to the one of @c HashMinImage().
+ * @param   p_state The state.
+ * @returns @c NO_ERRORS on success, @c BAD_ARGS if the tiles added to the
+ *          state do not cover the image exactly, or another error code (see
+ *          @c #MinErr).
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int FinalizeMinImageHash(
+    uint64_t              *p_hash,
+    const MinImgHashState *p_state);
+
+/**
+ * @brief   Checks whether two images have equal pixels.
+ * @param   p_image_a First image.
+ * @param   p_image_b Second image.
+ * @returns Zero if the images have the same prototype and equal pixels, a
+ *          positive value if they do not or negative error code (see
+ *          @c #MinErr).
+ * @ingroup MinImgAPI_API
+ *
+ * Unlike @c CompareMinImages() the function ignores the layout of the images:
+ * stride padding and the unused bits of the last byte of @c TYP_UINT1 lines
+ * do not matter. Pixels are compared bitwise, so @c -0.0 differs from @c 0.0.
+ * Large images are compared by several threads, which all stop as soon as a
+ * difference is found.
+ */
+MINIMGAPI_API int CompareMinImageContents(
+    const MinImg *p_image_a,
+    const MinImg *p_image_b);
+
+/**
+ * @brief   Difference statistics of two images.
+ * @ingroup MinImgAPI_API
+ */
+typedef struct MinImgDiffStats {
+  double  max_abs_diff;     ///< The maximum absolute difference of channels.
+  int64_t num_diff_pixels;  ///< The number of pixels having a channel that
+                            ///  differs by more than the tolerance.
+  double  sse;              ///< The sum of squared differences of channels.
+  double  mse;              ///< The mean squared difference of channels.
+  double  psnr;             ///< Peak signal-to-noise ratio in dB, infinite
+                            ///  for equal images.
+  int     diff_x;           ///< The x-coordinate of the bounding box of the
+                            ///  differing pixels.
+  int     diff_y;           ///< The y-coordinate of the bounding box.
+  int     diff_width;       ///< The width of the bounding box, zero if no
+                            ///  pixels differ.
+  int     diff_height;      ///< The height of the bounding box, zero if no
+                            ///  pixels differ.
+} MinImgDiffStats;
+
+/**
+ * @brief   Computes difference statistics of two images.
+ * @param   p_stats   The statistics.
+ * @param   p_image_a First image.
+ * @param   p_image_b Second image of the same prototype.
+ * @param   tolerance The largest absolute difference of a channel for which
+ *                    the pixel is not counted as differing.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ *
+ * The peak value of PSNR is the maximum of the integer scalar type, 1 for
+ * @c TYP_UINT1 and 1.0 for the real types. Two NaNs are treated as equal,
+ * while a NaN against a number makes @c max_abs_diff, @c sse, @c mse and
+ * @c psnr NaN and counts the pixel as differing. Lines of the signed and
+ * unsigned integer types up to 16 bits are processed by vector kernels and
+ * scanned pixel by pixel only if they contain a difference above the
+ * tolerance; large images are processed by several threads.
+ */
+MINIMGAPI_API int GetMinImagesDifference(
+    MinImgDiffStats *p_stats,
+    const MinImg    *p_image_a,
+    const MinImg    *p_image_b,
+    double           tolerance IS_BY_DEFAULT(0.0));
+
 /**
  * @brief   Returns type (MinTyp value) of an image channel element.
  * @param   p_image The input image.
@@ -1016,6 +1282,31 @@ MINIMGAPI_API int FillMinImage(
     const void   *p_canvas,
     int           value_size IS_BY_DEFAULT(0));
 
+/**
+ * @brief   Fills the margins around an image according to a border condition.
+ * @param   p_image    The image allocated by @c AllocMinImageWithBorders().
+ * @param   margin_x   The number of columns to fill on the left and the right.
+ * @param   margin_y   The number of lines to fill above and below.
+ * @param   border     The border condition: @c BO_REPEAT (replicate),
+ *                     @c BO_SYMMETRIC (reflect), @c BO_CYCLIC (wrap) or
+ *                     @c BO_CONSTANT; @c BO_IGNORE leaves the margins intact.
+ * @param   p_canvas   The pointer to the pixel value for @c BO_CONSTANT.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @remarks Margins must not exceed the allocated ones; this is checked when
+ *          the image owns its memory.
+ * @ingroup MinImgAPI_API
+ *
+ * The function fills the side margins of every visible line and then copies
+ * whole extended lines into the top and bottom margins, so each margin pixel
+ * is written once.
+ */
+MINIMGAPI_API int FillMinImageBorders(
+    const MinImg *p_image,
+    int           margin_x,
+    int           margin_y,
+    BorderOption  border,
+    const void   *p_canvas IS_BY_DEFAULT(NULL));
+
 /**
  * @brief   Copies one image to another.
  * @param   p_dst_image The destination image.
@@ -1099,6 +1390,22 @@ MINIMGAPI_API int FlipMinImage(
  * @ingroup MinImgAPI_API
  *
  * The function transpose the source image: @f[ pDst(i, j) = pSrc(j, i) @f]
+ *
+ * The destination may start at the same address as the source, for whole-byte
+ * pixel types, to transpose the image in place:
+ *  - a square image is transposed in place if both images have the same
+ *    stride; blocks of pixels are swapped across the diagonal, at the speed
+ *    of the regular transposition and without extra memory;
+ *  - an image of any other aspect ratio is transposed in place if both images
+ *    are solid (see @c AssureMinImageIsSolid()), i.e. the destination stride
+ *    is the source height times the pixel size. Pixels are moved along the
+ *    cycles of the transposition permutation, which needs a bitset of one bit
+ *    per pixel instead of a copy of the image, but accesses memory out of
+ *    order and is about an order of magnitude slower than the regular
+ *    transposition.
+ *
+ * In other cases of overlapping images the source is copied to a temporary
+ * image first.
 */
 MINIMGAPI_API int TransposeMinImage(
     const MinImg *p_dst_image,
@@ -1203,6 +1510,269 @@ MINIMGAPI_API int ResampleMinImage(
     double        x_phase IS_BY_DEFAULT(0.5),
     double        y_phase IS_BY_DEFAULT(0.5));
 
+/**
+ * @brief   Multi-plane (YUV 4:2:0) image.
+ * @details Plane 0 is the luma plane of @c width x @c height pixels. Chroma
+ *          planes have (@c width + 1) / 2 x (@c height + 1) / 2 pixels: one
+ *          2-channel plane for @c MPF_NV12 and @c MPF_NV21 or two 1-channel
+ *          planes for @c MPF_I420. Every plane is an ordinary @c MinImg, so
+ *          planes can be set up to wrap external buffers.
+ * @ingroup MinImgAPI_API
+ */
+typedef struct MinPlanarImg {
+  MinPlanarFormat format;      ///< Plane layout (see @c #MinPlanarFormat).
+  int32_t         width;       ///< Luma width in pixels.
+  int32_t         height;      ///< Luma height in pixels.
+  int32_t         num_planes;  ///< Number of used planes.
+  MinImg          planes[3];   ///< The planes.
+} MinPlanarImg;
+
+/**
+ * @brief   Sets up (and optionally allocates) a multi-plane image.
+ * @param   p_image      The image to set up.
+ * @param   width        Luma width.
+ * @param   height       Luma height.
+ * @param   format       Plane layout (see @c #MinPlanarFormat).
+ * @param   element_type Type of plane elements.
+ * @param   allocation   Specifies whether the planes should be allocated.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int NewMinPlanarImagePrototype(
+    MinPlanarImg    *p_image,
+    int              width,
+    int              height,
+    MinPlanarFormat  format,
+    MinTyp           element_type IS_BY_DEFAULT(TYP_UINT8),
+    AllocationOption allocation IS_BY_DEFAULT(AO_PREALLOCATED));
+
+/**
+ * @brief   Deallocates all planes of a multi-plane image.
+ * @param   p_image The image to be deallocated.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int FreeMinPlanarImage(
+    MinPlanarImg *p_image);
+
+/**
+ * @brief   Gets a region of a multi-plane image without copying.
+ * @param   p_dst_image The destination image.
+ * @param   p_src_image The source image.
+ * @param   x0          The x-coordinate of the top-left corner of the region.
+ * @param   y0          The y-coordinate of the top-left corner of the region.
+ * @param   width       The width of the region.
+ * @param   height      The height of the region.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @remarks @c x0 and @c y0 must be even, and so must be @c width and
+ *          @c height unless the region reaches the right or bottom edge,
+ *          so that chroma samples stay shared by the same luma pixels.
+ * @ingroup MinImgAPI_API
+ *
+ * Like @c GetMinImageRegion(), <b>it is strongly forbidden</b> to call
+ * @c FreeMinPlanarImage() for the @c p_dst_image.
+ */
+MINIMGAPI_API int GetMinPlanarImageRegion(
+    MinPlanarImg       *p_dst_image,
+    const MinPlanarImg *p_src_image,
+    int                 x0,
+    int                 y0,
+    int                 width,
+    int                 height);
+
+/**
+ * @brief   Copies all planes of one multi-plane image to another.
+ * @param   p_dst_image The destination image.
+ * @param   p_src_image The source image.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @remarks Both images must be allocated and have the same size and format.
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int CopyMinPlanarImage(
+    const MinPlanarImg *p_dst_image,
+    const MinPlanarImg *p_src_image);
+
+/**
+ * @brief   Flips all planes of a multi-plane image.
+ * @param   p_dst_image The destination image.
+ * @param   p_src_image The source image.
+ * @param   direction   Specifies how to flip the image (see #DirectionOption).
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @remarks Both images must be allocated and have the same size and format.
+ *          The flipped sizes must be even, so that the chroma samples stay
+ *          with their luma pixels.
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int FlipMinPlanarImage(
+    const MinPlanarImg *p_dst_image,
+    const MinPlanarImg *p_src_image,
+    DirectionOption     direction);
+
+/**
+ * @brief   Transposes all planes of a multi-plane image.
+ * @param   p_dst_image The destination image.
+ * @param   p_src_image The source image.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @remarks Both images must be allocated, have the same format and transposed
+ *          sizes.
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int TransposeMinPlanarImage(
+    const MinPlanarImg *p_dst_image,
+    const MinPlanarImg *p_src_image);
+
+/**
+ * @brief   Rotates all planes of a multi-plane image by 90 degrees (clockwise).
+ * @param   p_dst_image   The destination image.
+ * @param   p_src_image   The source image.
+ * @param   num_rotations The multiplication factor.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @remarks Both images must be allocated, have the same format and sizes
+ *          matching the rotation. The source sizes which the rotation mirrors
+ *          (the height for one turn, the width for three, both for two) must
+ *          be even, so that the chroma samples stay with their luma pixels.
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int RotateMinPlanarImageBy90(
+    const MinPlanarImg *p_dst_image,
+    const MinPlanarImg *p_src_image,
+    int                 num_rotations);
+
+/**
+ * @brief   Lazy description of a geometrically transformed image.
+ * @details The struct records a chain of crops, flips, transposes, rotations
+ *          and channel selections applied to a source image without touching
+ *          the pixel data. View pixel (x, y) refers to the source pixel
+ *          (x0 + x * dx_x + y * dy_x, y0 + x * dx_y + y * dy_y), channels
+ *          [channel_begin, channel_begin + channels). The chain is materialized
+ *          by @c CopyMinImageView() in a single pass.
+ * @remarks The view does not own the source image memory, so the source image
+ *          must outlive it.
+ * @ingroup MinImgAPI_API
+ */
+typedef struct MinImgView {
+  MinImg  image;          ///< The source image header (never freed by view).
+  int32_t width;          ///< View width in pixels.
+  int32_t height;         ///< View height in pixels.
+  int32_t channels;       ///< Number of selected channels.
+  int32_t channel_begin;  ///< First selected source channel.
+  int32_t x0;             ///< Source x-coordinate of the view pixel (0, 0).
+  int32_t y0;             ///< Source y-coordinate of the view pixel (0, 0).
+  int32_t dx_x;           ///< Source x step per view column.
+  int32_t dx_y;           ///< Source y step per view column.
+  int32_t dy_x;           ///< Source x step per view row.
+  int32_t dy_y;           ///< Source y step per view row.
+} MinImgView;
+
+/**
+ * @brief   Initializes an identity view of an image.
+ * @param   p_view  The view to initialize.
+ * @param   p_image The source image.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int InitMinImageView(
+    MinImgView   *p_view,
+    const MinImg *p_image);
+
+/**
+ * @brief   Restricts a view to a rectangular region (in view coordinates).
+ * @param   p_view The view to modify.
+ * @param   x0     The x-coordinate of the top-left corner of the region.
+ * @param   y0     The y-coordinate of the top-left corner of the region.
+ * @param   width  The width of the region.
+ * @param   height The height of the region.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int CropMinImageView(
+    MinImgView *p_view,
+    int         x0,
+    int         y0,
+    int         width,
+    int         height);
+
+/**
+ * @brief   Flips a view around vertical or horizontal axis (or both).
+ * @param   p_view    The view to modify.
+ * @param   direction Specifies how to flip the view (see #DirectionOption).
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ *
+ * Semantics of @c direction are the same as in @c FlipMinImage().
+ */
+MINIMGAPI_API int FlipMinImageView(
+    MinImgView     *p_view,
+    DirectionOption direction);
+
+/**
+ * @brief   Transposes a view.
+ * @param   p_view The view to modify.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int TransposeMinImageView(
+    MinImgView *p_view);
+
+/**
+ * @brief   Rotates a view by 90 degrees (clockwise).
+ * @param   p_view        The view to modify.
+ * @param   num_rotations The multiplication factor.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ *
+ * Semantics of @c num_rotations are the same as in @c RotateMinImageBy90().
+ */
+MINIMGAPI_API int RotateMinImageViewBy90(
+    MinImgView *p_view,
+    int         num_rotations);
+
+/**
+ * @brief   Restricts a view to a contiguous range of channels.
+ * @param   p_view        The view to modify.
+ * @param   channel_begin The first channel (relative to the current view).
+ * @param   channels      The number of channels.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int SelectMinImageViewChannels(
+    MinImgView *p_view,
+    int         channel_begin,
+    int         channels);
+
+/**
+ * @brief   Makes an image header matching the view.
+ * @param   p_dst_image The destination image.
+ * @param   p_view      The source view.
+ * @param   allocation  Specifies whether the destination image should be
+ *                      allocated.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @ingroup MinImgAPI_API
+ */
+MINIMGAPI_API int CloneMinImageViewPrototype(
+    MinImg           *p_dst_image,
+    const MinImgView *p_view,
+    AllocationOption  allocation IS_BY_DEFAULT(AO_PREALLOCATED));
+
+/**
+ * @brief   Materializes a view into an image.
+ * @param   p_dst_image The destination image.
+ * @param   p_view      The source view.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see @c #MinErr).
+ * @remarks The destination image must be already allocated and have the same
+ *          size, format and number of channels as the view.
+ * @ingroup MinImgAPI_API
+ *
+ * The function gathers all pixels of the view into the destination image in
+ * a single pass over the memory, so no intermediate images are created for
+ * a chain of transforms. Views of images with less than 8 bits per pixel are
+ * supported only when they keep the pixel order of lines (no horizontal flips,
+ * transposes or channel selections).
+ */
+MINIMGAPI_API int CopyMinImageView(
+    const MinImg     *p_dst_image,
+    const MinImgView *p_view);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
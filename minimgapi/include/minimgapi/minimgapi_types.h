@@ -90,6 +90,19 @@ typedef enum DirectionOption {
 } DirectionOption;
 
 
+/**
+ * @brief   Specifies layouts of multi-plane images.
+ * @details The enum specifies the plane layout of a @c MinPlanarImg. All
+ *          layouts have a full resolution luma (Y) plane and chroma planes
+ *          subsampled by two in both directions (4:2:0).
+ */
+typedef enum MinPlanarFormat {
+  MPF_NV12,  ///< Y plane and interleaved 2-channel UV plane.
+  MPF_NV21,  ///< Y plane and interleaved 2-channel VU plane.
+  MPF_I420   ///< Y, U and V planes.
+} MinPlanarFormat;
+
+
 /**
 * @brief   Specifies the part of Hough space to calculate
 * @details The enum specifies the part of Hough space to calculate. Each
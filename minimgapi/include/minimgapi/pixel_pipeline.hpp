@@ -0,0 +1,519 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/**
+ * @file   pixel_pipeline.hpp
+ * @brief  Fused per-pixel expressions over MinImg.
+ *
+ * Expressions are built from source images, constants, type casts, unary and
+ * binary operations (see @c #UnOp and @c #BiOp) and channel swizzles. Nothing
+ * is computed until @c minimg::Evaluate() is called, which walks the
+ * destination image once, line by line (lines are processed in parallel), so
+ * a chain of operations costs a single read of every source and a single
+ * write of the destination.
+ *
+ * @code
+ * // dst(uint8) = clamp(src(uint16) * 0.25 - 3, 0, 255), BGR -> RGB
+ * const int bgr_to_rgb[] = { 2, 1, 0 };
+ * MR_PROPAGATE_ERROR(minimg::Evaluate(dst_image,
+ *     minimg::SaturateCast<uint8_t>(minimg::Swizzle(
+ *       minimg::Apply<BIOP_DIF>(
+ *         minimg::Apply<BIOP_MUL>(minimg::Cast<float>(
+ *           minimg::Image<uint16_t>(src_image)), minimg::Constant(0.25f)),
+ *         minimg::Constant(3.f)),
+ *       bgr_to_rgb, 3))));
+ * @endcode
+ */
+
+#pragma once
+#ifndef MINIMGAPI_PIXEL_PIPELINE_HPP_INCLUDED
+#define MINIMGAPI_PIXEL_PIPELINE_HPP_INCLUDED
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include <minbase/crossplat.h>
+#include <minbase/minresult.h>
+#include <minutils/mathoper.h>
+#include <minimgapi/minimgapi.h>
+#include <minimgapi/minimgapi-helpers.hpp>
+
+namespace minimg {
+
+/**
+ * @brief   Calls @c p_func on disjoint ranges of lines [begin, end) covering
+ *          [0, height), possibly in parallel.
+ * @returns @c MR_SUCCESS if every call succeeded, or the first error observed.
+ */
+MINIMGAPI_API MinResult ParallelForLines(
+    int          height,
+    MinResult  (*p_func)(void *p_context, int begin, int end),
+    void        *p_context,
+    int          grain_size = 16);
+
+namespace pipeline {
+
+/// Number of channels of an expression that broadcasts over any channel count.
+static const int ANY_CHANNELS = -1;
+
+/// Maximum number of channels a swizzle can produce.
+static const int MAX_SWIZZLE_CHANNELS = 16;
+
+template<UnOp op> struct UnOpApplier;
+
+template<> struct UnOpApplier<UNOP_NEG> {
+  template<typename T> static MUSTINLINE T Apply(T a) { return -a; }
+};
+template<> struct UnOpApplier<UNOP_ABS> {
+  template<typename T> static MUSTINLINE T Apply(T a) { return a < 0 ? -a : a; }
+};
+template<> struct UnOpApplier<UNOP_SQRT> {
+  template<typename T> static MUSTINLINE T Apply(T a) {
+    return static_cast<T>(std::sqrt(a));
+  }
+};
+template<> struct UnOpApplier<UNOP_RCPR> {
+  template<typename T> static MUSTINLINE T Apply(T a) {
+    return static_cast<T>(1) / a;
+  }
+};
+template<> struct UnOpApplier<UNOP_INV> {
+  template<typename T> static MUSTINLINE T Apply(T a) {
+    return static_cast<T>(~a);
+  }
+};
+template<> struct UnOpApplier<UNOP_NOT> {
+  template<typename T> static MUSTINLINE T Apply(T a) {
+    return static_cast<T>(~a);
+  }
+};
+template<> struct UnOpApplier<UNOP_LOG> {
+  template<typename T> static MUSTINLINE T Apply(T a) {
+    return static_cast<T>(std::log(a));
+  }
+};
+template<> struct UnOpApplier<UNOP_EXP> {
+  template<typename T> static MUSTINLINE T Apply(T a) {
+    return static_cast<T>(std::exp(a));
+  }
+};
+
+template<BiOp op> struct BiOpApplier;
+
+template<> struct BiOpApplier<BIOP_MIN> {
+  template<typename T> static MUSTINLINE T Apply(T a, T b) {
+    return b < a ? b : a;
+  }
+};
+template<> struct BiOpApplier<BIOP_MAX> {
+  template<typename T> static MUSTINLINE T Apply(T a, T b) {
+    return a < b ? b : a;
+  }
+};
+template<> struct BiOpApplier<BIOP_ADD> {
+  template<typename T> static MUSTINLINE T Apply(T a, T b) {
+    return static_cast<T>(a + b);
+  }
+};
+template<> struct BiOpApplier<BIOP_DIF> {
+  template<typename T> static MUSTINLINE T Apply(T a, T b) {
+    return static_cast<T>(a - b);
+  }
+};
+template<> struct BiOpApplier<BIOP_ADF> {
+  template<typename T> static MUSTINLINE T Apply(T a, T b) {
+    return a < b ? static_cast<T>(b - a) : static_cast<T>(a - b);
+  }
+};
+template<> struct BiOpApplier<BIOP_MUL> {
+  template<typename T> static MUSTINLINE T Apply(T a, T b) {
+    return static_cast<T>(a * b);
+  }
+};
+template<> struct BiOpApplier<BIOP_AVE> {
+  template<typename T> static MUSTINLINE T Apply(T a, T b) {
+    return static_cast<T>((a + b) / 2);
+  }
+};
+template<> struct BiOpApplier<BIOP_EUC> {
+  template<typename T> static MUSTINLINE T Apply(T a, T b) {
+    return static_cast<T>(std::sqrt(a * a + b * b));
+  }
+};
+template<> struct BiOpApplier<BIOP_DIV> {
+  template<typename T> static MUSTINLINE T Apply(T a, T b) {
+    return static_cast<T>(a / b);
+  }
+};
+template<> struct BiOpApplier<BIOP_SSQ> {
+  template<typename T> static MUSTINLINE T Apply(T a, T b) {
+    return static_cast<T>(a * a + b * b);
+  }
+};
+template<> struct BiOpApplier<BIOP_POW> {
+  template<typename T> static MUSTINLINE T Apply(T a, T b) {
+    return static_cast<T>(std::pow(a, b));
+  }
+};
+template<> struct BiOpApplier<BIOP_AND> {
+  template<typename T> static MUSTINLINE T Apply(T a, T b) {
+    return static_cast<T>(a & b);
+  }
+};
+template<> struct BiOpApplier<BIOP_OR> {
+  template<typename T> static MUSTINLINE T Apply(T a, T b) {
+    return static_cast<T>(a | b);
+  }
+};
+template<> struct BiOpApplier<BIOP_XOR> {
+  template<typename T> static MUSTINLINE T Apply(T a, T b) {
+    return static_cast<T>(a ^ b);
+  }
+};
+
+/// Conversion with rounding (from floating point) and clamping to @c T range.
+template<typename T, typename S> MUSTINLINE T SaturateValue(S value) {
+  if (!std::is_floating_point<T>::value && std::is_floating_point<S>::value) {
+    const double rounded = std::floor(static_cast<double>(value) + 0.5);
+    if (!(rounded > static_cast<double>(std::numeric_limits<T>::lowest())))
+      return std::numeric_limits<T>::lowest();
+    if (!(rounded < static_cast<double>(std::numeric_limits<T>::max())))
+      return std::numeric_limits<T>::max();
+    return static_cast<T>(rounded);
+  }
+  typedef typename std::conditional<
+      std::is_floating_point<S>::value || std::is_floating_point<T>::value,
+      double,
+      typename std::conditional<std::is_signed<S>::value || std::is_signed<T>::value,
+                                int64_t, uint64_t>::type>::type Wide;
+  const Wide lo = static_cast<Wide>(std::numeric_limits<T>::lowest());
+  const Wide hi = static_cast<Wide>(std::numeric_limits<T>::max());
+  const Wide v = static_cast<Wide>(value);
+  if (std::is_unsigned<S>::value || !(v < lo))
+    return v > hi ? static_cast<T>(hi) : static_cast<T>(v);
+  return static_cast<T>(lo);
+}
+
+/// Reads channels of a @c MinImg with elements of type @c T.
+template<typename T> class ImageExpr {
+public:
+  typedef T value_type;
+
+  explicit ImageExpr(const MinImg &image) : image_(image) {}
+
+  bool Fits(int width, int height) const {
+    return image_.p_zero_line && image_.scalar_type == GetMinTypByCType<T>() &&
+           image_.width == width && image_.height == height;
+  }
+  int Channels() const { return image_.channels; }
+
+  class Row {
+  public:
+    Row(const ImageExpr &expr, int y)
+      : p_line_(reinterpret_cast<const T *>(
+            expr.image_.p_zero_line +
+            static_cast<intptr_t>(expr.image_.stride) * y)),
+        channels_(expr.image_.channels) {}
+    MUSTINLINE T operator()(int x, int c) const {
+      return p_line_[x * channels_ + c];
+    }
+  private:
+    const T  *p_line_;
+    const int channels_;
+  };
+
+private:
+  const MinImg image_;
+};
+
+/// Broadcasts a constant to every pixel and channel.
+template<typename T> class ConstantExpr {
+public:
+  typedef T value_type;
+
+  explicit ConstantExpr(T value) : value_(value) {}
+
+  bool Fits(int /*width*/, int /*height*/) const { return true; }
+  int Channels() const { return ANY_CHANNELS; }
+
+  class Row {
+  public:
+    Row(const ConstantExpr &expr, int /*y*/) : value_(expr.value_) {}
+    MUSTINLINE T operator()(int /*x*/, int /*c*/) const { return value_; }
+  private:
+    const T value_;
+  };
+
+private:
+  const T value_;
+};
+
+/// Converts elements with @c static_cast (or @c SaturateValue if saturate).
+template<typename T, typename E, bool saturate> class CastExpr {
+public:
+  typedef T value_type;
+
+  explicit CastExpr(const E &arg) : arg_(arg) {}
+
+  bool Fits(int width, int height) const { return arg_.Fits(width, height); }
+  int Channels() const { return arg_.Channels(); }
+
+  class Row {
+  public:
+    Row(const CastExpr &expr, int y) : arg_(expr.arg_, y) {}
+    MUSTINLINE T operator()(int x, int c) const {
+      return saturate ? SaturateValue<T>(arg_(x, c))
+                      : static_cast<T>(arg_(x, c));
+    }
+  private:
+    const typename E::Row arg_;
+  };
+
+private:
+  const E arg_;
+};
+
+template<UnOp op, typename E> class UnaryExpr {
+public:
+  typedef typename E::value_type value_type;
+
+  explicit UnaryExpr(const E &arg) : arg_(arg) {}
+
+  bool Fits(int width, int height) const { return arg_.Fits(width, height); }
+  int Channels() const { return arg_.Channels(); }
+
+  class Row {
+  public:
+    Row(const UnaryExpr &expr, int y) : arg_(expr.arg_, y) {}
+    MUSTINLINE value_type operator()(int x, int c) const {
+      return UnOpApplier<op>::Apply(arg_(x, c));
+    }
+  private:
+    const typename E::Row arg_;
+  };
+
+private:
+  const E arg_;
+};
+
+template<BiOp op, typename E1, typename E2> class BinaryExpr {
+public:
+  typedef typename E1::value_type value_type;
+  static_assert(std::is_same<value_type, typename E2::value_type>::value,
+                "binary operation arguments must have the same type, use Cast");
+
+  BinaryExpr(const E1 &arg1, const E2 &arg2) : arg1_(arg1), arg2_(arg2) {}
+
+  bool Fits(int width, int height) const {
+    return arg1_.Fits(width, height) && arg2_.Fits(width, height) &&
+           (arg1_.Channels() == ANY_CHANNELS ||
+            arg2_.Channels() == ANY_CHANNELS ||
+            arg1_.Channels() == arg2_.Channels());
+  }
+  int Channels() const {
+    return arg1_.Channels() == ANY_CHANNELS ? arg2_.Channels()
+                                            : arg1_.Channels();
+  }
+
+  class Row {
+  public:
+    Row(const BinaryExpr &expr, int y)
+      : arg1_(expr.arg1_, y), arg2_(expr.arg2_, y) {}
+    MUSTINLINE value_type operator()(int x, int c) const {
+      return BiOpApplier<op>::Apply(arg1_(x, c), arg2_(x, c));
+    }
+  private:
+    const typename E1::Row arg1_;
+    const typename E2::Row arg2_;
+  };
+
+private:
+  const E1 arg1_;
+  const E2 arg2_;
+};
+
+/// Output channel @c c reads channel @c p_channels[c] of the argument.
+template<typename E> class SwizzleExpr {
+public:
+  typedef typename E::value_type value_type;
+
+  SwizzleExpr(const E &arg, const int *p_channels, int channels)
+    : arg_(arg), channels_(channels) {
+    for (int c = 0; c < MAX_SWIZZLE_CHANNELS; ++c)
+      map_[c] = c < channels ? p_channels[c] : 0;
+  }
+
+  bool Fits(int width, int height) const {
+    if (channels_ <= 0 || channels_ > MAX_SWIZZLE_CHANNELS)
+      return false;
+    for (int c = 0; c < channels_; ++c)
+      if (map_[c] < 0 || (arg_.Channels() != ANY_CHANNELS &&
+                          map_[c] >= arg_.Channels()))
+        return false;
+    return arg_.Fits(width, height);
+  }
+  int Channels() const { return channels_; }
+
+  class Row {
+  public:
+    Row(const SwizzleExpr &expr, int y)
+      : arg_(expr.arg_, y), p_map_(expr.map_) {}
+    MUSTINLINE value_type operator()(int x, int c) const {
+      return arg_(x, p_map_[c]);
+    }
+  private:
+    const typename E::Row arg_;
+    const int *p_map_;
+  };
+
+private:
+  const E   arg_;
+  int       map_[MAX_SWIZZLE_CHANNELS];
+  const int channels_;
+};
+
+template<typename E> struct EvaluateContext {
+  const MinImg *p_dst_image;
+  const E      *p_expr;
+};
+
+template<typename E> MinResult EvaluateLines(
+    void *p_context,
+    int   begin,
+    int   end) {
+  typedef typename E::value_type T;
+  const EvaluateContext<E> &context =
+      *reinterpret_cast<const EvaluateContext<E> *>(p_context);
+  const MinImg &dst_image = *context.p_dst_image;
+  const int width = dst_image.width;
+  const int channels = dst_image.channels;
+  for (int y = begin; y < end; ++y) {
+    const typename E::Row row(*context.p_expr, y);
+    T *p_dst = reinterpret_cast<T *>(
+        dst_image.p_zero_line + static_cast<intptr_t>(dst_image.stride) * y);
+    if (channels == 1) {
+      for (int x = 0; x < width; ++x)
+        p_dst[x] = row(x, 0);
+    } else {
+      for (int x = 0; x < width; ++x, p_dst += channels)
+        for (int c = 0; c < channels; ++c)
+          p_dst[c] = row(x, c);
+    }
+  }
+  return MR_SUCCESS;
+}
+
+} // namespace pipeline
+
+template<typename T> MUSTINLINE pipeline::ImageExpr<T> Image(
+    const MinImg &image) {
+  return pipeline::ImageExpr<T>(image);
+}
+
+template<typename T> MUSTINLINE pipeline::ConstantExpr<T> Constant(T value) {
+  return pipeline::ConstantExpr<T>(value);
+}
+
+template<typename T, typename E>
+MUSTINLINE pipeline::CastExpr<T, E, false> Cast(const E &arg) {
+  return pipeline::CastExpr<T, E, false>(arg);
+}
+
+template<typename T, typename E>
+MUSTINLINE pipeline::CastExpr<T, E, true> SaturateCast(const E &arg) {
+  return pipeline::CastExpr<T, E, true>(arg);
+}
+
+template<UnOp op, typename E>
+MUSTINLINE pipeline::UnaryExpr<op, E> Apply(const E &arg) {
+  return pipeline::UnaryExpr<op, E>(arg);
+}
+
+template<BiOp op, typename E1, typename E2>
+MUSTINLINE pipeline::BinaryExpr<op, E1, E2> Apply(const E1 &arg1,
+                                                  const E2 &arg2) {
+  return pipeline::BinaryExpr<op, E1, E2>(arg1, arg2);
+}
+
+template<typename E>
+MUSTINLINE pipeline::BinaryExpr<BIOP_MIN,
+    pipeline::BinaryExpr<BIOP_MAX, E,
+                         pipeline::ConstantExpr<typename E::value_type> >,
+    pipeline::ConstantExpr<typename E::value_type> > Clamp(
+    const E                     &arg,
+    typename E::value_type       lo,
+    typename E::value_type       hi) {
+  return Apply<BIOP_MIN>(Apply<BIOP_MAX>(arg, Constant(lo)), Constant(hi));
+}
+
+template<typename E> MUSTINLINE pipeline::SwizzleExpr<E> Swizzle(
+    const E   &arg,
+    const int *p_channels,
+    int        channels) {
+  return pipeline::SwizzleExpr<E>(arg, p_channels, channels);
+}
+
+/**
+ * @brief   Computes an expression into an allocated image in a single pass.
+ * @param   dst_image The destination image; its type must match the
+ *                    expression value type and its size must match the size
+ *                    of every source image of the expression.
+ * @param   expr      The expression.
+ * @param   parallel  Whether lines may be processed in parallel.
+ * @returns @c MR_SUCCESS on success or an error code otherwise.
+ * @remarks The destination image must not overlap any source image unless it
+ *          coincides with it pixel-to-pixel.
+ */
+template<typename E> MinResult Evaluate(
+    const MinImg &dst_image,
+    const E      &expr,
+    bool          parallel = true) {
+  if (!dst_image.p_zero_line && dst_image.width && dst_image.height)
+    return MR_CONTRACT_VIOLATION;
+  if (dst_image.scalar_type != GetMinTypByCType<typename E::value_type>())
+    return MR_CONTRACT_VIOLATION;
+  if (!expr.Fits(dst_image.width, dst_image.height))
+    return MR_CONTRACT_VIOLATION;
+  if (expr.Channels() != pipeline::ANY_CHANNELS &&
+      expr.Channels() != dst_image.channels)
+    return MR_CONTRACT_VIOLATION;
+
+  pipeline::EvaluateContext<E> context = { &dst_image, &expr };
+  if (!parallel)
+    return pipeline::EvaluateLines<E>(&context, 0, dst_image.height);
+  return ParallelForLines(dst_image.height, pipeline::EvaluateLines<E>,
+                          &context);
+}
+
+} // namespace minimg
+
+#endif // #ifndef MINIMGAPI_PIXEL_PIPELINE_HPP_INCLUDED
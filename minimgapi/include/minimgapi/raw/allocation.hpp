@@ -38,6 +38,8 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <new>
 #include <algorithm>
 
+#include <minbase/minmemory.h>
+
 #include "minimgapi_raw_base.hpp"
 #include "gets.hpp"
 #include "assures_and_compares.hpp"
@@ -74,7 +76,7 @@ static MINIMGAPI_RAW_API MinResult AllocImageRaw(
       std::max<size_t>(alignment, alignof(MinImgAllocInfo));
 
   /// TODO: Recheck how alignment is processed
-  void* p_buf = alignedmalloc(buf_size, buf_alignment);
+  void* p_buf = MinMemAlloc(buf_size, buf_alignment, MinMemGetImageTag());
 //  void* p_buf = alignedmalloc(buf_size, alignof(MinImgLandInfo));
   if (!p_buf)
     return MR_ENV_ERROR;
@@ -111,7 +113,7 @@ static MINIMGAPI_RAW_API MinResult FreeImageRaw(MinImg& image) {
 
     const void* p_buf = reinterpret_cast<const void*>(image.p_alloc_info);
     /// TODO: Isn't there any more elegant solution than const_cast here?
-    alignedfree(const_cast<void*>(p_buf));
+    MinMemFree(const_cast<void*>(p_buf));
     image.is_owner = false;
     image.p_zero_line = nullptr;
     image.p_alloc_info = nullptr;
@@ -0,0 +1,204 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <cstring>
+#include <cstdlib>  // std::abs
+#include <minbase/minresult.h>
+#include <minbase/crossplat.h>
+#include <minimgapi/minimgapi.h>
+#include <minimgapi/minimgapi-inl.h>
+#include <minimgapi/raw/get_coord.hpp>
+
+
+#ifdef MINIMGAPI_STOPWATCH_OLD_INTERFACE
+DECLARE_MINSTOPWATCH(swAllocMinImageWithBorders,          "AllocMinImageWithBorders");
+DECLARE_MINSTOPWATCH(swFillMinImageBorders,               "FillMinImageBorders");
+#endif // MINIMGAPI_STOPWATCH_OLD_INTERFACE
+
+
+typedef int32_t (*GetCoordFunc)(int32_t c, int32_t sz);
+
+template<BorderOption border>
+static int32_t GetBorderCoord(int32_t c, int32_t sz) {
+  return minimg_raw::GetCoordRaw<border>(c, sz);
+}
+
+MINIMGAPI_API int AllocMinImageWithBorders(
+    MinImg *p_image,
+    int     margin_x,
+    int     margin_y,
+    int     alignment) {
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_OLD_INTERFACE(swAllocMinImageWithBorders);
+
+  if (!p_image || margin_x < 0 || margin_y < 0)
+    return BAD_ARGS;
+  PROPAGATE_ERROR(_AssureMinImagePrototypeIsValid(p_image));
+  if (p_image->p_zero_line)
+    return BAD_ARGS;
+  if (alignment <= 0 || alignment & (alignment - 1))
+    return BAD_ARGS;
+  const int bits_per_pixel = _GetMinImageBitsPerPixel(p_image);
+  PROPAGATE_ERROR(bits_per_pixel);
+  if (bits_per_pixel & 0x07)
+    return NOT_IMPLEMENTED;
+  const int pixel_size = bits_per_pixel >> 3;
+  if (!pixel_size)
+    return AllocMinImage(p_image, alignment);
+
+  // the left margin is rounded up to whole pixels which are a multiple of the
+  // alignment, so the zero line stays both aligned and on a pixel boundary
+  int unit = pixel_size;  // the least common multiple of both, in bytes
+  while (unit % alignment)
+    unit += pixel_size;
+  const int unit_width = unit / pixel_size;
+  const int left_margin = (margin_x + unit_width - 1) / unit_width * unit_width;
+
+  MinImg padded_image = *p_image;
+  padded_image.width = p_image->width + left_margin + margin_x;
+  padded_image.height = p_image->height + 2 * margin_y;
+  padded_image.stride = 0;
+  PROPAGATE_ERROR(AllocMinImage(&padded_image, alignment));
+
+  padded_image.width = p_image->width;
+  padded_image.height = p_image->height;
+  padded_image.p_zero_line += static_cast<intptr_t>(margin_y) *
+                              padded_image.stride + left_margin * pixel_size;
+  *p_image = padded_image;
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int FillMinImageBorders(
+    const MinImg *p_image,
+    int           margin_x,
+    int           margin_y,
+    BorderOption  border,
+    const void   *p_canvas) {
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swFillMinImageBorders, p_image);
+
+  PROPAGATE_ERROR(_AssureMinImageIsValid(p_image));
+  if (margin_x < 0 || margin_y < 0)
+    return BAD_ARGS;
+  if (_AssureMinImageIsEmpty(p_image) == NO_ERRORS)
+    return NO_ERRORS;
+  const int bits_per_pixel = _GetMinImageBitsPerPixel(p_image);
+  if (bits_per_pixel & 0x07)
+    return NOT_IMPLEMENTED;
+  const intptr_t pixel_size = bits_per_pixel >> 3;
+  const intptr_t stride = p_image->stride;
+  const int width = p_image->width;
+  const int height = p_image->height;
+
+  GetCoordFunc get_coord = NULL;
+  switch (border) {
+    case BO_IGNORE:
+      return NO_ERRORS;
+    case BO_REPEAT:
+      get_coord = GetBorderCoord<BO_REPEAT>;
+      break;
+    case BO_SYMMETRIC:
+      get_coord = GetBorderCoord<BO_SYMMETRIC>;
+      break;
+    case BO_CYCLIC:
+      get_coord = GetBorderCoord<BO_CYCLIC>;
+      break;
+    case BO_CONSTANT:
+      if (!p_canvas)
+        return BAD_ARGS;
+      break;
+    default:
+      return BAD_ARGS;
+  }
+
+  uint8_t *p_first_line = p_image->p_zero_line - margin_y * stride;
+  uint8_t *p_last_line = p_image->p_zero_line + (height - 1 + margin_y) * stride;
+  if (p_image->is_owner && p_image->p_alloc_info) {
+    const uint8_t *p_land = p_image->p_alloc_info->p_land_;
+    const uint8_t *p_land_end = p_land + p_image->p_alloc_info->stride_ *
+                                         p_image->p_alloc_info->height_;
+    const uint8_t *p_begin = (stride < 0 ? p_last_line : p_first_line) -
+                             margin_x * pixel_size;
+    const uint8_t *p_end = (stride < 0 ? p_first_line : p_last_line) +
+                           (width + margin_x) * pixel_size;
+    if (p_begin < p_land || p_end > p_land_end)
+      return BAD_ARGS;
+  }
+
+  // side margins of the visible lines
+  if (margin_x) {
+    for (int y = 0; y < height; ++y) {
+      uint8_t *p_line = p_image->p_zero_line + y * stride;
+      for (int x = 1; x <= margin_x; ++x) {
+        uint8_t *p_left = p_line - x * pixel_size;
+        uint8_t *p_right = p_line + (width - 1 + x) * pixel_size;
+        if (!get_coord) {
+          ::memcpy(p_left, p_canvas, pixel_size);
+          ::memcpy(p_right, p_canvas, pixel_size);
+        } else {
+          ::memcpy(p_left, p_line + get_coord(-x, width) * pixel_size,
+                   pixel_size);
+          ::memcpy(p_right, p_line + get_coord(width - 1 + x, width) * pixel_size,
+                   pixel_size);
+        }
+      }
+    }
+  }
+
+  // top and bottom margins, every line is an extended line copy
+  if (margin_y) {
+    const size_t line_size = (width + 2 * margin_x) * pixel_size;
+    const intptr_t line_offset = -margin_x * pixel_size;
+    const uint8_t *p_constant_line = NULL;
+    if (!get_coord) {
+      uint8_t *p_line = p_first_line + line_offset;
+      for (int x = 0; x < width + 2 * margin_x; ++x)
+        ::memcpy(p_line + x * pixel_size, p_canvas, pixel_size);
+      p_constant_line = p_line;
+    }
+    for (int y = 1; y <= margin_y; ++y) {
+      uint8_t *p_top = p_image->p_zero_line - y * stride + line_offset;
+      uint8_t *p_bottom = p_image->p_zero_line + (height - 1 + y) * stride +
+                          line_offset;
+      const uint8_t *p_top_src = p_constant_line;
+      const uint8_t *p_bottom_src = p_constant_line;
+      if (get_coord) {
+        p_top_src = p_image->p_zero_line + get_coord(-y, height) * stride +
+                    line_offset;
+        p_bottom_src = p_image->p_zero_line +
+                       get_coord(height - 1 + y, height) * stride + line_offset;
+      }
+      if (p_top != p_top_src)
+        ::memcpy(p_top, p_top_src, line_size);
+      ::memcpy(p_bottom, p_bottom_src, line_size);
+    }
+  }
+
+  return NO_ERRORS;
+}
@@ -0,0 +1,436 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <cmath>
+#include <cstring>
+#include <climits>
+#include <limits>
+#include <atomic>
+#include <type_traits>
+#include <algorithm>  // std::max
+#include <minbase/minresult.h>
+#include <minbase/crossplat.h>
+#include <minimgapi/minimgapi.h>
+#include <minimgapi/minimgapi-inl.h>
+#include "vector/compare-inl.h"
+
+MIN_WARNINGS_SUPPRESSION_BEGIN
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/blocked_range.h>
+MIN_WARNINGS_SUPPRESSION_END
+
+
+#ifdef MINIMGAPI_STOPWATCH_OLD_INTERFACE
+DECLARE_MINSTOPWATCH(swCompareMinImageContents,           "CompareMinImageContents");
+DECLARE_MINSTOPWATCH(swGetMinImagesDifference,            "GetMinImagesDifference");
+#endif // MINIMGAPI_STOPWATCH_OLD_INTERFACE
+
+
+// Images smaller than that are compared by the calling thread only.
+static const int64_t kParallelBytes = 1 << 20;
+static const int64_t kGrainBytes = 1 << 18;
+
+static int GetLineGrain(int64_t line_bytes) {
+  return static_cast<int>(std::max<int64_t>(1, kGrainBytes / line_bytes));
+}
+
+static MUSTINLINE const uint8_t *GetLine(const MinImg *p_image, int y) {
+  return p_image->p_zero_line + static_cast<ptrdiff_t>(y) * p_image->stride;
+}
+
+static MUSTINLINE uint8_t GetTailMask(int64_t line_bits) {
+  return static_cast<uint8_t>(0xFFU << (8 - (line_bits & 7)));
+}
+
+static bool AreLinesEqual(
+    const uint8_t *p_line_a,
+    const uint8_t *p_line_b,
+    int64_t        line_bits) {
+  const size_t line_bytes = static_cast<size_t>(line_bits >> 3);
+  if (::memcmp(p_line_a, p_line_b, line_bytes))
+    return false;
+  if (line_bits & 7)
+    return !((p_line_a[line_bytes] ^ p_line_b[line_bytes]) &
+             GetTailMask(line_bits));
+  return true;
+}
+
+static MUSTINLINE int CountBits(uint8_t v) {
+  v = static_cast<uint8_t>(v - ((v >> 1) & 0x55));
+  v = static_cast<uint8_t>((v & 0x33) + ((v >> 2) & 0x33));
+  return (v + (v >> 4)) & 0x0F;
+}
+
+static double Real16ToDouble(const real16_t &v) {
+  double magnitude;
+  if (v.exponent == 0)
+    magnitude = std::ldexp(static_cast<double>(v.significand), -24);
+  else if (v.exponent == 31)
+    magnitude = v.significand ? std::numeric_limits<double>::quiet_NaN()
+                              : std::numeric_limits<double>::infinity();
+  else
+    magnitude = std::ldexp(static_cast<double>(v.significand + 1024),
+                           v.exponent - 25);
+  return v.sign ? -magnitude : magnitude;
+}
+
+// Equal infinities and a pair of NaNs do not differ; a NaN against a number
+// differs by NaN.
+static MUSTINLINE double RealAbsDiff(double a, double b) {
+  if (a == b || (a != a && b != b))
+    return 0.0;
+  return std::fabs(a - b);
+}
+
+template<typename T> static MUSTINLINE double AbsDiff(const T &a, const T &b) {
+  typedef typename std::make_unsigned<T>::type U;
+  return a > b ? static_cast<double>(static_cast<U>(a) - static_cast<U>(b))
+               : static_cast<double>(static_cast<U>(b) - static_cast<U>(a));
+}
+
+template<> MUSTINLINE double AbsDiff(const real16_t &a, const real16_t &b) {
+  return RealAbsDiff(Real16ToDouble(a), Real16ToDouble(b));
+}
+
+template<> MUSTINLINE double AbsDiff(const real32_t &a, const real32_t &b) {
+  return RealAbsDiff(a, b);
+}
+
+template<> MUSTINLINE double AbsDiff(const real64_t &a, const real64_t &b) {
+  return RealAbsDiff(a, b);
+}
+
+struct DiffAccumulator {
+  double  max_abs_diff;
+  double  sse;
+  int64_t num_diff_pixels;
+  int     x_begin;
+  int     x_end;
+  int     y_begin;
+  int     y_end;
+
+  DiffAccumulator()
+      : max_abs_diff(0.0), sse(0.0), num_diff_pixels(0),
+        x_begin(INT_MAX), x_end(0), y_begin(INT_MAX), y_end(0) {}
+
+  void AddMaxAbsDiff(double value) {
+    if (value > max_abs_diff)
+      max_abs_diff = value;
+  }
+
+  void AddDiffPixels(int64_t count, int x_first, int x_last, int y) {
+    if (!count)
+      return;
+    num_diff_pixels += count;
+    x_begin = std::min(x_begin, x_first);
+    x_end = std::max(x_end, x_last + 1);
+    y_begin = std::min(y_begin, y);
+    y_end = std::max(y_end, y + 1);
+  }
+
+  void Join(const DiffAccumulator &other) {
+    AddMaxAbsDiff(other.max_abs_diff);
+    sse += other.sse;
+    num_diff_pixels += other.num_diff_pixels;
+    x_begin = std::min(x_begin, other.x_begin);
+    x_end = std::max(x_end, other.x_end);
+    y_begin = std::min(y_begin, other.y_begin);
+    y_end = std::max(y_end, other.y_end);
+  }
+};
+
+typedef void (*DiffLineFunc)(
+    DiffAccumulator *p_acc,
+    const uint8_t   *p_line_a,
+    const uint8_t   *p_line_b,
+    int              width,
+    int              channels,
+    double           tolerance,
+    int              y);
+
+// Counts the pixels of a line having a channel differing by more than the
+// tolerance.
+template<typename T>
+static void ScanDiffPixels(
+    DiffAccumulator *p_acc,
+    const T         *p_a,
+    const T         *p_b,
+    int              width,
+    int              channels,
+    double           tolerance,
+    int              y) {
+  int64_t count = 0;
+  int x_first = 0, x_last = 0;
+  for (int x = 0; x < width; ++x, p_a += channels, p_b += channels) {
+    int c = 0;
+    while (c < channels && AbsDiff(p_a[c], p_b[c]) <= tolerance)
+      ++c;
+    if (c == channels)
+      continue;
+    if (!count++)
+      x_first = x;
+    x_last = x;
+  }
+  p_acc->AddDiffPixels(count, x_first, x_last, y);
+}
+
+// Integers up to 16 bits: the vector kernel finds the maximum and the sum of
+// squares, and the pixels are only scanned when the maximum exceeds the
+// tolerance.
+template<typename T>
+static void DiffNarrowLine(
+    DiffAccumulator *p_acc,
+    const uint8_t   *p_line_a,
+    const uint8_t   *p_line_b,
+    int              width,
+    int              channels,
+    double           tolerance,
+    int              y) {
+  const T *p_a = reinterpret_cast<const T *>(p_line_a);
+  const T *p_b = reinterpret_cast<const T *>(p_line_b);
+  uint64_t max = 0, sse = 0;
+  vector_diff_max_sse(&max, &sse, p_a, p_b, width * channels);
+  p_acc->AddMaxAbsDiff(static_cast<double>(max));
+  p_acc->sse += static_cast<double>(sse);
+  if (static_cast<double>(max) > tolerance)
+    ScanDiffPixels(p_acc, p_a, p_b, width, channels, tolerance, y);
+}
+
+template<typename T>
+static void DiffWideLine(
+    DiffAccumulator *p_acc,
+    const uint8_t   *p_line_a,
+    const uint8_t   *p_line_b,
+    int              width,
+    int              channels,
+    double           tolerance,
+    int              y) {
+  const T *p_a = reinterpret_cast<const T *>(p_line_a);
+  const T *p_b = reinterpret_cast<const T *>(p_line_b);
+  double max = 0.0, sse = 0.0;
+  int64_t count = 0;
+  int x_first = 0, x_last = 0;
+  for (int x = 0; x < width; ++x, p_a += channels, p_b += channels) {
+    bool differs = false;
+    for (int c = 0; c < channels; ++c) {
+      const double d = AbsDiff(p_a[c], p_b[c]);
+      if (d > max)
+        max = d;
+      sse += d * d;
+      differs |= !(d <= tolerance);
+    }
+    if (!differs)
+      continue;
+    if (!count++)
+      x_first = x;
+    x_last = x;
+  }
+  p_acc->AddMaxAbsDiff(max);
+  p_acc->sse += sse;
+  p_acc->AddDiffPixels(count, x_first, x_last, y);
+}
+
+static void DiffBitLine(
+    DiffAccumulator *p_acc,
+    const uint8_t   *p_line_a,
+    const uint8_t   *p_line_b,
+    int              width,
+    int              channels,
+    double           tolerance,
+    int              y) {
+  const int64_t line_bits = static_cast<int64_t>(width) * channels;
+  const int64_t line_bytes = line_bits >> 3;
+  int64_t ones = 0;
+  for (int64_t i = 0; i < line_bytes; ++i)
+    ones += CountBits(p_line_a[i] ^ p_line_b[i]);
+  if (line_bits & 7)
+    ones += CountBits((p_line_a[line_bytes] ^ p_line_b[line_bytes]) &
+                      GetTailMask(line_bits));
+  if (!ones)
+    return;
+  p_acc->AddMaxAbsDiff(1.0);
+  p_acc->sse += static_cast<double>(ones);
+  if (!(1.0 > tolerance))
+    return;
+
+  int64_t count = 0;
+  int x_first = 0, x_last = 0;
+  for (int x = 0; x < width; ++x) {
+    bool differs = false;
+    for (int64_t k = static_cast<int64_t>(x) * channels;
+         k < static_cast<int64_t>(x + 1) * channels && !differs; ++k)
+      differs = ((p_line_a[k >> 3] ^ p_line_b[k >> 3]) >> (7 - (k & 7))) & 1;
+    if (!differs)
+      continue;
+    if (!count++)
+      x_first = x;
+    x_last = x;
+  }
+  p_acc->AddDiffPixels(count, x_first, x_last, y);
+}
+
+static DiffLineFunc GetDiffLineFunc(MinTyp type) {
+  switch (type) {
+  case TYP_UINT1:  return DiffBitLine;
+  case TYP_UINT8:  return DiffNarrowLine<uint8_t>;
+  case TYP_INT8:   return DiffNarrowLine<int8_t>;
+  case TYP_UINT16: return DiffNarrowLine<uint16_t>;
+  case TYP_INT16:  return DiffNarrowLine<int16_t>;
+  case TYP_UINT32: return DiffWideLine<uint32_t>;
+  case TYP_INT32:  return DiffWideLine<int32_t>;
+  case TYP_UINT64: return DiffWideLine<uint64_t>;
+  case TYP_INT64:  return DiffWideLine<int64_t>;
+  case TYP_REAL16: return DiffWideLine<real16_t>;
+  case TYP_REAL32: return DiffWideLine<real32_t>;
+  case TYP_REAL64: return DiffWideLine<real64_t>;
+  default:         return NULL;
+  }
+}
+
+// The largest value of an integer type or 1 for the real ones.
+static double GetPeakValue(MinTyp type) {
+  if (MinFormatOfMinType(type) == FMT_REAL)
+    return 1.0;
+  return std::ldexp(1.0, 1 << LogBitSizeOfMinType(type)) - 1.0;
+}
+
+MINIMGAPI_API int CompareMinImageContents(
+    const MinImg *p_image_a,
+    const MinImg *p_image_b) {
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swCompareMinImageContents,
+                                                   p_image_a);
+
+  PROPAGATE_ERROR(_AssureMinImageIsValid(p_image_a));
+  PROPAGATE_ERROR(_AssureMinImageIsValid(p_image_b));
+  if (_CompareMinImagePrototypes(p_image_a, p_image_b))
+    return 1;
+  if (_AssureMinImageIsEmpty(p_image_a) == NO_ERRORS)
+    return 0;
+  if (p_image_a->p_zero_line == p_image_b->p_zero_line &&
+      p_image_a->stride == p_image_b->stride)
+    return 0;
+
+  const int64_t line_bits =
+      static_cast<int64_t>(p_image_a->width) * _GetMinImageBitsPerPixel(p_image_a);
+  const int64_t line_bytes = (line_bits + 7) >> 3;
+  const int height = p_image_a->height;
+  if (line_bytes * height < kParallelBytes) {
+    for (int y = 0; y < height; ++y)
+      if (!AreLinesEqual(GetLine(p_image_a, y), GetLine(p_image_b, y),
+                         line_bits))
+        return 1;
+    return 0;
+  }
+
+  // Workers stop as soon as any of them finds a difference.
+  std::atomic<bool> differs(false);
+  tbb::parallel_for(
+      tbb::blocked_range<int>(0, height, GetLineGrain(line_bytes)),
+      [&](const tbb::blocked_range<int> &range) {
+        for (int y = range.begin(); y < range.end(); ++y) {
+          if (differs.load(std::memory_order_relaxed))
+            return;
+          if (!AreLinesEqual(GetLine(p_image_a, y), GetLine(p_image_b, y),
+                             line_bits)) {
+            differs.store(true, std::memory_order_relaxed);
+            return;
+          }
+        }
+      });
+  return differs.load() ? 1 : 0;
+}
+
+MINIMGAPI_API int GetMinImagesDifference(
+    MinImgDiffStats *p_stats,
+    const MinImg    *p_image_a,
+    const MinImg    *p_image_b,
+    double           tolerance) {
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swGetMinImagesDifference,
+                                                   p_image_a);
+
+  if (!p_stats)
+    return BAD_ARGS;
+  PROPAGATE_ERROR(_AssureMinImageIsValid(p_image_a));
+  PROPAGATE_ERROR(_AssureMinImageIsValid(p_image_b));
+  if (_CompareMinImagePrototypes(p_image_a, p_image_b))
+    return BAD_ARGS;
+  if (!(tolerance >= 0.0))
+    return BAD_ARGS;
+  const DiffLineFunc diff_line = GetDiffLineFunc(p_image_a->scalar_type);
+  if (!diff_line)
+    return BAD_ARGS;
+
+  const int width = p_image_a->width;
+  const int channels = p_image_a->channels;
+  const int64_t line_bytes =
+      (static_cast<int64_t>(width) * _GetMinImageBitsPerPixel(p_image_a) + 7) >> 3;
+  const auto diff_lines = [&](DiffAccumulator acc, int y_begin, int y_end) {
+    for (int y = y_begin; y < y_end; ++y)
+      diff_line(&acc, GetLine(p_image_a, y), GetLine(p_image_b, y),
+                width, channels, tolerance, y);
+    return acc;
+  };
+
+  DiffAccumulator acc;
+  if (line_bytes * p_image_a->height < kParallelBytes)
+    acc = diff_lines(acc, 0, p_image_a->height);
+  else
+    acc = tbb::parallel_reduce(
+        tbb::blocked_range<int>(0, p_image_a->height, GetLineGrain(line_bytes)),
+        DiffAccumulator(),
+        [&](const tbb::blocked_range<int> &range, DiffAccumulator partial) {
+          return diff_lines(partial, range.begin(), range.end());
+        },
+        [](DiffAccumulator a, const DiffAccumulator &b) {
+          a.Join(b);
+          return a;
+        });
+
+  ::memset(p_stats, 0, sizeof(*p_stats));
+  const int64_t num_samples =
+      static_cast<int64_t>(width) * p_image_a->height * channels;
+  p_stats->max_abs_diff = acc.sse != acc.sse ? acc.sse : acc.max_abs_diff;
+  p_stats->num_diff_pixels = acc.num_diff_pixels;
+  p_stats->sse = acc.sse;
+  p_stats->mse = num_samples ? acc.sse / static_cast<double>(num_samples) : 0.0;
+  const double peak = GetPeakValue(p_image_a->scalar_type);
+  p_stats->psnr = p_stats->mse == 0.0 ?
+      std::numeric_limits<double>::infinity() :
+      10.0 * std::log10(peak * peak / p_stats->mse);
+  if (acc.num_diff_pixels) {
+    p_stats->diff_x = acc.x_begin;
+    p_stats->diff_y = acc.y_begin;
+    p_stats->diff_width = acc.x_end - acc.x_begin;
+    p_stats->diff_height = acc.y_end - acc.y_begin;
+  }
+  return NO_ERRORS;
+}
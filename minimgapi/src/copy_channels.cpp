@@ -88,7 +88,7 @@ MINIMGAPI_API int CopyMinImageChannels(
     const int    *p_dst_channels,
     const int    *p_src_channels,
     int           num_channels) {
-  MINIMGAPI_DECLARE_STOPWATCH_CTL_OLD_INTERFACE(swCopyMinImageChannels);
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swCopyMinImageChannels, p_src_image);
 
   if (!p_dst_channels || !p_src_channels || num_channels < 0)
     return BAD_ARGS;
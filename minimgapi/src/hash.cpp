@@ -0,0 +1,281 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <cstring>
+#include <algorithm>  // std::max
+#include <minbase/minresult.h>
+#include <minbase/crossplat.h>
+#include <minimgapi/minimgapi.h>
+#include <minimgapi/minimgapi-inl.h>
+
+MIN_WARNINGS_SUPPRESSION_BEGIN
+#include <tbb/parallel_reduce.h>
+#include <tbb/blocked_range.h>
+MIN_WARNINGS_SUPPRESSION_END
+
+
+#ifdef MINIMGAPI_STOPWATCH_OLD_INTERFACE
+DECLARE_MINSTOPWATCH(swHashMinImage,                      "HashMinImage");
+DECLARE_MINSTOPWATCH(swUpdateMinImageHash,                "UpdateMinImageHash");
+#endif // MINIMGAPI_STOPWATCH_OLD_INTERFACE
+
+
+// Lines are cut into blocks of 512 bits. Every block is hashed with the
+// XXH64 round function (four independent multiply-rotate lanes over two
+// 32-byte stripes) keyed by the block position, and the image hash is the sum
+// of the block hashes. The sum does not depend on the order blocks are
+// visited in, which makes the hash both parallel and incremental.
+static const int kBlockBits = 512;
+static const int kBlockBytes = kBlockBits / 8;
+
+// Images smaller than that are hashed by the calling thread only.
+static const int64_t kParallelBytes = 1 << 20;
+static const int64_t kGrainBytes = 1 << 18;
+
+static const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+static const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+static MUSTINLINE uint64_t RotateLeft(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+static MUSTINLINE uint64_t Round(uint64_t acc, uint64_t input) {
+  acc += input * kPrime2;
+  return RotateLeft(acc, 31) * kPrime1;
+}
+
+static MUSTINLINE uint64_t Avalanche(uint64_t h) {
+  h ^= h >> 33;
+  h *= kPrime2;
+  h ^= h >> 29;
+  h *= kPrime3;
+  h ^= h >> 32;
+  return h;
+}
+
+static MUSTINLINE uint64_t Load64(const uint8_t *p) {
+  uint64_t v;
+  ::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);
+#endif
+  return v;
+}
+
+static MUSTINLINE uint64_t HashBlock(const uint8_t *p, uint64_t key) {
+  uint64_t v1 = key + kPrime1 + kPrime2;
+  uint64_t v2 = key + kPrime2;
+  uint64_t v3 = key;
+  uint64_t v4 = key - kPrime1;
+  v1 = Round(Round(v1, Load64(p +  0)), Load64(p + 32));
+  v2 = Round(Round(v2, Load64(p +  8)), Load64(p + 40));
+  v3 = Round(Round(v3, Load64(p + 16)), Load64(p + 48));
+  v4 = Round(Round(v4, Load64(p + 24)), Load64(p + 56));
+  // Blocks are short, so the XXH64 merge rounds are replaced by the final
+  // avalanche only; it halves the cost of a block.
+  return Avalanche(RotateLeft(v1, 1) + RotateLeft(v2, 7) +
+                   RotateLeft(v3, 12) + RotateLeft(v4, 18));
+}
+
+static uint64_t HashLine(
+    const uint8_t *p_line,
+    int64_t        line_bits,
+    uint64_t       line_key,
+    int64_t        first_block) {
+  const int64_t num_blocks = line_bits / kBlockBits;
+  uint64_t block_key = line_key + first_block * kPrime3;
+  uint64_t sum = 0;
+  for (int64_t k = 0; k < num_blocks; ++k, block_key += kPrime3)
+    sum += HashBlock(p_line + k * kBlockBytes, block_key);
+
+  const int tail_bits = static_cast<int>(line_bits % kBlockBits);
+  if (tail_bits) {
+    uint8_t tail[kBlockBytes] = {};
+    const int tail_bytes = (tail_bits + 7) >> 3;
+    ::memcpy(tail, p_line + num_blocks * kBlockBytes, tail_bytes);
+    if (tail_bits & 7)
+      tail[tail_bytes - 1] &=
+          static_cast<uint8_t>(0xFFU << (8 - (tail_bits & 7)));
+    sum += HashBlock(tail, block_key);
+  }
+  return sum;
+}
+
+static uint64_t HashLines(
+    const MinImg *p_tile,
+    int64_t       line_bits,
+    uint64_t      seed,
+    int           y0,
+    int64_t       first_block,
+    int           y_begin,
+    int           y_end) {
+  uint64_t sum = 0;
+  for (int y = y_begin; y < y_end; ++y)
+    sum += HashLine(p_tile->p_zero_line + static_cast<ptrdiff_t>(y) *
+                    p_tile->stride, line_bits,
+                    seed + static_cast<uint64_t>(y0 + y) * kPrime5,
+                    first_block);
+  return sum;
+}
+
+static uint64_t HashTile(
+    const MinImg *p_tile,
+    int64_t       line_bits,
+    uint64_t      seed,
+    int           y0,
+    int64_t       first_block) {
+  const int64_t line_bytes = (line_bits + 7) >> 3;
+  if (line_bytes * p_tile->height < kParallelBytes)
+    return HashLines(p_tile, line_bits, seed, y0, first_block,
+                     0, p_tile->height);
+
+  const int grain = static_cast<int>(
+      std::max<int64_t>(1, kGrainBytes / line_bytes));
+  return tbb::parallel_reduce(
+      tbb::blocked_range<int>(0, p_tile->height, grain), uint64_t(0),
+      [&](const tbb::blocked_range<int> &range, uint64_t sum) {
+        return sum + HashLines(p_tile, line_bits, seed, y0, first_block,
+                               range.begin(), range.end());
+      },
+      [](uint64_t a, uint64_t b) { return a + b; });
+}
+
+static int AddTileToMinImageHash(
+    MinImgHashState *p_state,
+    const MinImg    *p_tile,
+    int              x0,
+    int              y0) {
+  PROPAGATE_ERROR(_AssureMinImageIsValid(p_tile));
+  if (p_tile->channels != p_state->channels ||
+      p_tile->scalar_type != p_state->scalar_type)
+    return BAD_ARGS;
+  if (x0 < 0 || y0 < 0 ||
+      p_tile->width > p_state->width - x0 ||
+      p_tile->height > p_state->height - y0)
+    return BAD_ARGS;
+  if (!p_tile->width || !p_tile->height)
+    return NO_ERRORS;
+
+  const int64_t pixel_bits = _GetMinImageBitsPerPixel(p_tile);
+  const int64_t start_bits = x0 * pixel_bits;
+  const int64_t line_bits = p_tile->width * pixel_bits;
+  if (start_bits % kBlockBits)
+    return BAD_ARGS;
+  if (x0 + p_tile->width != p_state->width && line_bits % kBlockBits)
+    return BAD_ARGS;
+
+  p_state->sum += HashTile(p_tile, line_bits, p_state->seed, y0,
+                           start_bits / kBlockBits);
+  p_state->num_pixels += static_cast<int64_t>(p_tile->width) * p_tile->height;
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int InitMinImageHash(
+    MinImgHashState *p_state,
+    const MinImg    *p_image,
+    uint64_t         seed) {
+  if (!p_state)
+    return BAD_ARGS;
+  PROPAGATE_ERROR(_AssureMinImagePrototypeIsValid(p_image));
+  PROPAGATE_ERROR(LogBitSizeOfMinType(p_image->scalar_type));
+
+  ::memset(p_state, 0, sizeof(*p_state));
+  p_state->seed = seed;
+  p_state->width = p_image->width;
+  p_state->height = p_image->height;
+  p_state->channels = p_image->channels;
+  p_state->scalar_type = p_image->scalar_type;
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int UpdateMinImageHash(
+    MinImgHashState *p_state,
+    const MinImg    *p_tile,
+    int              x0,
+    int              y0) {
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swUpdateMinImageHash, p_tile);
+
+  if (!p_state)
+    return BAD_ARGS;
+  return AddTileToMinImageHash(p_state, p_tile, x0, y0);
+}
+
+MINIMGAPI_API int MergeMinImageHash(
+    MinImgHashState       *p_dst_state,
+    const MinImgHashState *p_src_state) {
+  if (!p_dst_state || !p_src_state)
+    return BAD_ARGS;
+  if (p_dst_state->seed != p_src_state->seed ||
+      p_dst_state->width != p_src_state->width ||
+      p_dst_state->height != p_src_state->height ||
+      p_dst_state->channels != p_src_state->channels ||
+      p_dst_state->scalar_type != p_src_state->scalar_type)
+    return BAD_ARGS;
+
+  p_dst_state->sum += p_src_state->sum;
+  p_dst_state->num_pixels += p_src_state->num_pixels;
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int FinalizeMinImageHash(
+    uint64_t              *p_hash,
+    const MinImgHashState *p_state) {
+  if (!p_hash || !p_state)
+    return BAD_ARGS;
+  if (p_state->num_pixels !=
+      static_cast<int64_t>(p_state->width) * p_state->height)
+    return BAD_ARGS;
+
+  uint64_t geometry = p_state->seed + kPrime5;
+  geometry = Round(geometry, static_cast<uint64_t>(p_state->width));
+  geometry = Round(geometry, static_cast<uint64_t>(p_state->height));
+  geometry = Round(geometry, static_cast<uint64_t>(p_state->channels));
+  geometry = Round(geometry, static_cast<uint64_t>(p_state->scalar_type));
+  *p_hash = Avalanche(p_state->sum ^ Avalanche(geometry));
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int HashMinImage(
+    uint64_t     *p_hash,
+    const MinImg *p_image,
+    uint64_t      seed) {
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swHashMinImage, p_image);
+
+  if (!p_hash)
+    return BAD_ARGS;
+  MinImgHashState state;
+  PROPAGATE_ERROR(InitMinImageHash(&state, p_image, seed));
+  PROPAGATE_ERROR(AddTileToMinImageHash(&state, p_image, 0, 0));
+  return FinalizeMinImageHash(p_hash, &state);
+}
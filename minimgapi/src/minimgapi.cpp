@@ -35,6 +35,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <minimgapi/minimgapi-inl.h>
 #include <minbase/minresult.h>
+#include <minbase/minmemory.h>
 #include <minutils/smartptr.h>
 #include <minbase/crossplat.h>
 #include <minimgapi/minimgapi.h>
@@ -597,7 +598,7 @@ MINIMGAPI_API int CheckMinImagesTangle(
 
 MINIMGAPI_API int ZeroFillMinImage(
     const MinImg *p_image) {
-  MINIMGAPI_DECLARE_STOPWATCH_CTL_OLD_INTERFACE(swZeroFillMinImage);
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swZeroFillMinImage, p_image);
 
   uint8_t zero = 0;
   return FillMinImage(p_image, &zero, 1);
@@ -607,7 +608,7 @@ MINIMGAPI_API int FillMinImage(
     const MinImg *p_image,
     const void   *p_canvas,
     int           value_size) {
-  MINIMGAPI_DECLARE_STOPWATCH_CTL_OLD_INTERFACE(swFillMinImage);
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swFillMinImage, p_image);
 
   PROPAGATE_ERROR(_AssureMinImageIsValid(p_image));
   if (!p_canvas || value_size < 0)
@@ -635,6 +636,7 @@ MINIMGAPI_API int FillMinImage(
 
   switch (value_size) {
     case 0: {
+      MinMemImageTagScope scratch_tag(MMT_SCRATCH);
       PROPAGATE_ERROR(_CloneResizedMinImagePrototype(&buffer_line, p_image,
                                                      p_image->width, 1));
       p_buffer = buffer_line.p_zero_line;
@@ -747,7 +749,7 @@ MINIMGAPI_API int FillMinImage(
 MINIMGAPI_API int CopyMinImage(
     const MinImg *p_dst_image,
     const MinImg *p_src_image) {
-  MINIMGAPI_DECLARE_STOPWATCH_CTL_OLD_INTERFACE(swCopyMinImage);
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swCopyMinImage, p_src_image);
 
   PROPAGATE_ERROR(_AssureMinImageIsValid(p_dst_image));
   PROPAGATE_ERROR(_AssureMinImageIsValid(p_src_image));
@@ -774,7 +776,10 @@ MINIMGAPI_API int CopyMinImage(
     p_work_dst_image = &dst_image;
     p_work_src_image = &src_image;
   } else if (tangling == TCR_TANGLED_IMAGES) {
-    PROPAGATE_ERROR(_CloneMinImagePrototype(&tmp_image, p_src_image));
+    {
+      MinMemImageTagScope scratch_tag(MMT_SCRATCH);
+      PROPAGATE_ERROR(_CloneMinImagePrototype(&tmp_image, p_src_image));
+    }
     SHOULD_WORK(CopyMinImage(&tmp_image, p_src_image));
     p_work_src_image = &tmp_image;
   } else if (~tangling & TCR_FORWARD_PASS_POSSIBLE)
@@ -830,7 +835,7 @@ MINIMGAPI_API int CopyMinImageFragment(
     int           src_y0,
     int           width,
     int           height) {
-  MINIMGAPI_DECLARE_STOPWATCH_CTL_OLD_INTERFACE(swCopyMinImageFragment);
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swCopyMinImageFragment, p_src_image);
 
   if (_CompareMinImagePixels(p_dst_image, p_src_image))
     return BAD_ARGS;
@@ -892,7 +897,10 @@ MINIMGAPI_API int CopyMinImageFragment(
       p_dst_region = &dst_image;
       p_src_region = &src_image;
     } else {
-      PROPAGATE_ERROR(_CloneMinImagePrototype(&tmp_image, p_src_region));
+      {
+        MinMemImageTagScope scratch_tag(MMT_SCRATCH);
+        PROPAGATE_ERROR(_CloneMinImagePrototype(&tmp_image, p_src_region));
+      }
       SHOULD_WORK(CopyMinImage(&tmp_image, p_src_region));
       p_src_region = &tmp_image;
     }
@@ -978,7 +986,7 @@ MINIMGAPI_API int FlipMinImage(
     const MinImg *p_dst_image,
     const MinImg *p_src_image,
     DirectionOption direction) {
-  MINIMGAPI_DECLARE_STOPWATCH_CTL_OLD_INTERFACE(swFlipMinImage);
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swFlipMinImage, p_src_image);
 
   if (direction == DO_BOTH)
     return RotateMinImageBy90(p_dst_image, p_src_image, 2);
@@ -1236,7 +1244,7 @@ MINIMGAPI_API int RotateMinImageBy90(
     const MinImg *p_dst_image,
     const MinImg *p_src_image,
     int           num_rotations) {
-  MINIMGAPI_DECLARE_STOPWATCH_CTL_OLD_INTERFACE(swRotateMinImageBy90);
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swRotateMinImageBy90, p_src_image);
 
   num_rotations = (num_rotations % 4 + 4) % 4;
   MinImg tmp_image = {};
@@ -1267,7 +1275,7 @@ MINIMGAPI_API int InterleaveMinImages(
     const MinImg        *p_dst_image,
     const MinImg *const *p_p_src_images,
     int                  num_src_images) {
-  MINIMGAPI_DECLARE_STOPWATCH_CTL_OLD_INTERFACE(swInterleaveMinImages);
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swInterleaveMinImages, p_dst_image);
 
   if (!p_p_src_images || num_src_images <= 0)
     return BAD_ARGS;
@@ -1338,7 +1346,7 @@ MINIMGAPI_API int DeinterleaveMinImage(
     const MinImg *const *p_p_dst_images,
     const MinImg        *p_src_image,
     int                  num_dst_images) {
-  MINIMGAPI_DECLARE_STOPWATCH_CTL_OLD_INTERFACE(swDeinterleaveMinImage);
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swDeinterleaveMinImage, p_src_image);
 
   if (!p_p_dst_images || num_dst_images <= 0)
     return BAD_ARGS;
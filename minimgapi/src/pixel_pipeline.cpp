@@ -0,0 +1,70 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <atomic>
+#include <minbase/minresult.h>
+#include <minbase/crossplat.h>
+#include <minimgapi/pixel_pipeline.hpp>
+
+MIN_WARNINGS_SUPPRESSION_BEGIN
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+MIN_WARNINGS_SUPPRESSION_END
+
+
+namespace minimg {
+
+MINIMGAPI_API MinResult ParallelForLines(
+    int          height,
+    MinResult  (*p_func)(void *p_context, int begin, int end),
+    void        *p_context,
+    int          grain_size) {
+  if (!p_func || height < 0 || grain_size <= 0)
+    return MR_CONTRACT_VIOLATION;
+  if (height <= grain_size)
+    return p_func(p_context, 0, height);
+
+  std::atomic<int> result(MR_SUCCESS);
+  tbb::parallel_for(tbb::blocked_range<int>(0, height, grain_size),
+                    [&](const tbb::blocked_range<int> &range) {
+    if (result.load(std::memory_order_relaxed) != MR_SUCCESS)
+      return;
+    const MinResult range_result = p_func(p_context, range.begin(),
+                                          range.end());
+    if (range_result != MR_SUCCESS) {
+      int expected = MR_SUCCESS;
+      result.compare_exchange_strong(expected, range_result);
+    }
+  });
+  return static_cast<MinResult>(result.load());
+}
+
+} // namespace minimg
@@ -0,0 +1,243 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <cstring>
+#include <minbase/minresult.h>
+#include <minbase/crossplat.h>
+#include <minimgapi/minimgapi.h>
+#include <minimgapi/minimgapi-inl.h>
+
+
+static int GetNumPlanes(MinPlanarFormat format) {
+  switch (format) {
+    case MPF_NV12:
+    case MPF_NV21:
+      return 2;
+    case MPF_I420:
+      return 3;
+    default:
+      return BAD_ARGS;
+  }
+}
+
+static int AssureMinPlanarImageIsValid(
+    const MinPlanarImg *p_image) {
+  if (!p_image || p_image->width < 0 || p_image->height < 0)
+    return BAD_ARGS;
+  const int num_planes = GetNumPlanes(p_image->format);
+  PROPAGATE_ERROR(num_planes);
+  if (p_image->num_planes != num_planes)
+    return BAD_ARGS;
+
+  const int chroma_width = (p_image->width + 1) / 2;
+  const int chroma_height = (p_image->height + 1) / 2;
+  const int chroma_channels = num_planes == 2 ? 2 : 1;
+  for (int k = 0; k < num_planes; ++k) {
+    const MinImg &plane = p_image->planes[k];
+    PROPAGATE_ERROR(_AssureMinImageIsValid(&plane));
+    if (plane.scalar_type != p_image->planes[0].scalar_type)
+      return BAD_ARGS;
+    if (k == 0 ? plane.width != p_image->width ||
+                 plane.height != p_image->height ||
+                 plane.channels != 1
+               : plane.width != chroma_width ||
+                 plane.height != chroma_height ||
+                 plane.channels != chroma_channels)
+      return BAD_ARGS;
+  }
+  return NO_ERRORS;
+}
+
+static int CompareMinPlanarImageLayouts(
+    const MinPlanarImg *p_dst_image,
+    const MinPlanarImg *p_src_image,
+    bool                transposed) {
+  PROPAGATE_ERROR(AssureMinPlanarImageIsValid(p_dst_image));
+  PROPAGATE_ERROR(AssureMinPlanarImageIsValid(p_src_image));
+  if (p_dst_image->format != p_src_image->format ||
+      p_dst_image->planes[0].scalar_type != p_src_image->planes[0].scalar_type)
+    return BAD_ARGS;
+  if (transposed ? p_dst_image->width != p_src_image->height ||
+                   p_dst_image->height != p_src_image->width
+                 : p_dst_image->width != p_src_image->width ||
+                   p_dst_image->height != p_src_image->height)
+    return BAD_ARGS;
+  return NO_ERRORS;
+}
+
+// A chroma sample covers two columns and two lines of luma, so it cannot
+// follow an odd last column or line mirrored to the opposite side.
+static int AssureMirroredSizesAreEven(
+    const MinPlanarImg *p_image,
+    bool                lines_mirrored,
+    bool                columns_mirrored) {
+  if ((lines_mirrored && (p_image->height & 1)) ||
+      (columns_mirrored && (p_image->width & 1)))
+    return BAD_ARGS;
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int NewMinPlanarImagePrototype(
+    MinPlanarImg    *p_image,
+    int              width,
+    int              height,
+    MinPlanarFormat  format,
+    MinTyp           element_type,
+    AllocationOption allocation) {
+  if (!p_image || width < 0 || height < 0)
+    return BAD_ARGS;
+  const int num_planes = GetNumPlanes(format);
+  PROPAGATE_ERROR(num_planes);
+  for (int k = 0; k < p_image->num_planes && k < 3; ++k)
+    if (p_image->planes[k].p_zero_line)
+      return BAD_ARGS;
+
+  ::memset(p_image, 0, sizeof(*p_image));
+  p_image->format = format;
+  p_image->width = width;
+  p_image->height = height;
+  p_image->num_planes = num_planes;
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  for (int k = 0; k < num_planes; ++k) {
+    int res = k == 0
+        ? NewMinImagePrototype(&p_image->planes[k], width, height, 1,
+                               element_type, 0, allocation)
+        : NewMinImagePrototype(&p_image->planes[k], chroma_width,
+                               chroma_height, num_planes == 2 ? 2 : 1,
+                               element_type, 0, allocation);
+    if (res < 0) {
+      FreeMinPlanarImage(p_image);
+      return res;
+    }
+  }
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int FreeMinPlanarImage(
+    MinPlanarImg *p_image) {
+  if (!p_image || p_image->num_planes < 0 || p_image->num_planes > 3)
+    return BAD_ARGS;
+
+  int result = NO_ERRORS;
+  for (int k = 0; k < p_image->num_planes; ++k) {
+    const int res = FreeMinImage(&p_image->planes[k]);
+    if (res < 0)
+      result = res;
+  }
+  return result;
+}
+
+MINIMGAPI_API int GetMinPlanarImageRegion(
+    MinPlanarImg       *p_dst_image,
+    const MinPlanarImg *p_src_image,
+    int                 x0,
+    int                 y0,
+    int                 width,
+    int                 height) {
+  if (!p_dst_image || p_dst_image == p_src_image)
+    return BAD_ARGS;
+  PROPAGATE_ERROR(AssureMinPlanarImageIsValid(p_src_image));
+  if ((x0 | y0) & 1)
+    return BAD_ARGS;
+  if (width & 1 && x0 + width != p_src_image->width)
+    return BAD_ARGS;
+  if (height & 1 && y0 + height != p_src_image->height)
+    return BAD_ARGS;
+
+  MinPlanarImg region = {};
+  region.format = p_src_image->format;
+  region.width = width;
+  region.height = height;
+  region.num_planes = p_src_image->num_planes;
+  PROPAGATE_ERROR(_GetMinImageRegion(&region.planes[0],
+      &p_src_image->planes[0], x0, y0, width, height));
+  for (int k = 1; k < region.num_planes; ++k)
+    PROPAGATE_ERROR(_GetMinImageRegion(&region.planes[k],
+        &p_src_image->planes[k], x0 / 2, y0 / 2,
+        (width + 1) / 2, (height + 1) / 2));
+  *p_dst_image = region;
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int CopyMinPlanarImage(
+    const MinPlanarImg *p_dst_image,
+    const MinPlanarImg *p_src_image) {
+  PROPAGATE_ERROR(CompareMinPlanarImageLayouts(p_dst_image, p_src_image,
+                                               false));
+  for (int k = 0; k < p_src_image->num_planes; ++k)
+    PROPAGATE_ERROR(CopyMinImage(&p_dst_image->planes[k],
+                                 &p_src_image->planes[k]));
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int FlipMinPlanarImage(
+    const MinPlanarImg *p_dst_image,
+    const MinPlanarImg *p_src_image,
+    DirectionOption     direction) {
+  PROPAGATE_ERROR(CompareMinPlanarImageLayouts(p_dst_image, p_src_image,
+                                               false));
+  PROPAGATE_ERROR(AssureMirroredSizesAreEven(p_src_image,
+      direction != DO_HORIZONTAL, direction != DO_VERTICAL));
+  for (int k = 0; k < p_src_image->num_planes; ++k)
+    PROPAGATE_ERROR(FlipMinImage(&p_dst_image->planes[k],
+                                 &p_src_image->planes[k], direction));
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int TransposeMinPlanarImage(
+    const MinPlanarImg *p_dst_image,
+    const MinPlanarImg *p_src_image) {
+  PROPAGATE_ERROR(CompareMinPlanarImageLayouts(p_dst_image, p_src_image,
+                                               true));
+  for (int k = 0; k < p_src_image->num_planes; ++k)
+    PROPAGATE_ERROR(TransposeMinImage(&p_dst_image->planes[k],
+                                      &p_src_image->planes[k]));
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int RotateMinPlanarImageBy90(
+    const MinPlanarImg *p_dst_image,
+    const MinPlanarImg *p_src_image,
+    int                 num_rotations) {
+  PROPAGATE_ERROR(CompareMinPlanarImageLayouts(p_dst_image, p_src_image,
+                                               num_rotations & 1));
+  // a clockwise turn mirrors the lines, a counterclockwise one the columns
+  const int turns = (num_rotations % 4 + 4) % 4;
+  PROPAGATE_ERROR(AssureMirroredSizesAreEven(p_src_image,
+                                             turns == 1 || turns == 2,
+                                             turns == 2 || turns == 3));
+  for (int k = 0; k < p_src_image->num_planes; ++k)
+    PROPAGATE_ERROR(RotateMinImageBy90(&p_dst_image->planes[k],
+                                       &p_src_image->planes[k],
+                                       num_rotations));
+  return NO_ERRORS;
+}
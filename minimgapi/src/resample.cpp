@@ -31,9 +31,8 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <cstring>
 #include <cmath>
-#include <memory>
 #include <minbase/minresult.h>
-//#include <minutils/smartptr.h>
+#include <minutils/smartptr.h>
 #include <minbase/crossplat.h>
 #include <minimgapi/minimgapi.h>
 #include <minimgapi/minimgapi-inl.h>
@@ -76,9 +75,10 @@ static int ChunkedResampleMinImage(
 //    return NOT_IMPLEMENTED;
 
   double x_qoutient = p_src_image->width / (p_dst_image->width + 0.);
-  std::unique_ptr<int32_t[]> src_indices_by_dst_buf(
-      new (std::nothrow) int32_t[chunks_per_line]);
-  int32_t* src_indices_by_dst = src_indices_by_dst_buf.get();
+  scoped_mem_array<int32_t> src_indices_by_dst(
+      MinMemAllocArray<int32_t>(chunks_per_line, MMT_SCRATCH));
+  if (!src_indices_by_dst)
+    return NO_MEMORY;
 //  scoped_cpp_array<int> src_indices_by_dst(new int[chunks_per_line]);
   for (int dst_x = 0; dst_x < p_dst_image->width; ++dst_x) {
     int *dst_pixel = &src_indices_by_dst[dst_x * chunks_per_pixel];
@@ -132,9 +132,10 @@ static int ResampleNBytesImage(
 //    return NOT_IMPLEMENTED;
 
   double x_quotient = p_src_image->width / (p_dst_image->width + 0.);
-  std::unique_ptr<int32_t[]> src_indices_by_dst_buf(
-      new (std::nothrow) int32_t[p_dst_image->width]);
-  int32_t* src_indices_by_dst = src_indices_by_dst_buf.get();
+  scoped_mem_array<int32_t> src_indices_by_dst(
+      MinMemAllocArray<int32_t>(p_dst_image->width, MMT_SCRATCH));
+  if (!src_indices_by_dst)
+    return NO_MEMORY;
 //  scoped_cpp_array<int> src_indices_by_dst(new int[p_dst_image->width]);
   for (int dst_x = 0; dst_x < p_dst_image->width; ++dst_x) {
     int src_x = static_cast<int>((dst_x + x_phase) * x_quotient);
@@ -184,9 +185,11 @@ static int ResampleNBitsImage(
 //    return NOT_IMPLEMENTED;
 
   double x_quotient = p_src_image->width / (p_dst_image->width + 0.);
-  std::unique_ptr<int32_t[]> src_indices_by_dst_buf(
-      new (std::nothrow) int32_t[p_dst_image->width * p_dst_image->channels]);
-  int32_t* src_indices_by_dst = src_indices_by_dst_buf.get();
+  scoped_mem_array<int32_t> src_indices_by_dst(
+      MinMemAllocArray<int32_t>(p_dst_image->width * p_dst_image->channels,
+                                MMT_SCRATCH));
+  if (!src_indices_by_dst)
+    return NO_MEMORY;
 //  scoped_cpp_array<int> src_indices_by_dst(
 //                           new int[p_dst_image->width * p_dst_image->channels]);
   for (int dst_x = 0; dst_x < p_dst_image->width; ++dst_x) {
@@ -225,7 +228,7 @@ MINIMGAPI_API int ResampleMinImage(
     const MinImg *p_src_image,
     double        x_phase,
     double        y_phase) {
-  MINIMGAPI_DECLARE_STOPWATCH_CTL_OLD_INTERFACE(swResampleMinImage);
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swResampleMinImage, p_src_image);
 
   PROPAGATE_ERROR(_AssureMinImageIsValid(p_src_image));
   PROPAGATE_ERROR(_AssureMinImageIsValid(p_dst_image));
@@ -0,0 +1,154 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <vector>
+#include <algorithm>  // std::min, std::max
+#include <minbase/minresult.h>
+#include <minbase/crossplat.h>
+#include <minimgapi/minimgapi.h>
+#include <minimgapi/minimgapi-inl.h>
+
+MIN_WARNINGS_SUPPRESSION_BEGIN
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+MIN_WARNINGS_SUPPRESSION_END
+
+
+#ifdef MINIMGAPI_STOPWATCH_OLD_INTERFACE
+DECLARE_MINSTOPWATCH(swForEachMinImageTile,               "ForEachMinImageTile");
+#endif // MINIMGAPI_STOPWATCH_OLD_INTERFACE
+
+
+static int RunMinImageTile(
+    const MinImg  *p_dst_image,
+    const MinImg  *p_src_image,
+    int            tile_index,
+    int            num_tile_columns,
+    int            tile_width,
+    int            tile_height,
+    int            halo,
+    MinImgTileFunc func,
+    void          *p_context) {
+  MinImgTile tile = {};
+  tile.index = tile_index;
+  tile.x0 = (tile_index % num_tile_columns) * tile_width;
+  tile.y0 = (tile_index / num_tile_columns) * tile_height;
+  tile.width = std::min(tile_width, p_src_image->width - tile.x0);
+  tile.height = std::min(tile_height, p_src_image->height - tile.y0);
+  tile.halo_left = std::min(halo, tile.x0);
+  tile.halo_top = std::min(halo, tile.y0);
+  tile.halo_right = std::min(halo,
+      p_src_image->width - tile.x0 - tile.width);
+  tile.halo_bottom = std::min(halo,
+      p_src_image->height - tile.y0 - tile.height);
+
+  MinImg src_tile = {};
+  PROPAGATE_ERROR(_GetMinImageRegion(&src_tile, p_src_image,
+      tile.x0 - tile.halo_left, tile.y0 - tile.halo_top,
+      tile.width + tile.halo_left + tile.halo_right,
+      tile.height + tile.halo_top + tile.halo_bottom));
+  MinImg dst_tile = {};
+  if (p_dst_image)
+    PROPAGATE_ERROR(_GetMinImageRegion(&dst_tile, p_dst_image,
+        tile.x0, tile.y0, tile.width, tile.height));
+
+  return func(p_context, &dst_tile, &src_tile, &tile);
+}
+
+MINIMGAPI_API int GetMinImageTileCount(
+    int          *p_num_tiles,
+    const MinImg *p_image,
+    int           tile_width,
+    int           tile_height) {
+  if (!p_num_tiles)
+    return BAD_ARGS;
+  PROPAGATE_ERROR(_AssureMinImageIsValid(p_image));
+
+  *p_num_tiles = 0;
+  if (_AssureMinImageIsEmpty(p_image) == NO_ERRORS)
+    return NO_ERRORS;
+  if (tile_width <= 0)
+    tile_width = p_image->width;
+  if (tile_height <= 0)
+    tile_height = p_image->height;
+  const int num_tile_columns = (p_image->width + tile_width - 1) / tile_width;
+  const int num_tile_rows = (p_image->height + tile_height - 1) / tile_height;
+  *p_num_tiles = num_tile_columns * num_tile_rows;
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int ForEachMinImageTile(
+    const MinImg  *p_dst_image,
+    const MinImg  *p_src_image,
+    int            tile_width,
+    int            tile_height,
+    int            halo,
+    MinImgTileFunc func,
+    void          *p_context) {
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swForEachMinImageTile, p_src_image);
+
+  if (!func || halo < 0)
+    return BAD_ARGS;
+  PROPAGATE_ERROR(_AssureMinImageIsValid(p_src_image));
+  if (p_dst_image) {
+    PROPAGATE_ERROR(_AssureMinImageIsValid(p_dst_image));
+    if (_CompareMinImage2DSizes(p_dst_image, p_src_image))
+      return BAD_ARGS;
+  }
+
+  int num_tiles = 0;
+  PROPAGATE_ERROR(GetMinImageTileCount(&num_tiles, p_src_image,
+                                       tile_width, tile_height));
+  if (num_tiles == 0)
+    return NO_ERRORS;
+  if (tile_width <= 0)
+    tile_width = p_src_image->width;
+  if (tile_height <= 0)
+    tile_height = p_src_image->height;
+  const int num_tile_columns =
+      (p_src_image->width + tile_width - 1) / tile_width;
+
+  if (num_tiles == 1)
+    return RunMinImageTile(p_dst_image, p_src_image, 0, num_tile_columns,
+        tile_width, tile_height, halo, func, p_context);
+
+  std::vector<int> results(num_tiles, NO_ERRORS);
+  tbb::parallel_for(tbb::blocked_range<int>(0, num_tiles),
+                    [&](const tbb::blocked_range<int> &range) {
+    for (int k = range.begin(); k < range.end(); ++k)
+      results[k] = RunMinImageTile(p_dst_image, p_src_image, k,
+          num_tile_columns, tile_width, tile_height, halo, func, p_context);
+  });
+
+  for (int k = 0; k < num_tiles; ++k)
+    PROPAGATE_ERROR(results[k]);
+  return NO_ERRORS;
+}
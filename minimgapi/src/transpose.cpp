@@ -30,7 +30,9 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <cstring>
+#include <algorithm>
 #include <minbase/minresult.h>
+#include <minbase/minmemory.h>
 #include <minutils/smartptr.h>
 #include <minbase/crossplat.h>
 #include <minimgapi/minimgapi.h>
@@ -153,7 +155,12 @@ static int Transpose8BitImage(
     for (int src_y = 0; src_y < src_aligned_height; src_y += 16) {
       const uint8_t *p_src_row = p_src_buffer + src_y * src_stride;
       uint8_t *p_dst_column = p_dst_buffer + src_y;
-      for (int src_x = 0; src_x < src_aligned_width; src_x += 16)
+      int src_x = 0;
+      for (; src_x + 16 * kTransposeStripBlocks <= src_aligned_width;
+           src_x += 16 * kTransposeStripBlocks)
+        Transpose16x16Strip(p_dst_column + src_x * dst_stride, dst_stride,
+                            p_src_row + src_x, src_stride);
+      for (; src_x < src_aligned_width; src_x += 16)
         Transpose16x16(p_dst_column + src_x * dst_stride, dst_stride,
                        p_src_row + src_x, src_stride);
     }
@@ -202,57 +209,20 @@ static int Transpose8BitImage16x128Vertical(
                 const uint8_t *p_src_row2 = p_src_row + src_y * src_stride;
                 uint8_t *p_dst_column2 = p_dst_column + src_y;
 
-                MIN_PREFETCH(p_src_row2 + 16 * src_stride, 0);
-                MIN_PREFETCH(p_src_row2 + 17 * src_stride, 0);
-                Transpose16x16(p_dst_column2, dst_stride,
-                               p_src_row2, src_stride);
-                MIN_PREFETCH(p_src_row2 + 18 * src_stride, 0);
-                MIN_PREFETCH(p_src_row2 + 19 * src_stride, 0);
-                Transpose16x16(p_dst_column2 + 16 * dst_stride, dst_stride,
-                               p_src_row2 + 16, src_stride);
-                MIN_PREFETCH(p_src_row2 + 20 * src_stride, 0);
-                MIN_PREFETCH(p_src_row2 + 21 * src_stride, 0);
-                Transpose16x16(p_dst_column2 + 32 * dst_stride, dst_stride,
-                               p_src_row2 + 32, src_stride);
-                MIN_PREFETCH(p_src_row2 + 22 * src_stride, 0);
-                MIN_PREFETCH(p_src_row2 + 23 * src_stride, 0);
-                Transpose16x16(p_dst_column2 + 48 * dst_stride, dst_stride,
-                               p_src_row2 + 48, src_stride);
-                MIN_PREFETCH(p_src_row2 + 24 * src_stride, 0);
-                MIN_PREFETCH(p_src_row2 + 25 * src_stride, 0);
-                Transpose16x16(p_dst_column2 + 64 * dst_stride, dst_stride,
-                               p_src_row2 + 64, src_stride);
-                MIN_PREFETCH(p_src_row2 + 26 * src_stride, 0);
-                MIN_PREFETCH(p_src_row2 + 27 * src_stride, 0);
-                Transpose16x16(p_dst_column2 + 80 * dst_stride, dst_stride,
-                               p_src_row2 + 80, src_stride);
-                MIN_PREFETCH(p_src_row2 + 28 * src_stride, 0);
-                MIN_PREFETCH(p_src_row2 + 29 * src_stride, 0);
-                Transpose16x16(p_dst_column2 + 96 * dst_stride, dst_stride,
-                               p_src_row2 + 96, src_stride);
-                MIN_PREFETCH(p_src_row2 + 30 * src_stride, 0);
-                MIN_PREFETCH(p_src_row2 + 31 * src_stride, 0);
-                Transpose16x16(p_dst_column2 + 112 * dst_stride, dst_stride,
-                               p_src_row2 + 112, src_stride);
+                for (int x = 0; x < 128; x += 16 * kTransposeStripBlocks) {
+                    for (int k = x / 16; k < x / 16 + kTransposeStripBlocks; ++k) {
+                        MIN_PREFETCH(p_src_row2 + (16 + 2 * k) * src_stride, 0);
+                        MIN_PREFETCH(p_src_row2 + (17 + 2 * k) * src_stride, 0);
+                    }
+                    Transpose16x16Strip(p_dst_column2 + x * dst_stride, dst_stride,
+                                        p_src_row2 + x, src_stride);
+                }
             }
             const uint8_t *p_src_row2 = p_src_row + (src_aligned_height - 16) * src_stride;
             uint8_t *p_dst_column2 = p_dst_column + src_aligned_height - 16;
-            Transpose16x16(p_dst_column2, dst_stride,
-                           p_src_row2, src_stride);
-            Transpose16x16(p_dst_column2 + 16 * dst_stride, dst_stride,
-                           p_src_row2 + 16, src_stride);
-            Transpose16x16(p_dst_column2 + 32 * dst_stride, dst_stride,
-                           p_src_row2 + 32, src_stride);
-            Transpose16x16(p_dst_column2 + 48 * dst_stride, dst_stride,
-                           p_src_row2 + 48, src_stride);
-            Transpose16x16(p_dst_column2 + 64 * dst_stride, dst_stride,
-                           p_src_row2 + 64, src_stride);
-            Transpose16x16(p_dst_column2 + 80 * dst_stride, dst_stride,
-                           p_src_row2 + 80, src_stride);
-            Transpose16x16(p_dst_column2 + 96 * dst_stride, dst_stride,
-                           p_src_row2 + 96, src_stride);
-            Transpose16x16(p_dst_column2 + 112 * dst_stride, dst_stride,
-                           p_src_row2 + 112, src_stride);
+            for (int x = 0; x < 128; x += 16 * kTransposeStripBlocks)
+                Transpose16x16Strip(p_dst_column2 + x * dst_stride, dst_stride,
+                                    p_src_row2 + x, src_stride);
         }
     };
     tbb::parallel_for(tbb::blocked_range<int>(0, block_count), process_block);
@@ -355,7 +325,13 @@ static int Transpose16BitImage(
       const uint16_t *p_src_row =
         reinterpret_cast<const uint16_t *>(p_src_buffer + src_y * src_stride);
       uint8_t *p_dst_column = p_dst_buffer + src_y * 2;
-      for (int src_x = 0; src_x < src_aligned_width; src_x += 8)
+      int src_x = 0;
+      for (; src_x + 8 * kTransposeStripBlocks <= src_aligned_width;
+           src_x += 8 * kTransposeStripBlocks)
+        Transpose8x8Strip(
+          reinterpret_cast<uint16_t *>(p_dst_column + src_x * dst_stride),
+          dst_stride, p_src_row + src_x, src_stride);
+      for (; src_x < src_aligned_width; src_x += 8)
         Transpose8x8(
           reinterpret_cast<uint16_t *>(p_dst_column + src_x * dst_stride),
           dst_stride, p_src_row + src_x, src_stride);
@@ -398,7 +374,13 @@ static int Transpose32BitImage(
       const uint32_t *p_src_row =
         reinterpret_cast<const uint32_t *>(p_src_buffer + src_y * src_stride);
       uint8_t *p_dst_column = p_dst_buffer + src_y * 4;
-      for (int src_x = 0; src_x < src_aligned_width; src_x += 4)
+      int src_x = 0;
+      for (; src_x + 4 * kTransposeStripBlocks <= src_aligned_width;
+           src_x += 4 * kTransposeStripBlocks)
+        Transpose4x4Strip(
+          reinterpret_cast<uint32_t *>(p_dst_column + src_x * dst_stride),
+          dst_stride, p_src_row + src_x, src_stride);
+      for (; src_x < src_aligned_width; src_x += 4)
         Transpose4x4(
           reinterpret_cast<uint32_t *>(p_dst_column + src_x * dst_stride),
           dst_stride, p_src_row + src_x, src_stride);
@@ -488,10 +470,189 @@ static int TransposeNBitsImage(
 }
 
 
+// In-place transposition of images of whole-byte pixels. E is the pixel size
+// in bytes, or zero to take it from elem_size at run time; the memcpy calls
+// are inlined when it is known.
+template<int E>
+static int TransposeSquareImageInPlace(
+    uint8_t *p_buffer,
+    int      stride,
+    int      size,
+    int      elem_size) {
+  const size_t elem_bytes = E ? E : elem_size;
+  scoped_mem_array<uint8_t> tmp(
+      MinMemAllocArray<uint8_t>(elem_bytes, MMT_SCRATCH));
+  if (!tmp)
+    return NO_MEMORY;
+
+  // Tiles above the diagonal are swapped with their mirrors below it.
+  const int tile = 32;
+  for (int y0 = 0; y0 < size; y0 += tile)
+    for (int x0 = y0; x0 < size; x0 += tile) {
+      const int y1 = std::min(y0 + tile, size);
+      const int x1 = std::min(x0 + tile, size);
+      for (int y = y0; y < y1; ++y)
+        for (int x = std::max(x0, y + 1); x < x1; ++x) {
+          uint8_t *p_a = p_buffer + static_cast<ptrdiff_t>(y) * stride +
+                         x * elem_bytes;
+          uint8_t *p_b = p_buffer + static_cast<ptrdiff_t>(x) * stride +
+                         y * elem_bytes;
+          ::memcpy(tmp, p_a, elem_bytes);
+          ::memcpy(p_a, p_b, elem_bytes);
+          ::memcpy(p_b, tmp, elem_bytes);
+        }
+    }
+  return NO_ERRORS;
+}
+
+// The pixels of a solid image form an array of N = width * height elements,
+// and transposition moves the element at y * width + x to x * height + y. The
+// permutation is applied cycle by cycle: position j = x * height + y receives
+// the element from y * width + x. A bitset marks the positions already filled.
+template<int E>
+static int TransposeSolidImageInPlace(
+    uint8_t *p_buffer,
+    int      width,
+    int      height,
+    int      elem_size) {
+  if (width == 1 || height == 1)
+    return NO_ERRORS;  // the order of elements does not change
+  const size_t elem_bytes = E ? E : elem_size;
+  const int64_t num_elems = static_cast<int64_t>(width) * height;
+  scoped_mem_array<uint8_t> tmp(
+      MinMemAllocArray<uint8_t>(elem_bytes, MMT_SCRATCH));
+  scoped_mem_array<uint64_t> filled(
+      MinMemAllocArray<uint64_t>((num_elems + 63) / 64, MMT_SCRATCH));
+  if (!tmp || !filled)
+    return NO_MEMORY;
+  ::memset(filled, 0, (num_elems + 63) / 64 * sizeof(uint64_t));
+
+  // The first and the last elements stay in place.
+  for (int64_t start = 1; start < num_elems - 1; ++start) {
+    const uint64_t word = filled[start >> 6];
+    if (word == ~0ULL) {
+      start |= 63;
+      continue;
+    }
+    if (word >> (start & 63) & 1)
+      continue;
+
+    ::memcpy(tmp, p_buffer + start * elem_bytes, elem_bytes);
+    int64_t dst = start;
+    for (;;) {
+      filled[dst >> 6] |= 1ULL << (dst & 63);
+      const int64_t src = dst % height * width + dst / height;
+      if (src == start)
+        break;
+      ::memcpy(p_buffer + dst * elem_bytes, p_buffer + src * elem_bytes,
+               elem_bytes);
+      dst = src;
+    }
+    ::memcpy(p_buffer + dst * elem_bytes, tmp, elem_bytes);
+  }
+  return NO_ERRORS;
+}
+
+static MUSTINLINE void TransposeBlock(
+    uint8_t *p_dst, int dst_stride, const uint8_t *p_src, int src_stride) {
+  Transpose16x16(p_dst, dst_stride, p_src, src_stride);
+}
+
+static MUSTINLINE void TransposeBlock(
+    uint16_t *p_dst, int dst_stride, const uint16_t *p_src, int src_stride) {
+  Transpose8x8(p_dst, dst_stride, p_src, src_stride);
+}
+
+static MUSTINLINE void TransposeBlock(
+    uint32_t *p_dst, int dst_stride, const uint32_t *p_src, int src_stride) {
+  Transpose4x4(p_dst, dst_stride, p_src, src_stride);
+}
+
+// Square images of 1, 2 and 4-byte pixels: 16-byte wide blocks above the
+// diagonal are exchanged with their mirrors through the vector block
+// transposes and one block of scratch, and the pixels of the right and bottom
+// strips that do not fill a block are swapped one by one.
+template<typename T>
+static int TransposeSquareImageBlocksInPlace(
+    uint8_t *p_buffer,
+    int      stride,
+    int      size) {
+  const int block = 16 / sizeof(T);
+  const int block_bytes = 16;
+  const int blocked_size = size / block * block;
+  T tmp[16 / sizeof(T) * 16 / sizeof(T)];
+  for (int y = 0; y < blocked_size; y += block)
+    for (int x = y; x < blocked_size; x += block) {
+      T *p_a = reinterpret_cast<T *>(
+          p_buffer + static_cast<ptrdiff_t>(y) * stride + x * sizeof(T));
+      T *p_b = reinterpret_cast<T *>(
+          p_buffer + static_cast<ptrdiff_t>(x) * stride + y * sizeof(T));
+      TransposeBlock(tmp, block_bytes, p_a, stride);
+      if (x != y)
+        TransposeBlock(p_a, stride, p_b, stride);
+      for (int row = 0; row < block; ++row)
+        ::memcpy(ShiftPtr(p_b, row * stride), tmp + row * block, block_bytes);
+    }
+
+  for (int y = 0; y < size; ++y)
+    for (int x = std::max(blocked_size, y + 1); x < size; ++x)
+      std::swap(*reinterpret_cast<T *>(p_buffer +
+                    static_cast<ptrdiff_t>(y) * stride + x * sizeof(T)),
+                *reinterpret_cast<T *>(p_buffer +
+                    static_cast<ptrdiff_t>(x) * stride + y * sizeof(T)));
+  return NO_ERRORS;
+}
+
+// Returns NOT_IMPLEMENTED if the images do not allow in-place transposition.
+static int TransposeMinImageInPlace(
+    const MinImg *p_dst_image,
+    const MinImg *p_src_image) {
+  const int bits_per_pixel = _GetMinImageBitsPerPixel(p_src_image);
+  if (p_dst_image->p_zero_line != p_src_image->p_zero_line ||
+      bits_per_pixel & 7)
+    return NOT_IMPLEMENTED;
+  const int elem_size = bits_per_pixel >> 3;
+  uint8_t *p_buffer = p_src_image->p_zero_line;
+
+  if (p_src_image->width == p_src_image->height &&
+      p_dst_image->stride == p_src_image->stride) {
+    const int size = p_src_image->width;
+    const int stride = p_src_image->stride;
+    switch (elem_size) {
+    case 1: return TransposeSquareImageBlocksInPlace<uint8_t>(p_buffer,
+                                                              stride, size);
+    case 2: return TransposeSquareImageBlocksInPlace<uint16_t>(p_buffer,
+                                                               stride, size);
+    case 3: return TransposeSquareImageInPlace<3>(p_buffer, stride, size, 3);
+    case 4: return TransposeSquareImageBlocksInPlace<uint32_t>(p_buffer,
+                                                               stride, size);
+    case 8: return TransposeSquareImageInPlace<8>(p_buffer, stride, size, 8);
+    default:
+      return TransposeSquareImageInPlace<0>(p_buffer, stride, size, elem_size);
+    }
+  }
+
+  if (_AssureMinImageIsSolid(p_src_image) != NO_ERRORS ||
+      _AssureMinImageIsSolid(p_dst_image) != NO_ERRORS)
+    return NOT_IMPLEMENTED;
+  const int width = p_src_image->width;
+  const int height = p_src_image->height;
+  switch (elem_size) {
+  case 1: return TransposeSolidImageInPlace<1>(p_buffer, width, height, 1);
+  case 2: return TransposeSolidImageInPlace<2>(p_buffer, width, height, 2);
+  case 3: return TransposeSolidImageInPlace<3>(p_buffer, width, height, 3);
+  case 4: return TransposeSolidImageInPlace<4>(p_buffer, width, height, 4);
+  case 8: return TransposeSolidImageInPlace<8>(p_buffer, width, height, 8);
+  default:
+    return TransposeSolidImageInPlace<0>(p_buffer, width, height, elem_size);
+  }
+}
+
+
 MINIMGAPI_API int TransposeMinImage(
     const MinImg *p_dst_image,
     const MinImg *p_src_image) {
-  MINIMGAPI_DECLARE_STOPWATCH_CTL_OLD_INTERFACE(swTransposeMinImage);
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swTransposeMinImage, p_src_image);
 
 //#if defined(MINSTOPWATCH_ENABLED)
 //  DECLARE_MINSTOPWATCH_CTL(gsw_TransposeMinImage);
@@ -515,7 +676,14 @@ MINIMGAPI_API int TransposeMinImage(
   uint32_t tangling = 0;
   PROPAGATE_ERROR(CheckMinImagesTangle(&tangling, p_dst_image, p_src_image));
   if (tangling != TCR_INDEPENDENT_IMAGES) {
-    PROPAGATE_ERROR(AllocMinImage(&tmp_image));
+    const int in_place_result =
+        TransposeMinImageInPlace(p_dst_image, p_src_image);
+    if (in_place_result != NOT_IMPLEMENTED)
+      return in_place_result;
+    {
+      MinMemImageTagScope scratch_tag(MMT_SCRATCH);
+      PROPAGATE_ERROR(AllocMinImage(&tmp_image));
+    }
     PROPAGATE_ERROR(CopyMinImage(&tmp_image, p_src_image));
     p_work_src_image = &tmp_image;
   }
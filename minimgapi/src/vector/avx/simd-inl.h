@@ -0,0 +1,145 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef MINIMGAPI_SRC_VECTOR_AVX_SIMD_INL_H_INCLUDED
+#define MINIMGAPI_SRC_VECTOR_AVX_SIMD_INL_H_INCLUDED
+
+#include <immintrin.h>
+#include <minbase/crossplat.h>
+#include <minbase/mintyp.h>
+
+// AVX2 backend of the SIMD wrapper (see ../simd-inl.h): a register holds two
+// blocks, and the in-lane AVX2 instructions already treat them independently.
+struct SimdAvx2 {
+  typedef __m256i reg;
+  enum { kBlocks = 2 };
+
+  static MUSTINLINE reg Load(const void *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  }
+
+  static MUSTINLINE void Store(void *p, reg a) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), a);
+  }
+
+  static MUSTINLINE reg LoadBlocks(const void *p, int stride) {
+    const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+        reinterpret_cast<const uint8_t *>(p) + stride));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+  }
+
+  static MUSTINLINE void StoreBlocks(void *p, int stride, reg a) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p),
+                     _mm256_castsi256_si128(a));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(
+                         reinterpret_cast<uint8_t *>(p) + stride),
+                     _mm256_extracti128_si256(a, 1));
+  }
+
+  static MUSTINLINE reg Zero() { return _mm256_setzero_si256(); }
+
+  static MUSTINLINE reg SplatU16(uint16_t v) {
+    return _mm256_set1_epi16(static_cast<short>(v));
+  }
+
+  static MUSTINLINE reg And(reg a, reg b) { return _mm256_and_si256(a, b); }
+  static MUSTINLINE reg Or(reg a, reg b) { return _mm256_or_si256(a, b); }
+  static MUSTINLINE reg Xor(reg a, reg b) { return _mm256_xor_si256(a, b); }
+
+  static MUSTINLINE reg ZipLo8(reg a, reg b) { return _mm256_unpacklo_epi8(a, b); }
+  static MUSTINLINE reg ZipHi8(reg a, reg b) { return _mm256_unpackhi_epi8(a, b); }
+  static MUSTINLINE reg ZipLo16(reg a, reg b) { return _mm256_unpacklo_epi16(a, b); }
+  static MUSTINLINE reg ZipHi16(reg a, reg b) { return _mm256_unpackhi_epi16(a, b); }
+  static MUSTINLINE reg ZipLo32(reg a, reg b) { return _mm256_unpacklo_epi32(a, b); }
+  static MUSTINLINE reg ZipHi32(reg a, reg b) { return _mm256_unpackhi_epi32(a, b); }
+  static MUSTINLINE reg ZipLo64(reg a, reg b) { return _mm256_unpacklo_epi64(a, b); }
+  static MUSTINLINE reg ZipHi64(reg a, reg b) { return _mm256_unpackhi_epi64(a, b); }
+
+  template<int N> static MUSTINLINE reg ShiftBytesLeft(reg a) {
+    return _mm256_slli_si256(a, N);
+  }
+
+  template<int N> static MUSTINLINE reg ShiftBytesRight(reg a) {
+    return _mm256_srli_si256(a, N);
+  }
+
+  static MUSTINLINE reg DropEveryFourthU8(reg a) {
+    return _mm256_shuffle_epi8(a, _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+  }
+
+  static MUSTINLINE reg PackSatI16ToU8(reg a, reg b) {
+    return _mm256_packus_epi16(a, b);
+  }
+
+  static MUSTINLINE reg MinU8(reg a, reg b) { return _mm256_min_epu8(a, b); }
+  static MUSTINLINE reg MaxU8(reg a, reg b) { return _mm256_max_epu8(a, b); }
+
+  static MUSTINLINE reg AbsDiffU8(reg a, reg b) {
+    return _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a));
+  }
+
+  static MUSTINLINE reg MaxU16(reg a, reg b) { return _mm256_max_epu16(a, b); }
+
+  static MUSTINLINE reg AbsDiffU16(reg a, reg b) {
+    return _mm256_or_si256(_mm256_subs_epu16(a, b), _mm256_subs_epu16(b, a));
+  }
+
+  static MUSTINLINE reg MulLoU16(reg a, reg b) { return _mm256_mullo_epi16(a, b); }
+  static MUSTINLINE reg MulHiU16(reg a, reg b) { return _mm256_mulhi_epu16(a, b); }
+
+  static MUSTINLINE reg MulAddI16(reg a, reg b) { return _mm256_madd_epi16(a, b); }
+  static MUSTINLINE reg AddU32(reg a, reg b) { return _mm256_add_epi32(a, b); }
+  static MUSTINLINE reg AddU64(reg a, reg b) { return _mm256_add_epi64(a, b); }
+
+  static MUSTINLINE uint8_t MaxLaneU8(reg a) {
+    __m128i m = _mm_max_epu8(_mm256_castsi256_si128(a),
+                             _mm256_extracti128_si256(a, 1));
+    m = _mm_max_epu8(m, _mm_srli_si128(m, 8));
+    m = _mm_max_epu8(m, _mm_srli_si128(m, 4));
+    m = _mm_max_epu8(m, _mm_srli_si128(m, 2));
+    m = _mm_max_epu8(m, _mm_srli_si128(m, 1));
+    return static_cast<uint8_t>(_mm_cvtsi128_si32(m));
+  }
+
+  static MUSTINLINE uint64_t SumLanesU64(reg a) {
+    const __m128i s = _mm_add_epi64(_mm256_castsi256_si128(a),
+                                    _mm256_extracti128_si256(a, 1));
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), s);
+    return lanes[0] + lanes[1];
+  }
+};
+
+#endif // #ifndef MINIMGAPI_SRC_VECTOR_AVX_SIMD_INL_H_INCLUDED
@@ -0,0 +1,200 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef MINIMGAPI_SRC_VECTOR_COMPARE_INL_H_INCLUDED
+#define MINIMGAPI_SRC_VECTOR_COMPARE_INL_H_INCLUDED
+
+#include <algorithm>
+#include <minbase/crossplat.h>
+#include <minbase/mintyp.h>
+#include "simd-inl.h"
+
+// Accumulates the maximum absolute difference and the sum of squared
+// differences of two arrays of narrow (up to 16-bit) integers.
+template<typename T> static MUSTINLINE void vector_diff_max_sse(
+    uint64_t *p_max,
+    uint64_t *p_sse,
+    const T  *p_a,
+    const T  *p_b,
+    int       len) {
+  uint64_t max = *p_max;
+  uint64_t sse = 0;
+  for (int i = 0; i < len; ++i) {
+    const uint32_t d = p_a[i] > p_b[i] ?
+        static_cast<uint32_t>(p_a[i] - p_b[i]) :
+        static_cast<uint32_t>(p_b[i] - p_a[i]);
+    if (d > max)
+      max = d;
+    sse += d * d;
+  }
+  *p_max = max;
+  *p_sse += sse;
+}
+
+// Signed lanes are compared as unsigned ones after flipping their sign bits
+// with the bias (0x80 for bytes, 0x8000 for words): this keeps both the order
+// and the differences.
+template<class V> static MUSTINLINE void DiffMaxSseU8Simd(
+    uint64_t      *p_max,
+    uint64_t      *p_sse,
+    const uint8_t *p_a,
+    const uint8_t *p_b,
+    int            len,
+    uint8_t        bias = 0) {
+  typedef typename V::reg reg;
+  const int step = 16 * V::kBlocks;
+  const reg zero = V::Zero();
+  const reg vbias = V::SplatU16(static_cast<uint16_t>(bias * 0x0101));
+  reg max = zero;
+  reg sse = zero;  // two 64-bit sums per block
+  int i = 0;
+  while (i + step <= len) {
+    // 32-bit lanes get at most 2 * 2 * 255^2 per iteration, so they are
+    // flushed to the 64-bit sums every 4096 iterations.
+    const int chunk_end = i + std::min(len - i, 4096 * step) - (step - 1);
+    reg sse32 = zero;
+    for (; i < chunk_end; i += step) {
+      const reg d = V::AbsDiffU8(V::Xor(V::Load(p_a + i), vbias),
+                                 V::Xor(V::Load(p_b + i), vbias));
+      max = V::MaxU8(max, d);
+      const reg lo = V::ZipLo8(d, zero);
+      const reg hi = V::ZipHi8(d, zero);
+      sse32 = V::AddU32(sse32, V::MulAddI16(lo, lo));
+      sse32 = V::AddU32(sse32, V::MulAddI16(hi, hi));
+    }
+    sse = V::AddU64(sse, V::ZipLo32(sse32, zero));
+    sse = V::AddU64(sse, V::ZipHi32(sse32, zero));
+  }
+  uint64_t vmax = V::MaxLaneU8(max);
+  uint64_t vsse = V::SumLanesU64(sse);
+  for (; i < len; ++i) {
+    const int a = p_a[i] ^ bias, b = p_b[i] ^ bias;
+    const uint32_t d = a > b ? a - b : b - a;
+    if (d > vmax)
+      vmax = d;
+    vsse += d * d;
+  }
+  if (vmax > *p_max)
+    *p_max = vmax;
+  *p_sse += vsse;
+}
+
+// Squares of 16-bit differences take all 32 bits, so they are assembled from
+// the halves of the products and added to the 64-bit sums right away.
+template<class V> static MUSTINLINE void DiffMaxSseU16Simd(
+    uint64_t       *p_max,
+    uint64_t       *p_sse,
+    const uint16_t *p_a,
+    const uint16_t *p_b,
+    int             len,
+    uint16_t        bias = 0) {
+  typedef typename V::reg reg;
+  const int step = 8 * V::kBlocks;
+  const reg zero = V::Zero();
+  const reg vbias = V::SplatU16(bias);
+  reg max = zero;
+  reg sse = zero;  // two 64-bit sums per block
+  int i = 0;
+  for (; i + step <= len; i += step) {
+    const reg d = V::AbsDiffU16(V::Xor(V::Load(p_a + i), vbias),
+                                V::Xor(V::Load(p_b + i), vbias));
+    max = V::MaxU16(max, d);
+    const reg sq_lo = V::MulLoU16(d, d);
+    const reg sq_hi = V::MulHiU16(d, d);
+    const reg sq0 = V::ZipLo16(sq_lo, sq_hi);
+    const reg sq1 = V::ZipHi16(sq_lo, sq_hi);
+    sse = V::AddU64(sse, V::ZipLo32(sq0, zero));
+    sse = V::AddU64(sse, V::ZipHi32(sq0, zero));
+    sse = V::AddU64(sse, V::ZipLo32(sq1, zero));
+    sse = V::AddU64(sse, V::ZipHi32(sq1, zero));
+  }
+  uint16_t lanes[8 * V::kBlocks];
+  V::Store(lanes, max);
+  uint64_t vmax = *std::max_element(lanes, lanes + 8 * V::kBlocks);
+  uint64_t vsse = V::SumLanesU64(sse);
+  for (; i < len; ++i) {
+    const int a = p_a[i] ^ bias, b = p_b[i] ^ bias;
+    const uint64_t d = a > b ? a - b : b - a;
+    if (d > vmax)
+      vmax = d;
+    vsse += d * d;
+  }
+  if (vmax > *p_max)
+    *p_max = vmax;
+  *p_sse += vsse;
+}
+
+#if defined(MINIMGAPI_VECTOR_NATIVE_SIMD)
+template<> STATIC_SPECIAL MUSTINLINE void vector_diff_max_sse(
+    uint64_t      *p_max,
+    uint64_t      *p_sse,
+    const uint8_t *p_a,
+    const uint8_t *p_b,
+    int            len) {
+  DiffMaxSseU8Simd<SimdNative>(p_max, p_sse, p_a, p_b, len);
+}
+
+template<> STATIC_SPECIAL MUSTINLINE void vector_diff_max_sse(
+    uint64_t     *p_max,
+    uint64_t     *p_sse,
+    const int8_t *p_a,
+    const int8_t *p_b,
+    int           len) {
+  DiffMaxSseU8Simd<SimdNative>(p_max, p_sse,
+                               reinterpret_cast<const uint8_t *>(p_a),
+                               reinterpret_cast<const uint8_t *>(p_b),
+                               len, 0x80);
+}
+
+template<> STATIC_SPECIAL MUSTINLINE void vector_diff_max_sse(
+    uint64_t       *p_max,
+    uint64_t       *p_sse,
+    const uint16_t *p_a,
+    const uint16_t *p_b,
+    int             len) {
+  DiffMaxSseU16Simd<SimdNative>(p_max, p_sse, p_a, p_b, len);
+}
+
+template<> STATIC_SPECIAL MUSTINLINE void vector_diff_max_sse(
+    uint64_t      *p_max,
+    uint64_t      *p_sse,
+    const int16_t *p_a,
+    const int16_t *p_b,
+    int            len) {
+  DiffMaxSseU16Simd<SimdNative>(p_max, p_sse,
+                                reinterpret_cast<const uint16_t *>(p_a),
+                                reinterpret_cast<const uint16_t *>(p_b),
+                                len, 0x8000);
+}
+#endif
+
+#endif // #ifndef MINIMGAPI_SRC_VECTOR_COMPARE_INL_H_INCLUDED
@@ -35,6 +35,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <minutils/smartptr.h>
 #include <minbase/crossplat.h>
+#include "simd-inl.h"
 
 template<typename T> static MUSTINLINE void vector_deinterleave_4to3(
     T       *p_dst,
@@ -49,10 +50,45 @@ template<typename T> static MUSTINLINE void vector_deinterleave_4to3(
   }
 }
 
-#if defined(USE_SSE_SIMD)
-#include "sse/copy_channels-inl.h"
-#elif defined(USE_NEON_SIMD)
+// Sixteen 4-byte pixels per block: each block loses its fourth bytes and the
+// 12-byte remainders are joined into three full blocks. Block k of a register
+// handles the pixels from 16 * k, hence the strided loads and stores.
+template<class V> static MUSTINLINE void DeinterleaveU8x4To3Simd(
+    uint8_t       *p_dst,
+    const uint8_t *p_src,
+    int            len) {
+  typedef typename V::reg reg;
+  const int step = 16 * V::kBlocks;
+  const int effective_len = len - len % step;
+  int i = 0;
+  for (; i < effective_len; i += step, p_src += 4 * step, p_dst += 3 * step) {
+    const reg r0 = V::DropEveryFourthU8(V::LoadBlocks(p_src, 64));
+    const reg r1 = V::DropEveryFourthU8(V::LoadBlocks(p_src + 16, 64));
+    const reg r2 = V::DropEveryFourthU8(V::LoadBlocks(p_src + 32, 64));
+    const reg r3 = V::DropEveryFourthU8(V::LoadBlocks(p_src + 48, 64));
+    V::StoreBlocks(p_dst, 48, V::Or(r0, V::template ShiftBytesLeft<12>(r1)));
+    V::StoreBlocks(p_dst + 16, 48, V::Or(V::template ShiftBytesRight<4>(r1),
+                                         V::template ShiftBytesLeft<8>(r2)));
+    V::StoreBlocks(p_dst + 32, 48, V::Or(V::template ShiftBytesRight<8>(r2),
+                                         V::template ShiftBytesLeft<4>(r3)));
+  }
+  for (; i < len; ++i, p_src += 4, p_dst += 3) {
+    p_dst[0] = p_src[0];
+    p_dst[1] = p_src[1];
+    p_dst[2] = p_src[2];
+  }
+}
+
+#if defined(USE_NEON_SIMD)
+// vld4q_u8/vst3q_u8 deinterleave natively, without the byte shuffles
 #include "neon/copy_channels-inl.h"
+#elif defined(MINIMGAPI_VECTOR_NATIVE_SIMD)
+template<> STATIC_SPECIAL MUSTINLINE void vector_deinterleave_4to3(
+    uint8_t       *p_dst,
+    const uint8_t *p_src,
+    int            len) {
+  DeinterleaveU8x4To3Simd<SimdNative>(p_dst, p_src, len);
+}
 #endif
 
 #endif // #ifndef MINIMGAPI_SRC_VECTOR_COPY_CHANNELS_INL_H_INCLUDED
@@ -0,0 +1,181 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef MINIMGAPI_SRC_VECTOR_NEON_SIMD_INL_H_INCLUDED
+#define MINIMGAPI_SRC_VECTOR_NEON_SIMD_INL_H_INCLUDED
+
+#include <arm_neon.h>
+#include <minbase/crossplat.h>
+#include <minbase/mintyp.h>
+
+// NEON backend of the SIMD wrapper (see ../simd-inl.h) for ARMv7 and AArch64.
+struct SimdNeon {
+  typedef uint8x16_t reg;
+  enum { kBlocks = 1 };
+
+  static MUSTINLINE reg Load(const void *p) {
+    return vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+  }
+
+  static MUSTINLINE void Store(void *p, reg a) {
+    vst1q_u8(reinterpret_cast<uint8_t *>(p), a);
+  }
+
+  static MUSTINLINE reg LoadBlocks(const void *p, int) { return Load(p); }
+  static MUSTINLINE void StoreBlocks(void *p, int, reg a) { Store(p, a); }
+
+  static MUSTINLINE reg Zero() { return vdupq_n_u8(0); }
+
+  static MUSTINLINE reg SplatU16(uint16_t v) {
+    return vreinterpretq_u8_u16(vdupq_n_u16(v));
+  }
+
+  static MUSTINLINE reg And(reg a, reg b) { return vandq_u8(a, b); }
+  static MUSTINLINE reg Or(reg a, reg b) { return vorrq_u8(a, b); }
+  static MUSTINLINE reg Xor(reg a, reg b) { return veorq_u8(a, b); }
+
+  static MUSTINLINE reg ZipLo8(reg a, reg b) { return vzipq_u8(a, b).val[0]; }
+  static MUSTINLINE reg ZipHi8(reg a, reg b) { return vzipq_u8(a, b).val[1]; }
+  static MUSTINLINE reg ZipLo16(reg a, reg b) {
+    return vreinterpretq_u8_u16(vzipq_u16(vreinterpretq_u16_u8(a),
+                                          vreinterpretq_u16_u8(b)).val[0]);
+  }
+  static MUSTINLINE reg ZipHi16(reg a, reg b) {
+    return vreinterpretq_u8_u16(vzipq_u16(vreinterpretq_u16_u8(a),
+                                          vreinterpretq_u16_u8(b)).val[1]);
+  }
+  static MUSTINLINE reg ZipLo32(reg a, reg b) {
+    return vreinterpretq_u8_u32(vzipq_u32(vreinterpretq_u32_u8(a),
+                                          vreinterpretq_u32_u8(b)).val[0]);
+  }
+  static MUSTINLINE reg ZipHi32(reg a, reg b) {
+    return vreinterpretq_u8_u32(vzipq_u32(vreinterpretq_u32_u8(a),
+                                          vreinterpretq_u32_u8(b)).val[1]);
+  }
+  static MUSTINLINE reg ZipLo64(reg a, reg b) {
+    return vcombine_u8(vget_low_u8(a), vget_low_u8(b));
+  }
+  static MUSTINLINE reg ZipHi64(reg a, reg b) {
+    return vcombine_u8(vget_high_u8(a), vget_high_u8(b));
+  }
+
+  template<int N> static MUSTINLINE reg ShiftBytesLeft(reg a) {
+    return vextq_u8(vdupq_n_u8(0), a, 16 - N);
+  }
+
+  template<int N> static MUSTINLINE reg ShiftBytesRight(reg a) {
+    return vextq_u8(a, vdupq_n_u8(0), N);
+  }
+
+  static MUSTINLINE reg DropEveryFourthU8(reg a) {
+    // Out-of-range indices produce zeros.
+    static const uint8_t kIndices[16] = {
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 255, 255, 255, 255};
+#if defined(__aarch64__)
+    return vqtbl1q_u8(a, vld1q_u8(kIndices));
+#else
+    uint8x8x2_t table;
+    table.val[0] = vget_low_u8(a);
+    table.val[1] = vget_high_u8(a);
+    return vcombine_u8(vtbl2_u8(table, vld1_u8(kIndices)),
+                       vtbl2_u8(table, vld1_u8(kIndices + 8)));
+#endif
+  }
+
+  static MUSTINLINE reg PackSatI16ToU8(reg a, reg b) {
+    return vcombine_u8(vqmovun_s16(vreinterpretq_s16_u8(a)),
+                       vqmovun_s16(vreinterpretq_s16_u8(b)));
+  }
+
+  static MUSTINLINE reg MinU8(reg a, reg b) { return vminq_u8(a, b); }
+  static MUSTINLINE reg MaxU8(reg a, reg b) { return vmaxq_u8(a, b); }
+  static MUSTINLINE reg AbsDiffU8(reg a, reg b) { return vabdq_u8(a, b); }
+
+  static MUSTINLINE reg MaxU16(reg a, reg b) {
+    return vreinterpretq_u8_u16(vmaxq_u16(vreinterpretq_u16_u8(a),
+                                          vreinterpretq_u16_u8(b)));
+  }
+
+  static MUSTINLINE reg AbsDiffU16(reg a, reg b) {
+    return vreinterpretq_u8_u16(vabdq_u16(vreinterpretq_u16_u8(a),
+                                          vreinterpretq_u16_u8(b)));
+  }
+
+  static MUSTINLINE reg MulLoU16(reg a, reg b) {
+    return vreinterpretq_u8_u16(vmulq_u16(vreinterpretq_u16_u8(a),
+                                          vreinterpretq_u16_u8(b)));
+  }
+
+  static MUSTINLINE reg MulHiU16(reg a, reg b) {
+    const uint16x8_t a16 = vreinterpretq_u16_u8(a);
+    const uint16x8_t b16 = vreinterpretq_u16_u8(b);
+    const uint32x4_t lo = vmull_u16(vget_low_u16(a16), vget_low_u16(b16));
+    const uint32x4_t hi = vmull_u16(vget_high_u16(a16), vget_high_u16(b16));
+    return vreinterpretq_u8_u16(vcombine_u16(vshrn_n_u32(lo, 16),
+                                             vshrn_n_u32(hi, 16)));
+  }
+
+  static MUSTINLINE reg MulAddI16(reg a, reg b) {
+    const int16x8_t sa = vreinterpretq_s16_u8(a);
+    const int16x8_t sb = vreinterpretq_s16_u8(b);
+    const int32x4_t lo = vmull_s16(vget_low_s16(sa), vget_low_s16(sb));
+    const int32x4_t hi = vmull_s16(vget_high_s16(sa), vget_high_s16(sb));
+    return vreinterpretq_u8_s32(vcombine_s32(
+        vpadd_s32(vget_low_s32(lo), vget_high_s32(lo)),
+        vpadd_s32(vget_low_s32(hi), vget_high_s32(hi))));
+  }
+
+  static MUSTINLINE reg AddU32(reg a, reg b) {
+    return vreinterpretq_u8_u32(vaddq_u32(vreinterpretq_u32_u8(a),
+                                          vreinterpretq_u32_u8(b)));
+  }
+
+  static MUSTINLINE reg AddU64(reg a, reg b) {
+    return vreinterpretq_u8_u64(vaddq_u64(vreinterpretq_u64_u8(a),
+                                          vreinterpretq_u64_u8(b)));
+  }
+
+  static MUSTINLINE uint8_t MaxLaneU8(reg a) {
+    uint8x8_t m = vpmax_u8(vget_low_u8(a), vget_high_u8(a));
+    m = vpmax_u8(m, m);
+    m = vpmax_u8(m, m);
+    m = vpmax_u8(m, m);
+    return vget_lane_u8(m, 0);
+  }
+
+  static MUSTINLINE uint64_t SumLanesU64(reg a) {
+    const uint64x2_t lanes = vreinterpretq_u64_u8(a);
+    return vgetq_lane_u64(lanes, 0) + vgetq_lane_u64(lanes, 1);
+  }
+};
+
+#endif // #ifndef MINIMGAPI_SRC_VECTOR_NEON_SIMD_INL_H_INCLUDED
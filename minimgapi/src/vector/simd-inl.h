@@ -0,0 +1,328 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef MINIMGAPI_SRC_VECTOR_SIMD_INL_H_INCLUDED
+#define MINIMGAPI_SRC_VECTOR_SIMD_INL_H_INCLUDED
+
+#include <cstring>
+#include <minbase/crossplat.h>
+#include <minbase/mintyp.h>
+
+// Thin SIMD wrapper for the kernels of this directory. A backend is a struct
+// with a register type @c reg of @c kBlocks 16-byte blocks and static
+// operations on it; kernels are templates over the backend and are
+// instantiated with @c SimdNative, or with @c SimdNativeBlock when they work
+// on a single block. Lanes wider than a byte are little-endian, as on every
+// supported target, and operations never depend on the backend: @c SimdScalar
+// reproduces the vector backends bit by bit, so kernels are unit-tested
+// against it on any machine.
+//
+// Operations below Store apply to every block on its own, as the in-lane
+// AVX2 instructions do; only the reductions combine the blocks.
+//
+// Operations:
+//   Load, Store                 unaligned access to 16 * kBlocks bytes;
+//   LoadBlocks, StoreBlocks     the same with block k at p + k * stride;
+//   Zero                        all bits cleared;
+//   SplatU16                    every 16-bit lane set to a value;
+//   And, Or, Xor                bitwise logic;
+//   ZipLo{8,16,32,64}           interleave the lower halves of two registers
+//                               (a0 b0 a1 b1 ...) by lanes of given bits;
+//   ZipHi{8,16,32,64}           the same for the upper halves;
+//   ShiftBytesLeft<N>           move bytes to higher addresses by N (1..15),
+//   ShiftBytesRight<N>          or to lower ones, filling with zeros;
+//   DropEveryFourthU8           keep bytes 0-2, 4-6, 8-10, 12-14 packed into
+//                               bytes 0..11, clear bytes 12..15;
+//   PackSatI16ToU8              saturate the signed 16-bit lanes of a and b to
+//                               unsigned bytes (a first);
+//   MinU8, MaxU8, AbsDiffU8     per-byte unsigned arithmetic;
+//   MaxU16, AbsDiffU16          the same for unsigned 16-bit lanes;
+//   MulLoU16, MulHiU16          low and high halves of the 32-bit products of
+//                               unsigned 16-bit lanes;
+//   MulAddI16                   products of signed 16-bit lanes summed by
+//                               pairs into 32-bit lanes (wrapping);
+//   AddU32, AddU64              wrapping addition;
+//   MaxLaneU8, SumLanesU64      horizontal reductions.
+
+struct SimdScalar {
+  struct reg {
+    uint8_t b[16];
+  };
+  enum { kBlocks = 1 };
+
+  static MUSTINLINE reg Load(const void *p) {
+    reg r;
+    ::memcpy(r.b, p, 16);
+    return r;
+  }
+
+  static MUSTINLINE void Store(void *p, const reg &a) {
+    ::memcpy(p, a.b, 16);
+  }
+
+  static MUSTINLINE reg LoadBlocks(const void *p, int) { return Load(p); }
+  static MUSTINLINE void StoreBlocks(void *p, int, const reg &a) {
+    Store(p, a);
+  }
+
+  static MUSTINLINE reg Zero() {
+    reg r = {};
+    return r;
+  }
+
+  static MUSTINLINE reg SplatU16(uint16_t v) {
+    reg r;
+    for (int i = 0; i < 8; ++i)
+      SetLane(&r, 2, i, v);
+    return r;
+  }
+
+  static MUSTINLINE reg And(const reg &a, const reg &b) {
+    reg r;
+    for (int i = 0; i < 16; ++i)
+      r.b[i] = a.b[i] & b.b[i];
+    return r;
+  }
+
+  static MUSTINLINE reg Or(const reg &a, const reg &b) {
+    reg r;
+    for (int i = 0; i < 16; ++i)
+      r.b[i] = a.b[i] | b.b[i];
+    return r;
+  }
+
+  static MUSTINLINE reg Xor(const reg &a, const reg &b) {
+    reg r;
+    for (int i = 0; i < 16; ++i)
+      r.b[i] = a.b[i] ^ b.b[i];
+    return r;
+  }
+
+  static MUSTINLINE reg ZipLo8(const reg &a, const reg &b) {
+    return Zip(a, b, 1, 0);
+  }
+  static MUSTINLINE reg ZipHi8(const reg &a, const reg &b) {
+    return Zip(a, b, 1, 8);
+  }
+  static MUSTINLINE reg ZipLo16(const reg &a, const reg &b) {
+    return Zip(a, b, 2, 0);
+  }
+  static MUSTINLINE reg ZipHi16(const reg &a, const reg &b) {
+    return Zip(a, b, 2, 8);
+  }
+  static MUSTINLINE reg ZipLo32(const reg &a, const reg &b) {
+    return Zip(a, b, 4, 0);
+  }
+  static MUSTINLINE reg ZipHi32(const reg &a, const reg &b) {
+    return Zip(a, b, 4, 8);
+  }
+  static MUSTINLINE reg ZipLo64(const reg &a, const reg &b) {
+    return Zip(a, b, 8, 0);
+  }
+  static MUSTINLINE reg ZipHi64(const reg &a, const reg &b) {
+    return Zip(a, b, 8, 8);
+  }
+
+  template<int N> static MUSTINLINE reg ShiftBytesLeft(const reg &a) {
+    reg r = {};
+    for (int i = N; i < 16; ++i)
+      r.b[i] = a.b[i - N];
+    return r;
+  }
+
+  template<int N> static MUSTINLINE reg ShiftBytesRight(const reg &a) {
+    reg r = {};
+    for (int i = N; i < 16; ++i)
+      r.b[i - N] = a.b[i];
+    return r;
+  }
+
+  static MUSTINLINE reg DropEveryFourthU8(const reg &a) {
+    reg r = {};
+    for (int i = 0; i < 4; ++i) {
+      r.b[3 * i + 0] = a.b[4 * i + 0];
+      r.b[3 * i + 1] = a.b[4 * i + 1];
+      r.b[3 * i + 2] = a.b[4 * i + 2];
+    }
+    return r;
+  }
+
+  static MUSTINLINE reg PackSatI16ToU8(const reg &a, const reg &b) {
+    reg r;
+    for (int i = 0; i < 8; ++i) {
+      r.b[i]     = SaturateU8(static_cast<int16_t>(GetLane(a, 2, i)));
+      r.b[i + 8] = SaturateU8(static_cast<int16_t>(GetLane(b, 2, i)));
+    }
+    return r;
+  }
+
+  static MUSTINLINE reg MinU8(const reg &a, const reg &b) {
+    reg r;
+    for (int i = 0; i < 16; ++i)
+      r.b[i] = a.b[i] < b.b[i] ? a.b[i] : b.b[i];
+    return r;
+  }
+
+  static MUSTINLINE reg MaxU8(const reg &a, const reg &b) {
+    reg r;
+    for (int i = 0; i < 16; ++i)
+      r.b[i] = a.b[i] > b.b[i] ? a.b[i] : b.b[i];
+    return r;
+  }
+
+  static MUSTINLINE reg AbsDiffU8(const reg &a, const reg &b) {
+    reg r;
+    for (int i = 0; i < 16; ++i)
+      r.b[i] = static_cast<uint8_t>(a.b[i] > b.b[i] ? a.b[i] - b.b[i]
+                                                    : b.b[i] - a.b[i]);
+    return r;
+  }
+
+  static MUSTINLINE reg MaxU16(const reg &a, const reg &b) {
+    reg r;
+    for (int i = 0; i < 8; ++i) {
+      const uint64_t x = GetLane(a, 2, i), y = GetLane(b, 2, i);
+      SetLane(&r, 2, i, x > y ? x : y);
+    }
+    return r;
+  }
+
+  static MUSTINLINE reg AbsDiffU16(const reg &a, const reg &b) {
+    reg r;
+    for (int i = 0; i < 8; ++i) {
+      const uint64_t x = GetLane(a, 2, i), y = GetLane(b, 2, i);
+      SetLane(&r, 2, i, x > y ? x - y : y - x);
+    }
+    return r;
+  }
+
+  static MUSTINLINE reg MulLoU16(const reg &a, const reg &b) {
+    reg r;
+    for (int i = 0; i < 8; ++i)
+      SetLane(&r, 2, i, GetLane(a, 2, i) * GetLane(b, 2, i));
+    return r;
+  }
+
+  static MUSTINLINE reg MulHiU16(const reg &a, const reg &b) {
+    reg r;
+    for (int i = 0; i < 8; ++i)
+      SetLane(&r, 2, i, GetLane(a, 2, i) * GetLane(b, 2, i) >> 16);
+    return r;
+  }
+
+  static MUSTINLINE reg MulAddI16(const reg &a, const reg &b) {
+    reg r;
+    for (int i = 0; i < 4; ++i) {
+      const int64_t sum =
+          int64_t(int16_t(GetLane(a, 2, 2 * i))) *
+              int16_t(GetLane(b, 2, 2 * i)) +
+          int64_t(int16_t(GetLane(a, 2, 2 * i + 1))) *
+              int16_t(GetLane(b, 2, 2 * i + 1));
+      SetLane(&r, 4, i, static_cast<uint64_t>(sum));
+    }
+    return r;
+  }
+
+  static MUSTINLINE reg AddU32(const reg &a, const reg &b) {
+    reg r;
+    for (int i = 0; i < 4; ++i)
+      SetLane(&r, 4, i, GetLane(a, 4, i) + GetLane(b, 4, i));
+    return r;
+  }
+
+  static MUSTINLINE reg AddU64(const reg &a, const reg &b) {
+    reg r;
+    for (int i = 0; i < 2; ++i)
+      SetLane(&r, 8, i, GetLane(a, 8, i) + GetLane(b, 8, i));
+    return r;
+  }
+
+  static MUSTINLINE uint8_t MaxLaneU8(const reg &a) {
+    uint8_t m = 0;
+    for (int i = 0; i < 16; ++i)
+      m = a.b[i] > m ? a.b[i] : m;
+    return m;
+  }
+
+  static MUSTINLINE uint64_t SumLanesU64(const reg &a) {
+    return GetLane(a, 8, 0) + GetLane(a, 8, 1);
+  }
+
+private:
+  static MUSTINLINE uint64_t GetLane(const reg &a, int bytes, int i) {
+    uint64_t v = 0;
+    for (int k = bytes - 1; k >= 0; --k)
+      v = v << 8 | a.b[bytes * i + k];
+    return v;
+  }
+
+  static MUSTINLINE void SetLane(reg *p_r, int bytes, int i, uint64_t v) {
+    for (int k = 0; k < bytes; ++k, v >>= 8)
+      p_r->b[bytes * i + k] = static_cast<uint8_t>(v);
+  }
+
+  static MUSTINLINE reg Zip(const reg &a, const reg &b, int bytes, int from) {
+    reg r;
+    for (int i = 0; i < 8 / bytes; ++i)
+      for (int k = 0; k < bytes; ++k) {
+        r.b[2 * bytes * i + k]         = a.b[from + bytes * i + k];
+        r.b[2 * bytes * i + bytes + k] = b.b[from + bytes * i + k];
+      }
+    return r;
+  }
+
+  static MUSTINLINE uint8_t SaturateU8(int16_t v) {
+    return static_cast<uint8_t>(v < 0 ? 0 : v > 255 ? 255 : v);
+  }
+};
+
+#if defined(USE_SSE_SIMD)
+#include "sse/simd-inl.h"
+#if defined(__AVX2__)
+#include "avx/simd-inl.h"
+typedef SimdAvx2 SimdNative;
+#else
+typedef SimdSse2 SimdNative;
+#endif
+typedef SimdSse2 SimdNativeBlock;
+#define MINIMGAPI_VECTOR_NATIVE_SIMD
+#elif defined(USE_NEON_SIMD)
+#include "neon/simd-inl.h"
+typedef SimdNeon SimdNative;
+typedef SimdNeon SimdNativeBlock;
+#define MINIMGAPI_VECTOR_NATIVE_SIMD
+#else
+typedef SimdScalar SimdNative;
+typedef SimdScalar SimdNativeBlock;
+#endif
+
+#endif // #ifndef MINIMGAPI_SRC_VECTOR_SIMD_INL_H_INCLUDED
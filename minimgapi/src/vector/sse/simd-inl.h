@@ -0,0 +1,144 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef MINIMGAPI_SRC_VECTOR_SSE_SIMD_INL_H_INCLUDED
+#define MINIMGAPI_SRC_VECTOR_SSE_SIMD_INL_H_INCLUDED
+
+#include <emmintrin.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#include <minbase/crossplat.h>
+#include <minbase/mintyp.h>
+
+// SSE2 backend of the SIMD wrapper (see ../simd-inl.h). SSSE3 is used when
+// available.
+struct SimdSse2 {
+  typedef __m128i reg;
+  enum { kBlocks = 1 };
+
+  static MUSTINLINE reg Load(const void *p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  }
+
+  static MUSTINLINE void Store(void *p, reg a) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), a);
+  }
+
+  static MUSTINLINE reg LoadBlocks(const void *p, int) { return Load(p); }
+  static MUSTINLINE void StoreBlocks(void *p, int, reg a) { Store(p, a); }
+
+  static MUSTINLINE reg Zero() { return _mm_setzero_si128(); }
+
+  static MUSTINLINE reg SplatU16(uint16_t v) {
+    return _mm_set1_epi16(static_cast<short>(v));
+  }
+
+  static MUSTINLINE reg And(reg a, reg b) { return _mm_and_si128(a, b); }
+  static MUSTINLINE reg Or(reg a, reg b) { return _mm_or_si128(a, b); }
+  static MUSTINLINE reg Xor(reg a, reg b) { return _mm_xor_si128(a, b); }
+
+  static MUSTINLINE reg ZipLo8(reg a, reg b) { return _mm_unpacklo_epi8(a, b); }
+  static MUSTINLINE reg ZipHi8(reg a, reg b) { return _mm_unpackhi_epi8(a, b); }
+  static MUSTINLINE reg ZipLo16(reg a, reg b) { return _mm_unpacklo_epi16(a, b); }
+  static MUSTINLINE reg ZipHi16(reg a, reg b) { return _mm_unpackhi_epi16(a, b); }
+  static MUSTINLINE reg ZipLo32(reg a, reg b) { return _mm_unpacklo_epi32(a, b); }
+  static MUSTINLINE reg ZipHi32(reg a, reg b) { return _mm_unpackhi_epi32(a, b); }
+  static MUSTINLINE reg ZipLo64(reg a, reg b) { return _mm_unpacklo_epi64(a, b); }
+  static MUSTINLINE reg ZipHi64(reg a, reg b) { return _mm_unpackhi_epi64(a, b); }
+
+  template<int N> static MUSTINLINE reg ShiftBytesLeft(reg a) {
+    return _mm_slli_si128(a, N);
+  }
+
+  template<int N> static MUSTINLINE reg ShiftBytesRight(reg a) {
+    return _mm_srli_si128(a, N);
+  }
+
+  static MUSTINLINE reg DropEveryFourthU8(reg a) {
+#if defined(__SSSE3__)
+    return _mm_shuffle_epi8(a, _mm_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+#else
+    // Pack pairs of 24-bit pixels within 64-bit lanes, then join the lanes.
+    const reg low32 = _mm_set_epi32(0, -1, 0, -1);
+    const reg m = _mm_and_si128(a, _mm_set1_epi32(0x00FFFFFF));
+    const reg q = _mm_or_si128(_mm_and_si128(m, low32),
+                               _mm_srli_epi64(_mm_andnot_si128(low32, m), 8));
+    return _mm_or_si128(_mm_move_epi64(q),
+                        _mm_slli_si128(_mm_srli_si128(q, 8), 6));
+#endif
+  }
+
+  static MUSTINLINE reg PackSatI16ToU8(reg a, reg b) {
+    return _mm_packus_epi16(a, b);
+  }
+
+  static MUSTINLINE reg MinU8(reg a, reg b) { return _mm_min_epu8(a, b); }
+  static MUSTINLINE reg MaxU8(reg a, reg b) { return _mm_max_epu8(a, b); }
+
+  static MUSTINLINE reg AbsDiffU8(reg a, reg b) {
+    return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+  }
+
+  // SSE2 has no unsigned 16-bit maximum: a + (b - a saturated at zero).
+  static MUSTINLINE reg MaxU16(reg a, reg b) {
+    return _mm_add_epi16(a, _mm_subs_epu16(b, a));
+  }
+
+  static MUSTINLINE reg AbsDiffU16(reg a, reg b) {
+    return _mm_or_si128(_mm_subs_epu16(a, b), _mm_subs_epu16(b, a));
+  }
+
+  static MUSTINLINE reg MulLoU16(reg a, reg b) { return _mm_mullo_epi16(a, b); }
+  static MUSTINLINE reg MulHiU16(reg a, reg b) { return _mm_mulhi_epu16(a, b); }
+
+  static MUSTINLINE reg MulAddI16(reg a, reg b) { return _mm_madd_epi16(a, b); }
+  static MUSTINLINE reg AddU32(reg a, reg b) { return _mm_add_epi32(a, b); }
+  static MUSTINLINE reg AddU64(reg a, reg b) { return _mm_add_epi64(a, b); }
+
+  static MUSTINLINE uint8_t MaxLaneU8(reg a) {
+    a = _mm_max_epu8(a, _mm_srli_si128(a, 8));
+    a = _mm_max_epu8(a, _mm_srli_si128(a, 4));
+    a = _mm_max_epu8(a, _mm_srli_si128(a, 2));
+    a = _mm_max_epu8(a, _mm_srli_si128(a, 1));
+    return static_cast<uint8_t>(_mm_cvtsi128_si32(a));
+  }
+
+  static MUSTINLINE uint64_t SumLanesU64(reg a) {
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), a);
+    return lanes[0] + lanes[1];
+  }
+};
+
+#endif // #ifndef MINIMGAPI_SRC_VECTOR_SSE_SIMD_INL_H_INCLUDED
@@ -35,11 +35,124 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <minutils/smartptr.h>
 #include <minbase/crossplat.h>
+#include "simd-inl.h"
+
+// Transposes a strip of V::kBlocks square blocks of N lanes of W bytes each:
+// log2(N) rounds of interleaving row i with row i + N / 2 turn rows into
+// columns. The block at column k * N of the source rows lands in the rows
+// from k * N of the destination.
+template<class V, int W> struct SimdZip;
+template<class V> struct SimdZip<V, 1> {
+  static MUSTINLINE typename V::reg Lo(typename V::reg a, typename V::reg b) {
+    return V::ZipLo8(a, b);
+  }
+  static MUSTINLINE typename V::reg Hi(typename V::reg a, typename V::reg b) {
+    return V::ZipHi8(a, b);
+  }
+};
+template<class V> struct SimdZip<V, 2> {
+  static MUSTINLINE typename V::reg Lo(typename V::reg a, typename V::reg b) {
+    return V::ZipLo16(a, b);
+  }
+  static MUSTINLINE typename V::reg Hi(typename V::reg a, typename V::reg b) {
+    return V::ZipHi16(a, b);
+  }
+};
+template<class V> struct SimdZip<V, 4> {
+  static MUSTINLINE typename V::reg Lo(typename V::reg a, typename V::reg b) {
+    return V::ZipLo32(a, b);
+  }
+  static MUSTINLINE typename V::reg Hi(typename V::reg a, typename V::reg b) {
+    return V::ZipHi32(a, b);
+  }
+};
+
+template<class V, int W> static MUSTINLINE void TransposeBlockSimd(
+    uint8_t       *p_dst_buffer,
+    int            dst_stride,
+    const uint8_t *p_src_buffer,
+    int            src_stride) {
+  typedef typename V::reg reg;
+  const int N = 16 / W;
+  reg rows[N], zipped[N];
+  for (int i = 0; i < N; ++i)
+    rows[i] = V::Load(p_src_buffer + i * src_stride);
+  for (int round = 1; round < N; round *= 2) {
+    for (int i = 0; i < N / 2; ++i) {
+      zipped[2 * i]     = SimdZip<V, W>::Lo(rows[i], rows[i + N / 2]);
+      zipped[2 * i + 1] = SimdZip<V, W>::Hi(rows[i], rows[i + N / 2]);
+    }
+    for (int i = 0; i < N; ++i)
+      rows[i] = zipped[i];
+  }
+  for (int i = 0; i < N; ++i)
+    V::StoreBlocks(p_dst_buffer + i * dst_stride, N * dst_stride, rows[i]);
+}
+
+#if defined(MINIMGAPI_VECTOR_NATIVE_SIMD)
+
+static MUSTINLINE void Transpose16x16(
+    uint8_t       *p_dst_buffer,
+    int            dst_stride,
+    const uint8_t *p_src_buffer,
+    int            src_stride) {
+  TransposeBlockSimd<SimdNativeBlock, 1>(p_dst_buffer, dst_stride,
+                                         p_src_buffer, src_stride);
+}
+
+static MUSTINLINE void Transpose8x8(
+    uint16_t       *p_dst_buffer,
+    int             dst_stride,
+    const uint16_t *p_src_buffer,
+    int             src_stride) {
+  TransposeBlockSimd<SimdNativeBlock, 2>(
+      reinterpret_cast<uint8_t *>(p_dst_buffer), dst_stride,
+      reinterpret_cast<const uint8_t *>(p_src_buffer), src_stride);
+}
+
+static MUSTINLINE void Transpose4x4(
+    uint32_t       *p_dst_buffer,
+    int             dst_stride,
+    const uint32_t *p_src_buffer,
+    int             src_stride) {
+  TransposeBlockSimd<SimdNativeBlock, 4>(
+      reinterpret_cast<uint8_t *>(p_dst_buffer), dst_stride,
+      reinterpret_cast<const uint8_t *>(p_src_buffer), src_stride);
+}
+
+// The strip versions transpose kTransposeStripBlocks blocks that follow each
+// other in the source rows at once, e.g. 16x32 bytes with AVX2.
+static const int kTransposeStripBlocks = SimdNative::kBlocks;
+
+static MUSTINLINE void Transpose16x16Strip(
+    uint8_t       *p_dst_buffer,
+    int            dst_stride,
+    const uint8_t *p_src_buffer,
+    int            src_stride) {
+  TransposeBlockSimd<SimdNative, 1>(p_dst_buffer, dst_stride,
+                                    p_src_buffer, src_stride);
+}
+
+static MUSTINLINE void Transpose8x8Strip(
+    uint16_t       *p_dst_buffer,
+    int             dst_stride,
+    const uint16_t *p_src_buffer,
+    int             src_stride) {
+  TransposeBlockSimd<SimdNative, 2>(
+      reinterpret_cast<uint8_t *>(p_dst_buffer), dst_stride,
+      reinterpret_cast<const uint8_t *>(p_src_buffer), src_stride);
+}
+
+static MUSTINLINE void Transpose4x4Strip(
+    uint32_t       *p_dst_buffer,
+    int             dst_stride,
+    const uint32_t *p_src_buffer,
+    int             src_stride) {
+  TransposeBlockSimd<SimdNative, 4>(
+      reinterpret_cast<uint8_t *>(p_dst_buffer), dst_stride,
+      reinterpret_cast<const uint8_t *>(p_src_buffer), src_stride);
+}
 
-#if defined(USE_SSE_SIMD)
-#include "sse/transpose-inl.h"
-#elif defined(USE_NEON_SIMD)
-#include "neon/transpose-inl.h"
 #else
 
 static MUSTINLINE void Transpose16x16(
@@ -81,6 +194,32 @@ static MUSTINLINE void Transpose4x4(
   }
 }
 
+static const int kTransposeStripBlocks = 1;
+
+static MUSTINLINE void Transpose16x16Strip(
+    uint8_t       *p_dst_buffer,
+    int            dst_stride,
+    const uint8_t *p_src_buffer,
+    int            src_stride) {
+  Transpose16x16(p_dst_buffer, dst_stride, p_src_buffer, src_stride);
+}
+
+static MUSTINLINE void Transpose8x8Strip(
+    uint16_t       *p_dst_buffer,
+    int             dst_stride,
+    const uint16_t *p_src_buffer,
+    int             src_stride) {
+  Transpose8x8(p_dst_buffer, dst_stride, p_src_buffer, src_stride);
+}
+
+static MUSTINLINE void Transpose4x4Strip(
+    uint32_t       *p_dst_buffer,
+    int             dst_stride,
+    const uint32_t *p_src_buffer,
+    int             src_stride) {
+  Transpose4x4(p_dst_buffer, dst_stride, p_src_buffer, src_stride);
+}
+
 #endif
 
 #define PERMUTE_32_01_01(p_dst, dst_stride, p_src, src_stride, buf)   \
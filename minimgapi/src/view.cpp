@@ -0,0 +1,337 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <cstring>
+#include <algorithm>  // std::min
+#include <minbase/minresult.h>
+#include <minbase/crossplat.h>
+#include <minimgapi/minimgapi.h>
+#include <minimgapi/minimgapi-inl.h>
+#include <minimgapi/imgguard.hpp>
+
+
+#ifdef MINIMGAPI_STOPWATCH_OLD_INTERFACE
+DECLARE_MINSTOPWATCH(swCopyMinImageView,                  "CopyMinImageView");
+#endif // MINIMGAPI_STOPWATCH_OLD_INTERFACE
+
+
+// Size of a square destination block processed at once when view columns
+// are not adjacent in memory (transposed views), so that the touched source
+// lines stay in cache.
+static const int VIEW_GATHER_BLOCK_SIZE = 64;
+
+template <int pixel_size>
+MUSTINLINE void CopyViewPixel(
+    uint8_t       *p_dst,
+    const uint8_t *p_src,
+    int            /*size*/) {
+  ::memcpy(p_dst, p_src, pixel_size);
+}
+
+template <>
+MUSTINLINE void CopyViewPixel<0>(
+    uint8_t       *p_dst,
+    const uint8_t *p_src,
+    int            size) {
+  ::memcpy(p_dst, p_src, size);
+}
+
+template <int pixel_size>
+static void GatherViewLines(
+    uint8_t       *p_dst_line,
+    int            dst_stride,
+    const uint8_t *p_src_origin,
+    intptr_t       src_step_x,
+    intptr_t       src_step_y,
+    int            width,
+    int            height,
+    int            size) {
+  for (int y = 0; y < height; ++y) {
+    uint8_t *p_dst = p_dst_line;
+    const uint8_t *p_src = p_src_origin;
+    for (int x = 0; x < width; ++x) {
+      CopyViewPixel<pixel_size>(p_dst, p_src, size);
+      p_dst += size;
+      p_src += src_step_x;
+    }
+    p_dst_line += dst_stride;
+    p_src_origin += src_step_y;
+  }
+}
+
+template <int pixel_size>
+static void GatherView(
+    uint8_t       *p_dst_line,
+    int            dst_stride,
+    const uint8_t *p_src_origin,
+    intptr_t       src_step_x,
+    intptr_t       src_step_y,
+    int            width,
+    int            height,
+    int            size) {
+  if (std::abs(src_step_x) <= size) {
+    GatherViewLines<pixel_size>(p_dst_line, dst_stride, p_src_origin,
+        src_step_x, src_step_y, width, height, size);
+    return;
+  }
+  for (int y = 0; y < height; y += VIEW_GATHER_BLOCK_SIZE) {
+    const int block_height = std::min(VIEW_GATHER_BLOCK_SIZE, height - y);
+    for (int x = 0; x < width; x += VIEW_GATHER_BLOCK_SIZE) {
+      const int block_width = std::min(VIEW_GATHER_BLOCK_SIZE, width - x);
+      GatherViewLines<pixel_size>(
+          p_dst_line + static_cast<intptr_t>(y) * dst_stride +
+              static_cast<intptr_t>(x) * size,
+          dst_stride,
+          p_src_origin + y * src_step_y + x * src_step_x,
+          src_step_x, src_step_y, block_width, block_height, size);
+    }
+  }
+}
+
+MINIMGAPI_API int InitMinImageView(
+    MinImgView   *p_view,
+    const MinImg *p_image) {
+  if (!p_view)
+    return BAD_ARGS;
+  PROPAGATE_ERROR(_AssureMinImageIsValid(p_image));
+
+  ::memset(p_view, 0, sizeof(*p_view));
+  p_view->image = *p_image;
+  p_view->image.is_owner = 0;
+  p_view->width = p_image->width;
+  p_view->height = p_image->height;
+  p_view->channels = p_image->channels;
+  p_view->dx_x = 1;
+  p_view->dy_y = 1;
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int CropMinImageView(
+    MinImgView *p_view,
+    int         x0,
+    int         y0,
+    int         width,
+    int         height) {
+  if (!p_view || x0 < 0 || y0 < 0 || width < 0 || height < 0)
+    return BAD_ARGS;
+  if (x0 + width > p_view->width || y0 + height > p_view->height)
+    return BAD_ARGS;
+
+  p_view->x0 += x0 * p_view->dx_x + y0 * p_view->dy_x;
+  p_view->y0 += x0 * p_view->dx_y + y0 * p_view->dy_y;
+  p_view->width = width;
+  p_view->height = height;
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int FlipMinImageView(
+    MinImgView     *p_view,
+    DirectionOption direction) {
+  if (!p_view)
+    return BAD_ARGS;
+  if (direction != DO_VERTICAL && direction != DO_HORIZONTAL &&
+      direction != DO_BOTH)
+    return BAD_ARGS;
+
+  if (direction == DO_VERTICAL || direction == DO_BOTH) {
+    if (p_view->height > 0) {
+      p_view->x0 += (p_view->height - 1) * p_view->dy_x;
+      p_view->y0 += (p_view->height - 1) * p_view->dy_y;
+    }
+    p_view->dy_x = -p_view->dy_x;
+    p_view->dy_y = -p_view->dy_y;
+  }
+  if (direction == DO_HORIZONTAL || direction == DO_BOTH) {
+    if (p_view->width > 0) {
+      p_view->x0 += (p_view->width - 1) * p_view->dx_x;
+      p_view->y0 += (p_view->width - 1) * p_view->dx_y;
+    }
+    p_view->dx_x = -p_view->dx_x;
+    p_view->dx_y = -p_view->dx_y;
+  }
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int TransposeMinImageView(
+    MinImgView *p_view) {
+  if (!p_view)
+    return BAD_ARGS;
+
+  std::swap(p_view->width, p_view->height);
+  std::swap(p_view->dx_x, p_view->dy_x);
+  std::swap(p_view->dx_y, p_view->dy_y);
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int RotateMinImageViewBy90(
+    MinImgView *p_view,
+    int         num_rotations) {
+  if (!p_view)
+    return BAD_ARGS;
+
+  switch (num_rotations & 3) {
+    case 0:
+      return NO_ERRORS;
+    case 1:
+      PROPAGATE_ERROR(TransposeMinImageView(p_view));
+      return FlipMinImageView(p_view, DO_HORIZONTAL);
+    case 2:
+      return FlipMinImageView(p_view, DO_BOTH);
+    case 3:
+      PROPAGATE_ERROR(TransposeMinImageView(p_view));
+      return FlipMinImageView(p_view, DO_VERTICAL);
+    default:
+      return INTERNAL_ERROR;
+  }
+}
+
+MINIMGAPI_API int SelectMinImageViewChannels(
+    MinImgView *p_view,
+    int         channel_begin,
+    int         channels) {
+  if (!p_view || channel_begin < 0 || channels <= 0)
+    return BAD_ARGS;
+  if (channel_begin + channels > p_view->channels)
+    return BAD_ARGS;
+
+  p_view->channel_begin += channel_begin;
+  p_view->channels = channels;
+  return NO_ERRORS;
+}
+
+MINIMGAPI_API int CloneMinImageViewPrototype(
+    MinImg           *p_dst_image,
+    const MinImgView *p_view,
+    AllocationOption  allocation) {
+  if (!p_view)
+    return BAD_ARGS;
+
+  return NewMinImagePrototype(p_dst_image, p_view->width, p_view->height,
+      p_view->channels, p_view->image.scalar_type, 0, allocation);
+}
+
+MINIMGAPI_API int CopyMinImageView(
+    const MinImg     *p_dst_image,
+    const MinImgView *p_view) {
+  MINIMGAPI_DECLARE_STOPWATCH_CTL_EX_OLD_INTERFACE(swCopyMinImageView, p_dst_image);
+
+  if (!p_view)
+    return BAD_ARGS;
+  PROPAGATE_ERROR(_AssureMinImageIsValid(p_dst_image));
+  const MinImg *p_src_image = &p_view->image;
+  PROPAGATE_ERROR(_AssureMinImageIsValid(p_src_image));
+  if (p_dst_image->width != p_view->width ||
+      p_dst_image->height != p_view->height ||
+      p_dst_image->channels != p_view->channels ||
+      p_dst_image->scalar_type != p_src_image->scalar_type)
+    return BAD_ARGS;
+  if (_AssureMinImageIsEmpty(p_dst_image) == NO_ERRORS)
+    return NO_ERRORS;
+
+  const bool keeps_lines = p_view->dx_x == 1 && p_view->dx_y == 0 &&
+      p_view->dy_x == 0 && p_view->channel_begin == 0 &&
+      p_view->channels == p_src_image->channels;
+  if (keeps_lines) {
+    // the view is a region of the source image, possibly flipped vertically;
+    // this is expressible with image headers only
+    MinImg region = {};
+    const int top = p_view->dy_y > 0 ? p_view->y0 :
+                                       p_view->y0 - p_view->height + 1;
+    PROPAGATE_ERROR(_GetMinImageRegion(&region, p_src_image,
+        p_view->x0, top, p_view->width, p_view->height));
+    if (p_view->dy_y > 0)
+      return CopyMinImage(p_dst_image, &region);
+    MinImg flipped_region = {};
+    PROPAGATE_ERROR(_FlipMinImageVertically(&flipped_region, &region));
+    return CopyMinImage(p_dst_image, &flipped_region);
+  }
+
+  const int bits_per_element = _GetMinImageBitsPerPixel(p_src_image) /
+                               p_src_image->channels;
+  if (bits_per_element & 0x07)
+    return NOT_IMPLEMENTED;
+  const int element_size = bits_per_element >> 3;
+
+  uint32_t tangling = 0;
+  PROPAGATE_ERROR(CheckMinImagesTangle(&tangling, p_dst_image, p_src_image));
+  if (tangling != TCR_INDEPENDENT_IMAGES) {
+    DECLARE_GUARDED_MINIMG(tmp_image);
+    PROPAGATE_ERROR(CloneMinImagePrototype(&tmp_image, p_dst_image));
+    PROPAGATE_ERROR(CopyMinImageView(&tmp_image, p_view));
+    return CopyMinImage(p_dst_image, &tmp_image);
+  }
+
+  // check that all view corners are inside the source image
+  const int last_x = p_view->width - 1;
+  const int last_y = p_view->height - 1;
+  for (int corner = 0; corner < 4; ++corner) {
+    const int x = corner & 1 ? last_x : 0;
+    const int y = corner & 2 ? last_y : 0;
+    const int src_x = p_view->x0 + x * p_view->dx_x + y * p_view->dy_x;
+    const int src_y = p_view->y0 + x * p_view->dx_y + y * p_view->dy_y;
+    if (src_x < 0 || src_x >= p_src_image->width ||
+        src_y < 0 || src_y >= p_src_image->height)
+      return BAD_ARGS;
+  }
+
+  const intptr_t src_pixel_size =
+      static_cast<intptr_t>(element_size) * p_src_image->channels;
+  const intptr_t src_step_x = p_view->dx_x * src_pixel_size +
+      static_cast<intptr_t>(p_view->dx_y) * p_src_image->stride;
+  const intptr_t src_step_y = p_view->dy_x * src_pixel_size +
+      static_cast<intptr_t>(p_view->dy_y) * p_src_image->stride;
+  const uint8_t *p_src_origin = p_src_image->p_zero_line +
+      static_cast<intptr_t>(p_view->y0) * p_src_image->stride +
+      p_view->x0 * src_pixel_size +
+      static_cast<intptr_t>(p_view->channel_begin) * element_size;
+  const int size = element_size * p_view->channels;
+
+#define GATHER_VIEW(pixel_size)                                           \
+  GatherView<pixel_size>(p_dst_image->p_zero_line, p_dst_image->stride,   \
+      p_src_origin, src_step_x, src_step_y,                               \
+      p_view->width, p_view->height, size)
+
+  switch (size) {
+    case 1:  GATHER_VIEW(1);  break;
+    case 2:  GATHER_VIEW(2);  break;
+    case 3:  GATHER_VIEW(3);  break;
+    case 4:  GATHER_VIEW(4);  break;
+    case 6:  GATHER_VIEW(6);  break;
+    case 8:  GATHER_VIEW(8);  break;
+    case 12: GATHER_VIEW(12); break;
+    case 16: GATHER_VIEW(16); break;
+    default: GATHER_VIEW(0);  break;
+  }
+
+#undef GATHER_VIEW
+
+  return NO_ERRORS;
+}
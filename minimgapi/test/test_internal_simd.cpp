@@ -0,0 +1,324 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <minimgapi/minimgapi.h>
+#include <minimgapi/minimgapi-inl.h>
+#include "../src/vector/compare-inl.h"
+#include "../src/vector/copy_channels-inl.h"
+#include "../src/vector/transpose-inl.h"
+
+// Room for a register of any backend; the bytes past it stay zero.
+struct Bytes {
+  uint8_t b[32];
+  bool operator==(const Bytes &other) const {
+    return !::memcmp(b, other.b, sizeof(b));
+  }
+};
+
+static void PrintTo(const Bytes &bytes, std::ostream *p_os) {
+  for (int i = 0; i < 32; ++i)
+    *p_os << (i ? " " : "") << int(bytes.b[i]);
+}
+
+static Bytes RandomBytes() {
+  Bytes bytes;
+  for (int i = 0; i < 32; ++i)
+    bytes.b[i] = static_cast<uint8_t>(rand());
+  return bytes;
+}
+
+template<class V> static Bytes ToBytes(typename V::reg r) {
+  Bytes bytes = {};
+  V::Store(bytes.b, r);
+  return bytes;
+}
+
+// Applies the scalar operation op(k) to every block k of a register of V.
+template<class V, class Op> static Bytes ScalarBlocks(Op op) {
+  Bytes bytes = {};
+  for (int k = 0; k < V::kBlocks; ++k)
+    SimdScalar::Store(bytes.b + 16 * k, op(k));
+  return bytes;
+}
+
+// Runs an operation on a pair of registers with the backend V.
+#define BINARY_OP(V, op, x, y) ToBytes<V>(V::op(V::Load((x).b), V::Load((y).b)))
+#define UNARY_OP(V, op, x) ToBytes<V>(V::op(V::Load((x).b)))
+
+// The same operation of the scalar backend, block by block.
+#define SCALAR_BINARY_OP(V, op, x, y) ScalarBlocks<V>([&](int k) {    \
+    return SimdScalar::op(SimdScalar::Load((x).b + 16 * k),           \
+                          SimdScalar::Load((y).b + 16 * k)); })
+#define SCALAR_UNARY_OP(V, op, x) ScalarBlocks<V>([&](int k) {        \
+    return SimdScalar::op(SimdScalar::Load((x).b + 16 * k)); })
+
+TEST(SimdTest, ScalarSemantics) {
+  typedef SimdScalar V;
+  Bytes a, b;
+  for (int i = 0; i < 16; ++i) {
+    a.b[i] = static_cast<uint8_t>(i);
+    b.b[i] = static_cast<uint8_t>(0x80 + i);
+  }
+  const Bytes zip_lo8 = {{0, 0x80, 1, 0x81, 2, 0x82, 3, 0x83,
+                          4, 0x84, 5, 0x85, 6, 0x86, 7, 0x87}};
+  EXPECT_EQ(zip_lo8, BINARY_OP(V, ZipLo8, a, b));
+  const Bytes zip_hi32 = {{8, 9, 10, 11, 0x88, 0x89, 0x8A, 0x8B,
+                           12, 13, 14, 15, 0x8C, 0x8D, 0x8E, 0x8F}};
+  EXPECT_EQ(zip_hi32, BINARY_OP(V, ZipHi32, a, b));
+  const Bytes dropped = {{0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 0, 0, 0, 0}};
+  EXPECT_EQ(dropped, UNARY_OP(V, DropEveryFourthU8, a));
+  const Bytes shifted = {{0, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}};
+  EXPECT_EQ(shifted, ToBytes<V>(V::ShiftBytesLeft<4>(V::Load(a.b))));
+
+  // Little-endian 16-bit lanes: -2, 300, 7, -32768 x 5.
+  const Bytes words = {{0xFE, 0xFF, 0x2C, 0x01, 0x07, 0x00, 0x00, 0x80,
+                        0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80}};
+  const Bytes packed = {{0, 255, 7, 0, 0, 0, 0, 0,
+                         0, 255, 7, 0, 0, 0, 0, 0}};
+  EXPECT_EQ(packed, BINARY_OP(V, PackSatI16ToU8, words, words));
+  // 4 + 90000, 49 + 2^30, 2^31 wrapped, 2^31 wrapped.
+  const Bytes madd = {{0x94, 0x5F, 0x01, 0x00, 0x31, 0x00, 0x00, 0x40,
+                       0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x80}};
+  EXPECT_EQ(madd, BINARY_OP(V, MulAddI16, words, words));
+}
+
+template<class N> static void CheckMatchesScalar() {
+  typedef SimdScalar S;
+  for (int k = 0; k < 1000; ++k) {
+    const Bytes a = RandomBytes(), b = RandomBytes();
+    EXPECT_EQ(SCALAR_BINARY_OP(N, And, a, b), BINARY_OP(N, And, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, Or, a, b), BINARY_OP(N, Or, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, Xor, a, b), BINARY_OP(N, Xor, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, ZipLo8, a, b), BINARY_OP(N, ZipLo8, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, ZipHi8, a, b), BINARY_OP(N, ZipHi8, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, ZipLo16, a, b), BINARY_OP(N, ZipLo16, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, ZipHi16, a, b), BINARY_OP(N, ZipHi16, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, ZipLo32, a, b), BINARY_OP(N, ZipLo32, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, ZipHi32, a, b), BINARY_OP(N, ZipHi32, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, ZipLo64, a, b), BINARY_OP(N, ZipLo64, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, ZipHi64, a, b), BINARY_OP(N, ZipHi64, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, PackSatI16ToU8, a, b),
+              BINARY_OP(N, PackSatI16ToU8, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, MinU8, a, b), BINARY_OP(N, MinU8, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, MaxU8, a, b), BINARY_OP(N, MaxU8, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, AbsDiffU8, a, b),
+              BINARY_OP(N, AbsDiffU8, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, MaxU16, a, b), BINARY_OP(N, MaxU16, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, AbsDiffU16, a, b),
+              BINARY_OP(N, AbsDiffU16, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, MulLoU16, a, b),
+              BINARY_OP(N, MulLoU16, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, MulHiU16, a, b),
+              BINARY_OP(N, MulHiU16, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, MulAddI16, a, b),
+              BINARY_OP(N, MulAddI16, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, AddU32, a, b), BINARY_OP(N, AddU32, a, b));
+    EXPECT_EQ(SCALAR_BINARY_OP(N, AddU64, a, b), BINARY_OP(N, AddU64, a, b));
+    EXPECT_EQ(SCALAR_UNARY_OP(N, DropEveryFourthU8, a),
+              UNARY_OP(N, DropEveryFourthU8, a));
+    EXPECT_EQ(SCALAR_UNARY_OP(N, ShiftBytesLeft<5>, a),
+              ToBytes<N>(N::template ShiftBytesLeft<5>(N::Load(a.b))));
+    EXPECT_EQ(SCALAR_UNARY_OP(N, ShiftBytesRight<11>, a),
+              ToBytes<N>(N::template ShiftBytesRight<11>(N::Load(a.b))));
+    const uint16_t v = static_cast<uint16_t>(rand());
+    EXPECT_EQ(ScalarBlocks<N>([&](int) { return S::SplatU16(v); }),
+              ToBytes<N>(N::SplatU16(v)));
+    uint8_t max = 0;
+    uint64_t sum = 0;
+    for (int i = 0; i < N::kBlocks; ++i) {
+      max = std::max(max, S::MaxLaneU8(S::Load(a.b + 16 * i)));
+      sum += S::SumLanesU64(S::Load(a.b + 16 * i));
+    }
+    EXPECT_EQ(max, N::MaxLaneU8(N::Load(a.b)));
+    EXPECT_EQ(sum, N::SumLanesU64(N::Load(a.b)));
+
+    // Block k at 20 * k bytes.
+    uint8_t spread[52] = {}, spread_back[52] = {};
+    for (int i = 0; i < N::kBlocks; ++i)
+      ::memcpy(spread + 20 * i, a.b + 16 * i, 16);
+    N::StoreBlocks(spread_back, 20, N::LoadBlocks(spread, 20));
+    EXPECT_EQ(0, ::memcmp(spread, spread_back, sizeof(spread)));
+    EXPECT_EQ(ToBytes<N>(N::Load(a.b)),
+              ToBytes<N>(N::LoadBlocks(spread, 20)));
+  }
+}
+
+TEST(SimdTest, NativeMatchesScalar) {
+  CheckMatchesScalar<SimdNativeBlock>();
+  CheckMatchesScalar<SimdNative>();
+}
+
+template<class V, int W> static void CheckTransposeBlock() {
+  const int n = 16 / W, width = n * V::kBlocks;
+  const int src_stride = 16 * V::kBlocks + 3, dst_stride = 16 + 5;
+  std::vector<uint8_t> src(n * src_stride), dst(width * dst_stride);
+  for (size_t k = 0; k < src.size(); ++k)
+    src[k] = static_cast<uint8_t>(rand());
+  TransposeBlockSimd<V, W>(dst.data(), dst_stride, src.data(), src_stride);
+  for (int y = 0; y < width; ++y)
+    for (int x = 0; x < n; ++x)
+      ASSERT_EQ(0, ::memcmp(&dst[y * dst_stride + x * W],
+                            &src[x * src_stride + y * W], W));
+}
+
+TEST(SimdTest, TransposeBlock) {
+  CheckTransposeBlock<SimdScalar, 1>();
+  CheckTransposeBlock<SimdScalar, 2>();
+  CheckTransposeBlock<SimdScalar, 4>();
+  CheckTransposeBlock<SimdNative, 1>();
+  CheckTransposeBlock<SimdNative, 2>();
+  CheckTransposeBlock<SimdNative, 4>();
+  CheckTransposeBlock<SimdNativeBlock, 1>();
+  CheckTransposeBlock<SimdNativeBlock, 2>();
+  CheckTransposeBlock<SimdNativeBlock, 4>();
+}
+
+template<class V> static void CheckDeinterleave(int len) {
+  std::vector<uint8_t> src(4 * len), dst(3 * len + 1, 0xEE);
+  for (size_t k = 0; k < src.size(); ++k)
+    src[k] = static_cast<uint8_t>(rand());
+  DeinterleaveU8x4To3Simd<V>(dst.data(), src.data(), len);
+  for (int x = 0; x < len; ++x)
+    ASSERT_EQ(0, ::memcmp(&dst[3 * x], &src[4 * x], 3));
+  ASSERT_EQ(0xEE, dst[3 * len]);
+}
+
+TEST(SimdTest, DeinterleaveU8x4To3) {
+  for (int len : {0, 5, 16, 37, 48, 160}) {
+    CheckDeinterleave<SimdScalar>(len);
+    CheckDeinterleave<SimdNative>(len);
+  }
+}
+
+// the kernel the library dispatches to, which is native on NEON
+TEST(SimdTest, VectorDeinterleave4To3) {
+  for (int len : {0, 5, 16, 37, 160}) {
+    std::vector<uint8_t> src(4 * len), dst(3 * len + 1, 0xEE);
+    for (size_t k = 0; k < src.size(); ++k)
+      src[k] = static_cast<uint8_t>(rand());
+    vector_deinterleave_4to3(dst.data(), src.data(), len);
+    for (int x = 0; x < len; ++x)
+      ASSERT_EQ(0, ::memcmp(&dst[3 * x], &src[4 * x], 3));
+    ASSERT_EQ(0xEE, dst[3 * len]);
+  }
+}
+
+static void RunDiffKernel(bool native, uint64_t *p_max, uint64_t *p_sse,
+                          const uint8_t *p_a, const uint8_t *p_b, int len) {
+  if (native)
+    DiffMaxSseU8Simd<SimdNative>(p_max, p_sse, p_a, p_b, len);
+  else
+    DiffMaxSseU8Simd<SimdScalar>(p_max, p_sse, p_a, p_b, len);
+}
+
+static void RunDiffKernel(bool native, uint64_t *p_max, uint64_t *p_sse,
+                          const int8_t *p_a, const int8_t *p_b, int len) {
+  const uint8_t *p_ua = reinterpret_cast<const uint8_t *>(p_a);
+  const uint8_t *p_ub = reinterpret_cast<const uint8_t *>(p_b);
+  if (native)
+    DiffMaxSseU8Simd<SimdNative>(p_max, p_sse, p_ua, p_ub, len, 0x80);
+  else
+    DiffMaxSseU8Simd<SimdScalar>(p_max, p_sse, p_ua, p_ub, len, 0x80);
+}
+
+static void RunDiffKernel(bool native, uint64_t *p_max, uint64_t *p_sse,
+                          const uint16_t *p_a, const uint16_t *p_b, int len) {
+  if (native)
+    DiffMaxSseU16Simd<SimdNative>(p_max, p_sse, p_a, p_b, len);
+  else
+    DiffMaxSseU16Simd<SimdScalar>(p_max, p_sse, p_a, p_b, len);
+}
+
+static void RunDiffKernel(bool native, uint64_t *p_max, uint64_t *p_sse,
+                          const int16_t *p_a, const int16_t *p_b, int len) {
+  const uint16_t *p_ua = reinterpret_cast<const uint16_t *>(p_a);
+  const uint16_t *p_ub = reinterpret_cast<const uint16_t *>(p_b);
+  if (native)
+    DiffMaxSseU16Simd<SimdNative>(p_max, p_sse, p_ua, p_ub, len, 0x8000);
+  else
+    DiffMaxSseU16Simd<SimdScalar>(p_max, p_sse, p_ua, p_ub, len, 0x8000);
+}
+
+// Random values with the extremes of T mixed in, so that the largest
+// differences and squares are reached.
+template<typename T> static T RandomValue() {
+  switch (rand() % 4) {
+  case 0:  return std::numeric_limits<T>::min();
+  case 1:  return std::numeric_limits<T>::max();
+  default: return static_cast<T>(rand());
+  }
+}
+
+template<typename T> static void CheckDiffMaxSse(int len) {
+  std::vector<T> a(len), b(len);
+  uint64_t max = 0, sse = 0;
+  for (int k = 0; k < len; ++k) {
+    a[k] = RandomValue<T>();
+    b[k] = RandomValue<T>();
+    const int64_t d = std::abs(int64_t(a[k]) - int64_t(b[k]));
+    max = std::max(max, uint64_t(d));
+    sse += uint64_t(d * d);
+  }
+  for (bool native : {false, true}) {
+    uint64_t simd_max = 0, simd_sse = 7;
+    RunDiffKernel(native, &simd_max, &simd_sse, a.data(), b.data(), len);
+    EXPECT_EQ(max, simd_max) << "native " << native;
+    EXPECT_EQ(sse + 7, simd_sse) << "native " << native;
+  }
+  uint64_t lib_max = 0, lib_sse = 7;
+  vector_diff_max_sse(&lib_max, &lib_sse, a.data(), b.data(), len);
+  EXPECT_EQ(max, lib_max);
+  EXPECT_EQ(sse + 7, lib_sse);
+}
+
+TEST(SimdTest, DiffMaxSse) {
+  for (int len : {0, 15, 16, 31, 32, 1000, (1 << 17) + 100}) {
+    CheckDiffMaxSse<uint8_t>(len);
+    CheckDiffMaxSse<int8_t>(len);
+    CheckDiffMaxSse<uint16_t>(len);
+    CheckDiffMaxSse<int16_t>(len);
+  }
+}
+
+int main(int argc, char **argv) {
+  // This will force Visual Studio to link against minimgapi library.
+  MinImg dummy = {};
+  GetMinImageType(&dummy);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -30,10 +30,15 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 #include <minbase/minresult.h>
+#include <minbase/minmemory.h>
 #include <minimgapi/minimgapi.h>
 #include <minimgapi/minimgapi-inl.h>
 #include <minimgapi/imgguard.hpp>
+#include <minimgapi/pixel_pipeline.hpp>
 
 TEST(TestMinimgapi, TestCompareMinImages) {
   uint8_t data_a[14], data_b[15];
@@ -151,6 +156,573 @@ TEST(TestMinimgapi, TestCopyMinImageChannels43) {
 }
 
 
+TEST(TestMinimgapi, TestCopyMinImageView) {
+  DECLARE_GUARDED_MINIMG(src);
+  ASSERT_EQ(NO_ERRORS, NewMinImagePrototype(&src, 157, 93, 3, TYP_UINT16));
+  for (int y = 0; y < src.height; ++y) {
+    uint16_t *line = reinterpret_cast<uint16_t *>(GetMinImageLine(&src, y));
+    for (int x = 0; x < src.width * src.channels; ++x)
+      line[x] = static_cast<uint16_t>(rand());
+  }
+
+  for (int num_rotations = 0; num_rotations < 4; ++num_rotations) {
+    // reference: region -> rotate -> horizontal flip -> channel 1..2
+    MinImg region = {};
+    ASSERT_EQ(NO_ERRORS, GetMinImageRegion(&region, &src, 11, 5, 130, 71));
+    DECLARE_GUARDED_MINIMG(rotated);
+    if (num_rotations & 1)
+      ASSERT_EQ(NO_ERRORS, CloneTransposedMinImagePrototype(&rotated, &region));
+    else
+      ASSERT_EQ(NO_ERRORS, CloneMinImagePrototype(&rotated, &region));
+    ASSERT_EQ(NO_ERRORS, RotateMinImageBy90(&rotated, &region, num_rotations));
+    DECLARE_GUARDED_MINIMG(flipped);
+    ASSERT_EQ(NO_ERRORS, CloneMinImagePrototype(&flipped, &rotated));
+    ASSERT_EQ(NO_ERRORS, FlipMinImage(&flipped, &rotated, DO_HORIZONTAL));
+    DECLARE_GUARDED_MINIMG(expected);
+    ASSERT_EQ(NO_ERRORS, NewMinImagePrototype(&expected, flipped.width,
+                                              flipped.height, 2, TYP_UINT16));
+    const int dst_channels[] = { 0, 1 };
+    const int src_channels[] = { 1, 2 };
+    ASSERT_EQ(NO_ERRORS, CopyMinImageChannels(&expected, &flipped,
+                                              dst_channels, src_channels, 2));
+
+    MinImgView view = {};
+    ASSERT_EQ(NO_ERRORS, InitMinImageView(&view, &src));
+    ASSERT_EQ(NO_ERRORS, CropMinImageView(&view, 11, 5, 130, 71));
+    ASSERT_EQ(NO_ERRORS, RotateMinImageViewBy90(&view, num_rotations));
+    ASSERT_EQ(NO_ERRORS, FlipMinImageView(&view, DO_HORIZONTAL));
+    ASSERT_EQ(NO_ERRORS, SelectMinImageViewChannels(&view, 1, 2));
+    DECLARE_GUARDED_MINIMG(actual);
+    ASSERT_EQ(NO_ERRORS, CloneMinImageViewPrototype(&actual, &view));
+    ASSERT_EQ(NO_ERRORS, CopyMinImageView(&actual, &view));
+    EXPECT_EQ(NO_ERRORS, CompareMinImages(&expected, &actual));
+  }
+
+  MinImgView view = {};
+  ASSERT_EQ(NO_ERRORS, InitMinImageView(&view, &src));
+  EXPECT_EQ(BAD_ARGS, CropMinImageView(&view, 100, 0, 58, 10));
+  EXPECT_EQ(BAD_ARGS, SelectMinImageViewChannels(&view, 2, 2));
+}
+
+TEST(TestMinimgapi, TestPixelPipeline) {
+  DECLARE_GUARDED_MINIMG(src);
+  DECLARE_GUARDED_MINIMG(dst);
+  ASSERT_EQ(NO_ERRORS, NewMinImagePrototype(&src, 301, 77, 3, TYP_UINT16));
+  ASSERT_EQ(NO_ERRORS, NewMinImagePrototype(&dst, 301, 77, 3, TYP_UINT8));
+  for (int y = 0; y < src.height; ++y) {
+    uint16_t *line = reinterpret_cast<uint16_t *>(GetMinImageLine(&src, y));
+    for (int x = 0; x < src.width * src.channels; ++x)
+      line[x] = static_cast<uint16_t>(rand() & 0x7FF);
+  }
+
+  // dst = saturate(src * 0.25 - 3), BGR -> RGB
+  const int bgr_to_rgb[] = { 2, 1, 0 };
+  ASSERT_EQ(MR_SUCCESS, minimg::Evaluate(dst,
+      minimg::SaturateCast<uint8_t>(minimg::Swizzle(
+        minimg::Apply<BIOP_DIF>(
+          minimg::Apply<BIOP_MUL>(
+            minimg::Cast<float>(minimg::Image<uint16_t>(src)),
+            minimg::Constant(0.25f)),
+          minimg::Constant(3.f)),
+        bgr_to_rgb, 3))));
+  for (int y = 0; y < src.height; ++y) {
+    const uint16_t *p_src =
+        reinterpret_cast<const uint16_t *>(GetMinImageLine(&src, y));
+    const uint8_t *p_dst = GetMinImageLine(&dst, y);
+    for (int x = 0; x < src.width; ++x)
+      for (int c = 0; c < 3; ++c) {
+        const float value = p_src[x * 3 + 2 - c] * 0.25f - 3.f;
+        const int expected = value < 0 ? 0 : value > 255 ? 255 :
+                             static_cast<int>(std::floor(value + 0.5));
+        ASSERT_EQ(expected, p_dst[x * 3 + c]);
+      }
+  }
+
+  // mismatching type and channel count are rejected
+  EXPECT_EQ(MR_CONTRACT_VIOLATION,
+            minimg::Evaluate(dst, minimg::Image<uint16_t>(src)));
+  EXPECT_EQ(MR_CONTRACT_VIOLATION, minimg::Evaluate(dst,
+      minimg::Swizzle(minimg::Image<uint8_t>(dst), bgr_to_rgb, 2)));
+}
+
+static int BoxFilterTile(
+    void             *p_context,
+    const MinImg     *p_dst_tile,
+    const MinImg     *p_src_tile,
+    const MinImgTile *p_tile) {
+  int *p_visits = reinterpret_cast<int *>(p_context);
+  ++p_visits[p_tile->index];
+  for (int y = 0; y < p_tile->height; ++y) {
+    uint16_t *p_dst =
+        reinterpret_cast<uint16_t *>(GetMinImageLine(p_dst_tile, y));
+    for (int x = 0; x < p_tile->width; ++x) {
+      int sum = 0;
+      for (int dy = -1; dy <= 1; ++dy)
+        for (int dx = -1; dx <= 1; ++dx) {
+          const int sx = x + p_tile->halo_left + dx;
+          const int sy = y + p_tile->halo_top + dy;
+          if (sx >= 0 && sy >= 0 &&
+              sx < p_src_tile->width && sy < p_src_tile->height)
+            sum += GetMinImageLine(p_src_tile, sy)[sx];
+        }
+      p_dst[x] = static_cast<uint16_t>(sum);
+    }
+  }
+  return p_tile->index == 5 || p_tile->index == 9 ? -100 - p_tile->index
+                                                   : NO_ERRORS;
+}
+
+TEST(TestMinimgapi, TestForEachMinImageTile) {
+  DECLARE_GUARDED_MINIMG(src);
+  DECLARE_GUARDED_MINIMG(dst);
+  ASSERT_EQ(NO_ERRORS, NewMinImagePrototype(&src, 250, 130, 1, TYP_UINT8));
+  ASSERT_EQ(NO_ERRORS, NewMinImagePrototype(&dst, 250, 130, 1, TYP_UINT16));
+  for (int y = 0; y < src.height; ++y)
+    for (int x = 0; x < src.width; ++x)
+      GetMinImageLine(&src, y)[x] = static_cast<uint8_t>(rand());
+
+  int num_tiles = 0;
+  ASSERT_EQ(NO_ERRORS, GetMinImageTileCount(&num_tiles, &src, 64, 32));
+  ASSERT_EQ(4 * 5, num_tiles);
+  std::vector<int> visits(num_tiles, 0);
+  // the error of the tile with the lowest index wins regardless of scheduling
+  EXPECT_EQ(-105, ForEachMinImageTile(&dst, &src, 64, 32, 1,
+                                      BoxFilterTile, visits.data()));
+  for (int k = 0; k < num_tiles; ++k)
+    EXPECT_EQ(1, visits[k]);
+
+  for (int y = 0; y < src.height; ++y)
+    for (int x = 0; x < src.width; ++x) {
+      int sum = 0;
+      for (int sy = std::max(0, y - 1); sy <= std::min(src.height - 1, y + 1); ++sy)
+        for (int sx = std::max(0, x - 1); sx <= std::min(src.width - 1, x + 1); ++sx)
+          sum += GetMinImageLine(&src, sy)[sx];
+      ASSERT_EQ(sum, reinterpret_cast<uint16_t *>(
+                         GetMinImageLine(&dst, y))[x]);
+    }
+}
+
+TEST(TestMinimgapi, TestFillMinImageBorders) {
+  const int margin_x = 5, margin_y = 3;
+  DECLARE_GUARDED_MINIMG(image);
+  ASSERT_EQ(NO_ERRORS, NewMinImagePrototype(&image, 7, 4, 3, TYP_UINT8,
+                                            0, AO_EMPTY));
+  ASSERT_EQ(NO_ERRORS, AllocMinImageWithBorders(&image, margin_x, margin_y));
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(image.p_zero_line) & 15U);
+  for (int y = 0; y < image.height; ++y)
+    for (int x = 0; x < image.width * image.channels; ++x)
+      GetMinImageLine(&image, y)[x] = static_cast<uint8_t>(rand());
+
+  const BorderOption borders[] = { BO_REPEAT, BO_SYMMETRIC, BO_CYCLIC };
+  for (int k = 0; k < 3; ++k) {
+    ASSERT_EQ(NO_ERRORS, FillMinImageBorders(&image, margin_x, margin_y,
+                                             borders[k]));
+    for (int y = -margin_y; y < image.height + margin_y; ++y)
+      for (int x = -margin_x; x < image.width + margin_x; ++x) {
+        int sx = x, sy = y;
+        switch (borders[k]) {
+          case BO_REPEAT:
+            sx = minimg_raw::GetCoordRaw<BO_REPEAT>(x, image.width);
+            sy = minimg_raw::GetCoordRaw<BO_REPEAT>(y, image.height);
+            break;
+          case BO_SYMMETRIC:
+            sx = minimg_raw::GetCoordRaw<BO_SYMMETRIC>(x, image.width);
+            sy = minimg_raw::GetCoordRaw<BO_SYMMETRIC>(y, image.height);
+            break;
+          default:
+            sx = minimg_raw::GetCoordRaw<BO_CYCLIC>(x, image.width);
+            sy = minimg_raw::GetCoordRaw<BO_CYCLIC>(y, image.height);
+        }
+        const uint8_t *p_pixel = image.p_zero_line + y * image.stride + x * 3;
+        const uint8_t *p_expected =
+            image.p_zero_line + sy * image.stride + sx * 3;
+        ASSERT_EQ(0, ::memcmp(p_pixel, p_expected, 3)) << k << " " << x << " " << y;
+      }
+  }
+
+  const uint8_t value[] = { 1, 2, 3 };
+  ASSERT_EQ(NO_ERRORS, FillMinImageBorders(&image, margin_x, margin_y,
+                                           BO_CONSTANT, value));
+  EXPECT_EQ(0, ::memcmp(image.p_zero_line - margin_y * image.stride -
+                        margin_x * 3, value, 3));
+  EXPECT_EQ(0, ::memcmp(image.p_zero_line + image.width * 3, value, 3));
+  EXPECT_EQ(BAD_ARGS, FillMinImageBorders(&image, margin_x, margin_y + 1,
+                                          BO_REPEAT));
+  // the zero line has to stay on a pixel of the allocation to free it
+  ASSERT_EQ(NO_ERRORS, FreeMinImage(&image));
+}
+
+TEST(TestMinimgapi, TestMinPlanarImage) {
+  MinPlanarImg src = {};
+  ASSERT_EQ(NO_ERRORS, NewMinPlanarImagePrototype(&src, 9, 6, MPF_NV12));
+  ASSERT_EQ(2, src.num_planes);
+  EXPECT_EQ(5, src.planes[1].width);
+  EXPECT_EQ(3, src.planes[1].height);
+  EXPECT_EQ(2, src.planes[1].channels);
+  for (int k = 0; k < src.num_planes; ++k)
+    for (int y = 0; y < src.planes[k].height; ++y)
+      for (int x = 0; x < src.planes[k].width * src.planes[k].channels; ++x)
+        GetMinImageLine(&src.planes[k], y)[x] = static_cast<uint8_t>(rand());
+
+  MinPlanarImg region = {};
+  EXPECT_EQ(BAD_ARGS, GetMinPlanarImageRegion(&region, &src, 1, 2, 4, 4));
+  EXPECT_EQ(BAD_ARGS, GetMinPlanarImageRegion(&region, &src, 2, 2, 4, 3));
+  ASSERT_EQ(NO_ERRORS, GetMinPlanarImageRegion(&region, &src, 2, 2, 7, 4));
+  EXPECT_EQ(4, region.planes[1].width);
+  EXPECT_EQ(2, region.planes[1].height);
+  EXPECT_EQ(GetMinImageLine(&src.planes[1], 1) + 2, region.planes[1].p_zero_line);
+
+  MinPlanarImg rotated = {};
+  ASSERT_EQ(NO_ERRORS, NewMinPlanarImagePrototype(&rotated, 4, 7, MPF_NV12));
+  EXPECT_EQ(BAD_ARGS, RotateMinPlanarImageBy90(&rotated, &region, 2));
+  ASSERT_EQ(NO_ERRORS, RotateMinPlanarImageBy90(&rotated, &region, 1));
+  MinPlanarImg restored = {};
+  ASSERT_EQ(NO_ERRORS, NewMinPlanarImagePrototype(&restored, 7, 4, MPF_NV12));
+  ASSERT_EQ(NO_ERRORS, RotateMinPlanarImageBy90(&restored, &rotated, 3));
+  for (int k = 0; k < region.num_planes; ++k)
+    EXPECT_EQ(NO_ERRORS, CompareMinImages(&region.planes[k],
+                                          &restored.planes[k]));
+
+  // Every pixel has to keep both its luma and its chroma. The chroma of an odd
+  // column or line cannot follow it to the opposite side, so only the even
+  // sizes can be mirrored.
+  const MinImg &src_y = region.planes[0], &src_uv = region.planes[1];
+  MinPlanarImg flipped = {};
+  ASSERT_EQ(NO_ERRORS, NewMinPlanarImagePrototype(&flipped, 7, 4, MPF_NV12));
+  EXPECT_EQ(BAD_ARGS, FlipMinPlanarImage(&flipped, &region, DO_HORIZONTAL));
+  EXPECT_EQ(BAD_ARGS, FlipMinPlanarImage(&flipped, &region, DO_BOTH));
+  ASSERT_EQ(NO_ERRORS, FlipMinPlanarImage(&flipped, &region, DO_VERTICAL));
+  for (int y = 0; y < 4; ++y)
+    for (int x = 0; x < 7; ++x) {
+      const int sx = x, sy = 3 - y;
+      ASSERT_EQ(GetMinImageLine(&src_y, sy)[sx],
+                GetMinImageLine(&flipped.planes[0], y)[x]) << x << " " << y;
+      ASSERT_EQ(0, ::memcmp(GetMinImageLine(&src_uv, sy / 2) + sx / 2 * 2,
+                            GetMinImageLine(&flipped.planes[1], y / 2) +
+                                x / 2 * 2, 2)) << x << " " << y;
+    }
+  EXPECT_EQ(BAD_ARGS, RotateMinPlanarImageBy90(&rotated, &region, 3));
+  for (int y = 0; y < 7; ++y)
+    for (int x = 0; x < 4; ++x) {
+      const int sx = y, sy = 3 - x;  // clockwise
+      ASSERT_EQ(GetMinImageLine(&src_y, sy)[sx],
+                GetMinImageLine(&rotated.planes[0], y)[x]) << x << " " << y;
+      ASSERT_EQ(0, ::memcmp(GetMinImageLine(&src_uv, sy / 2) + sx / 2 * 2,
+                            GetMinImageLine(&rotated.planes[1], y / 2) +
+                                x / 2 * 2, 2)) << x << " " << y;
+    }
+
+  EXPECT_EQ(NO_ERRORS, FreeMinPlanarImage(&flipped));
+  EXPECT_EQ(NO_ERRORS, FreeMinPlanarImage(&restored));
+  EXPECT_EQ(NO_ERRORS, FreeMinPlanarImage(&rotated));
+  EXPECT_EQ(NO_ERRORS, FreeMinPlanarImage(&src));
+}
+
+TEST(TestMinimgapi, TestMemoryAccounting) {
+  MinMemResetStats();
+  MinMemStats before = {};
+  ASSERT_EQ(NO_ERRORS, MinMemGetStats(&before, MMT_IMAGE, 1));
+  MinMemStats stats = {};
+  MinImg image = {};
+  ASSERT_EQ(NO_ERRORS, NewMinImagePrototype(&image, 64, 64, 1, TYP_UINT8));
+  ASSERT_EQ(NO_ERRORS, MinMemGetStats(&stats, MMT_IMAGE, 1));
+  EXPECT_LE(before.current_bytes + 64 * 64, stats.current_bytes);
+
+  // Transposing overlapping regions goes through a temporary copy of the
+  // source, while a square image is transposed in place without one.
+  MinImg src_region = {}, dst_region = {};
+  ASSERT_EQ(NO_ERRORS, GetMinImageRegion(&src_region, &image, 0, 0, 63, 63));
+  ASSERT_EQ(NO_ERRORS, GetMinImageRegion(&dst_region, &image, 1, 0, 63, 63));
+  ASSERT_EQ(NO_ERRORS, TransposeMinImage(&dst_region, &src_region));
+  ASSERT_EQ(NO_ERRORS, MinMemGetStats(&stats, MMT_SCRATCH, 1));
+  EXPECT_EQ(0, stats.current_bytes);
+  EXPECT_LE(63 * 63, stats.peak_bytes);
+  MinMemResetStats();
+  ASSERT_EQ(NO_ERRORS, TransposeMinImage(&image, &image));
+  ASSERT_EQ(NO_ERRORS, MinMemGetStats(&stats, MMT_SCRATCH, 1));
+  EXPECT_GT(64, stats.peak_bytes);
+
+  MinMemStats total = {};
+  ASSERT_EQ(NO_ERRORS, MinMemGetStats(&total, MMT_TOTAL, 0));
+  MinMemSetBudget(total.current_bytes + 1024);
+  MinImg big = {};
+  EXPECT_EQ(NO_MEMORY, NewMinImagePrototype(&big, 64, 64, 1, TYP_UINT8));
+  EXPECT_EQ(NO_MEMORY, TransposeMinImage(&dst_region, &src_region));
+  EXPECT_EQ(NO_ERRORS, TransposeMinImage(&image, &image));
+  MinMemSetBudget(0);
+  ASSERT_EQ(NO_ERRORS, MinMemGetStats(&stats, MMT_TOTAL, 1));
+  EXPECT_EQ(2, stats.failed_count);
+
+  EXPECT_EQ(NO_ERRORS, FreeMinImage(&image));
+  ASSERT_EQ(NO_ERRORS, MinMemGetStats(&stats, MMT_IMAGE, 1));
+  EXPECT_EQ(before.current_bytes, stats.current_bytes);
+}
+
+struct HashTilesContext {
+  std::vector<MinImgHashState> states;
+};
+
+static int HashTile(
+    void             *p_context,
+    const MinImg     * /*p_dst_tile*/,
+    const MinImg     *p_src_tile,
+    const MinImgTile *p_tile) {
+  HashTilesContext &context = *static_cast<HashTilesContext *>(p_context);
+  return UpdateMinImageHash(&context.states[p_tile->index], p_src_tile,
+                            p_tile->x0, p_tile->y0);
+}
+
+TEST(TestMinimgapi, TestHashMinImage) {
+  const int width = 100, height = 37, channels = 3;
+  std::vector<uint8_t> packed(width * channels * height);
+  std::vector<uint8_t> padded((width * channels + 13) * height);
+  for (size_t k = 0; k < padded.size(); ++k)
+    padded[k] = static_cast<uint8_t>(rand());
+  MinImg image = {}, padded_image = {};
+  ASSERT_EQ(NO_ERRORS, WrapAlignedBufferWithMinImage(&image, packed.data(),
+      width, height, channels, TYP_UINT8, width * channels));
+  ASSERT_EQ(NO_ERRORS, WrapAlignedBufferWithMinImage(&padded_image,
+      padded.data(), width, height, channels, TYP_UINT8,
+      width * channels + 13));
+  ASSERT_EQ(NO_ERRORS, CopyMinImage(&image, &padded_image));
+
+  uint64_t hash = 0, padded_hash = 0, other_hash = 0;
+  ASSERT_EQ(NO_ERRORS, HashMinImage(&hash, &image));
+  ASSERT_EQ(NO_ERRORS, HashMinImage(&padded_hash, &padded_image));
+  EXPECT_EQ(hash, padded_hash);
+  ASSERT_EQ(NO_ERRORS, HashMinImage(&other_hash, &image, 1));
+  EXPECT_NE(hash, other_hash);
+
+  // Negative stride view against a flipped copy.
+  MinImg flipped_view = {};
+  ASSERT_EQ(NO_ERRORS, FlipMinImageVertically(&flipped_view, &image));
+  DECLARE_GUARDED_MINIMG(flipped);
+  ASSERT_EQ(NO_ERRORS, CloneMinImagePrototype(&flipped, &image));
+  ASSERT_EQ(NO_ERRORS, FlipMinImage(&flipped, &image, DO_VERTICAL));
+  ASSERT_EQ(NO_ERRORS, HashMinImage(&hash, &flipped));
+  ASSERT_EQ(NO_ERRORS, HashMinImage(&other_hash, &flipped_view));
+  EXPECT_EQ(hash, other_hash);
+
+  GetMinImageLine(&flipped, 20)[7] ^= 1;
+  ASSERT_EQ(NO_ERRORS, HashMinImage(&other_hash, &flipped));
+  EXPECT_NE(hash, other_hash);
+
+  // Unused bits of the last byte of 1-bit lines are ignored.
+  uint8_t bits[2 * 3] = {0xA5, 0xF0, 0, 0x3C, 0x08, 0};
+  MinImg bit_image = {};
+  ASSERT_EQ(NO_ERRORS, NewMinImagePrototype(&bit_image, 13, 2, 1, TYP_UINT1,
+                                            0, AO_EMPTY));
+  bit_image.stride = 3;
+  bit_image.p_zero_line = bits;
+  ASSERT_EQ(NO_ERRORS, HashMinImage(&hash, &bit_image));
+  bits[1] |= 0x07;
+  bits[2] = 0xFF;
+  bits[4] |= 0x01;
+  ASSERT_EQ(NO_ERRORS, HashMinImage(&other_hash, &bit_image));
+  EXPECT_EQ(hash, other_hash);
+  bits[4] |= 0x10;
+  ASSERT_EQ(NO_ERRORS, HashMinImage(&other_hash, &bit_image));
+  EXPECT_NE(hash, other_hash);
+}
+
+TEST(TestMinimgapi, TestHashMinImageIncremental) {
+  DECLARE_GUARDED_MINIMG(image);
+  ASSERT_EQ(NO_ERRORS, NewMinImagePrototype(&image, 1500, 900, 1, TYP_UINT8));
+  for (int y = 0; y < image.height; ++y)
+    for (int x = 0; x < image.width; ++x)
+      GetMinImageLine(&image, y)[x] = static_cast<uint8_t>(rand());
+  uint64_t hash = 0, tiled_hash = 0;
+  ASSERT_EQ(NO_ERRORS, HashMinImage(&hash, &image));
+
+  int num_tiles = 0;
+  ASSERT_EQ(NO_ERRORS, GetMinImageTileCount(&num_tiles, &image, 128, 100));
+  HashTilesContext context;
+  context.states.resize(num_tiles);
+  for (int k = 0; k < num_tiles; ++k)
+    ASSERT_EQ(NO_ERRORS, InitMinImageHash(&context.states[k], &image));
+  ASSERT_EQ(NO_ERRORS, ForEachMinImageTile(nullptr, &image, 128, 100, 0,
+                                           HashTile, &context));
+  MinImgHashState state = {};
+  ASSERT_EQ(NO_ERRORS, InitMinImageHash(&state, &image));
+  for (int k = num_tiles - 1; k >= 0; --k)
+    ASSERT_EQ(NO_ERRORS, MergeMinImageHash(&state, &context.states[k]));
+  ASSERT_EQ(NO_ERRORS, FinalizeMinImageHash(&tiled_hash, &state));
+  EXPECT_EQ(hash, tiled_hash);
+
+  MinImg unaligned = {}, partial = {}, tile = {};
+  ASSERT_EQ(NO_ERRORS, GetMinImageRegion(&unaligned, &image, 32, 0, 64, 10));
+  EXPECT_EQ(BAD_ARGS, UpdateMinImageHash(&state, &unaligned, 32, 0));
+  ASSERT_EQ(NO_ERRORS, GetMinImageRegion(&partial, &image, 64, 0, 100, 10));
+  EXPECT_EQ(BAD_ARGS, UpdateMinImageHash(&state, &partial, 64, 0));
+  ASSERT_EQ(NO_ERRORS, GetMinImageRegion(&tile, &image, 64, 0, 64, 10));
+  ASSERT_EQ(NO_ERRORS, UpdateMinImageHash(&state, &tile, 64, 0));
+  EXPECT_EQ(BAD_ARGS, FinalizeMinImageHash(&tiled_hash, &state));
+}
+
+TEST(TestMinimgapi, TestCompareMinImageContents) {
+  const int width = 1200, height = 900, channels = 3;
+  DECLARE_GUARDED_MINIMG(image);
+  ASSERT_EQ(NO_ERRORS, NewMinImagePrototype(&image, width, height, channels,
+                                            TYP_UINT8));
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width * channels; ++x)
+      GetMinImageLine(&image, y)[x] = static_cast<uint8_t>(rand());
+  std::vector<uint8_t> padded((width * channels + 13) * height);
+  MinImg padded_image = {};
+  ASSERT_EQ(NO_ERRORS, WrapAlignedBufferWithMinImage(&padded_image,
+      padded.data(), width, height, channels, TYP_UINT8,
+      width * channels + 13));
+  ASSERT_EQ(NO_ERRORS, CopyMinImage(&padded_image, &image));
+  EXPECT_EQ(0, CompareMinImageContents(&image, &padded_image));
+
+  GetMinImageLine(&padded_image, height - 1)[width * channels - 1] ^= 0x40;
+  EXPECT_LT(0, CompareMinImageContents(&image, &padded_image));
+  MinImg region = {};
+  ASSERT_EQ(NO_ERRORS, GetMinImageRegion(&region, &image, 0, 0, 10, 10));
+  EXPECT_LT(0, CompareMinImageContents(&image, &region));
+
+  // Unused bits of the last byte of 1-bit lines are ignored.
+  uint8_t bits_a[2 * 2] = {0xA5, 0xF0, 0x3C, 0x08};
+  uint8_t bits_b[2 * 2] = {0xA5, 0xF7, 0x3C, 0x0F};
+  MinImg bit_image_a = {}, bit_image_b = {};
+  ASSERT_EQ(NO_ERRORS, NewMinImagePrototype(&bit_image_a, 13, 2, 1, TYP_UINT1,
+                                            0, AO_EMPTY));
+  ASSERT_EQ(NO_ERRORS, CloneMinImagePrototype(&bit_image_b, &bit_image_a,
+                                              AO_EMPTY));
+  bit_image_a.stride = bit_image_b.stride = 2;
+  bit_image_a.p_zero_line = bits_a;
+  bit_image_b.p_zero_line = bits_b;
+  EXPECT_EQ(0, CompareMinImageContents(&bit_image_a, &bit_image_b));
+  bits_b[3] |= 0x10;
+  EXPECT_LT(0, CompareMinImageContents(&bit_image_a, &bit_image_b));
+}
+
+TEST(TestMinimgapi, TestGetMinImagesDifference) {
+  const int width = 1200, height = 900, channels = 3;
+  DECLARE_GUARDED_MINIMG(image_a);
+  DECLARE_GUARDED_MINIMG(image_b);
+  ASSERT_EQ(NO_ERRORS, NewMinImagePrototype(&image_a, width, height, channels,
+                                            TYP_UINT8));
+  ASSERT_EQ(NO_ERRORS, CloneMinImagePrototype(&image_b, &image_a));
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width * channels; ++x)
+      GetMinImageLine(&image_a, y)[x] = static_cast<uint8_t>(rand());
+  ASSERT_EQ(NO_ERRORS, CopyMinImage(&image_b, &image_a));
+
+  MinImgDiffStats stats = {};
+  ASSERT_EQ(NO_ERRORS, GetMinImagesDifference(&stats, &image_a, &image_b));
+  EXPECT_EQ(0.0, stats.max_abs_diff);
+  EXPECT_EQ(0, stats.num_diff_pixels);
+  EXPECT_EQ(0, stats.diff_width);
+  EXPECT_TRUE(std::isinf(stats.psnr));
+
+  // Pixels (17, 5) and (1100, 800) differ by 1 and 9 in one channel, and
+  // pixel (1100, 801) differs by 2 in two channels.
+  uint8_t *p = GetMinImageLine(&image_b, 5) + 17 * channels + 1;
+  *p = static_cast<uint8_t>(*p < 128 ? *p + 1 : *p - 1);
+  p = GetMinImageLine(&image_b, 800) + 1100 * channels;
+  *p = static_cast<uint8_t>(*p < 128 ? *p + 9 : *p - 9);
+  p = GetMinImageLine(&image_b, 801) + 1100 * channels + 1;
+  p[0] = static_cast<uint8_t>(p[0] < 128 ? p[0] + 2 : p[0] - 2);
+  p[1] = static_cast<uint8_t>(p[1] < 128 ? p[1] + 2 : p[1] - 2);
+
+  ASSERT_EQ(NO_ERRORS, GetMinImagesDifference(&stats, &image_a, &image_b));
+  EXPECT_EQ(9.0, stats.max_abs_diff);
+  EXPECT_EQ(3, stats.num_diff_pixels);
+  EXPECT_EQ(1.0 + 81.0 + 8.0, stats.sse);
+  EXPECT_DOUBLE_EQ(90.0 / (width * height * channels), stats.mse);
+  EXPECT_NEAR(10.0 * std::log10(255.0 * 255.0 / stats.mse), stats.psnr, 1e-9);
+  EXPECT_EQ(17, stats.diff_x);
+  EXPECT_EQ(5, stats.diff_y);
+  EXPECT_EQ(1100 - 17 + 1, stats.diff_width);
+  EXPECT_EQ(801 - 5 + 1, stats.diff_height);
+
+  ASSERT_EQ(NO_ERRORS, GetMinImagesDifference(&stats, &image_a, &image_b, 2));
+  EXPECT_EQ(1, stats.num_diff_pixels);
+  EXPECT_EQ(1100, stats.diff_x);
+  EXPECT_EQ(800, stats.diff_y);
+  EXPECT_EQ(1, stats.diff_width);
+  EXPECT_EQ(1, stats.diff_height);
+  EXPECT_EQ(1.0 + 81.0 + 8.0, stats.sse);
+
+  MinImg region = {};
+  ASSERT_EQ(NO_ERRORS, GetMinImageRegion(&region, &image_a, 0, 0, 10, 10));
+  EXPECT_EQ(BAD_ARGS, GetMinImagesDifference(&stats, &image_a, &region));
+  EXPECT_EQ(BAD_ARGS, GetMinImagesDifference(&stats, &image_a, &image_b, -1));
+
+  // Real images: two NaNs are equal, a NaN against a number is not.
+  float reals_a[4] = {0.5f, -1.0f, NAN, 2.0f};
+  float reals_b[4] = {0.25f, -1.0f, NAN, 2.0f};
+  MinImg real_image_a = {}, real_image_b = {};
+  ASSERT_EQ(NO_ERRORS, WrapAlignedBufferWithMinImage(&real_image_a, reals_a,
+      4, 1, 1, TYP_REAL32, sizeof(reals_a)));
+  ASSERT_EQ(NO_ERRORS, WrapAlignedBufferWithMinImage(&real_image_b, reals_b,
+      4, 1, 1, TYP_REAL32, sizeof(reals_b)));
+  ASSERT_EQ(NO_ERRORS,
+            GetMinImagesDifference(&stats, &real_image_a, &real_image_b));
+  EXPECT_EQ(0.25, stats.max_abs_diff);
+  EXPECT_EQ(1, stats.num_diff_pixels);
+  EXPECT_NEAR(10.0 * std::log10(4.0 / 0.0625), stats.psnr, 1e-9);
+  reals_b[3] = NAN;
+  ASSERT_EQ(NO_ERRORS,
+            GetMinImagesDifference(&stats, &real_image_a, &real_image_b));
+  EXPECT_TRUE(std::isnan(stats.max_abs_diff));
+  EXPECT_EQ(2, stats.num_diff_pixels);
+  EXPECT_EQ(4, stats.diff_width);
+
+  // Two-channel 1-bit pixels.
+  uint8_t bits_a[1 * 2] = {0xA5, 0xF0};
+  uint8_t bits_b[1 * 2] = {0xA4, 0xC3};
+  MinImg bit_image_a = {}, bit_image_b = {};
+  ASSERT_EQ(NO_ERRORS, NewMinImagePrototype(&bit_image_a, 6, 1, 2, TYP_UINT1,
+                                            0, AO_EMPTY));
+  ASSERT_EQ(NO_ERRORS, CloneMinImagePrototype(&bit_image_b, &bit_image_a,
+                                              AO_EMPTY));
+  bit_image_a.stride = bit_image_b.stride = 2;
+  bit_image_a.p_zero_line = bits_a;
+  bit_image_b.p_zero_line = bits_b;
+  ASSERT_EQ(NO_ERRORS,
+            GetMinImagesDifference(&stats, &bit_image_a, &bit_image_b));
+  EXPECT_EQ(1.0, stats.max_abs_diff);
+  EXPECT_EQ(2, stats.num_diff_pixels);
+  EXPECT_EQ(3.0, stats.sse);
+  EXPECT_EQ(3, stats.diff_x);
+  EXPECT_EQ(3, stats.diff_width);
+}
+
+TEST(TestMinimgapi, TestTransposeMinImageInPlace) {
+  struct Case { int width, height, channels; MinTyp type; int padding; };
+  const Case cases[] = {
+    {37, 23, 1, TYP_UINT8, 0},
+    {100, 7, 3, TYP_UINT8, 0},
+    {13, 29, 2, TYP_REAL64, 0},
+    {1, 40, 1, TYP_UINT16, 0},
+    {50, 50, 1, TYP_UINT16, 6},
+    {45, 45, 3, TYP_UINT8, 0},
+  };
+  for (const Case &c : cases) {
+    const int pixel_size = c.channels * ((1 << LogBitSizeOfMinType(c.type)) / 8);
+    const int src_stride = c.width * pixel_size + c.padding;
+    const int dst_stride = c.height * pixel_size + c.padding;
+    std::vector<uint8_t> buffer(
+        std::max(src_stride * c.height, dst_stride * c.width));
+    for (size_t k = 0; k < buffer.size(); ++k)
+      buffer[k] = static_cast<uint8_t>(rand());
+    MinImg src = {}, dst = {};
+    ASSERT_EQ(NO_ERRORS, WrapAlignedBufferWithMinImage(&src, buffer.data(),
+        c.width, c.height, c.channels, c.type, src_stride));
+    ASSERT_EQ(NO_ERRORS, WrapAlignedBufferWithMinImage(&dst, buffer.data(),
+        c.height, c.width, c.channels, c.type, dst_stride));
+    DECLARE_GUARDED_MINIMG(expected);
+    ASSERT_EQ(NO_ERRORS, CloneTransposedMinImagePrototype(&expected, &src));
+    ASSERT_EQ(NO_ERRORS, TransposeMinImage(&expected, &src));
+
+    ASSERT_EQ(NO_ERRORS, TransposeMinImage(&dst, &src));
+    EXPECT_EQ(0, CompareMinImageContents(&dst, &expected))
+        << c.width << "x" << c.height << "x" << c.channels;
+  }
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -33,6 +33,156 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <minimgapi/imgguard.hpp>
 #include <benchmark/benchmark.h>
 #include <minimgapi/test/minrandom.hpp>
+#include <tbb/global_control.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>  // std::remove
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define BENCH_COUNT_ALLOCATIONS
+#include <malloc.h>
+#include <sys/resource.h>
+#endif
+
+
+//
+// Allocation accounting: on glibc every malloc family call of the process
+// (including the ones made by libjpeg, libpng, libtiff and libwebp) goes
+// through the wrappers below, which count calls and live heap bytes.
+//
+
+static std::atomic<int64_t> g_alloc_count(0);
+static std::atomic<int64_t> g_live_bytes(0);
+static std::atomic<int64_t> g_peak_bytes(0);
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+}
+
+static void *AccountAllocation(void *ptr) {
+  if (ptr) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    const int64_t live = g_live_bytes.fetch_add(
+        malloc_usable_size(ptr), std::memory_order_relaxed) +
+        static_cast<int64_t>(malloc_usable_size(ptr));
+    int64_t peak = g_peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !g_peak_bytes.compare_exchange_weak(
+        peak, live, std::memory_order_relaxed)) {}
+  }
+  return ptr;
+}
+
+static void AccountDeallocation(void *ptr) {
+  if (ptr)
+    g_live_bytes.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+}
+
+extern "C" {
+
+void *malloc(size_t size) {
+  return AccountAllocation(__libc_malloc(size));
+}
+
+void *calloc(size_t count, size_t size) {
+  return AccountAllocation(__libc_calloc(count, size));
+}
+
+void *realloc(void *ptr, size_t size) {
+  AccountDeallocation(ptr);
+  void *result = __libc_realloc(ptr, size);
+  if (!result && ptr && size) {  // the old block is still alive
+    g_live_bytes.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed);
+    return result;
+  }
+  return AccountAllocation(result);
+}
+
+void *memalign(size_t alignment, size_t size) {
+  return AccountAllocation(__libc_memalign(alignment, size));
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+  return AccountAllocation(__libc_memalign(alignment, size));
+}
+
+int posix_memalign(void **p_ptr, size_t alignment, size_t size) {
+  void *ptr = AccountAllocation(__libc_memalign(alignment, size));
+  if (!ptr)
+    return ENOMEM;
+  *p_ptr = ptr;
+  return 0;
+}
+
+void free(void *ptr) {
+  AccountDeallocation(ptr);
+  __libc_free(ptr);
+}
+
+} // extern "C"
+
+static double GetMaxRssMegabytes() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage))
+    return 0.0;
+  return usage.ru_maxrss / 1024.0;  // ru_maxrss is in kilobytes on Linux
+}
+
+#else
+
+static double GetMaxRssMegabytes() {
+  return 0.0;
+}
+
+#endif // BENCH_COUNT_ALLOCATIONS
+
+
+// Measures allocations and the heap peak of the timed operations. The peak
+// is tracked per operation relative to the live bytes before it.
+class MemoryMeter {
+public:
+  MemoryMeter() : count_(0), peak_(0), start_count_(0), start_live_(0) {}
+
+  void Begin() {
+    start_count_ = g_alloc_count.load(std::memory_order_relaxed);
+    start_live_ = g_live_bytes.load(std::memory_order_relaxed);
+    g_peak_bytes.store(start_live_, std::memory_order_relaxed);
+  }
+
+  void End() {
+    count_ += g_alloc_count.load(std::memory_order_relaxed) - start_count_;
+    peak_ = std::max(peak_, g_peak_bytes.load(std::memory_order_relaxed) -
+                            start_live_);
+  }
+
+  void Report(benchmark::State &state) const {
+#ifdef BENCH_COUNT_ALLOCATIONS
+    state.counters["allocs"] = benchmark::Counter(
+        static_cast<double>(count_), benchmark::Counter::kAvgIterations);
+    state.counters["peak_heap_MB"] = peak_ / (1024.0 * 1024.0);
+#endif
+    state.counters["max_rss_MB"] = GetMaxRssMegabytes();
+  }
+
+private:
+  int64_t count_;
+  int64_t peak_;
+  int64_t start_count_;
+  int64_t start_live_;
+};
 
 
 struct VectorBinaryStream
@@ -69,6 +219,12 @@ struct VectorBinaryStream
       this->vec.resize(this->pos);
     return static_cast<int64_t>(this->pos);
   };
+  // decoding goes through the zero-copy paths, as from any in-memory file
+  const uint8_t* peek(std::size_t &size) override {
+    const std::size_t pos = std::min(this->pos, this->vec.size());
+    size = this->vec.size() - pos;
+    return this->vec.data() + pos;
+  }
 
 protected:
   std::vector<uint8_t> &vec;
@@ -82,62 +238,540 @@ protected:
   std::vector<uint8_t> inner_vec;
 };
 
-#define FAIL_ON_ERROR(call) do {if ((call) != 0) \
-  state.SkipWithError("min call failed");} while (0)
+#define FAIL_ON_ERROR(call) do { const int res = (call); if (res != 0) { \
+  state.SkipWithError(("min call failed with " + std::to_string(res) + \
+                       ": " #call).c_str()); return; } } while (0)
+
+
+struct Resolution {
+  const char *name;
+  int         width;
+  int         height;
+};
+
+static const Resolution kResolutions[] = {
+  {"vga", 640, 480},
+  {"svga", 800, 600},
+  {"hd", 1920, 1080},
+  {"4k", 3840, 2160},
+};
+
+struct Codec {
+  std::string   name;
+  ImgFileFormat iff;
+  ImgFileComp   comp;
+  int           qty;
+};
+
+struct Layout {
+  int    channels;
+  MinTyp type;
+};
+
+// Smooth gradients with a little noise, which compress like photos rather
+// than like white noise. Bit images get random bits.
+static int FillTestImage(const MinImg &img) {
+  if (img.scalar_type == TYP_UINT1)
+    return ApplyLineFunctor(&img, RandomBytes());
+  RNG rng;
+  const int values = img.width * img.channels;
+  for (int y = 0; y < img.height; ++y) {
+    uint8_t *p_line = img.p_zero_line + y * img.stride;
+    for (int i = 0; i < values; ++i) {
+      const int x = i / img.channels, c = i % img.channels;
+      const uint32_t v = static_cast<uint32_t>(
+          x * 3 + y * 5 + c * 40 + static_cast<int>(rng() & 7));
+      if (img.scalar_type == TYP_UINT16)
+        reinterpret_cast<uint16_t *>(p_line)[i] =
+            static_cast<uint16_t>(v * 37);
+      else
+        p_line[i] = static_cast<uint8_t>(v);
+    }
+  }
+  return NO_ERRORS;
+}
+
+static ExtImgProps MakeProps(const Codec &codec) {
+  ExtImgProps props = {};
+  props.iff = codec.iff;
+  props.comp = codec.comp;
+  props.qty = codec.qty;
+  return props;
+}
 
 
 static void BM_Decoding(
-    benchmark::State& state,
-    ImgFileFormat const img_format,
-    int const width,
-    int const height) {
+    benchmark::State &state,
+    Codec const       codec,
+    Resolution const  resolution,
+    Layout const      layout) {
   DECLARE_GUARDED_MINIMG(src);
   DECLARE_GUARDED_MINIMG(dst);
-  FAIL_ON_ERROR(NewMinImagePrototype(&src, width, height, 3, TYP_UINT8));
-  ApplyLineFunctor(&src, Random255());
+  FAIL_ON_ERROR(NewMinImagePrototype(&src, resolution.width,
+                                     resolution.height, layout.channels,
+                                     layout.type));
+  FAIL_ON_ERROR(FillTestImage(src));
   TestBinaryStream stream;
-  FAIL_ON_ERROR(minimgio::Save(stream, src, img_format));
+  const ExtImgProps props = MakeProps(codec);
+  FAIL_ON_ERROR(minimgio::Save(stream, src, codec.iff, &props));
   FAIL_ON_ERROR(CloneMinImagePrototype(&dst, &src));
+  MemoryMeter meter;
   for (auto _ : state) {
+    meter.Begin();
     FAIL_ON_ERROR(minimgio::Load(dst, stream, 0));
+    meter.End();
   }
+  meter.Report(state);
   state.SetBytesProcessed(
     int64_t(state.iterations()) * stream.lseek(0, SEEK_END));
   state.SetItemsProcessed(
-    int64_t(state.iterations()) * width * height * src.channels);
+    int64_t(state.iterations()) * src.width * src.height * src.channels);
 }
 
 static void BM_Encoding(
-    benchmark::State& state,
-    ImgFileFormat const img_format,
-    int const width,
-    int const height) {
+    benchmark::State &state,
+    Codec const       codec,
+    Resolution const  resolution,
+    Layout const      layout) {
   DECLARE_GUARDED_MINIMG(src);
-  DECLARE_GUARDED_MINIMG(dst);
-  FAIL_ON_ERROR(NewMinImagePrototype(&src, width, height, 3, TYP_UINT8));
-  ApplyLineFunctor(&src, Random255());
+  FAIL_ON_ERROR(NewMinImagePrototype(&src, resolution.width,
+                                     resolution.height, layout.channels,
+                                     layout.type));
+  FAIL_ON_ERROR(FillTestImage(src));
   TestBinaryStream stream;
+  const ExtImgProps props = MakeProps(codec);
+  MemoryMeter meter;
   for (auto _ : state) {
     stream.lseek(0, SEEK_SET);
-    FAIL_ON_ERROR(minimgio::Save(stream, src, img_format));
+    meter.Begin();
+    FAIL_ON_ERROR(minimgio::Save(stream, src, codec.iff, &props));
+    meter.End();
   }
+  meter.Report(state);
   state.SetBytesProcessed(
     int64_t(state.iterations()) * stream.lseek(0, SEEK_END));
   state.SetItemsProcessed(
-    int64_t(state.iterations()) * width * height * src.channels);
+    int64_t(state.iterations()) * src.width * src.height * src.channels);
+}
+
+
+// Counts the `read` and `lseek` syscalls the descriptor stream makes.
+struct SyscallCountingFileStream : public minimgio::BinaryFileStream {
+  SyscallCountingFileStream(const char *filename)
+      : minimgio::BinaryFileStream(filename) {}
+  std::size_t read(void* buffer, std::size_t size) override {
+    ++syscalls;
+    return minimgio::BinaryFileStream::read(buffer, size);
+  }
+  int64_t lseek(int64_t offset, int whence) override {
+    ++syscalls;
+    return minimgio::BinaryFileStream::lseek(offset, whence);
+  }
+  static int64_t syscalls;
+};
+int64_t SyscallCountingFileStream::syscalls = 0;
+
+static void ReportSyscalls(benchmark::State &state,
+                           const SyscallCountingFileStream *) {
+  state.counters["syscalls"] = benchmark::Counter(
+      static_cast<double>(SyscallCountingFileStream::syscalls),
+      benchmark::Counter::kAvgIterations);
+}
+
+static void ReportSyscalls(benchmark::State &,
+                           const minimgio::BinaryMappedFileStream *) {}
+
+// Decodes an HD image from a file on disk through the descriptor stream,
+// which `Load` reads through its read-ahead buffer, or through the mapped
+// stream, which needs no syscalls after mapping.
+template<typename FileStream>
+static void BM_DecodingFile(benchmark::State &state, Codec const codec) {
+  DECLARE_GUARDED_MINIMG(src);
+  DECLARE_GUARDED_MINIMG(dst);
+  FAIL_ON_ERROR(NewMinImagePrototype(&src, 1920, 1080, 3, TYP_UINT8));
+  FAIL_ON_ERROR(FillTestImage(src));
+  FAIL_ON_ERROR(CloneMinImagePrototype(&dst, &src));
+  const std::string path = "bench_minimgio_" + codec.name + ".tmp";
+  const ExtImgProps props = MakeProps(codec);
+  int64_t file_size = 0;
+  {
+    minimgio::BinaryFileStream stream(path.c_str());
+    FAIL_ON_ERROR(minimgio::Save(stream, src, codec.iff, &props));
+    file_size = stream.lseek(0, SEEK_END);
+  }
+  SyscallCountingFileStream::syscalls = 0;
+  for (auto _ : state) {
+    FileStream stream(path.c_str());
+    FAIL_ON_ERROR(minimgio::Load(dst, stream, 0));
+  }
+  std::remove(path.c_str());
+  ReportSyscalls(state, static_cast<const FileStream *>(nullptr));
+  state.SetBytesProcessed(int64_t(state.iterations()) * file_size);
+  state.SetItemsProcessed(
+    int64_t(state.iterations()) * src.width * src.height);
+}
+
+
+// The usual way to open a file: query the properties, then load a VGA image,
+// either with two free calls, which parse the headers twice, or through one
+// `DecoderSession`.
+static void BM_PropsAndLoad(
+    benchmark::State &state,
+    Codec const       codec,
+    bool const        use_session) {
+  DECLARE_GUARDED_MINIMG(src);
+  DECLARE_GUARDED_MINIMG(dst);
+  FAIL_ON_ERROR(NewMinImagePrototype(&src, 640, 480, 3, TYP_UINT8));
+  FAIL_ON_ERROR(FillTestImage(src));
+  FAIL_ON_ERROR(CloneMinImagePrototype(&dst, &src));
+  const std::string path = "bench_minimgio_props_" + codec.name + ".tmp";
+  const ExtImgProps props = MakeProps(codec);
+  {
+    minimgio::BinaryFileStream stream(path.c_str());
+    FAIL_ON_ERROR(minimgio::Save(stream, src, codec.iff, &props));
+  }
+  SyscallCountingFileStream::syscalls = 0;
+  for (auto _ : state) {
+    SyscallCountingFileStream stream(path.c_str());
+    MinImg img = {};
+    if (use_session) {
+      minimgio::DecoderSession session(stream);
+      FAIL_ON_ERROR(session.get_file_props(img));
+      FAIL_ON_ERROR(session.load(dst));
+    } else {
+      FAIL_ON_ERROR(minimgio::GetFileProps(img, stream));
+      FAIL_ON_ERROR(minimgio::Load(dst, stream));
+    }
+  }
+  std::remove(path.c_str());
+  ReportSyscalls(state, static_cast<const SyscallCountingFileStream *>(nullptr));
+  state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+// Thumbnails and previews: decodes a 4K image at 1/`range(0)` of its size.
+static void BM_DecodingScaled(benchmark::State &state, Codec const codec) {
+  DECLARE_GUARDED_MINIMG(src);
+  FAIL_ON_ERROR(NewMinImagePrototype(&src, 3840, 2160, 3, TYP_UINT8));
+  FAIL_ON_ERROR(FillTestImage(src));
+  TestBinaryStream stream;
+  const ExtImgProps props = MakeProps(codec);
+  FAIL_ON_ERROR(minimgio::Save(stream, src, codec.iff, &props));
+  DecodeOptions options = {};
+  options.scale_denom = static_cast<int>(state.range(0));
+  DECLARE_GUARDED_MINIMG(dst);
+  FAIL_ON_ERROR(minimgio::GetFileProps(dst, stream, nullptr, 0, &options));
+  FAIL_ON_ERROR(AllocMinImage(&dst));
+  for (auto _ : state)
+    FAIL_ON_ERROR(minimgio::Load(dst, stream, 0, &options));
+  state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+// A zone of a document scan: decodes a 512x256 region of a 4K image, at the
+// top (`range(0)` == 0) or at the bottom of it, or the full image.
+static void BM_DecodingRegion(benchmark::State &state, Codec const codec) {
+  DECLARE_GUARDED_MINIMG(src);
+  FAIL_ON_ERROR(NewMinImagePrototype(&src, 3840, 2160, 3, TYP_UINT8));
+  FAIL_ON_ERROR(FillTestImage(src));
+  TestBinaryStream stream;
+  const ExtImgProps props = MakeProps(codec);
+  FAIL_ON_ERROR(minimgio::Save(stream, src, codec.iff, &props));
+  DecodeOptions options = {};
+  if (state.range(0) >= 0) {
+    options.region_x = 1600;
+    options.region_y = state.range(0) ? 1800 : 100;
+    options.region_width = 512;
+    options.region_height = 256;
+  }
+  DECLARE_GUARDED_MINIMG(dst);
+  FAIL_ON_ERROR(minimgio::GetFileProps(dst, stream, nullptr, 0, &options));
+  FAIL_ON_ERROR(AllocMinImage(&dst));
+  for (auto _ : state)
+    FAIL_ON_ERROR(minimgio::Load(dst, stream, 0, &options));
+  state.SetItemsProcessed(int64_t(state.iterations()));
 }
 
-#define BENCHMARK_FORMAT(Func, name, NAME) \
-  /*BENCHMARK_CAPTURE(Func, name##_vga, IFF_##NAME, 640, 480);*/ \
-  BENCHMARK_CAPTURE(Func, name##_svga, IFF_##NAME, 800, 600); \
-  /*BENCHMARK_CAPTURE(Func, name##_hdtv, IFF_##NAME, 1920, 1080);*/ \
-  /*BENCHMARK_CAPTURE(Func, name##_wquxga, IFF_##NAME, 3840, 2400);*/
+// Inserts an EXIF block with the `orientation` tag right after the SOI marker
+// of a JPEG file.
+static std::vector<uint8_t> AddJpegOrientation(
+    const std::vector<uint8_t> &jpeg,
+    uint16_t                    orientation) {
+  const uint8_t app1[] = {
+    0xFF, 0xE1, 0, 34,                        // APP1 and its size
+    'E', 'x', 'i', 'f', 0, 0,
+    'I', 'I', 42, 0, 8, 0, 0, 0,              // TIFF header, IFD0 at 8
+    1, 0,                                     // one tag
+    0x12, 0x01, 3, 0, 1, 0, 0, 0,             // orientation, SHORT, 1 value
+    static_cast<uint8_t>(orientation), 0, 0, 0,
+    0, 0, 0, 0                                // no next IFD
+  };
+  std::vector<uint8_t> result(jpeg);
+  result.insert(result.begin() + 2, app1, app1 + sizeof(app1));
+  return result;
+}
+
+// A phone photo: decodes a 4K image with the EXIF orientation `range(0)`.
+static void BM_DecodingOriented(benchmark::State &state, Codec const codec) {
+  DECLARE_GUARDED_MINIMG(src);
+  FAIL_ON_ERROR(NewMinImagePrototype(&src, 3840, 2160, 3, TYP_UINT8));
+  FAIL_ON_ERROR(FillTestImage(src));
+  TestBinaryStream saved;
+  const ExtImgProps props = MakeProps(codec);
+  FAIL_ON_ERROR(minimgio::Save(saved, src, codec.iff, &props));
+  std::vector<uint8_t> data(static_cast<size_t>(saved.lseek(0, SEEK_END)));
+  saved.lseek(0, SEEK_SET);
+  saved.read(data.data(), data.size());
+  data = AddJpegOrientation(
+      data, static_cast<uint16_t>(state.range(0)));
+  minimgio::BinaryMemoryReadonlyStream stream(data.data(), data.size());
+  DECLARE_GUARDED_MINIMG(dst);
+  FAIL_ON_ERROR(minimgio::GetFileProps(dst, stream));
+  FAIL_ON_ERROR(AllocMinImage(&dst));
+  MemoryMeter meter;
+  for (auto _ : state) {
+    meter.Begin();
+    FAIL_ON_ERROR(minimgio::Load(dst, stream));
+    meter.End();
+  }
+  meter.Report(state);
+  state.SetItemsProcessed(int64_t(state.iterations()));
+}
 
-BENCHMARK_FORMAT(BM_Decoding, jpeg, JPEG);
-BENCHMARK_FORMAT(BM_Decoding, png, PNG);
-BENCHMARK_FORMAT(BM_Decoding, tiff, TIFF);
-BENCHMARK_FORMAT(BM_Encoding, jpeg, JPEG);
-BENCHMARK_FORMAT(BM_Encoding, png, PNG);
-BENCHMARK_FORMAT(BM_Encoding, tiff, TIFF);
+// Rotating a photo by 90 degrees: losslessly (`range(0)` == 0), or by decoding
+// it with the matching EXIF orientation and encoding it again.
+static void BM_TransformJpeg(benchmark::State &state, Codec const codec) {
+  DECLARE_GUARDED_MINIMG(src);
+  FAIL_ON_ERROR(NewMinImagePrototype(&src, 3840, 2160, 3, TYP_UINT8));
+  FAIL_ON_ERROR(FillTestImage(src));
+  TestBinaryStream saved;
+  const ExtImgProps props = MakeProps(codec);
+  FAIL_ON_ERROR(minimgio::Save(saved, src, codec.iff, &props));
+  std::vector<uint8_t> data(static_cast<size_t>(saved.lseek(0, SEEK_END)));
+  saved.lseek(0, SEEK_SET);
+  saved.read(data.data(), data.size());
+  const bool lossless = state.range(0) == 0;
+  if (!lossless)
+    data = AddJpegOrientation(data, 6);
+  minimgio::BinaryMemoryReadonlyStream stream(data.data(), data.size());
+  DECLARE_GUARDED_MINIMG(rotated);
+  FAIL_ON_ERROR(minimgio::GetFileProps(rotated, stream));
+  FAIL_ON_ERROR(AllocMinImage(&rotated));
+  TransformOptions options = {};
+  options.transform = ITR_ROTATE_90;
+  for (auto _ : state) {
+    minimgio::BinaryMemoryStream dst(data.size());
+    if (lossless) {
+      FAIL_ON_ERROR(minimgio::TransformJpeg(dst, stream, &options));
+    } else {
+      FAIL_ON_ERROR(minimgio::Load(rotated, stream));
+      FAIL_ON_ERROR(minimgio::Save(dst, rotated, codec.iff, &props));
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()));
+}
 
-BENCHMARK_MAIN();
+// Writes `range(0)` SVGA pages into one TIFF, then decodes all of them.
+static void BM_TiffMultiPage(benchmark::State &state, bool decode) {
+  const int num_pages = static_cast<int>(state.range(0));
+  DECLARE_GUARDED_MINIMG(src);
+  DECLARE_GUARDED_MINIMG(dst);
+  FAIL_ON_ERROR(NewMinImagePrototype(&src, 800, 600, 3, TYP_UINT8));
+  FAIL_ON_ERROR(FillTestImage(src));
+  FAIL_ON_ERROR(CloneMinImagePrototype(&dst, &src));
+  ExtImgProps props = {};
+  props.iff = IFF_TIFF;
+  props.comp = IFC_LZW;
+  TestBinaryStream stream;
+  MemoryMeter meter;
+  if (decode)
+    for (int page = 0; page < num_pages; ++page)
+      FAIL_ON_ERROR(minimgio::Save(stream, src, IFF_TIFF, &props, page));
+  for (auto _ : state) {
+    meter.Begin();
+    for (int page = 0; page < num_pages; ++page) {
+      if (decode) {
+        FAIL_ON_ERROR(minimgio::Load(dst, stream, page));
+      } else {
+        if (!page)
+          stream.lseek(0, SEEK_SET);
+        FAIL_ON_ERROR(minimgio::Save(stream, src, IFF_TIFF, &props, page));
+      }
+    }
+    meter.End();
+  }
+  meter.Report(state);
+  state.SetItemsProcessed(int64_t(state.iterations()) * num_pages);
+}
+BENCHMARK_CAPTURE(BM_TiffMultiPage, decode, true)
+    ->ArgName("pages")->Arg(1)->Arg(4)->Arg(16);
+BENCHMARK_CAPTURE(BM_TiffMultiPage, encode, false)
+    ->ArgName("pages")->Arg(1)->Arg(4)->Arg(16);
+
+
+// Every thread decodes its own copy of the same HD image; with real time
+// the items rate shows how decoding scales across cores.
+static void BM_DecodingParallel(benchmark::State &state, Codec const codec) {
+  DECLARE_GUARDED_MINIMG(src);
+  DECLARE_GUARDED_MINIMG(dst);
+  FAIL_ON_ERROR(NewMinImagePrototype(&src, 1920, 1080, 3, TYP_UINT8));
+  FAIL_ON_ERROR(FillTestImage(src));
+  TestBinaryStream stream;
+  const ExtImgProps props = MakeProps(codec);
+  FAIL_ON_ERROR(minimgio::Save(stream, src, codec.iff, &props));
+  FAIL_ON_ERROR(CloneMinImagePrototype(&dst, &src));
+  for (auto _ : state) {
+    FAIL_ON_ERROR(minimgio::Load(dst, stream, 0));
+  }
+  state.SetItemsProcessed(
+    int64_t(state.iterations()) * src.width * src.height);
+}
+
+
+static std::vector<Codec> MakeCodecs() {
+  std::vector<Codec> codecs;
+  for (int qty : {50, 75, 90, 100})
+    codecs.push_back({"jpeg_q" + std::to_string(qty), IFF_JPEG, IFC_NONE,
+                      qty});
+  codecs.push_back({"png", IFF_PNG, IFC_NONE, -1});
+  codecs.push_back({"webp", IFF_WEBP, IFC_NONE, -1});
+  static const struct {
+    const char  *name;
+    ImgFileComp  comp;
+  } tiff_comps[] = {
+    {"none", IFC_NONE}, {"lzw", IFC_LZW}, {"deflate", IFC_DEFLATE},
+    {"packbits", IFC_PACKBITS}, {"jpeg", IFC_JPEG}, {"rle", IFC_RLE},
+    {"group3", IFC_GROUP3}, {"group4", IFC_GROUP4},
+  };
+  for (const auto &tiff_comp : tiff_comps)
+    codecs.push_back({std::string("tiff_") + tiff_comp.name, IFF_TIFF,
+                      tiff_comp.comp, 90});
+  return codecs;
+}
+
+// Pixel layouts each codec can store.
+static std::vector<Layout> MakeLayouts(const Codec &codec) {
+  switch (codec.iff) {
+    case IFF_JPEG:
+      return {{1, TYP_UINT8}, {3, TYP_UINT8}};
+    case IFF_WEBP:
+      return {{3, TYP_UINT8}, {4, TYP_UINT8}};
+    case IFF_TIFF:
+      if (codec.comp == IFC_RLE || codec.comp == IFC_GROUP3 ||
+          codec.comp == IFC_GROUP4)
+        return {{1, TYP_UINT1}};
+      if (codec.comp == IFC_JPEG)
+        return {{1, TYP_UINT8}, {3, TYP_UINT8}};
+      // fall through
+    default:
+      return {{1, TYP_UINT8}, {3, TYP_UINT8}, {4, TYP_UINT8},
+              {1, TYP_UINT16}, {3, TYP_UINT16}, {4, TYP_UINT16}};
+  }
+}
+
+static std::string LayoutName(const Layout &layout) {
+  const char *type = layout.type == TYP_UINT1 ? "uint1" :
+                     layout.type == TYP_UINT16 ? "uint16" : "uint8";
+  return "c" + std::to_string(layout.channels) + "_" + type;
+}
+
+static void RegisterCodecBenchmarks() {
+  const std::vector<Codec> codecs = MakeCodecs();
+  for (const Codec &codec : codecs)
+    for (const Resolution &resolution : kResolutions)
+      for (const Layout &layout : MakeLayouts(codec)) {
+        const std::string suffix = codec.name + "/" + resolution.name + "/" +
+                                   LayoutName(layout);
+        benchmark::RegisterBenchmark(("BM_Decoding/" + suffix).c_str(),
+                                     BM_Decoding, codec, resolution, layout);
+        benchmark::RegisterBenchmark(("BM_Encoding/" + suffix).c_str(),
+                                     BM_Encoding, codec, resolution, layout);
+      }
+
+  for (const Codec &codec : codecs)
+    if (codec.name == "jpeg_q90" || codec.name == "png" ||
+        codec.name == "tiff_lzw") {
+      benchmark::RegisterBenchmark(
+          ("BM_DecodingFile/read/" + codec.name).c_str(),
+          BM_DecodingFile<SyscallCountingFileStream>, codec);
+      benchmark::RegisterBenchmark(
+          ("BM_DecodingFile/mmap/" + codec.name).c_str(),
+          BM_DecodingFile<minimgio::BinaryMappedFileStream>, codec);
+      benchmark::RegisterBenchmark(
+          ("BM_PropsAndLoad/free/" + codec.name).c_str(),
+          BM_PropsAndLoad, codec, false);
+      benchmark::RegisterBenchmark(
+          ("BM_PropsAndLoad/session/" + codec.name).c_str(),
+          BM_PropsAndLoad, codec, true);
+    }
+
+  for (const Codec &codec : codecs)
+    if (codec.name == "jpeg_q90")
+      benchmark::RegisterBenchmark(
+          ("BM_DecodingScaled/" + codec.name).c_str(),
+          BM_DecodingScaled, codec)
+          ->ArgName("denom")->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+  for (const Codec &codec : codecs)
+    if (codec.name == "jpeg_q90")
+      benchmark::RegisterBenchmark(
+          ("BM_DecodingRegion/" + codec.name).c_str(),
+          BM_DecodingRegion, codec)
+          ->ArgName("bottom")->Arg(-1)->Arg(0)->Arg(1);
+  for (const Codec &codec : codecs)
+    if (codec.name == "jpeg_q90")
+      benchmark::RegisterBenchmark(
+          ("BM_DecodingOriented/" + codec.name).c_str(),
+          BM_DecodingOriented, codec)
+          ->ArgName("orientation")->DenseRange(1, 8);
+  for (const Codec &codec : codecs)
+    if (codec.name == "jpeg_q90")
+      benchmark::RegisterBenchmark(
+          ("BM_TransformJpeg/" + codec.name).c_str(),
+          BM_TransformJpeg, codec)
+          ->ArgName("reencode")->Arg(0)->Arg(1);
+
+  const int max_threads = static_cast<int>(
+      std::max(1U, std::thread::hardware_concurrency()));
+  for (const Codec &codec : codecs)
+    if (codec.name == "jpeg_q90" || codec.name == "png" ||
+        codec.name == "tiff_lzw")
+      benchmark::RegisterBenchmark(
+          ("BM_DecodingParallel/" + codec.name).c_str(),
+          BM_DecodingParallel, codec)
+          ->ThreadRange(1, max_threads)->UseRealTime();
+}
+
+
+// Takes `--threads=N` out of the arguments and caps the TBB workers at N, so
+// the timings of the parallel kernels do not depend on the number of cores.
+// The cap is recorded in the report context as `tbb_threads`.
+static std::unique_ptr<tbb::global_control> PinTbbThreads(
+    int   &argc,
+    char **argv) {
+  static const char kFlag[] = "--threads=";
+  std::unique_ptr<tbb::global_control> control;
+  int kept = 1;
+  for (int k = 1; k < argc; ++k) {
+    if (std::strncmp(argv[k], kFlag, sizeof(kFlag) - 1) != 0) {
+      argv[kept++] = argv[k];
+      continue;
+    }
+    const int threads = std::max(1, std::atoi(argv[k] + sizeof(kFlag) - 1));
+    control.reset(new tbb::global_control(
+        tbb::global_control::max_allowed_parallelism,
+        static_cast<size_t>(threads)));
+    benchmark::AddCustomContext("tbb_threads", std::to_string(threads));
+  }
+  argc = kept;
+  argv[argc] = nullptr;
+  return control;
+}
+
+int main(int argc, char **argv) {
+  const std::unique_ptr<tbb::global_control> control =
+      PinTbbThreads(argc, argv);
+  RegisterCodecBenchmarks();
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -135,6 +135,11 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *   char szImageMemPath[250] = {0};
  *   sprintf(szImageMemPath, "mem://%p.%lu", pImageData, imageSize);
  * @endcode
+ *
+ * The stream functions need no such names: @c MinImgIoCreateMemoryStream()
+ * reads an image from memory, and an image saved to a stream created by
+ * @c MinImgIoCreateGrowableMemoryStream() is fetched with
+ * @c MinImgIoGetMemoryStreamData() without copying.
  */
 
 /**
@@ -182,6 +187,19 @@ MINIMGIO_API MinResult MinImgIoCreateFileStream(
 MINIMGIO_API MinResult MinImgIoCreateFileDescriptorStream(
     MIStreamHandle *handle, int fd);
 
+// `data` MUST live till the stream is freed
+MINIMGIO_API MinResult MinImgIoCreateMemoryStream(
+    MIStreamHandle *handle, const uint8_t *data, size_t size);
+
+// a stream writing to memory, `capacity` is a hint of the data size
+MINIMGIO_API MinResult MinImgIoCreateGrowableMemoryStream(
+    MIStreamHandle *handle, size_t capacity);
+
+// the data of a growable memory stream, without copying; valid until the
+// stream is written to or freed; other streams are a contract violation
+MINIMGIO_API MinResult MinImgIoGetMemoryStreamData(
+    const uint8_t **data, size_t *size, MIStreamHandle handle);
+
 MINIMGIO_API MinResult MinImgIoGetError(
     const char** message, MIStreamHandle handle);
 
@@ -199,6 +217,20 @@ MINIMGIO_API MinResult MinImgIoLoad(
     MIStreamHandle  stream,
     int             page);
 
+// `MinImgIoGetFileProps` and `MinImgIoLoad` with options, which may be NULL
+MINIMGIO_API MinResult MinImgIoGetFilePropsEx(
+    MinImg              *img,
+    ExtImgProps         *p_props,
+    MIStreamHandle       stream,
+    int                  page,
+    const DecodeOptions *p_options);
+
+MINIMGIO_API MinResult MinImgIoLoadEx(
+    const MinImg        *img,
+    MIStreamHandle       stream,
+    int                  page,
+    const DecodeOptions *p_options);
+
 MINIMGIO_API MinResult MinImgIoSave(
     MIStreamHandle     stream,
     const MinImg      *img,
@@ -206,6 +238,12 @@ MINIMGIO_API MinResult MinImgIoSave(
     const ExtImgProps *p_props,
     int                page);
 
+// see `minimgio::TransformJpeg`, `p_options` may be NULL
+MINIMGIO_API MinResult MinImgIoTransformJpeg(
+    MIStreamHandle          dst_stream,
+    MIStreamHandle          src_stream,
+    const TransformOptions *p_options);
+
 #ifdef __cplusplus
   } // extern "C"
 #endif
@@ -229,6 +267,15 @@ struct MINIMGIO_API BinaryStream {
   // error message callback
   virtual void error(const char* message) = 0;
   virtual const char *get_source() const { return nullptr; }
+  // optional zero-copy access for memory-backed streams: returns the bytes
+  // from the current position to the end of the stream without moving the
+  // position, and their number in `size`. Returns nullptr when the stream
+  // has no such span; the span is valid until the stream is written to or
+  // destroyed
+  virtual const uint8_t* peek(std::size_t &size) {
+    size = 0;
+    return nullptr;
+  }
 
   BinaryStream() = default;
   virtual ~BinaryStream() = default;
@@ -276,6 +323,34 @@ private:
   const char* filename;
 };
 
+// Reads a regular file through a read-only memory mapping: `read` copies
+// from the mapping and `lseek` only moves the position, so decoding costs no
+// syscalls after `initialize`. The mapping is made for MIS_READONLY only;
+// other flags, pipes, character devices, empty files and failed mappings fall
+// back to the descriptor calls of `BinaryFileStream`.
+// small caveat: truncating the file while it is mapped crashes the reader
+struct MINIMGIO_API BinaryMappedFileStream : public BinaryFileStream {
+  BinaryMappedFileStream(const char* filename);
+  MinResult initialize(MISInitFlag flag) override;
+  std::size_t read(void* buffer, std::size_t size) override;
+  std::size_t write(const void* buffer, std::size_t size) override;
+  int64_t lseek(int64_t offset, int whence) override;
+  const uint8_t* peek(std::size_t &size) override;
+  ~BinaryMappedFileStream() override;
+
+  // the mapped file contents, nullptr when the stream is not mapped
+  const uint8_t* mapped_data() const { return this->data; }
+  std::size_t mapped_size() const { return this->size; }
+
+private:
+  const uint8_t* data;
+  std::size_t size;
+  std::size_t pos;
+#ifdef _WIN32
+  void* mapping;
+#endif
+};
+
 struct MINIMGIO_API BinaryMemoryReadonlyStream
     : public BinaryStreamErrorHandling {
   // small caveat: buffer MUST live till the stream is destroyed
@@ -284,6 +359,7 @@ struct MINIMGIO_API BinaryMemoryReadonlyStream
   std::size_t read(void* buffer, std::size_t size) override;
   std::size_t write(const void* buffer, std::size_t size) override;
   int64_t lseek(int64_t offset, int whence) override;
+  const uint8_t* peek(std::size_t &size) override;
 
   BinaryMemoryReadonlyStream(const BinaryMemoryReadonlyStream&) = delete;
 
@@ -293,6 +369,102 @@ private:
   std::size_t pos;
 };
 
+// Reads and writes a buffer of its own, which grows geometrically when data
+// is written past its end, e.g. to encode an image for sending it away.
+// Seeking past the end is allowed; a write there fills the gap with zeros.
+struct MINIMGIO_API BinaryMemoryStream : public BinaryStreamErrorHandling {
+  // `capacity` is a hint of the data size, see `reserve`
+  explicit BinaryMemoryStream(std::size_t capacity = 0);
+  ~BinaryMemoryStream() override;
+  MinResult initialize(MISInitFlag) override { return MR_SUCCESS; }
+  std::size_t read(void* buffer, std::size_t size) override;
+  std::size_t write(const void* buffer, std::size_t size) override;
+  int64_t lseek(int64_t offset, int whence) override;
+  const uint8_t* peek(std::size_t &size) override;
+
+  // makes room for `capacity` bytes, so that writing them reallocates nothing
+  MinResult reserve(std::size_t capacity);
+  // the data written so far; valid until the next write or `reserve`
+  const uint8_t* data() const { return this->buffer; }
+  std::size_t size() const { return this->data_size; }
+
+  BinaryMemoryStream(const BinaryMemoryStream&) = delete;
+
+private:
+  uint8_t* buffer;
+  std::size_t capacity;
+  std::size_t data_size;
+  std::size_t pos;
+};
+
+// Read-ahead decorator: reads are served from a buffer refilled with one
+// `read` of the inner stream, and seeks inside the buffer cost no calls of the
+// inner stream. Reads of at least the buffer size go straight through.
+// `Load` and `GetFileProps` apply it to streams without `peek` themselves.
+// small caveat: `inner` MUST live till the stream is destroyed
+struct MINIMGIO_API BufferedBinaryStream : public BinaryStream {
+  static const std::size_t DEFAULT_BUFFER_SIZE = 256 * 1024;
+
+  BufferedBinaryStream(BinaryStream &inner,
+                       std::size_t buffer_size = DEFAULT_BUFFER_SIZE);
+  ~BufferedBinaryStream() override;
+  MinResult initialize(MISInitFlag flag) override;
+  std::size_t read(void* buffer, std::size_t size) override;
+  std::size_t write(const void* buffer, std::size_t size) override;
+  int64_t lseek(int64_t offset, int whence) override;
+  void error(const char* message) override;
+  const char *get_source() const override;
+
+private:
+  // moves the inner stream to `this->pos`
+  bool sync_inner();
+
+  BinaryStream &inner;
+  uint8_t* buffer;
+  const std::size_t buffer_size;
+  std::size_t buffer_fill;  // valid bytes in the buffer
+  int64_t buffer_start;  // stream offset of the first buffered byte
+  int64_t pos;
+  int64_t inner_pos;  // -1 when unknown
+};
+
+namespace internal {
+struct Decoder;
+}
+
+// Serves several queries about one image file: the stream is initialized and
+// its format is guessed once, and the codec keeps what it has parsed between
+// the calls, so `get_file_props` followed by `load` of the same page parses the
+// headers once. Each of the free functions below opens a session of its own.
+// All queries use the same `p_options`, if any (see `DecodeOptions`).
+// small caveat: `stream` MUST live till the session is destroyed and must not
+// be read or seeked by others meanwhile
+struct MINIMGIO_API DecoderSession {
+  explicit DecoderSession(
+      BinaryStream &stream, const DecodeOptions *p_options = nullptr);
+  ~DecoderSession();
+
+  MinResult get_num_pages(int &num_pages);
+  MinResult get_page_name(char *p_page_name, int page_name_size, int page);
+  MinResult get_file_props(
+      MinImg &img, ExtImgProps *p_props = nullptr, int page = 0);
+  MinResult load(const MinImg &img, int page = 0);
+
+  DecoderSession(const DecoderSession&) = delete;
+  DecoderSession& operator=(const DecoderSession&) = delete;
+
+private:
+  // initializes the stream, guesses the format and creates the decoder
+  MinResult open();
+
+  BinaryStream &stream;
+  BufferedBinaryStream buffered_stream;  // for streams without `peek`
+  BinaryStream *p_source;  // the stream the decoder reads
+  DecodeOptions options;
+  ImgFileFormat iff;
+  internal::Decoder *p_decoder;  // nullptr until opened
+};
+
 MINIMGIO_API MinResult GetNumPages(
     int          &num_pages,
     BinaryStream &stream);
@@ -304,15 +476,17 @@ MINIMGIO_API MinResult GetPageName(
     int page);
 
 MINIMGIO_API MinResult GetFileProps(
-    MinImg       &img,
-    BinaryStream &stream,
-    ExtImgProps  *p_props = nullptr,
-    int           page = 0);
+    MinImg              &img,
+    BinaryStream        &stream,
+    ExtImgProps         *p_props = nullptr,
+    int                  page = 0,
+    const DecodeOptions *p_options = nullptr);
 
 MINIMGIO_API MinResult Load(
-    const MinImg &img,
-    BinaryStream &stream,
-    int           page = 0);
+    const MinImg        &img,
+    BinaryStream        &stream,
+    int                  page = 0,
+    const DecodeOptions *p_options = nullptr);
 
 MINIMGIO_API MinResult Save(
     BinaryStream      &stream,
@@ -321,6 +495,16 @@ MINIMGIO_API MinResult Save(
     const ExtImgProps *p_props = nullptr,
     int                page = 0);
 
+// Rotates, flips or crops a JPEG image without decoding it, on the DCT
+// coefficients, and writes the result to `dst_stream`. The EXIF orientation is
+// applied too and reset in the copied EXIF data. The partial iMCUs at the
+// right and bottom edges are dropped when they would have to move to the
+// opposite side, like `jpegtran -trim` does.
+MINIMGIO_API MinResult TransformJpeg(
+    BinaryStream           &dst_stream,
+    BinaryStream           &src_stream,
+    const TransformOptions *p_options = nullptr);
+
 MINIMGIO_API MinResult Pack(
     const MinImg &dst_image,
     const MinImg &src_image,
@@ -99,6 +99,64 @@ typedef struct {
   uint32_t       focal_length_den;  ///< EXIF FocalLength denomenator.
 } ExtImgProps;
 
+/**
+ * @brief   Specifies how an image is decoded.
+ * @details The structure asks to decode a reduced image or a region of it. The
+ *          properties query and the load have to get the same options: the
+ *          query reports the image the load produces. Reduction is a request,
+ *          not a demand: formats which cannot decode reduced images (all but
+ *          JPEG) decode and report the full one. The region is given in the
+ *          coordinates of the image as it is shown, after the EXIF orientation
+ *          and the reduction are applied; only JPEG decodes regions, other
+ *          formats fail with @c MR_NOT_IMPLEMENTED. Zero-initialized options
+ *          decode the full image.
+ * @ingroup MinImgIOAPI
+ */
+typedef struct {
+  int  scale_denom;    ///< Decode 1/scale_denom of the size: 1, 2, 4 or 8 (0 means 1).
+  int  max_width;      ///< If positive, reduce until the width fits.
+  int  max_height;     ///< If positive, reduce until the height fits.
+  int  region_x;       ///< The x-coordinate of the left-top corner of the region.
+  int  region_y;       ///< The y-coordinate of the left-top corner of the region.
+  int  region_width;   ///< The width of the region (0 means the whole image).
+  int  region_height;  ///< The height of the region (0 means the whole image).
+} DecodeOptions;
+
+
+/**
+ * @brief   Specifies lossless transformations of JPEG images.
+ * @details The transformations apply to the image as it is shown, that is
+ *          after its EXIF orientation.
+ * @ingroup MinImgIOAPI
+ */
+typedef enum {
+  ITR_NONE,             ///< Keeps the image as it is shown.
+  ITR_FLIP_HORIZONTAL,  ///< Mirrors the left and the right sides.
+  ITR_FLIP_VERTICAL,    ///< Mirrors the top and the bottom.
+  ITR_TRANSPOSE,        ///< Mirrors across the top-left to bottom-right diagonal.
+  ITR_TRANSVERSE,       ///< Mirrors across the top-right to bottom-left diagonal.
+  ITR_ROTATE_90,        ///< Rotates by 90 degrees clockwise.
+  ITR_ROTATE_180,       ///< Rotates by 180 degrees.
+  ITR_ROTATE_270        ///< Rotates by 270 degrees clockwise.
+} ImgTransform;
+
+/**
+ * @brief   Specifies how a JPEG image is transformed without recompression.
+ * @details The crop is given in the coordinates of the transformed image. Its
+ *          left-top corner has to lie on the iMCU grid (8 or 16 pixels,
+ *          depending on the chroma subsampling). Zero crop sizes keep the
+ *          whole image. Zero-initialized options only apply the EXIF
+ *          orientation.
+ * @ingroup MinImgIOAPI
+ */
+typedef struct {
+  ImgTransform  transform;    ///< The transformation (see #ImgTransform).
+  int           crop_x;       ///< The x-coordinate of the left-top corner of the crop.
+  int           crop_y;       ///< The y-coordinate of the left-top corner of the crop.
+  int           crop_width;   ///< The width of the crop (0 means the whole image).
+  int           crop_height;  ///< The height of the crop (0 means the whole image).
+} TransformOptions;
+
 
 typedef struct {
   MinResult (*initialize)(void *handle, MISInitFlag flag);
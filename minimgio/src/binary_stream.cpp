@@ -33,7 +33,8 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <sys/stat.h>  // fstat
 #include <fcntl.h>  // open,  O_* flags
 
-#include <cstring>  // strerror
+#include <cstdint>  // SIZE_MAX
+#include <cstring>  // strerror, memcpy
 #include <minbase/minresult.h>
 #include <minimgio/minimgio.hpp>
 #include <minutils/smartptr.h>
@@ -42,6 +43,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #ifndef _WIN32
 #  include <unistd.h>  // close, read, write
+#  include <sys/mman.h>  // mmap, munmap, madvise
 #  include <cerrno>  // errno
 #  if defined(_LARGEFILE64_SOURCE) && _LFS64_LARGEFILE-0
 #    define MINIMGIO_LSEEK ::lseek64
@@ -291,6 +293,232 @@ const char *BinaryFileStream::get_source() const {
   return this->filename;
 }
 
+//
+// BinaryMappedFileStream
+//
+BinaryMappedFileStream::BinaryMappedFileStream(const char* filename):
+  BinaryFileStream(filename), data(nullptr), size(0), pos(0)
+#ifdef _WIN32
+  , mapping(NULL)
+#endif
+{}
+
+BinaryMappedFileStream::~BinaryMappedFileStream() {
+  if (!this->data)
+    return;
+#ifndef _WIN32
+  ::munmap(const_cast<uint8_t*>(this->data), this->size);
+#else
+  UnmapViewOfFile(this->data);
+  CloseHandle(this->mapping);
+#endif
+}
+
+MinResult BinaryMappedFileStream::initialize(MISInitFlag flag) {
+  MR_PROPAGATE_ERROR(BinaryFileStream::initialize(flag));
+  if (this->data || flag != MIS_READONLY)
+    return MR_SUCCESS;
+  // any failure below leaves the descriptor calls to serve the stream
+#ifndef _WIN32
+  struct stat path_stat;
+  if (fstat(this->fd, &path_stat) != 0 || !S_ISREG(path_stat.st_mode) ||
+      path_stat.st_size <= 0 ||
+      static_cast<uint64_t>(path_stat.st_size) > SIZE_MAX)
+    return MR_SUCCESS;
+  const std::size_t file_size = static_cast<std::size_t>(path_stat.st_size);
+  void* p_map = ::mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+  if (p_map == MAP_FAILED)
+    return MR_SUCCESS;
+#  ifdef MADV_SEQUENTIAL
+  ::madvise(p_map, file_size, MADV_SEQUENTIAL);
+#  endif
+#  ifdef MADV_WILLNEED
+  ::madvise(p_map, file_size, MADV_WILLNEED);
+#  endif
+#else
+  LARGE_INTEGER file_size_li;
+  if (GetFileType(this->handle) != FILE_TYPE_DISK ||
+      !GetFileSizeEx(this->handle, &file_size_li) ||
+      file_size_li.QuadPart <= 0 ||
+      static_cast<uint64_t>(file_size_li.QuadPart) > SIZE_MAX)
+    return MR_SUCCESS;
+  const std::size_t file_size = static_cast<std::size_t>(file_size_li.QuadPart);
+  this->mapping = CreateFileMappingW(this->handle, NULL, PAGE_READONLY, 0, 0,
+                                     NULL);
+  if (!this->mapping)
+    return MR_SUCCESS;
+  void* p_map = MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!p_map) {
+    CloseHandle(this->mapping);
+    this->mapping = NULL;
+    return MR_SUCCESS;
+  }
+#endif // !_WIN32
+  this->data = static_cast<const uint8_t*>(p_map);
+  this->size = file_size;
+  // the descriptor may have been read before the mapping was made
+  const int64_t fd_pos = BinaryFileDescriptorStream::lseek(0, SEEK_CUR);
+  this->pos = fd_pos > 0 ? static_cast<std::size_t>(fd_pos) : 0;
+  return MR_SUCCESS;
+}
+
+std::size_t BinaryMappedFileStream::read(void* buffer, std::size_t size) {
+  if (!this->data)
+    return BinaryFileDescriptorStream::read(buffer, size);
+  if (this->pos >= this->size)
+    return 0;
+  const std::size_t n = std::min(size, this->size - this->pos);
+  ::memcpy(buffer, this->data + this->pos, n);
+  this->pos += n;
+  return n;
+}
+
+std::size_t BinaryMappedFileStream::write(const void* buffer, std::size_t size) {
+  if (!this->data)
+    return BinaryFileDescriptorStream::write(buffer, size);
+  this->error("writing to a mapped file");
+  return 0;
+}
+
+int64_t BinaryMappedFileStream::lseek(int64_t offset, int whence) {
+  if (!this->data)
+    return BinaryFileDescriptorStream::lseek(offset, whence);
+  int64_t new_pos = -1;
+  switch (whence) {
+    case SEEK_SET: new_pos = offset; break;
+    case SEEK_CUR: new_pos = static_cast<int64_t>(this->pos) + offset; break;
+    case SEEK_END: new_pos = static_cast<int64_t>(this->size) + offset; break;
+  }
+  if (new_pos < 0)
+    return -1;
+  this->pos = static_cast<std::size_t>(new_pos);
+  return new_pos;
+}
+
+const uint8_t* BinaryMappedFileStream::peek(std::size_t &size) {
+  if (!this->data) {
+    size = 0;
+    return nullptr;
+  }
+  const std::size_t pos = std::min(this->pos, this->size);
+  size = this->size - pos;
+  return this->data + pos;
+}
+
+//
+// BufferedBinaryStream
+//
+const std::size_t BufferedBinaryStream::DEFAULT_BUFFER_SIZE;
+
+BufferedBinaryStream::BufferedBinaryStream(
+    BinaryStream &inner,
+    std::size_t   buffer_size):
+  inner(inner), buffer(nullptr), buffer_size(buffer_size), buffer_fill(0),
+  buffer_start(0), pos(0), inner_pos(-1) {}
+
+BufferedBinaryStream::~BufferedBinaryStream() {
+  MinMemFree(this->buffer);
+}
+
+MinResult BufferedBinaryStream::initialize(MISInitFlag flag) {
+  // the buffered bytes stay valid, but the inner position may change
+  this->inner_pos = -1;
+  return this->inner.initialize(flag);
+}
+
+bool BufferedBinaryStream::sync_inner() {
+  if (this->inner_pos == this->pos)
+    return true;
+  this->inner_pos = this->inner.lseek(this->pos, SEEK_SET);
+  return this->inner_pos == this->pos;
+}
+
+std::size_t BufferedBinaryStream::read(void* out_buffer, std::size_t size) {
+  uint8_t* p_out = static_cast<uint8_t*>(out_buffer);
+  std::size_t done = 0;
+  while (done < size) {
+    const int64_t offset = this->pos - this->buffer_start;
+    if (offset >= 0 && static_cast<uint64_t>(offset) < this->buffer_fill) {
+      const std::size_t n = std::min(
+        size - done, this->buffer_fill - static_cast<std::size_t>(offset));
+      ::memcpy(p_out + done, this->buffer + offset, n);
+      done += n;
+      this->pos += n;
+      continue;
+    }
+    if (!this->buffer && size - done < this->buffer_size)
+      this->buffer = MinMemAllocArray<uint8_t>(this->buffer_size, MMT_CODEC);
+    if (!this->sync_inner())
+      break;
+    if (!this->buffer || size - done >= this->buffer_size) {
+      // large reads gain nothing from the buffer
+      const std::size_t n = this->inner.read(p_out + done, size - done);
+      if (n > size - done)  // an error of a descriptor read
+        break;
+      done += n;
+      this->pos += n;
+      this->inner_pos = this->pos;
+      break;
+    }
+    const std::size_t n = this->inner.read(this->buffer, this->buffer_size);
+    this->buffer_start = this->pos;
+    this->buffer_fill = n > this->buffer_size ? 0 : n;
+    this->inner_pos = this->pos + this->buffer_fill;
+    if (!this->buffer_fill)
+      break;
+  }
+  return done;
+}
+
+std::size_t BufferedBinaryStream::write(const void* buffer, std::size_t size) {
+  this->buffer_fill = 0;
+  if (!this->sync_inner())
+    return 0;
+  const std::size_t n = this->inner.write(buffer, size);
+  if (n <= size) {
+    this->pos += n;
+    this->inner_pos = this->pos;
+  } else {
+    this->inner_pos = -1;
+  }
+  return n;
+}
+
+int64_t BufferedBinaryStream::lseek(int64_t offset, int whence) {
+  int64_t new_pos = -1;
+  switch (whence) {
+    case SEEK_SET: new_pos = offset; break;
+    case SEEK_CUR: new_pos = this->pos + offset; break;
+    case SEEK_END: {
+      // the size is only known to the inner stream
+      this->inner_pos = this->inner.lseek(offset, SEEK_END);
+      if (this->inner_pos < 0)
+        return -1;
+      this->pos = this->inner_pos;
+      return this->pos;
+    }
+  }
+  if (new_pos < 0)
+    return -1;
+  if (new_pos < this->buffer_start ||
+      new_pos > this->buffer_start + static_cast<int64_t>(this->buffer_fill)) {
+    // outside of the buffer the inner stream decides if the seek is valid
+    this->inner_pos = this->inner.lseek(new_pos, SEEK_SET);
+    if (this->inner_pos != new_pos)
+      return this->inner_pos < 0 ? -1 : this->inner_pos;
+  }
+  this->pos = new_pos;
+  return this->pos;
+}
+
+void BufferedBinaryStream::error(const char* message) {
+  this->inner.error(message);
+}
+
+const char *BufferedBinaryStream::get_source() const {
+  return this->inner.get_source();
+}
+
 //
 // BinaryMemoryReadonlyStream
 //
@@ -344,5 +572,91 @@ int64_t BinaryMemoryReadonlyStream::lseek(
   return this->pos;
 
 }
+const uint8_t* BinaryMemoryReadonlyStream::peek(
+    std::size_t &peek_size) {
+  const std::size_t pos = std::min(this->pos, this->size);
+  peek_size = this->size - pos;
+  return this->buffer + pos;
+}
+
+BinaryMemoryStream::BinaryMemoryStream(
+    std::size_t capacity):
+  buffer(nullptr), capacity(0), data_size(0), pos(0) {
+  this->reserve(capacity);
+}
+
+BinaryMemoryStream::~BinaryMemoryStream() {
+  MinMemFree(this->buffer);
+}
+
+MinResult BinaryMemoryStream::reserve(
+    std::size_t capacity) {
+  if (capacity <= this->capacity)
+    return MR_SUCCESS;
+  uint8_t *new_buffer = MinMemAllocArray<uint8_t>(capacity, MMT_CODEC);
+  if (!new_buffer)
+    return MR_ENV_ERROR;
+  if (this->data_size)
+    ::memcpy(new_buffer, this->buffer, this->data_size);
+  MinMemFree(this->buffer);
+  this->buffer = new_buffer;
+  this->capacity = capacity;
+  return MR_SUCCESS;
+}
+
+std::size_t BinaryMemoryStream::read(
+    void        *out_buffer,
+    std::size_t  read_size) {
+  if (this->pos >= this->data_size)
+    return 0;
+  const std::size_t n = std::min(read_size, this->data_size - this->pos);
+  ::memcpy(out_buffer, this->buffer + this->pos, n);
+  this->pos += n;
+  return n;
+}
+
+std::size_t BinaryMemoryStream::write(
+    const void  *in_buffer,
+    std::size_t  write_size) {
+  if (write_size > SIZE_MAX - this->pos)
+    return 0;
+  const std::size_t end = this->pos + write_size;
+  if (end > this->capacity) {
+    // doubling keeps the copying linear in the final size
+    const std::size_t grown = this->capacity > SIZE_MAX / 2 ?
+      SIZE_MAX : std::max<std::size_t>(this->capacity * 2, 4096);
+    if (this->reserve(std::max(end, grown)) != MR_SUCCESS)
+      return 0;
+  }
+  if (this->pos > this->data_size)
+    ::memset(this->buffer + this->data_size, 0, this->pos - this->data_size);
+  if (write_size)
+    ::memcpy(this->buffer + this->pos, in_buffer, write_size);
+  this->pos = end;
+  this->data_size = std::max(this->data_size, end);
+  return write_size;
+}
+
+int64_t BinaryMemoryStream::lseek(
+    int64_t offset,
+    int     whence) {
+  int64_t new_pos = -1;
+  switch (whence) {
+    case SEEK_SET: new_pos = offset; break;
+    case SEEK_CUR: new_pos = static_cast<int64_t>(this->pos) + offset; break;
+    case SEEK_END: new_pos = static_cast<int64_t>(this->data_size) + offset; break;
+  }
+  if (new_pos < 0)
+    return -1;
+  this->pos = static_cast<std::size_t>(new_pos);
+  return new_pos;
+}
+
+const uint8_t* BinaryMemoryStream::peek(
+    std::size_t &peek_size) {
+  const std::size_t pos = std::min(this->pos, this->data_size);
+  peek_size = this->data_size - pos;
+  return this->buffer ? this->buffer + pos : nullptr;
+}
 
 }  // namespace minimgio
@@ -30,12 +30,32 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #pragma once
-#ifndef MINIMGAPI_SRC_VECTOR_SSE_COPY_CHANNELS_INL_H_INCLUDED
-#define MINIMGAPI_SRC_VECTOR_SSE_COPY_CHANNELS_INL_H_INCLUDED
-
-#include <emmintrin.h>
-#include <xmmintrin.h>
-#include <minbase/crossplat.h>
-#include <minutils/smartptr.h>
-
-#endif // #ifndef MINIMGAPI_SRC_VECTOR_SSE_COPY_CHANNELS_INL_H_INCLUDED
+#ifndef MINIMGIO_SRC_DECODER_H_INCLUDED
+#define MINIMGIO_SRC_DECODER_H_INCLUDED
+
+#include <minbase/minresult.h>
+#include <minbase/minimg.h>
+#include <minimgio/minimgio.hpp>
+
+namespace minimgio { namespace internal {
+
+// Reading side of one opened image file, created once the format is known.
+// Implementations keep what they parsed between calls (headers, decompressor
+// state, directory lists), so that a property query followed by the load of
+// the same page parses the file once.
+struct Decoder {
+  virtual ~Decoder() {}
+  virtual MinResult GetNumPages(
+      int &num_pages) = 0;
+  virtual MinResult GetProps(
+      MinImg      &img,
+      ExtImgProps *p_props,
+      int          page) = 0;
+  virtual MinResult Load(
+      const MinImg &img,
+      int           page) = 0;
+};
+
+}} // namespace minimgio::internal
+
+#endif // #ifndef MINIMGIO_SRC_DECODER_H_INCLUDED
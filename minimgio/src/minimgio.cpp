@@ -43,6 +43,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "minimgiodevice.h"
 #include "utils.h"
 #include "pack.h"
+#include "decoder.h"
 
 #ifdef _WIN32
 #define stricmp _stricmp
@@ -55,18 +56,10 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 namespace minimgio { namespace internal {
 
 #define MIN_DECLARE_INTERNAL(MODULE_NAME) \
-MinResult GetNumPages ## MODULE_NAME(     \
-    int &num_pages,                       \
-    BinaryStream &stream);                \
-MinResult GetProps ## MODULE_NAME(        \
-    MinImg       &img,                    \
-    ExtImgProps  *p_props,                \
-    BinaryStream &stream,                 \
-    int          page);                   \
-MinResult Load ## MODULE_NAME(            \
-    MinImg const &img,                    \
-    BinaryStream &stream,                 \
-    int          page);                   \
+MinResult CreateDecoder ## MODULE_NAME(   \
+    Decoder             *&p_decoder,      \
+    BinaryStream        &stream,          \
+    const DecodeOptions &options);        \
 MinResult Save ## MODULE_NAME(            \
     BinaryStream      &stream,            \
     const MinImg      &img,               \
@@ -82,6 +75,10 @@ MIN_DECLARE_INTERNAL(Tiff)
 
 #ifdef WITH_JPEG
 MIN_DECLARE_INTERNAL(Jpeg)
+MinResult TransformJpeg(
+    BinaryStream           &dst_stream,
+    BinaryStream           &src_stream,
+    const TransformOptions &options);
 #define MIN_JPEG_CALL(call) call
 #else
 #define MIN_JPEG_CALL(call) MR_STRIPPED_VERSION
@@ -106,6 +103,31 @@ MIN_DECLARE_INTERNAL(Lst)
 #undef MIN_DECLARE_INTERNAL
 }}
 
+#ifdef MINIMGIO_STOPWATCH
+DECLARE_MINSTOPWATCH(swGetFileProps, "minimgio::GetFileProps");
+DECLARE_MINSTOPWATCH(swLoad,         "minimgio::Load");
+DECLARE_MINSTOPWATCH(swLoadTiff,     "minimgio::LoadTiff");
+DECLARE_MINSTOPWATCH(swLoadJpeg,     "minimgio::LoadJpeg");
+DECLARE_MINSTOPWATCH(swLoadPng,      "minimgio::LoadPng");
+DECLARE_MINSTOPWATCH(swLoadWebP,     "minimgio::LoadWebP");
+DECLARE_MINSTOPWATCH(swLoadLst,      "minimgio::LoadLst");
+DECLARE_MINSTOPWATCH(swSave,         "minimgio::Save");
+DECLARE_MINSTOPWATCH(swSaveTiff,     "minimgio::SaveTiff");
+DECLARE_MINSTOPWATCH(swSaveJpeg,     "minimgio::SaveJpeg");
+DECLARE_MINSTOPWATCH(swSavePng,      "minimgio::SavePng");
+DECLARE_MINSTOPWATCH(swSaveWebP,     "minimgio::SaveWebP");
+
+static const minstopwatch::Stopwatch &LoadStopwatch(ImgFileFormat iff) {
+  switch (iff) {
+    case IFF_TIFF: return swLoadTiff;
+    case IFF_JPEG: return swLoadJpeg;
+    case IFF_PNG:  return swLoadPng;
+    case IFF_WEBP: return swLoadWebP;
+    default:       return swLoadLst;  // `open` accepts no other format
+  }
+}
+#endif
+
 MinResult GetLstPageName(
     char *pPageName,
     int pageNameSize,
@@ -160,23 +182,61 @@ static MinResult GuessImageFileFormat(
 }
 } // namespace internal
 
-MINIMGIO_API MinResult GetNumPages(
-    int &pages,
-    BinaryStream &stream) {
-  MR_PROPAGATE_ERROR(stream.initialize(MIS_READONLY));
-  ImgFileFormat iff;
-  MR_PROPAGATE_ERROR(internal::GuessImageFileFormat(iff, stream));
-  switch (iff) {
+static bool IsMemoryBacked(BinaryStream &stream) {
+  std::size_t size = 0;
+  return stream.peek(size) != nullptr;
+}
+
+DecoderSession::DecoderSession(
+    BinaryStream        &stream,
+    const DecodeOptions *p_options):
+  stream(stream), buffered_stream(stream), p_source(nullptr), options(),
+  iff(IFF_UNKNOWN), p_decoder(nullptr) {
+  if (p_options)
+    this->options = *p_options;
+}
+
+DecoderSession::~DecoderSession() {
+  delete this->p_decoder;
+}
+
+MinResult DecoderSession::open() {
+  if (this->p_decoder)
+    return MR_SUCCESS;
+  const int scale_denom = this->options.scale_denom;
+  if (scale_denom != 0 && scale_denom != 1 && scale_denom != 2 &&
+      scale_denom != 4 && scale_denom != 8)
+    return MR_CONTRACT_VIOLATION;
+  const bool has_region =
+    this->options.region_width != 0 || this->options.region_height != 0;
+  MR_PROPAGATE_ERROR(this->stream.initialize(MIS_READONLY));
+  this->p_source = IsMemoryBacked(this->stream) ?
+    &this->stream : static_cast<BinaryStream*>(&this->buffered_stream);
+  BinaryStream &source = *this->p_source;
+  MR_PROPAGATE_ERROR(internal::GuessImageFileFormat(this->iff, source));
+  // the lists pass the region on to their pages
+  if (has_region && this->iff != IFF_JPEG && this->iff != IFF_LST)
+    return MR_NOT_IMPLEMENTED;
+  switch (this->iff) {
     case IFF_TIFF:
-      return MIN_TIFF_CALL(minimgio::internal::GetNumPagesTiff(pages, stream));
+      return MIN_TIFF_CALL(
+        internal::CreateDecoderTiff(
+          this->p_decoder, source, this->options));
     case IFF_JPEG:
-      return MIN_JPEG_CALL(minimgio::internal::GetNumPagesJpeg(pages, stream));
+      return MIN_JPEG_CALL(
+        internal::CreateDecoderJpeg(
+          this->p_decoder, source, this->options));
     case IFF_PNG:
-      return MIN_PNG_CALL(minimgio::internal::GetNumPagesPng(pages, stream));
+      return MIN_PNG_CALL(
+        internal::CreateDecoderPng(
+          this->p_decoder, source, this->options));
     case IFF_WEBP:
-      return MIN_WEBP_CALL(minimgio::internal::GetNumPagesWebP(pages, stream));
+      return MIN_WEBP_CALL(
+        internal::CreateDecoderWebP(
+          this->p_decoder, source, this->options));
     case IFF_LST:
-      return minimgio::internal::GetNumPagesLst(pages, stream);
+      return internal::CreateDecoderLst(
+        this->p_decoder, source, this->options);
     case IFF_UNKNOWN:
     default:
       return MR_CONTRACT_VIOLATION;
@@ -184,86 +244,76 @@ MINIMGIO_API MinResult GetNumPages(
   return MR_INTERNAL_ERROR;
 }
 
+MinResult DecoderSession::get_num_pages(
+    int &num_pages) {
+  MR_PROPAGATE_ERROR(this->open());
+  return this->p_decoder->GetNumPages(num_pages);
+}
+
+MinResult DecoderSession::get_page_name(
+    char *p_page_name,
+    int   page_name_size,
+    int   page) {
+  MR_PROPAGATE_ERROR(this->open());
+  if (this->iff == IFF_LST)
+    return GetLstPageName(p_page_name, page_name_size, *this->p_source, page);
+  return CopyString(p_page_name, page_name_size, this->stream.get_source());
+}
+
+MinResult DecoderSession::get_file_props(
+    MinImg      &img,
+    ExtImgProps *p_props,
+    int          page) {
+  MINIMGIO_DECLARE_STOPWATCH_CTL(swGetFileProps, NULL);
+  MR_PROPAGATE_ERROR(this->open());
+  return this->p_decoder->GetProps(img, p_props, page);
+}
+
+MinResult DecoderSession::load(
+    const MinImg &img,
+    int           page) {
+  MINIMGIO_DECLARE_STOPWATCH_CTL(swLoad, &img);
+  MR_PROPAGATE_ERROR(this->open());
+#ifdef MINIMGIO_STOPWATCH
+  const minstopwatch::Stopwatch &swLoadFormat = LoadStopwatch(this->iff);
+#endif
+  MINIMGIO_DECLARE_STOPWATCH_CTL(swLoadFormat, &img);
+  return this->p_decoder->Load(img, page);
+}
+
+MINIMGIO_API MinResult GetNumPages(
+    int &pages,
+    BinaryStream &stream) {
+  DecoderSession session(stream);
+  return session.get_num_pages(pages);
+}
+
 MINIMGIO_API MinResult GetPageName(
     char *pPageName,
     int pageNameSize,
     BinaryStream &stream,
     int page) {
-  MR_PROPAGATE_ERROR(stream.initialize(MIS_READONLY));
-  ImgFileFormat iff;
-  MR_PROPAGATE_ERROR(internal::GuessImageFileFormat(iff, stream));
-  switch (iff) {
-    case IFF_TIFF:
-      return MIN_TIFF_CALL(CopyString(
-        pPageName, pageNameSize, stream.get_source()));
-    case IFF_JPEG:
-      return MIN_JPEG_CALL(CopyString(
-        pPageName, pageNameSize, stream.get_source()));
-    case IFF_PNG:
-      return MIN_PNG_CALL(CopyString(
-        pPageName, pageNameSize, stream.get_source()));
-    case IFF_WEBP:
-      return MIN_WEBP_CALL(CopyString(
-        pPageName, pageNameSize, stream.get_source()));
-    case IFF_LST:
-      return GetLstPageName(pPageName, pageNameSize, stream, page);
-    default:
-      return MR_CONTRACT_VIOLATION;
-  }
-
-  return MR_INTERNAL_ERROR;
+  DecoderSession session(stream);
+  return session.get_page_name(pPageName, pageNameSize, page);
 }
 
-
 MINIMGIO_API MinResult GetFileProps(
-    MinImg       &img,
-    BinaryStream &stream,
-    ExtImgProps  *p_props,
-    int           page) {
-  MR_PROPAGATE_ERROR(stream.initialize(MIS_READONLY));
-  ImgFileFormat iff;
-  MR_PROPAGATE_ERROR(internal::GuessImageFileFormat(iff, stream));
-  switch (iff) {
-    case IFF_TIFF:
-      return MIN_TIFF_CALL(internal::GetPropsTiff(img, p_props, stream, page));
-    case IFF_JPEG:
-      return MIN_JPEG_CALL(internal::GetPropsJpeg(img, p_props, stream, page));
-    case IFF_PNG:
-      return MIN_PNG_CALL(internal::GetPropsPng(img, p_props, stream, page));
-    case IFF_WEBP:
-      return MIN_WEBP_CALL(internal::GetPropsWebP(img, p_props, stream, page));
-    case IFF_LST:
-      return internal::GetPropsLst(img, p_props, stream, page);
-    case IFF_UNKNOWN:
-    default:
-      return MR_CONTRACT_VIOLATION;
-  }
-  return MR_INTERNAL_ERROR;
+    MinImg              &img,
+    BinaryStream        &stream,
+    ExtImgProps         *p_props,
+    int                  page,
+    const DecodeOptions *p_options) {
+  DecoderSession session(stream, p_options);
+  return session.get_file_props(img, p_props, page);
 }
 
 MINIMGIO_API MinResult Load(
-    const MinImg &img,
-    BinaryStream &stream,
-    int           page) {
-  MR_PROPAGATE_ERROR(stream.initialize(MIS_READONLY));
-  ImgFileFormat iff;
-  MR_PROPAGATE_ERROR(internal::GuessImageFileFormat(iff, stream));
-  switch (iff) {
-    case IFF_TIFF:
-      return MIN_TIFF_CALL(internal::LoadTiff(img, stream, page));
-    case IFF_JPEG:
-      return MIN_JPEG_CALL(internal::LoadJpeg(img, stream, page));
-    case IFF_PNG:
-      return MIN_PNG_CALL(internal::LoadPng(img, stream, page));
-    case IFF_WEBP:
-      return MIN_WEBP_CALL(internal::LoadWebP(img, stream, page));
-    case IFF_LST:
-      return internal::LoadLst(img, stream, page);
-    case IFF_UNKNOWN:
-    default:
-      return MR_CONTRACT_VIOLATION;
-  }
-  return MR_INTERNAL_ERROR;
+    const MinImg        &img,
+    BinaryStream        &stream,
+    int                  page,
+    const DecodeOptions *p_options) {
+  DecoderSession session(stream, p_options);
+  return session.load(img, page);
 }
 
 MINIMGIO_API MinResult Save(
@@ -273,16 +323,25 @@ MINIMGIO_API MinResult Save(
     const ExtImgProps  *p_props,
     int                 page) {
 #ifdef MINIMGIO_GENERATE
+  MINIMGIO_DECLARE_STOPWATCH_CTL(swSave, &img);
   switch (img_file_format)
   {
-  case IFF_TIFF:
+  case IFF_TIFF: {
+    MINIMGIO_DECLARE_STOPWATCH_CTL(swSaveTiff, &img);
     return MIN_TIFF_CALL(internal::SaveTiff(stream, img, p_props, page));
-  case IFF_JPEG:
+  }
+  case IFF_JPEG: {
+    MINIMGIO_DECLARE_STOPWATCH_CTL(swSaveJpeg, &img);
     return MIN_JPEG_CALL(internal::SaveJpeg(stream, img, p_props, page));
-  case IFF_PNG:
+  }
+  case IFF_PNG: {
+    MINIMGIO_DECLARE_STOPWATCH_CTL(swSavePng, &img);
     return MIN_PNG_CALL(internal::SavePng(stream, img, p_props, page));
-  case IFF_WEBP:
+  }
+  case IFF_WEBP: {
+    MINIMGIO_DECLARE_STOPWATCH_CTL(swSaveWebP, &img);
     return MIN_WEBP_CALL(internal::SaveWebP(stream, img, p_props, page));
+  }
   default:
     return MR_CONTRACT_VIOLATION;
   }
@@ -292,6 +351,22 @@ MINIMGIO_API MinResult Save(
 #endif
 }
 
+MINIMGIO_API MinResult TransformJpeg(
+    BinaryStream           &dst_stream,
+    BinaryStream           &src_stream,
+    const TransformOptions *p_options) {
+#ifdef MINIMGIO_GENERATE
+  if (!p_options) {
+    const TransformOptions no_options = {};
+    return TransformJpeg(dst_stream, src_stream, &no_options);
+  }
+  return MIN_JPEG_CALL(
+    internal::TransformJpeg(dst_stream, src_stream, *p_options));
+#else
+  return MR_STRIPPED_VERSION;
+#endif
+}
+
 MINIMGIO_API MinResult Pack(
     const MinImg &dst_image,
     const MinImg &src_image,
@@ -418,7 +493,7 @@ MINIMGIO_API MinResult MinImgIoCreateFileStream(
     MIStreamHandle *handle, const char* path) {
   if (!handle || !path)
     return MR_CONTRACT_VIOLATION;
-  *handle = new minimgio::BinaryFileStream(path);
+  *handle = new minimgio::BinaryMappedFileStream(path);
   return MR_SUCCESS;
 }
 
@@ -431,6 +506,47 @@ MINIMGIO_API MinResult MinImgIoCreateFileDescriptorStream(
   return MR_SUCCESS;
 }
 
+MINIMGIO_API MinResult MinImgIoCreateMemoryStream(
+    MIStreamHandle *handle,
+    const uint8_t  *data,
+    size_t          size) {
+  if (!handle || (!data && size))
+    return MR_CONTRACT_VIOLATION;
+  *handle = new minimgio::BinaryMemoryReadonlyStream(data, size);
+  return MR_SUCCESS;
+}
+
+MINIMGIO_API MinResult MinImgIoCreateGrowableMemoryStream(
+    MIStreamHandle *handle,
+    size_t          capacity) {
+  if (!handle)
+    return MR_CONTRACT_VIOLATION;
+  minimgio::BinaryMemoryStream *stream = new minimgio::BinaryMemoryStream();
+  if (stream->reserve(capacity) != MR_SUCCESS) {
+    delete stream;
+    return MR_ENV_ERROR;
+  }
+  *handle = stream;
+  return MR_SUCCESS;
+}
+
+MINIMGIO_API MinResult MinImgIoGetMemoryStreamData(
+    const uint8_t  **data,
+    size_t          *size,
+    MIStreamHandle   handle) {
+  if (!data || !size || !handle)
+    return MR_CONTRACT_VIOLATION;
+  // the handle must come from `MinImgIoCreateGrowableMemoryStream`
+  minimgio::BinaryMemoryStream *stream =
+    dynamic_cast<minimgio::BinaryMemoryStream*>(
+      reinterpret_cast<minimgio::BinaryStream*>(handle));
+  if (!stream)
+    return MR_CONTRACT_VIOLATION;
+  *data = stream->data();
+  *size = stream->size();
+  return MR_SUCCESS;
+}
+
 MINIMGIO_API MinResult MinImgIoGetError(
     const char**   message,
     MIStreamHandle handle) {
@@ -473,6 +589,30 @@ MINIMGIO_API MinResult MinImgIoLoad(
     *img, *reinterpret_cast<minimgio::BinaryStream*>(stream), page);
 }
 
+MINIMGIO_API MinResult MinImgIoGetFilePropsEx(
+    MinImg              *img,
+    ExtImgProps         *p_props,
+    MIStreamHandle       stream,
+    int                  page,
+    const DecodeOptions *p_options) {
+  if (!stream || !img)
+    return MR_CONTRACT_VIOLATION;
+  return minimgio::GetFileProps(
+    *img, *reinterpret_cast<minimgio::BinaryStream*>(stream), p_props, page,
+    p_options);
+}
+
+MINIMGIO_API MinResult MinImgIoLoadEx(
+    const MinImg        *img,
+    MIStreamHandle       stream,
+    int                  page,
+    const DecodeOptions *p_options) {
+  if (!stream || !img)
+    return MR_CONTRACT_VIOLATION;
+  return minimgio::Load(
+    *img, *reinterpret_cast<minimgio::BinaryStream*>(stream), page, p_options);
+}
+
 MINIMGIO_API MinResult MinImgIoSave(
     MIStreamHandle     stream,
     const MinImg      *img,
@@ -484,3 +624,14 @@ MINIMGIO_API MinResult MinImgIoSave(
   return minimgio::Save(*reinterpret_cast<minimgio::BinaryStream*>(stream),
                         *img, img_file_format, p_props, page);
 }
+
+MINIMGIO_API MinResult MinImgIoTransformJpeg(
+    MIStreamHandle          dst_stream,
+    MIStreamHandle          src_stream,
+    const TransformOptions *p_options) {
+  if (!dst_stream || !src_stream)
+    return MR_CONTRACT_VIOLATION;
+  return minimgio::TransformJpeg(
+    *reinterpret_cast<minimgio::BinaryStream*>(dst_stream),
+    *reinterpret_cast<minimgio::BinaryStream*>(src_stream), p_options);
+}
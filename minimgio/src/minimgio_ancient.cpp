@@ -54,6 +54,11 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define stricmp strcasecmp
 #endif
 
+#ifdef MINIMGIO_STOPWATCH
+DECLARE_MINSTOPWATCH(swLoadMinImage, "LoadMinImage");
+DECLARE_MINSTOPWATCH(swSaveMinImage, "SaveMinImage");
+#endif
+
 
 typedef enum _FileLocation {
   inFileSystem,
@@ -80,7 +85,7 @@ struct UniversalBinaryStream {
   UniversalBinaryStream() : stream(NULL) {}
   MinResult initialize(const char *pFileName, const FileLocation fileLocation ) {
     if (fileLocation == inFileSystem)
-      this->stream = new minimgio::BinaryFileStream(pFileName);
+      this->stream = new minimgio::BinaryMappedFileStream(pFileName);
     else if (fileLocation == inMemory) {
       uint8_t *ptr = 0;
       size_t size = 0;
@@ -170,7 +175,7 @@ MINIMGIO_API int GetMinImagePageName(
   const FileLocation fileLocation = DeduceFileLocation(pFileName);
   if (fileLocation == inDevice)
     return GetDevicePageName(pPageName, pageNameSize, pFileName, page);
-  minimgio::BinaryFileStream stream(pFileName);
+  minimgio::BinaryMappedFileStream stream(pFileName);
   return minimgio::GetPageName(pPageName, pageNameSize, stream, page);
 }
 
@@ -200,6 +205,7 @@ MINIMGIO_API int LoadMinImage(
     const MinImg *pImg,
     const char   *pFileName,
     int           page) {
+  MINIMGIO_DECLARE_STOPWATCH_CTL(swLoadMinImage, pImg);
   if (!pFileName || !pImg)
     return MR_CONTRACT_VIOLATION;
   const FileLocation fileLocation = DeduceFileLocation(pFileName);
@@ -224,6 +230,7 @@ MINIMGIO_API int SaveMinImageEx(
     const MinImg      *pImg,
     const ExtImgProps *pProps,
     int                page) {
+  MINIMGIO_DECLARE_STOPWATCH_CTL(swSaveMinImage, pImg);
   const FileLocation fileLocation = DeduceFileLocation(pFileName);
   if (fileLocation == inDevice)
     return SaveDeviceEx(pFileName, pImg, pProps);
@@ -32,7 +32,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <cstdio>
 #include <csetjmp>
 #include <cstring>
-#include <algorithm>  // std::min
+#include <algorithm>  // std::min, std::max
 
 #include <minutils/smartptr.h>  // DEFINE_SCOPED_OBJECT
 #include <minimgapi/imgguard.hpp>
@@ -40,6 +40,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <minimgapi/minimgapi.hpp>
 
 #include "utils.h"
+#include "decoder.h"
 
 #include <jpeglib.h>
 #include <jerror.h>
@@ -106,18 +107,25 @@ static uint32_t read_uint32(uint8_t const* data, bool is_little_endian)
     return (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
 }
 
+// The size of the buffers between libjpeg and the streams. Large chunks save
+// the calls to the streams, that is the system calls of the file ones.
+#ifndef MINIMGIO_JPEG_BUFFER_SIZE
+#define MINIMGIO_JPEG_BUFFER_SIZE 65536
+#endif
+static const size_t kJpegBufferSize = MINIMGIO_JPEG_BUFFER_SIZE;
+
 // READING
 typedef struct {
   struct jpeg_source_mgr pub;
   minimgio::BinaryStream *stream;
-  JOCTET buffer[4096];
+  JOCTET *buffer;  // of `kJpegBufferSize`, in the permanent pool of `cinfo`
 } minimgio_source_mgr;
 
 // WRITING
 typedef struct {
   jpeg_destination_mgr pub;
   minimgio::BinaryStream *stream;
-  JOCTET buffer[4096];
+  JOCTET *buffer;  // of `kJpegBufferSize`, in the permanent pool of `cinfo`
 } minimgio_destination_mgr;
 
 static void minimgio_noop(j_decompress_ptr /*cinfo*/)
@@ -151,7 +159,7 @@ static boolean fill_input_buffer(j_decompress_ptr cinfo)
   minimgio_source_mgr *src = reinterpret_cast<minimgio_source_mgr*>(cinfo->src);
   size_t nbytes;
 
-  nbytes = src->stream->read(src->buffer, sizeof(src->buffer));
+  nbytes = src->stream->read(src->buffer, kJpegBufferSize);
 
   if (nbytes == 0) {
     // minimgio won't have zero lenght files here
@@ -170,9 +178,23 @@ static boolean fill_input_buffer(j_decompress_ptr cinfo)
   return TRUE;
 }
 
+// The whole file is in memory, like with `jpeg_mem_src`: running out of it
+// is the end of the file.
+static boolean fill_memory_input_buffer(j_decompress_ptr cinfo)
+{
+  static const JOCTET eoi_buffer[2] = {
+    static_cast<JOCTET>(0xFF), static_cast<JOCTET>(JPEG_EOI)
+  };
+  WARNMS(cinfo, JWRN_JPEG_EOF);
+  cinfo->src->next_input_byte = eoi_buffer;
+  cinfo->src->bytes_in_buffer = sizeof(eoi_buffer);
+  return TRUE;
+}
+
 static void RecursiveDecodeEXIF(
     ExtImgProps         *p_props,
     uint16_t            &orientation,
+    const uint8_t      *&p_orientation,
     const uint8_t *const data,
     uint32_t             ifd_offset,
     bool                 is_little_endian,
@@ -195,6 +217,7 @@ static void RecursiveDecodeEXIF(
     const uint32_t count = read_uint32(cur_ptr + 4, is_little_endian);
     if (tag == EXIF_TAG_ORIENTATION && type == EXIF_TYPE_SHORT && count == 1) {
       orientation = read_uint16(cur_ptr + 8, is_little_endian);
+      p_orientation = cur_ptr + 8;
     } else if (tag == EXIF_TAG_FOCAL_LENGTH && type == EXIF_TYPE_RATIONAL64U &&
                count == 1) {
       uint32_t offset = read_uint32(cur_ptr + 8, is_little_endian);
@@ -205,7 +228,8 @@ static void RecursiveDecodeEXIF(
       /// Check that next ifd is located after current ifd tags
       /// and not too deep recursion
       if (recursion_limit && nxt_ifd_offset >= ifd_offset + num_tags * 12)
-        RecursiveDecodeEXIF(p_props, orientation, data, nxt_ifd_offset,
+        RecursiveDecodeEXIF(p_props, orientation, p_orientation, data,
+            nxt_ifd_offset,
             is_little_endian, max_num_tags - num_tags, recursion_limit - 1);
     }
     cur_ptr += 12;
@@ -213,6 +237,61 @@ static void RecursiveDecodeEXIF(
 }
 
 
+// Parses the EXIF block of an APP1 marker, if it is one. `p_orientation`
+// points to the orientation value in the marker data, if there is one.
+static void decodeExif(
+    ExtImgProps               *p_props,
+    uint16_t                  &orientation,
+    const uint8_t            *&p_orientation,
+    const jpeg_marker_struct  &marker) {
+  static const uint8_t exif[] = { 'E', 'x', 'i', 'f', '\0', '\0' };
+  static const uint8_t big_endian[] = { 'M','M' };
+  static const uint8_t little_endian[] = { 'I','I' };
+  static const uint32_t header_sz =
+    sizeof(exif) + sizeof(little_endian) + sizeof(uint16_t) + sizeof(uint32_t);
+
+  uint32_t sz = marker.data_length;
+  if (sz < header_sz)
+    return;
+  // shift sz, so that it's right after header
+  sz -= header_sz;
+  uint8_t const* cur_ptr = marker.data;
+  // check chat it is exif header
+  if (memcmp(cur_ptr, exif, sizeof(exif)) != 0)
+    return;
+  cur_ptr += sizeof(exif);
+  // read endianness
+  bool is_little_endian;
+  if (memcmp(cur_ptr, little_endian, sizeof(little_endian)) == 0)
+    is_little_endian = true;
+  else if (memcmp(cur_ptr, big_endian, sizeof(big_endian)) == 0)
+    is_little_endian = false;
+  else
+    return;
+
+  const uint8_t* const data = cur_ptr;
+
+  cur_ptr += sizeof(little_endian);
+  if (read_uint16(cur_ptr, is_little_endian) != 42)
+    return;
+  cur_ptr += sizeof(uint16_t);
+
+  // read offset to the data
+  uint32_t offset = read_uint32(cur_ptr, is_little_endian);
+  cur_ptr += sizeof(uint32_t);
+  // if offset points inside the header, return
+  if (offset < sizeof(little_endian) + sizeof(uint16_t) + sizeof(uint32_t))
+    return;
+  // make offset relative to the cur_ptr position
+  uint32_t offset_from_cur_ptr =
+      offset - sizeof(little_endian) - sizeof(uint16_t) - sizeof(uint32_t);
+  // check that we can read the number of tags
+  if (offset_from_cur_ptr + sizeof(uint16_t) > sz)
+    return;
+  RecursiveDecodeEXIF(p_props, orientation, p_orientation, data, offset,
+      is_little_endian, (sz - 2 - offset_from_cur_ptr) / 12);
+}
+
 /// returns orientation
 static uint16_t decodeExtProps(
     ExtImgProps            *p_props,
@@ -235,57 +314,10 @@ static uint16_t decodeExtProps(
     p_props->yDPI = 0.f;
   }
 
-  static const uint8_t exif[] = { 'E', 'x', 'i', 'f', '\0', '\0' };
-  static const uint8_t big_endian[] = { 'M','M' };
-  static const uint8_t little_endian[] = { 'I','I' };
-  static const uint32_t header_sz =
-    sizeof(exif) + sizeof(little_endian) + sizeof(uint16_t) + sizeof(uint32_t);
-
   uint16_t orientation = 0;
-
-  for (jpeg_saved_marker_ptr marker = jds->marker_list; marker; marker = marker->next) {
-    uint32_t sz = marker->data_length;
-    if (sz < header_sz)
-      continue;
-    // shift sz, so that it's right after header
-    sz -= header_sz;
-    uint8_t const* cur_ptr = marker->data;
-    // check chat it is exif header
-    if (memcmp(cur_ptr, exif, sizeof(exif)) != 0)
-      continue;
-    cur_ptr += sizeof(exif);
-    // read endianness
-    bool is_little_endian;
-    if (memcmp(cur_ptr, little_endian, sizeof(little_endian)) == 0)
-      is_little_endian = true;
-    else if (memcmp(cur_ptr, big_endian, sizeof(big_endian)) == 0)
-      is_little_endian = false;
-    else
-      continue;
-
-    const uint8_t* const data = cur_ptr;
-
-    cur_ptr += sizeof(little_endian);
-    if (read_uint16(cur_ptr, is_little_endian) != 42)
-      continue;
-    cur_ptr += sizeof(uint16_t);
-
-    // read offset to the data
-    uint32_t offset = read_uint32(cur_ptr, is_little_endian);
-    cur_ptr += sizeof(uint32_t);
-    // if offset points inside the header, continue
-    if (offset < sizeof(little_endian) + sizeof(uint16_t) + sizeof(uint32_t))
-      continue;
-    // make offset relative to the cur_ptr position
-    uint32_t offset_from_cur_ptr =
-        offset - sizeof(little_endian) - sizeof(uint16_t) - sizeof(uint32_t);
-    // check that we can read the number of tags
-    if (offset_from_cur_ptr + sizeof(uint16_t) > sz)
-      continue;
-    cur_ptr += offset;
-    RecursiveDecodeEXIF(p_props, orientation, data, offset,
-        is_little_endian, (sz - 2 - offset_from_cur_ptr) / 12);
-  }
+  const uint8_t *p_orientation = NULL;
+  for (jpeg_saved_marker_ptr marker = jds->marker_list; marker; marker = marker->next)
+    decodeExif(p_props, orientation, p_orientation, *marker);
 
   if (orientation > 4 && orientation <= 8)
     std::swap(p_props->xDPI, p_props->yDPI);
@@ -314,65 +346,191 @@ static MinResult decodeImgProps(
   return MR_SUCCESS;
 }
 
+// A rectangle of the decoded image.
+typedef struct {
+  int x;
+  int y;
+  int width;
+  int height;
+} JpegRegion;
+
+// Maps a region of the image as it is shown to the region of the image as it
+// is stored (`width` x `height`), which `orientation` turns into the former.
+static JpegRegion StoredRegion(
+    const JpegRegion &shown,
+    uint16_t          orientation,
+    int               width,
+    int               height) {
+  const int right = width - shown.x - shown.width;
+  const int bottom = height - shown.y - shown.height;
+  switch (orientation) {
+  case 2: return {right, shown.y, shown.width, shown.height};
+  case 3: return {right, bottom, shown.width, shown.height};
+  case 4: return {shown.x, bottom, shown.width, shown.height};
+  case 5: return {shown.y, shown.x, shown.height, shown.width};
+  case 6: return {shown.y, height - shown.x - shown.width,
+                  shown.height, shown.width};
+  case 7: return {width - shown.y - shown.height,
+                  height - shown.x - shown.width, shown.height, shown.width};
+  case 8: return {width - shown.y - shown.height, shown.x,
+                  shown.height, shown.width};
+  default: return shown;
+  }
+}
+
+// Rows are decoded and encoded in batches of this many rows, which covers the
+// `rec_outbuf_height` of any decompression. A transposing orientation writes
+// each decoded batch as that many adjacent pixels of every line.
+static const int kJpegRowBatch = 16;
+
+// Places `count` stored rows, the first of which is row `first` of the stored
+// region, where `orientation` puts them in `dst`. The pixels are `N` bytes,
+// or `pixel_size` bytes when `N` is 0.
+template<int N>
+static void PlaceRows(
+    const MinImg  &dst,
+    const uint8_t *p_rows,
+    size_t         rows_stride,
+    int            first,
+    int            count,
+    int            width,
+    uint16_t       orientation,
+    size_t         pixel_size) {
+  const size_t size = N ? N : pixel_size;
+  if (orientation > 4 && orientation <= 8) {
+    // each stored row becomes a column; going down the stored columns keeps
+    // the writes to every line of `dst` adjacent
+    const bool down = orientation == 5 || orientation == 6;
+    const bool right = orientation == 5 || orientation == 8;
+    const int dst_x = right ? first : dst.width - 1 - first;
+    const ptrdiff_t step = right ? ptrdiff_t(size) : -ptrdiff_t(size);
+    for (int x = 0; x < width; ++x) {
+      const int dst_y = down ? x : dst.height - 1 - x;
+      uint8_t *p_dst = dst.p_zero_line + dst_y * dst.stride + dst_x * size;
+      const uint8_t *p_src = p_rows + x * size;
+      for (int r = 0; r < count; ++r, p_dst += step, p_src += rows_stride)
+        ::memcpy(p_dst, p_src, size);
+    }
+    return;
+  }
+  const bool mirrored = orientation == 2 || orientation == 3;
+  const bool upside_down = orientation == 3 || orientation == 4;
+  for (int r = 0; r < count; ++r) {
+    const int dst_y = upside_down ? dst.height - 1 - (first + r) : first + r;
+    uint8_t *p_dst = dst.p_zero_line + dst_y * dst.stride;
+    const uint8_t *p_src = p_rows + r * rows_stride;
+    if (!mirrored) {
+      ::memcpy(p_dst, p_src, width * size);
+      continue;
+    }
+    p_dst += (width - 1) * size;
+    for (int x = 0; x < width; ++x, p_dst -= size, p_src += size)
+      ::memcpy(p_dst, p_src, size);
+  }
+}
+
 static MinResult decodeImgLoad(
     const MinImg           &img,
     jpeg_decompress_struct &jds,
-    uint16_t                orientation) {
+    uint16_t                orientation,
+    const JpegRegion       &region) {
   if (img.scalar_type != TYP_UINT8 || img.channels != jds.output_components)
     return MR_CONTRACT_VIOLATION;
-  int width = jds.output_width;
-  int height = jds.output_height;
-  if (orientation > 4 && orientation <= 8)
-    std::swap(width, height);
-  if (img.width < width || img.height < height)
+  if (img.width < region.width || img.height < region.height)
     return MR_CONTRACT_VIOLATION;
-
-  DECLARE_GUARDED_MINIMG(t_img);
-  const MinImg *p_read_img = &img;
-  if (orientation > 4 && orientation < 9) {
-    MR_PROPAGATE_ERROR(
-      minimg::CloneTransposedPrototype(t_img, img, AO_PREALLOCATED));
-    p_read_img = &t_img;
+  MinImg dst_img = {};
+  if (GetMinImageRegion(&dst_img, &img, 0, 0,
+                        region.width, region.height, RO_REUSE_CONTAINER) < 0)
+    return MR_INTERNAL_ERROR;
+  const JpegRegion stored = StoredRegion(region, orientation,
+    static_cast<int>(jds.output_width), static_cast<int>(jds.output_height));
+
+  // Only the iMCU columns and rows covering the region are decoded. Without
+  // libjpeg-turbo whole scanlines are, and the rows above are read and dropped.
+  JDIMENSION x_offset = 0;
+  JDIMENSION x_width = jds.output_width;
+  int rows_to_skip = stored.y;
+#ifdef LIBJPEG_TURBO_VERSION_NUMBER
+  // the columns next to the region keep the chroma upsampling of its borders
+  // the same as in the full image
+  const int margin = jds.max_h_samp_factor;
+  const int left = std::max(stored.x - margin, 0);
+  const int right = std::min(stored.x + stored.width + margin,
+                             static_cast<int>(jds.output_width));
+  if (right - left < static_cast<int>(jds.output_width)) {
+    x_offset = static_cast<JDIMENSION>(left);
+    x_width = static_cast<JDIMENSION>(right - left);
+    jpeg_crop_scanline(&jds, &x_offset, &x_width);  // widens to iMCU bounds
   }
+  if (stored.y > 0)
+    rows_to_skip -= static_cast<int>(
+      jpeg_skip_scanlines(&jds, static_cast<JDIMENSION>(stored.y)));
+#endif
+
+  // The rows go straight to their lines, when they need no cropping and stay
+  // rows. Otherwise each batch is decoded into a buffer and placed from it,
+  // so no temporary image and no second pass are needed.
+  const int components = jds.output_components;
+  const int shift = (stored.x - static_cast<int>(x_offset)) * components;
+  const bool in_place = shift == 0 &&
+                        static_cast<int>(x_width) == stored.width &&
+                        (orientation <= 1 || orientation == 4 ||
+                         orientation > 8);
+  const size_t batch_stride = static_cast<size_t>(x_width) * components;
+  const bool buffered = !in_place || rows_to_skip > 0;
+  scoped_mem_array<JSAMPLE> p_batch(!buffered ? NULL :
+    MinMemAllocArray<JSAMPLE>(batch_stride * kJpegRowBatch, MMT_CODEC));
+  if (buffered && !p_batch)
+    return MR_ENV_ERROR;
 
-  JSAMPROW ppBuf[1] = {};
-  JSAMPROW line = p_read_img->p_zero_line;
-  for (int y = 0; y < static_cast<int>(jds.output_height); y++) {
-    ppBuf[0] = static_cast<JSAMPROW>(line);
-    jpeg_read_scanlines(&jds, ppBuf, 1);
-    line += p_read_img->stride;
+  JSAMPROW rows[kJpegRowBatch] = {};
+  for (int y = -rows_to_skip; y < stored.height;) {
+    const int count = std::min(kJpegRowBatch, y < 0 ? -y : stored.height - y);
+    for (int i = 0; i < count; ++i) {
+      if (y >= 0 && in_place)
+        rows[i] = dst_img.p_zero_line + dst_img.stride *
+          (orientation == 4 ? stored.height - 1 - (y + i) : y + i);
+      else
+        rows[i] = p_batch + batch_stride * i;
+    }
+    // libjpeg returns up to `rec_outbuf_height` rows per call
+    for (int read = 0; read < count;) {
+      const JDIMENSION n = jpeg_read_scanlines(
+        &jds, rows + read, static_cast<JDIMENSION>(count - read));
+      if (n == 0)
+        return MR_ENV_ERROR;
+      read += static_cast<int>(n);
+    }
+    if (y >= 0 && !in_place) {
+      const uint8_t *p_rows = p_batch + shift;
+      switch (components) {
+      case 1:
+        PlaceRows<1>(dst_img, p_rows, batch_stride, y, count, stored.width,
+                     orientation, 1);
+        break;
+      case 3:
+        PlaceRows<3>(dst_img, p_rows, batch_stride, y, count, stored.width,
+                     orientation, 3);
+        break;
+      case 4:
+        PlaceRows<4>(dst_img, p_rows, batch_stride, y, count, stored.width,
+                     orientation, 4);
+        break;
+      default:
+        PlaceRows<0>(dst_img, p_rows, batch_stride, y, count, stored.width,
+                     orientation, static_cast<size_t>(components));
+      }
+    }
+    y += count;
   }
-  return static_cast<MinResult>(
-    OrientImageSpecial(img, *p_read_img, orientation));
+  return MR_SUCCESS;
 }
 
-
-static MinResult GetJpegPropsEx(
-    MinImg                 &img,
-    ExtImgProps            *p_props,
-    minimgio::BinaryStream &stream,
-    int                     page,
-    bool                    decode_image) {
-  if (page != 0)
-    return MR_CONTRACT_VIOLATION;
-  // Instantiate decoding environment.
-  jpeg_decompress_struct cinfo = {};
-  jem jerr;
-  ::memset(&jerr, 0, sizeof(jerr));
-  cinfo.err = jpeg_std_error(&jerr.pub);
-  jerr.pub.error_exit = jee;
-  jerr.pub.output_message = jom;
-
-  if (setjmp(jerr.buf)) {
-    jpeg_destroy_decompress(&cinfo);
-    return MR_ENV_ERROR;
-  }
-
-  jpeg_create_decompress(&cinfo);
-  scoped_ljobj guard(&cinfo);
-
-  minimgio_source_mgr src_mgr;
-
+// Makes `cinfo` read `stream` from its start.
+static MinResult SetSource(
+    jpeg_decompress_struct &cinfo,
+    minimgio_source_mgr    &src_mgr,
+    minimgio::BinaryStream &stream) {
   cinfo.src = &src_mgr.pub;
   src_mgr.pub.init_source = minimgio_noop;
   src_mgr.pub.fill_input_buffer = fill_input_buffer;
@@ -380,57 +538,200 @@ static MinResult GetJpegPropsEx(
   src_mgr.pub.resync_to_restart = jpeg_resync_to_restart;
   src_mgr.pub.term_source = minimgio_noop;
   src_mgr.stream = &stream;
+  src_mgr.buffer = NULL;
   src_mgr.pub.bytes_in_buffer = 0; /* forces fill_input_buffer on first read */
   src_mgr.pub.next_input_byte = NULL; /* until buffer loaded */
 
-  jpeg_save_markers(&cinfo, JPEG_APP0 + 1, 0xFFFF);
   if (stream.lseek(0) != 0)
     return MR_ENV_ERROR;
-  jpeg_read_header(&cinfo, TRUE);
-  jpeg_start_decompress(&cinfo);
+  std::size_t data_size = 0;
+  if (const uint8_t *p_data = stream.peek(data_size)) {
+    // decode straight from the stream memory, without copies
+    src_mgr.pub.next_input_byte = p_data;
+    src_mgr.pub.bytes_in_buffer = data_size;
+    src_mgr.pub.fill_input_buffer = fill_memory_input_buffer;
+    return MR_SUCCESS;
+  }
+  src_mgr.buffer = static_cast<JOCTET *>((*cinfo.mem->alloc_large)(
+    reinterpret_cast<j_common_ptr>(&cinfo), JPOOL_PERMANENT, kJpegBufferSize));
+  return MR_SUCCESS;
+}
 
+// The reduction `options` ask for an image of `width` x `height`, as it is
+// oriented for the user.
+static int ChooseScaleDenom(
+    const DecodeOptions &options,
+    int                  width,
+    int                  height) {
+  int denom = options.scale_denom > 1 ? options.scale_denom : 1;
+  // libjpeg rounds the reduced sizes up
+  while (denom < 8 &&
+         ((options.max_width > 0 &&
+           (width + denom - 1) / denom > options.max_width) ||
+          (options.max_height > 0 &&
+           (height + denom - 1) / denom > options.max_height)))
+    denom *= 2;
+  return denom;
+}
 
-  ExtImgProps local_props = {};
-  ExtImgProps* p_work_props = p_props ? p_props : &local_props;
-  uint16_t orientation = decodeExtProps(p_work_props, &cinfo);
+namespace {
+
+// Keeps the decompression started by a property query, so that the following
+// load continues right after the parsed header.
+class JpegDecoder : public minimgio::internal::Decoder {
+public:
+  JpegDecoder(minimgio::BinaryStream &stream, const DecodeOptions &options):
+    stream(stream), options(options), created(false), started(false),
+    orientation(0), scale_denom(1) {}
+  ~JpegDecoder() override {
+    this->Close();
+  }
+  MinResult GetNumPages(int &num_pages) override {
+    num_pages = 1;
+    return MR_SUCCESS;
+  }
+  MinResult GetProps(MinImg &img, ExtImgProps *p_props, int page) override;
+  MinResult Load(const MinImg &img, int page) override;
+
+private:
+  // reads the header and starts the decompression, unless it is started
+  MinResult Start();
+  // the part of the started decompression the options ask for, as it is shown
+  MinResult GetRegion(JpegRegion &region) const;
+  void Close();
+
+  minimgio::BinaryStream &stream;
+  const DecodeOptions options;
+  jpeg_decompress_struct cinfo;
+  jem jerr;
+  minimgio_source_mgr src_mgr;
+  bool created;  // `cinfo` has to be destroyed
+  bool started;  // no scanlines are read since `jpeg_start_decompress`
+  uint16_t orientation;
+  int scale_denom;  // of the started decompression
+};
 
-  if (decode_image)
-  {
-    MR_PROPAGATE_ERROR(decodeImgLoad(img, cinfo, orientation));
-    if (jpeg_finish_decompress(&cinfo) != TRUE)  // request for suspension
-      return MR_NOT_IMPLEMENTED;
+void JpegDecoder::Close() {
+  if (this->created)
+    jpeg_destroy_decompress(&this->cinfo);
+  this->created = false;
+  this->started = false;
+}
+
+MinResult JpegDecoder::Start() {
+  if (this->started)
+    return MR_SUCCESS;
+  this->Close();
+  // Instantiate decoding environment.
+  jpeg_decompress_struct &cinfo = this->cinfo;
+  ::memset(&cinfo, 0, sizeof(cinfo));
+  ::memset(&this->jerr, 0, sizeof(this->jerr));
+  cinfo.err = jpeg_std_error(&this->jerr.pub);
+  this->jerr.pub.error_exit = jee;
+  this->jerr.pub.output_message = jom;
+
+  if (setjmp(this->jerr.buf)) {
+    this->Close();
+    return MR_ENV_ERROR;
   }
-  else {
-    MR_PROPAGATE_ERROR(decodeImgProps(img, cinfo, orientation));
-    jpeg_abort_decompress(&cinfo);
+
+  jpeg_create_decompress(&cinfo);
+  this->created = true;
+
+  jpeg_save_markers(&cinfo, JPEG_APP0 + 1, 0xFFFF);
+  MR_PROPAGATE_ERROR(SetSource(cinfo, this->src_mgr, this->stream));
+  jpeg_read_header(&cinfo, TRUE);
+
+  ExtImgProps local_props = {};
+  this->orientation = decodeExtProps(&local_props, &cinfo);
+  int width = static_cast<int>(cinfo.image_width);
+  int height = static_cast<int>(cinfo.image_height);
+  if (this->orientation > 4 && this->orientation <= 8)
+    std::swap(width, height);
+  // the IDCT produces the reduced image right away
+  this->scale_denom = ChooseScaleDenom(this->options, width, height);
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = this->scale_denom;
+  jpeg_start_decompress(&cinfo);
+  this->started = true;
+  return MR_SUCCESS;
+}
+
+MinResult JpegDecoder::GetRegion(JpegRegion &region) const {
+  int width = static_cast<int>(this->cinfo.output_width);
+  int height = static_cast<int>(this->cinfo.output_height);
+  if (this->orientation > 4 && this->orientation <= 8)
+    std::swap(width, height);
+  const DecodeOptions &options = this->options;
+  if (options.region_width == 0 && options.region_height == 0) {
+    region = {0, 0, width, height};
+    return MR_SUCCESS;
   }
+  region = {options.region_x, options.region_y,
+            options.region_width, options.region_height};
+  if (region.x < 0 || region.y < 0 || region.width <= 0 ||
+      region.height <= 0 || region.width > width - region.x ||
+      region.height > height - region.y)
+    return MR_CONTRACT_VIOLATION;
   return MR_SUCCESS;
 }
 
-namespace minimgio { namespace internal {
-MinResult GetPropsJpeg(
-    MinImg                &img,
-    ExtImgProps           *p_props,
-    BinaryStream &stream,
-    int                    page) {
+MinResult JpegDecoder::GetProps(
+    MinImg      &img,
+    ExtImgProps *p_props,
+    int          page) {
   if (page != 0)
     return MR_CONTRACT_VIOLATION;
-  return GetJpegPropsEx(img, p_props, stream, page, false);
-};
-
-MinResult GetNumPagesJpeg(int &num_pages, BinaryStream &) {
-  num_pages = 1;
+  MR_PROPAGATE_ERROR(this->Start());
+  // the saved markers live till the decompression is finished
+  if (p_props) {
+    decodeExtProps(p_props, &this->cinfo);
+    p_props->xDPI /= this->scale_denom;
+    p_props->yDPI /= this->scale_denom;
+  }
+  JpegRegion region;
+  MR_PROPAGATE_ERROR(this->GetRegion(region));
+  MR_PROPAGATE_ERROR(decodeImgProps(img, this->cinfo, this->orientation));
+  img.width = region.width;
+  img.height = region.height;
   return MR_SUCCESS;
 }
-MinResult LoadJpeg(
-    MinImg const &img,
-    BinaryStream &stream,
-    int          page) {
+
+MinResult JpegDecoder::Load(
+    const MinImg &img,
+    int           page) {
   if (page != 0)
     return MR_CONTRACT_VIOLATION;
-  // const_cast is safe because the image isn't changed when
-  // decode_image=true; removing const_cast requires more code
-  return GetJpegPropsEx(const_cast<MinImg&>(img), NULL, stream, page, true);
+  MR_PROPAGATE_ERROR(this->Start());
+  // whatever happens below, the next query has to start over
+  this->started = false;
+  JpegRegion region;
+  MR_PROPAGATE_ERROR(this->GetRegion(region));
+  if (setjmp(this->jerr.buf)) {
+    this->Close();
+    return MR_ENV_ERROR;
+  }
+  MR_PROPAGATE_ERROR(
+    decodeImgLoad(img, this->cinfo, this->orientation, region));
+  if (this->cinfo.output_scanline < this->cinfo.output_height) {
+    // the rows below the region are not decoded at all
+    jpeg_abort_decompress(&this->cinfo);
+    return MR_SUCCESS;
+  }
+  if (jpeg_finish_decompress(&this->cinfo) != TRUE)  // request for suspension
+    return MR_NOT_IMPLEMENTED;
+  return MR_SUCCESS;
+}
+
+} // anonymous namespace
+
+namespace minimgio { namespace internal {
+MinResult CreateDecoderJpeg(
+    Decoder             *&p_decoder,
+    BinaryStream        &stream,
+    const DecodeOptions &options) {
+  p_decoder = new JpegDecoder(stream, options);
+  return MR_SUCCESS;
 }
 }}
 
@@ -442,12 +743,12 @@ static void init_destination(jpeg_compress_struct* /*cinfo*/) {
 static boolean empty_output_buffer(jpeg_compress_struct* cinfo) {
   minimgio_destination_mgr* dst_mgr =
     reinterpret_cast<minimgio_destination_mgr*>(cinfo->dest);
-  if (dst_mgr->stream->write(dst_mgr->buffer, sizeof(dst_mgr->buffer)
-      ) !=sizeof(dst_mgr->buffer))
+  if (dst_mgr->stream->write(dst_mgr->buffer, kJpegBufferSize
+      ) != kJpegBufferSize)
     ERREXIT(cinfo, JERR_FILE_WRITE);
 
   dst_mgr->pub.next_output_byte = dst_mgr->buffer;
-  dst_mgr->pub.free_in_buffer = sizeof(dst_mgr->buffer);
+  dst_mgr->pub.free_in_buffer = kJpegBufferSize;
 
   return TRUE;
 }
@@ -456,7 +757,7 @@ static void term_destination(j_compress_ptr cinfo)
 {
   minimgio_destination_mgr* dst_mgr =
     reinterpret_cast<minimgio_destination_mgr*>(cinfo->dest);
-  size_t datacount = sizeof(dst_mgr->buffer) - dst_mgr->pub.free_in_buffer;
+  size_t datacount = kJpegBufferSize - dst_mgr->pub.free_in_buffer;
 
   /* Write any data remaining in the buffer */
   if (datacount > 0) {
@@ -465,6 +766,21 @@ static void term_destination(j_compress_ptr cinfo)
   }
 }
 
+static void SetDestination(
+    jpeg_compress_struct     &cinfo,
+    minimgio_destination_mgr &dst_mgr,
+    minimgio::BinaryStream   &stream) {
+  dst_mgr.buffer = static_cast<JOCTET *>((*cinfo.mem->alloc_large)(
+    reinterpret_cast<j_common_ptr>(&cinfo), JPOOL_PERMANENT, kJpegBufferSize));
+  dst_mgr.pub.next_output_byte = dst_mgr.buffer;
+  dst_mgr.pub.free_in_buffer = kJpegBufferSize;
+  dst_mgr.pub.init_destination = init_destination;
+  dst_mgr.pub.empty_output_buffer = empty_output_buffer;
+  dst_mgr.pub.term_destination = term_destination;
+  dst_mgr.stream = &stream;
+  cinfo.dest = reinterpret_cast<jpeg_destination_mgr *>(&dst_mgr);
+}
+
 namespace minimgio { namespace internal {
 MinResult SaveJpeg(
     BinaryStream      &stream,
@@ -489,13 +805,7 @@ MinResult SaveJpeg(
   jpeg_create_compress(&cinfo);
   scoped_sjobj guard(&cinfo);
   minimgio_destination_mgr dst_mgr;
-  dst_mgr.pub.next_output_byte = dst_mgr.buffer;
-  dst_mgr.pub.free_in_buffer = sizeof(dst_mgr.buffer);
-  dst_mgr.pub.init_destination = init_destination;
-  dst_mgr.pub.empty_output_buffer = empty_output_buffer;
-  dst_mgr.pub.term_destination = term_destination;
-  dst_mgr.stream = &stream;
-  cinfo.dest = reinterpret_cast<jpeg_destination_mgr *>(&dst_mgr);
+  SetDestination(cinfo, dst_mgr, stream);
 
 
   cinfo.image_width = img.width;
@@ -528,12 +838,17 @@ MinResult SaveJpeg(
   jpeg_set_quality(&cinfo, quality, TRUE);
   jpeg_start_compress(&cinfo, TRUE);
 
-  JSAMPROW ppBuf[1] = {};
-  JSAMPROW line = img.p_zero_line;
-  for (int y = 0; y < img.height; y++) {
-    ppBuf[0] = static_cast<JSAMPROW>(line);
-    jpeg_write_scanlines(&cinfo, ppBuf, 1);
-    line += img.stride;
+  // the rows are passed in batches, straight from the image
+  JSAMPROW rows[kJpegRowBatch] = {};
+  for (int y = 0; y < img.height;) {
+    const int count = std::min(kJpegRowBatch, img.height - y);
+    for (int i = 0; i < count; ++i)
+      rows[i] = img.p_zero_line + img.stride * (y + i);
+    const JDIMENSION n = jpeg_write_scanlines(
+      &cinfo, rows, static_cast<JDIMENSION>(count));
+    if (n == 0)
+      return MR_ENV_ERROR;
+    y += static_cast<int>(n);
   }
 
   jpeg_finish_compress(&cinfo);
@@ -541,4 +856,251 @@ MinResult SaveJpeg(
   return MR_SUCCESS;
 }
 }} // namespace minimgio::internal
+
+// The eight ways to turn an image, numbered like the EXIF orientations, as
+// matrices {a, b, c, d}, which map the stored coordinates (x, y), centered, to
+// the shown ones (a * x + b * y, c * x + d * y).
+static const int kOrientationMatrices[9][4] = {
+  {1, 0, 0, 1},  // unknown orientations are ignored
+  {1, 0, 0, 1}, {-1, 0, 0, 1}, {-1, 0, 0, -1}, {1, 0, 0, -1},
+  {0, 1, 1, 0}, {0, -1, 1, 0}, {0, -1, -1, 0}, {0, 1, -1, 0}
+};
+
+// `ImgTransform`s as orientations
+static const uint16_t kTransformOrientations[] = {1, 2, 4, 5, 7, 6, 3, 8};
+
+// The orientation which turns an image like `first`, then like `second`.
+static uint16_t ComposeOrientations(uint16_t first, uint16_t second) {
+  const int *a = kOrientationMatrices[first <= 8 ? first : 0];
+  const int *b = kOrientationMatrices[second <= 8 ? second : 0];
+  const int m[4] = {
+    b[0] * a[0] + b[1] * a[2], b[0] * a[1] + b[1] * a[3],
+    b[2] * a[0] + b[3] * a[2], b[2] * a[1] + b[3] * a[3]
+  };
+  for (uint16_t orientation = 1; orientation <= 8; ++orientation)
+    if (std::equal(m, m + 4, kOrientationMatrices[orientation]))
+      return orientation;
+  return 1;
+}
+
+// Fills the blocks of one component of the turned image from the stored ones.
+// The blocks are `stored_width` x `stored_height` after trimming; the turned
+// component starts at block (`x0`, `y0`) of the whole turned one.
+static void TurnComponent(
+    jpeg_decompress_struct    &src,
+    jvirt_barray_ptr           src_array,
+    jvirt_barray_ptr           dst_array,
+    const jpeg_component_info &dst_comp,
+    uint16_t                   orientation,
+    int                        stored_width,
+    int                        stored_height,
+    int                        x0,
+    int                        y0) {
+  j_common_ptr common = reinterpret_cast<j_common_ptr>(&src);
+  const bool transposed = orientation > 4;
+  // the coefficients of odd horizontal (vertical) frequencies change sign when
+  // the turned image is mirrored left to right (top to bottom)
+  const bool negate_u = orientation == 2 || orientation == 3 ||
+                        orientation == 6 || orientation == 7;
+  const bool negate_v = orientation == 3 || orientation == 4 ||
+                        orientation == 7 || orientation == 8;
+  const int width = static_cast<int>(dst_comp.width_in_blocks);
+  const int height = static_cast<int>(dst_comp.height_in_blocks);
+  for (int y = 0; y < height; ++y) {
+    JBLOCKROW dst_row = (*src.mem->access_virt_barray)(
+      common, dst_array, static_cast<JDIMENSION>(y), 1, TRUE)[0];
+    for (int x = 0; x < width; ++x) {
+      // the stored block, by the inverse of `kOrientationMatrices`
+      const int X = x + x0, Y = y + y0;
+      int sx = X, sy = Y;
+      switch (orientation) {
+      case 2: sx = stored_width - 1 - X; break;
+      case 3: sx = stored_width - 1 - X; sy = stored_height - 1 - Y; break;
+      case 4: sy = stored_height - 1 - Y; break;
+      case 5: sx = Y; sy = X; break;
+      case 6: sx = Y; sy = stored_height - 1 - X; break;
+      case 7: sx = stored_width - 1 - Y; sy = stored_height - 1 - X; break;
+      case 8: sx = stored_width - 1 - Y; sy = X; break;
+      }
+      if (sx < 0 || sy < 0 || sx >= stored_width || sy >= stored_height)
+        continue;
+      const JCOEF *p_src = (*src.mem->access_virt_barray)(
+        common, src_array, static_cast<JDIMENSION>(sy), 1, FALSE)[0][sx];
+      JCOEF *p_dst = dst_row[x];
+      for (int v = 0; v < DCTSIZE; ++v)
+        for (int u = 0; u < DCTSIZE; ++u) {
+          const JCOEF coef = transposed ? p_src[u * DCTSIZE + v] :
+                                          p_src[v * DCTSIZE + u];
+          const bool negate = ((u & 1) && negate_u) != ((v & 1) && negate_v);
+          p_dst[v * DCTSIZE + u] = negate ? static_cast<JCOEF>(-coef) : coef;
+        }
+    }
+  }
+}
+
+namespace minimgio { namespace internal {
+MinResult TransformJpeg(
+    BinaryStream           &dst_stream,
+    BinaryStream           &src_stream,
+    const TransformOptions &options) {
+  if (options.transform < ITR_NONE || options.transform > ITR_ROTATE_270)
+    return MR_CONTRACT_VIOLATION;
+  if (&dst_stream == &src_stream)
+    return MR_CONTRACT_VIOLATION;
+
+  jpeg_decompress_struct src = {};
+  jpeg_compress_struct dst = {};
+  jem jerr = {{0}};
+  src.err = jpeg_std_error(&jerr.pub);
+  dst.err = &jerr.pub;
+  jerr.pub.error_exit = jee;
+  jerr.pub.output_message = jom;
+  scoped_ljobj src_guard(&src);
+  scoped_sjobj dst_guard(&dst);
+  minimgio_source_mgr src_mgr;
+  minimgio_destination_mgr dst_mgr;
+
+  // the stream of the side being worked on gets the library's error text
+  BinaryStream *volatile p_failing_stream = &src_stream;
+  if (setjmp(jerr.buf)) {
+    char message[JMSG_LENGTH_MAX];
+    (*jerr.pub.format_message)(reinterpret_cast<j_common_ptr>(&src), message);
+    p_failing_stream->error(message);
+    return MR_ENV_ERROR;
+  }
+
+  jpeg_create_decompress(&src);
+  // all the markers are copied
+  jpeg_save_markers(&src, JPEG_COM, 0xFFFF);
+  for (int i = 0; i < 16; ++i)
+    jpeg_save_markers(&src, JPEG_APP0 + i, 0xFFFF);
+  MR_PROPAGATE_ERROR(src_stream.initialize(MIS_READONLY));
+  MR_PROPAGATE_ERROR(SetSource(src, src_mgr, src_stream));
+  jpeg_read_header(&src, TRUE);
+
+  uint16_t exif_orientation = 0;
+  const uint8_t *p_orientation = NULL;
+  jpeg_saved_marker_ptr exif_marker = NULL;
+  for (jpeg_saved_marker_ptr marker = src.marker_list; marker;
+       marker = marker->next) {
+    ExtImgProps props = {};
+    const uint8_t *p_value = NULL;
+    decodeExif(&props, exif_orientation, p_value, *marker);
+    if (p_value) {
+      p_orientation = p_value;
+      exif_marker = marker;
+    }
+  }
+  const uint16_t orientation = ComposeOrientations(
+    exif_orientation, kTransformOrientations[options.transform]);
+  const bool transposed = orientation > 4;
+  const int *m = kOrientationMatrices[orientation];
+
+  // The partial iMCUs at the right and the bottom cannot become the left or
+  // the top ones, so the directions which are mirrored are trimmed.
+  const int imcu_width = src.max_h_samp_factor * DCTSIZE;
+  const int imcu_height = src.max_v_samp_factor * DCTSIZE;
+  int width = static_cast<int>(src.image_width);
+  int height = static_cast<int>(src.image_height);
+  if (m[0] < 0 || m[2] < 0)
+    width -= width % imcu_width;
+  if (m[1] < 0 || m[3] < 0)
+    height -= height % imcu_height;
+  if (width == 0 || height == 0)
+    return MR_NOT_IMPLEMENTED;
+
+  const int dst_width = transposed ? height : width;
+  const int dst_height = transposed ? width : height;
+  const int dst_imcu_width = transposed ? imcu_height : imcu_width;
+  const int dst_imcu_height = transposed ? imcu_width : imcu_height;
+  int crop_x = 0, crop_y = 0, crop_width = dst_width, crop_height = dst_height;
+  if (options.crop_width != 0 || options.crop_height != 0) {
+    crop_x = options.crop_x;
+    crop_y = options.crop_y;
+    crop_width = options.crop_width;
+    crop_height = options.crop_height;
+    if (crop_x < 0 || crop_y < 0 || crop_width <= 0 || crop_height <= 0 ||
+        crop_width > dst_width - crop_x || crop_height > dst_height - crop_y ||
+        crop_x % dst_imcu_width != 0 || crop_y % dst_imcu_height != 0)
+      return MR_CONTRACT_VIOLATION;
+  }
+
+  // the turned coefficients; the arrays are realized by the reading below
+  jvirt_barray_ptr dst_arrays[MAX_COMPONENTS] = {};
+  for (int c = 0; c < src.num_components; ++c) {
+    const jpeg_component_info &comp = src.comp_info[c];
+    const int h_samp = transposed ? comp.v_samp_factor : comp.h_samp_factor;
+    const int v_samp = transposed ? comp.h_samp_factor : comp.v_samp_factor;
+    const int width_in_blocks = (crop_width * h_samp + dst_imcu_width - 1) /
+                                dst_imcu_width;
+    const int height_in_blocks = (crop_height * v_samp + dst_imcu_height - 1) /
+                                 dst_imcu_height;
+    dst_arrays[c] = (*src.mem->request_virt_barray)(
+      reinterpret_cast<j_common_ptr>(&src), JPOOL_IMAGE, TRUE,
+      static_cast<JDIMENSION>((width_in_blocks + h_samp - 1) / h_samp * h_samp),
+      static_cast<JDIMENSION>((height_in_blocks + v_samp - 1) / v_samp * v_samp),
+      static_cast<JDIMENSION>(v_samp));
+  }
+  jvirt_barray_ptr *src_arrays = jpeg_read_coefficients(&src);
+
+  p_failing_stream = &dst_stream;
+  jpeg_create_compress(&dst);
+  jpeg_copy_critical_parameters(&src, &dst);
+  dst.image_width = static_cast<JDIMENSION>(crop_width);
+  dst.image_height = static_cast<JDIMENSION>(crop_height);
+  if (transposed) {
+    for (int c = 0; c < dst.num_components; ++c)
+      std::swap(dst.comp_info[c].h_samp_factor, dst.comp_info[c].v_samp_factor);
+    for (int q = 0; q < NUM_QUANT_TBLS; ++q)
+      if (JQUANT_TBL *p_table = dst.quant_tbl_ptrs[q])
+        for (int v = 0; v < DCTSIZE; ++v)
+          for (int u = 0; u < v; ++u)
+            std::swap(p_table->quantval[v * DCTSIZE + u],
+                      p_table->quantval[u * DCTSIZE + v]);
+  }
+  MR_PROPAGATE_ERROR(dst_stream.initialize(MIS_WRITEONLY));
+  if (dst_stream.lseek(0) != 0)
+    return MR_ENV_ERROR;
+  SetDestination(dst, dst_mgr, dst_stream);
+  jpeg_write_coefficients(&dst, dst_arrays);
+
+  // the turned image is shown as it is stored
+  if (p_orientation) {
+    JOCTET *p_value = exif_marker->data + (p_orientation - exif_marker->data);
+    const bool is_little_endian = exif_marker->data[6] == 'I';
+    p_value[0] = static_cast<JOCTET>(is_little_endian ? 1 : 0);
+    p_value[1] = static_cast<JOCTET>(is_little_endian ? 0 : 1);
+  }
+  for (jpeg_saved_marker_ptr marker = src.marker_list; marker;
+       marker = marker->next) {
+    // the library writes these itself
+    if (dst.write_JFIF_header && marker->marker == JPEG_APP0 &&
+        marker->data_length >= 5 && ::memcmp(marker->data, "JFIF", 5) == 0)
+      continue;
+    if (dst.write_Adobe_marker && marker->marker == JPEG_APP0 + 14 &&
+        marker->data_length >= 5 && ::memcmp(marker->data, "Adobe", 5) == 0)
+      continue;
+    jpeg_write_marker(&dst, marker->marker, marker->data, marker->data_length);
+  }
+
+  for (int c = 0; c < src.num_components; ++c) {
+    const jpeg_component_info &comp = src.comp_info[c];
+    const jpeg_component_info &dst_comp = dst.comp_info[c];
+    const int stored_width = m[0] < 0 || m[2] < 0 ?
+      width / imcu_width * comp.h_samp_factor :
+      static_cast<int>(comp.width_in_blocks);
+    const int stored_height = m[1] < 0 || m[3] < 0 ?
+      height / imcu_height * comp.v_samp_factor :
+      static_cast<int>(comp.height_in_blocks);
+    TurnComponent(src, src_arrays[c], dst_arrays[c], dst_comp, orientation,
+                  stored_width, stored_height,
+                  crop_x / dst_imcu_width * dst_comp.h_samp_factor,
+                  crop_y / dst_imcu_height * dst_comp.v_samp_factor);
+  }
+
+  jpeg_finish_compress(&dst);
+  jpeg_finish_decompress(&src);
+  return MR_SUCCESS;
+}
+}} // namespace minimgio::internal
 #endif // #ifdef MINIMGIO_GENERATE
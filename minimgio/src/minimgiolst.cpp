@@ -36,6 +36,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <minutils/smartptr.h>
 #include <minimgio/minimgio.hpp>
 #include "utils.h"
+#include "decoder.h"
 
 
 class MemoryInputStream: public std::istream
@@ -120,11 +121,37 @@ MinResult GetLstPageName(
   return MR_CONTRACT_VIOLATION;
 }
 
-namespace minimgio { namespace internal {
-MinResult GetNumPagesLst(
-    int &num_pages,
-    BinaryStream &stream) {
-  MemoryInputStream fileStream(stream);
+namespace {
+
+// Keeps the file of the last queried page opened, so that the properties and
+// the pixels of a page are read through one session.
+class LstDecoder : public minimgio::internal::Decoder {
+public:
+  LstDecoder(minimgio::BinaryStream &stream, const DecodeOptions &options):
+    stream(stream), options(options), page(-1), p_page_stream(NULL),
+    p_page_session(NULL) {}
+  ~LstDecoder() override {
+    this->ClosePage();
+  }
+  MinResult GetNumPages(int &num_pages) override;
+  MinResult GetProps(MinImg &img, ExtImgProps *p_props, int page) override;
+  MinResult Load(const MinImg &img, int page) override;
+
+private:
+  MinResult OpenPage(int page);
+  void ClosePage();
+
+  minimgio::BinaryStream &stream;
+  const DecodeOptions options;  // for every page
+  int page;  // -1 when no page is opened
+  std::string page_path;  // `p_page_stream` keeps a pointer to it
+  minimgio::BinaryMappedFileStream *p_page_stream;
+  minimgio::DecoderSession *p_page_session;
+};
+
+MinResult LstDecoder::GetNumPages(
+    int &num_pages) {
+  MemoryInputStream fileStream(this->stream);
 
   int pageCount = 0;
   std::string imageName;
@@ -140,33 +167,61 @@ MinResult GetNumPagesLst(
   num_pages = pageCount;
   return MR_SUCCESS;
 }
-MinResult GetPropsLst(
+
+MinResult LstDecoder::OpenPage(
+    int page) {
+  if (this->page == page)
+    return MR_SUCCESS;
+  this->ClosePage();
+  char szPageName[4096] = {};
+  MR_PROPAGATE_ERROR(
+    GetLstPageName(szPageName, sizeof(szPageName), this->stream, page));
+  const char * source = this->stream.get_source();
+  this->page_path = absoluteImagePath(
+    std::string(source ? source : "./"), szPageName);
+  this->p_page_stream =
+    new minimgio::BinaryMappedFileStream(this->page_path.c_str());
+  this->p_page_session =
+    new minimgio::DecoderSession(*this->p_page_stream, &this->options);
+  this->page = page;
+  return MR_SUCCESS;
+}
+
+void LstDecoder::ClosePage() {
+  delete this->p_page_session;
+  delete this->p_page_stream;
+  this->p_page_session = NULL;
+  this->p_page_stream = NULL;
+  this->page = -1;
+}
+
+MinResult LstDecoder::GetProps(
     MinImg       &img,
     ExtImgProps *p_props,
-    BinaryStream &stream,
     int          page) {
-  char szPageName[4096] = {};
-  MR_PROPAGATE_ERROR(GetLstPageName(szPageName, sizeof(szPageName), stream, page));
-  const char * source = stream.get_source();
-  const std::string absolute_path = absoluteImagePath(
-    std::string(source ? source : "./"), szPageName);
-  BinaryFileStream inner_stream(absolute_path.c_str());
-  MinResult ret = ::minimgio::GetFileProps(img, inner_stream, p_props, 0);
+  MR_PROPAGATE_ERROR(this->OpenPage(page));
+  MinResult ret = this->p_page_session->get_file_props(img, p_props, 0);
   if (ret != MR_SUCCESS)
-    stream.error(inner_stream.get_error());
+    this->stream.error(this->p_page_stream->get_error());
   return ret;
 }
-MinResult LoadLst(
+
+MinResult LstDecoder::Load(
     const MinImg &img,
-    BinaryStream  &stream,
     int           page) {
-  char szPageName[4096] = {};
-  MR_PROPAGATE_ERROR(GetLstPageName(szPageName, sizeof(szPageName), stream, page));
-  const char * source = stream.get_source();
-  const std::string absolute_path = absoluteImagePath(
-    std::string(source ? source : "./"), szPageName);
-  BinaryFileStream inner_stream(absolute_path.c_str());
-  return ::minimgio::Load(img, inner_stream, 0);
+  MR_PROPAGATE_ERROR(this->OpenPage(page));
+  return this->p_page_session->load(img, 0);
+}
+
+} // anonymous namespace
+
+namespace minimgio { namespace internal {
+MinResult CreateDecoderLst(
+    Decoder             *&p_decoder,
+    BinaryStream        &stream,
+    const DecodeOptions &options) {
+  p_decoder = new LstDecoder(stream, options);
+  return MR_SUCCESS;
 }
 } // namespace internal
 } // namespace minimgio
@@ -30,9 +30,11 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <algorithm>  // std::max, std::min
+#include <cstring>  // memcpy
 //#include <minbase/minresult.h>
 #include <minutils/smartptr.h>
 #include <minimgio/minimgio.hpp>
+#include "decoder.h"
 
 
 #include <png.h>
@@ -42,8 +44,17 @@ namespace {
 struct MIN_PNG {
   png_structp p_png = NULL;
   png_infop p_info = NULL;
+  // the compressed data when the stream exposes it, see `BinaryStream::peek`
+  const uint8_t *p_data = NULL;
+  size_t data_size = 0;
+  minimgio::BinaryStream *stream = NULL;
   ~MIN_PNG() {
+    this->reset();
+  }
+  void reset() {
     png_destroy_read_struct(&this->p_png, &this->p_info, NULL);
+    this->p_png = NULL;
+    this->p_info = NULL;
   }
 };
 
@@ -53,9 +64,16 @@ namespace minimgio {namespace internal {
 static void MinimgioPngRead(png_structp png_ptr,
                             png_bytep   bytes,
                             png_size_t  count) {
-  BinaryStream *stream = static_cast<BinaryStream *>(png_get_io_ptr(png_ptr));
-  if (stream->read(bytes, count) != count)
+  MIN_PNG *png = static_cast<MIN_PNG *>(png_get_io_ptr(png_ptr));
+  if (png->p_data) {
+    if (count > png->data_size)
+      png_error(png_ptr, "unexpected end of data (file corrupted?)");
+    ::memcpy(bytes, png->p_data, count);
+    png->p_data += count;
+    png->data_size -= count;
+  } else if (png->stream->read(bytes, count) != count) {
     png_error(png_ptr, "`read` call failed (file corrupted?)");
+  }
 }
 
 static void MinimgioPngWrite(png_structp png_ptr,
@@ -71,14 +89,13 @@ static void MinimgioPngFlush(png_structp) {
 
 static void MinimgioPngError(png_structp png_ptr,
                              png_const_charp error_msg) {
-  BinaryStream *stream = static_cast<BinaryStream *>(png_get_io_ptr(png_ptr));
+  BinaryStream *stream =
+    static_cast<BinaryStream *>(png_get_error_ptr(png_ptr));
   stream->error(error_msg);
 }
 
-static MinResult PngInitAndReadPrototype(
-    png_structp  *ppPng,
-    png_infop    *ppInfo,
-    MinImg       &img,
+static MinResult PngReadInfo(
+    MIN_PNG      &png,
     BinaryStream &stream) {
   png_byte header[8] = {};
   if (stream.read(header, sizeof(header)) != sizeof(header))
@@ -86,54 +103,103 @@ static MinResult PngInitAndReadPrototype(
   if (png_sig_cmp(header, 0, 8) != 0)
     return MR_INTERNAL_ERROR;
 
-  png_structp pPng = *ppPng = png_create_read_struct(
+  png_structp pPng = png.p_png = png_create_read_struct(
     PNG_LIBPNG_VER_STRING, &stream,
     MinimgioPngError, MinimgioPngError);
-  png_infop pInfo = *ppInfo = png_create_info_struct(pPng);
+  png_infop pInfo = png.p_info = png_create_info_struct(pPng);
   if (!pInfo)
     return MR_INTERNAL_ERROR;
 
-  png_set_read_fn(pPng, &stream, MinimgioPngRead);
+  png.stream = &stream;
+  png.p_data = stream.peek(png.data_size);
+  png_set_read_fn(pPng, &png, MinimgioPngRead);
 
   if (setjmp(png_jmpbuf(pPng)))
     return MR_ENV_ERROR;
 
   png_set_sig_bytes(pPng, 8);
   png_read_info(pPng, pInfo);
+  return MR_SUCCESS;
+}
 
-  // Begin
+enum {
+  MIN_PNG_EXPAND_GRAY = 1 << 0,
+  MIN_PNG_STRIP_ALPHA = 1 << 1,
+  MIN_PNG_STRIP_16 = 1 << 2,
+  MIN_PNG_SWAP = 1 << 3,
+  MIN_PNG_PACKING = 1 << 4
+};
+
+// The transformations that make the file fit `img`, which can be a blank
+// prototype: only its scalar type and channels are looked at.
+static int PngTransforms(
+    const MIN_PNG &png,
+    const MinImg  &img) {
   png_uint_32 width = 0, height = 0;
   int depth = 0, color_type = 0, interlace = 0;
-  png_get_IHDR(pPng, pInfo, &width, &height, &depth,
+  png_get_IHDR(png.p_png, png.p_info, &width, &height, &depth,
                &color_type, &interlace, 0, 0);
-
-  if (color_type == PNG_COLOR_TYPE_PALETTE)
-    png_set_palette_to_rgb(pPng);
-
   int image_scalar_size_bytes = ByteSizeOfMinType(img.scalar_type);
 
+  int transforms = 0;
   if (color_type == PNG_COLOR_TYPE_GRAY && depth < 8
       && (depth != 1 || image_scalar_size_bytes == 1))
-    png_set_expand_gray_1_2_4_to_8(pPng);
+    transforms |= MIN_PNG_EXPAND_GRAY;
 
   if (color_type & PNG_COLOR_MASK_ALPHA &&
-      png_get_channels(pPng, pInfo) == img.channels + 1)
-    png_set_strip_alpha(pPng);
-
-  if (png_get_valid(pPng, pInfo, PNG_INFO_tRNS))
-    png_set_tRNS_to_alpha(pPng);
+      png_get_channels(png.p_png, png.p_info) == img.channels + 1)
+    transforms |= MIN_PNG_STRIP_ALPHA;
 
   if (depth == 16)
   {
     if (image_scalar_size_bytes == 1)
-      png_set_strip_16(pPng);
+      transforms |= MIN_PNG_STRIP_16;
 #ifndef __BIG_ENDIAN__
     else
-      png_set_swap(pPng);
+      transforms |= MIN_PNG_SWAP;
 #endif
   }
 
   if (depth > 1 && depth < 8 && image_scalar_size_bytes == 1)
+    transforms |= MIN_PNG_PACKING;
+  return transforms;
+}
+
+// Applies `transforms` to the png read by `PngReadInfo` and writes the
+// resulting prototype to `img`.
+static MinResult PngApplyTransforms(
+    MIN_PNG &png,
+    int      transforms,
+    MinImg  &img) {
+  png_structp pPng = png.p_png;
+  png_infop pInfo = png.p_info;
+  if (setjmp(png_jmpbuf(pPng)))
+    return MR_ENV_ERROR;
+
+  // Begin
+  png_uint_32 width = 0, height = 0;
+  int depth = 0, color_type = 0, interlace = 0;
+  png_get_IHDR(pPng, pInfo, &width, &height, &depth,
+               &color_type, &interlace, 0, 0);
+
+  if (color_type == PNG_COLOR_TYPE_PALETTE)
+    png_set_palette_to_rgb(pPng);
+
+  if (transforms & MIN_PNG_EXPAND_GRAY)
+    png_set_expand_gray_1_2_4_to_8(pPng);
+
+  if (transforms & MIN_PNG_STRIP_ALPHA)
+    png_set_strip_alpha(pPng);
+
+  if (png_get_valid(pPng, pInfo, PNG_INFO_tRNS))
+    png_set_tRNS_to_alpha(pPng);
+
+  if (transforms & MIN_PNG_STRIP_16)
+    png_set_strip_16(pPng);
+  if (transforms & MIN_PNG_SWAP)
+    png_set_swap(pPng);
+
+  if (transforms & MIN_PNG_PACKING)
     png_set_packing(pPng);
 
   if (interlace != PNG_INTERLACE_NONE)
@@ -155,30 +221,81 @@ static MinResult PngInitAndReadPrototype(
 }}
 
 
-namespace minimgio {namespace internal {
-MinResult GetNumPagesPng(int &num_pages, BinaryStream &) {
-  num_pages = 1;
+namespace {
+
+// Keeps the png read by a property query, so that the following load does
+// not read the header again. libpng cannot undo transformations, so the load
+// reuses the png only when it needs the same ones as the query.
+class PngDecoder : public minimgio::internal::Decoder {
+public:
+  explicit PngDecoder(minimgio::BinaryStream &stream):
+    stream(stream), transforms(-1), prototype() {}
+  MinResult GetNumPages(int &num_pages) override {
+    num_pages = 1;
+    return MR_SUCCESS;
+  }
+  MinResult GetProps(MinImg &img, ExtImgProps *p_props, int page) override;
+  MinResult Load(const MinImg &img, int page) override;
+
+private:
+  // reads the info and sets up the transformations for `img`, then writes
+  // the prototype of the image to decode to `img`
+  MinResult Prepare(MinImg &img);
+
+  minimgio::BinaryStream &stream;
+  MIN_PNG png;
+  int transforms;  // -1 unless they are applied to `png`
+  MinImg prototype;  // of the applied transformations
+};
+
+MinResult PngDecoder::Prepare(
+    MinImg &img) {
+  if (this->png.p_png && this->transforms >= 0) {
+    if (minimgio::internal::PngTransforms(this->png, img) == this->transforms) {
+      img.scalar_type = this->prototype.scalar_type;
+      img.channels = this->prototype.channels;
+      img.height = this->prototype.height;
+      img.width = this->prototype.width;
+      return MR_SUCCESS;
+    }
+    this->png.reset();
+  }
+  this->transforms = -1;
+  if (!this->png.p_png) {
+    if (this->stream.lseek(0) != 0)
+      return MR_ENV_ERROR;
+    const MinResult ret = minimgio::internal::PngReadInfo(this->png, this->stream);
+    if (ret != MR_SUCCESS) {
+      this->png.reset();
+      return ret;
+    }
+  }
+  const int transforms = minimgio::internal::PngTransforms(this->png, img);
+  const MinResult ret =
+    minimgio::internal::PngApplyTransforms(this->png, transforms, img);
+  if (ret != MR_SUCCESS) {
+    this->png.reset();
+    return ret;
+  }
+  this->transforms = transforms;
+  this->prototype = img;
   return MR_SUCCESS;
 }
-MinResult GetPropsPng(
+
+MinResult PngDecoder::GetProps(
     MinImg      &img,
     ExtImgProps *p_props,
-    BinaryStream &stream,
     int /*page*/
 ) {
   if (img.p_zero_line)
     return MR_CONTRACT_VIOLATION;
-  if (stream.lseek(0) != 0)
-    return MR_ENV_ERROR;
-  MIN_PNG png{};
-  MR_PROPAGATE_ERROR(
-    PngInitAndReadPrototype(&png.p_png, &png.p_info, img, stream));
+  MR_PROPAGATE_ERROR(this->Prepare(img));
 
   if (p_props)
   {
     int unitType = PNG_RESOLUTION_UNKNOWN;
     png_uint_32 resX = 0, resY = 0;
-    png_get_pHYs(png.p_png, png.p_info, &resX, &resY, &unitType);
+    png_get_pHYs(this->png.p_png, this->png.p_info, &resX, &resY, &unitType);
     p_props->iff = IFF_PNG;
     p_props->comp = IFC_NONE;
     p_props->qty = 0;  // zlib compression quality is unknown
@@ -196,9 +313,9 @@ MinResult GetPropsPng(
   }
   return MR_SUCCESS;
 }
-MinResult LoadPng(
+
+MinResult PngDecoder::Load(
   const MinImg &img,
-  BinaryStream &stream,
   int           /*page*/
 ) {
   if (!img.p_zero_line || img.channels < 1)
@@ -210,17 +327,10 @@ MinResult LoadPng(
   if (img.channels > 4)
     return MR_NOT_IMPLEMENTED;
 
-  // png_structp pPng = NULL;
-  // png_infop pInfo = NULL;
   MinImg imgRead = {};
   imgRead.channels = img.channels;
   imgRead.scalar_type = img.scalar_type;
-  if (stream.lseek(0) != 0)
-    return MR_ENV_ERROR;
-  MIN_PNG png{};
-  MR_PROPAGATE_ERROR(
-    PngInitAndReadPrototype(&png.p_png, &png.p_info, imgRead, stream)
-  );
+  MR_PROPAGATE_ERROR(this->Prepare(imgRead));
 
   if (
     imgRead.width != img.width ||
@@ -233,23 +343,45 @@ MinResult LoadPng(
     return MR_CONTRACT_VIOLATION;
   }
 
+  // The row table is allocated before setjmp, so that a libpng error
+  // does not jump over its release.
+  scoped_mem_array<png_bytep> ppRows(
+      MinMemAllocArray<png_bytep>(img.height, MMT_CODEC));
+  if (!ppRows)
+    return MR_ENV_ERROR;
+
+  // the rows are consumed, the next query has to read the file again
+  this->transforms = -1;
+  png_structp pPng = this->png.p_png;
   // Read the file
-  if (setjmp(png_jmpbuf(png.p_png)))
+  if (setjmp(png_jmpbuf(pPng)))
   {
+    this->png.reset();
     return MR_ENV_ERROR;
   }
-  scoped_cpp_array<png_bytep> ppRows(new png_bytep[img.height]);
   png_bytep line = img.p_zero_line;
   for (int32_t y = 0; y < img.height; ++y) {
     ppRows[y] = line;
     line += img.stride;
   }
 
-  png_read_image(png.p_png, ppRows);
+  png_read_image(pPng, ppRows);
+  this->png.reset();
 
   return MR_SUCCESS;
 }
 
+} // anonymous namespace
+
+namespace minimgio {namespace internal {
+MinResult CreateDecoderPng(
+    Decoder             *&p_decoder,
+    BinaryStream        &stream,
+    const DecodeOptions &/*options*/) {  // decodes full images only
+  p_decoder = new PngDecoder(stream);
+  return MR_SUCCESS;
+}
+
 #ifdef MINIMGIO_GENERATE
 MinResult SavePng(
     BinaryStream      &stream,
@@ -273,6 +405,11 @@ MinResult SavePng(
     return MR_CONTRACT_VIOLATION;
   }
 
+  scoped_mem_array<png_bytep> ppRows(
+      MinMemAllocArray<png_bytep>(img.height, MMT_CODEC));
+  if (!ppRows)
+    return MR_ENV_ERROR;
+
   png_structp pPng = png_create_write_struct(
     PNG_LIBPNG_VER_STRING, &stream, MinimgioPngError, MinimgioPngError);
   if (pPng == 0)
@@ -328,7 +465,6 @@ MinResult SavePng(
     png_set_swap(pPng);
 #endif
 
-  scoped_cpp_array<png_bytep> ppRows(new png_bytep[img.height]);
   png_bytep line = img.p_zero_line;
   for(int y = 0; y < img.height; ++y) {
     ppRows[y] = line;
@@ -45,6 +45,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <limits>
 #include "utils.h"
 #include "pack.h"
+#include "decoder.h"
 
 static void _TIFFClose(TIFF *pTIF) {
   if (pTIF)
@@ -54,9 +55,6 @@ static void _TIFFClose(TIFF *pTIF) {
 DEFINE_SCOPED_OBJECT(_scoped_tiff_handle, _TIFFClose)
 typedef _scoped_tiff_handle<TIFF> scoped_tiff_handle;
 
-DEFINE_SCOPED_OBJECT(_tiff_memory, _TIFFfree)
-typedef _tiff_memory<uint8_t> tiff_memory;
-
 template <class T> static void _TIFFGetField(
     TIFF *pTIF,
     ttag_t tag,
@@ -101,6 +99,33 @@ static toff_t MinimgioTIFFSize(
   return 0;
 }
 
+// Lets libtiff read memory-backed streams in place, see `BinaryStream::peek`.
+// Other streams fail to map and are read through `MinimgioTIFFRead`.
+static int MinimgioTIFFMap(
+    thandle_t handle,
+    void** p_base,
+    toff_t* p_size) {
+  minimgio::BinaryStream *stream =
+    reinterpret_cast<minimgio::BinaryStream*>(handle);
+  const int64_t pos = stream->lseek(0, SEEK_CUR);
+  if (pos < 0 || stream->lseek(0) != 0)
+    return 0;
+  std::size_t size = 0;
+  const uint8_t *p_data = stream->peek(size);
+  stream->lseek(pos);
+  if (!p_data || !size)
+    return 0;
+  *p_base = const_cast<uint8_t*>(p_data);
+  *p_size = static_cast<toff_t>(size);
+  return 1;
+}
+
+static void MinimgioTIFFUnmap(
+    thandle_t /*handle*/,
+    void* /*base*/,
+    toff_t /*size*/) {
+}
+
 static tsize_t MinimgioTIFFWrite(
     thandle_t handle,
     tdata_t buf,
@@ -164,35 +189,11 @@ static inline bool go_rgba(int metr) {
   return metr >= PHOTOMETRIC_YCBCR && metr != PHOTOMETRIC_CFA;
 }
 
-namespace minimgio { namespace internal {
-MinResult GetPropsTiff(
-    MinImg       &img,
-    ExtImgProps  *p_props,
-    BinaryStream &stream,
-    int           page) {
-  if (img.p_zero_line)
-    return MR_CONTRACT_VIOLATION;
-  if (page > std::numeric_limits<uint16_t>::max())
-    return MR_CONTRACT_VIOLATION;
-  if (stream.lseek(0) != 0)
-    return MR_ENV_ERROR;
-
-  TIFFSetErrorHandler(NULL);
-  TIFFSetWarningHandler(NULL);
-  TIFFSetErrorHandlerExt(MinimgioTIFFError);
-  scoped_tiff_handle pTIF(TIFFClientOpen(
-      "MINTIFF", "rmh", static_cast<thandle_t>(&stream), MinimgioTIFFRead,
-      MinimgioTIFFWrite, MinimgioTiffSeek, MinimgioTIFFClose,
-      MinimgioTIFFSize, NULL, NULL
-    ));
-  if (!pTIF)
-    return MR_ENV_ERROR;
-
-  const int num_pages = TIFFNumberOfDirectories(pTIF);
-  if (page >= num_pages)
-    return MR_CONTRACT_VIOLATION;
-  TIFFSetDirectory(pTIF, static_cast<uint16_t>(page));
-
+// Reads the properties of the current directory of `pTIF`.
+static MinResult ReadTiffProps(
+    MinImg      &img,
+    ExtImgProps *p_props,
+    TIFF        *pTIF) {
   {
     int nc = 0, typ = PLANARCONFIG_CONTIG, metr = 0;
     _TIFFGetField(pTIF, TIFFTAG_SAMPLESPERPIXEL, &nc, 1);
@@ -290,57 +291,10 @@ MinResult GetPropsTiff(
   return MR_SUCCESS;
 }
 
-MinResult GetNumPagesTiff(
-    int          &pages,
-    BinaryStream &stream) {
-  stream.initialize(MIS_READONLY);
-  if (stream.lseek(0) != 0)
-    return MR_ENV_ERROR;
-  TIFFSetErrorHandler(NULL);
-  TIFFSetWarningHandler(NULL);
-  TIFFSetErrorHandlerExt(NULL);  // don't show read error
-  scoped_tiff_handle pTIF(TIFFClientOpen(
-      "MINTIFF", "rm", static_cast<thandle_t>(&stream),
-      MinimgioTIFFRead, MinimgioTIFFWrite, MinimgioTiffSeek,
-      MinimgioTIFFClose, MinimgioTIFFSize, NULL, NULL
-    ));
-  if (!pTIF)
-    return MR_ENV_ERROR;
-  const int tiff_pages = TIFFNumberOfDirectories(pTIF);
-  if (tiff_pages < 0)
-    return MR_INTERNAL_ERROR;
-  pages = tiff_pages;
-  return MR_SUCCESS;
-}
-
-MinResult LoadTiff(
-    MinImg const &img,
-    BinaryStream &stream,
-    int           page) {
-  if (page < 0)
-    return MR_CONTRACT_VIOLATION;
-  if (!img.p_zero_line)
-    return MR_CONTRACT_VIOLATION;
-  if (page > std::numeric_limits<uint16_t>::max())
-    return MR_CONTRACT_VIOLATION;
-
-  TIFFSetErrorHandler(NULL);
-  TIFFSetWarningHandler(NULL);
-  TIFFSetErrorHandlerExt(MinimgioTIFFError);
-  if (stream.lseek(0) != 0)
-    return MR_ENV_ERROR;
-  scoped_tiff_handle pTIF(TIFFClientOpen(
-      "MINTIFF", "rm", static_cast<thandle_t>(&stream),
-      MinimgioTIFFRead, MinimgioTIFFWrite, MinimgioTiffSeek,
-      MinimgioTIFFClose, MinimgioTIFFSize, NULL, NULL
-    ));
-  if (!pTIF)
-    return MR_ENV_ERROR;
-  const int num_pages = TIFFNumberOfDirectories(pTIF);
-  if (page >= num_pages)
-    return MR_CONTRACT_VIOLATION;
-  TIFFSetDirectory(pTIF, static_cast<uint16_t>(page));
-
+// Reads the image of the current directory of `pTIF`.
+static MinResult ReadTiffImage(
+    const MinImg &img,
+    TIFF         *pTIF) {
   int nc = 0, typ = PLANARCONFIG_CONTIG, metr = PHOTOMETRIC_MINISWHITE;
   _TIFFGetField(pTIF, TIFFTAG_SAMPLESPERPIXEL, &nc, 1);
   _TIFFGetField(pTIF, TIFFTAG_PHOTOMETRIC, &metr, PHOTOMETRIC_MINISWHITE);
@@ -433,7 +387,8 @@ MinResult LoadTiff(
     if (!TIFFIsTiled(pTIF))
     {
       const tsize_t scan_size = TIFFScanlineSize(pTIF);
-      tiff_memory p_scan_line(reinterpret_cast<uint8_t*>(_TIFFmalloc(scan_size)));
+      scoped_mem_array<uint8_t> p_scan_line(MinMemAllocArray<uint8_t>(
+          static_cast<size_t>(scan_size), MMT_CODEC));
       if (!p_scan_line)
         return MR_ENV_ERROR;
       const int byte_width = GetMinImageBytesPerLine(p_read_img);
@@ -469,9 +424,10 @@ MinResult LoadTiff(
           !TIFFGetField(pTIF, TIFFTAG_TILELENGTH, &tile_height)) {
         return MR_ENV_ERROR;
       }
-      tiff_memory buf(reinterpret_cast<uint8_t*>(_TIFFmalloc(TIFFTileSize(pTIF))));
+      scoped_mem_array<uint8_t> buf(MinMemAllocArray<uint8_t>(
+          static_cast<size_t>(TIFFTileSize(pTIF)), MMT_CODEC));
       if (!buf)
-        return MR_INTERNAL_ERROR;
+        return MR_ENV_ERROR;
       const int pix_size = (bpc >> 3) * nc;
       for (int tile_y = 0; tile_y < ht; tile_y += tile_height)
       {
@@ -498,6 +454,112 @@ MinResult LoadTiff(
   return static_cast<MinResult>(
     OrientImageSpecial(img, *p_read_img, orientation));
 }
+
+namespace {
+
+// Keeps the file opened and its directory list counted between the queries,
+// so that a property query followed by the load of the same page reads the
+// directory once.
+class TiffDecoder : public minimgio::internal::Decoder {
+public:
+  explicit TiffDecoder(minimgio::BinaryStream &stream):
+    stream(stream), pTIF(NULL), num_pages(-1), directory(-1) {}
+  ~TiffDecoder() override {
+    _TIFFClose(this->pTIF);
+  }
+  MinResult GetNumPages(int &num_pages) override;
+  MinResult GetProps(MinImg &img, ExtImgProps *p_props, int page) override;
+  MinResult Load(const MinImg &img, int page) override;
+
+private:
+  MinResult Open();
+  // makes `page` the current directory
+  MinResult SetPage(int page);
+
+  minimgio::BinaryStream &stream;
+  TIFF *pTIF;  // NULL until opened
+  int num_pages;
+  int directory;  // the current one, -1 when it has to be read again
+};
+
+MinResult TiffDecoder::Open() {
+  TIFFSetErrorHandler(NULL);
+  TIFFSetWarningHandler(NULL);
+  TIFFSetErrorHandlerExt(MinimgioTIFFError);
+  if (this->pTIF)
+    return MR_SUCCESS;
+  if (this->stream.lseek(0) != 0)
+    return MR_ENV_ERROR;
+  // "h" defers reading of the first directory to `SetPage`
+  this->pTIF = TIFFClientOpen(
+      "MINTIFF", "rh", static_cast<thandle_t>(&this->stream),
+      MinimgioTIFFRead, MinimgioTIFFWrite, MinimgioTiffSeek,
+      MinimgioTIFFClose, MinimgioTIFFSize, MinimgioTIFFMap, MinimgioTIFFUnmap
+    );
+  if (!this->pTIF)
+    return MR_ENV_ERROR;
+  const int tiff_pages = TIFFNumberOfDirectories(this->pTIF);
+  if (tiff_pages < 0)
+    return MR_INTERNAL_ERROR;
+  this->num_pages = tiff_pages;
+  this->directory = -1;
+  return MR_SUCCESS;
+}
+
+MinResult TiffDecoder::SetPage(
+    int page) {
+  if (page < 0 || page > std::numeric_limits<uint16_t>::max())
+    return MR_CONTRACT_VIOLATION;
+  MR_PROPAGATE_ERROR(this->Open());
+  if (page >= this->num_pages)
+    return MR_CONTRACT_VIOLATION;
+  if (page != this->directory) {
+    this->directory = -1;
+    if (!TIFFSetDirectory(this->pTIF, static_cast<uint16_t>(page)))
+      return MR_ENV_ERROR;
+    this->directory = page;
+  }
+  return MR_SUCCESS;
+}
+
+MinResult TiffDecoder::GetNumPages(
+    int &pages) {
+  MR_PROPAGATE_ERROR(this->Open());
+  pages = this->num_pages;
+  return MR_SUCCESS;
+}
+
+MinResult TiffDecoder::GetProps(
+    MinImg      &img,
+    ExtImgProps *p_props,
+    int          page) {
+  if (img.p_zero_line)
+    return MR_CONTRACT_VIOLATION;
+  MR_PROPAGATE_ERROR(this->SetPage(page));
+  return ReadTiffProps(img, p_props, this->pTIF);
+}
+
+MinResult TiffDecoder::Load(
+    const MinImg &img,
+    int           page) {
+  if (!img.p_zero_line)
+    return MR_CONTRACT_VIOLATION;
+  MR_PROPAGATE_ERROR(this->SetPage(page));
+  // decoding moves libtiff on, so the directory is read again next time
+  this->directory = -1;
+  return ReadTiffImage(img, this->pTIF);
+}
+
+} // anonymous namespace
+
+namespace minimgio { namespace internal {
+MinResult CreateDecoderTiff(
+    Decoder             *&p_decoder,
+    BinaryStream        &stream,
+    const DecodeOptions &/*options*/) {  // decodes full images only
+  p_decoder = new TiffDecoder(stream);
+  return MR_SUCCESS;
+}
 } // namespace internal
 } // namespace minimgio
 
@@ -535,8 +597,7 @@ struct TiffData
 
   ~TiffData()
   {
-    if (scan_lines)
-      delete [] scan_lines;
+    MinMemFree(scan_lines);
     scan_lines = 0;
   }
 };
@@ -629,7 +690,9 @@ static MinResult AddPageToTiffExImpl(
 
     const uint8_t level = 128;
     size_t size = (img.width + 7) / 8;
-    scoped_cpp_array<uint8_t> pBuf(new uint8_t[size]);
+    scoped_mem_array<uint8_t> pBuf(MinMemAllocArray<uint8_t>(size, MMT_CODEC));
+    if (!pBuf)
+      return MR_ENV_ERROR;
 
     for (int y = 0; y < img.height; y++) {
       PackLine(pBuf, line, level, img.width, false);
@@ -647,7 +710,9 @@ static MinResult AddPageToTiffExImpl(
 //      return MR_NOT_IMPLEMENTED;
 
     const int size = img.width;
-    scoped_cpp_array<uint8_t> pBuf(new uint8_t[size]);
+    scoped_mem_array<uint8_t> pBuf(MinMemAllocArray<uint8_t>(size, MMT_CODEC));
+    if (!pBuf)
+      return MR_ENV_ERROR;
 
     for (int y = 0; y < img.height; ++y) {
       UnpackLine(pBuf, line, img.width, false);
@@ -669,6 +734,29 @@ static MinResult AddPageToTiffExImpl(
 }
 
 
+// Counts the pages of a file opened for writing, which may be empty.
+static MinResult GetNumPagesTiff(
+    int                    &pages,
+    minimgio::BinaryStream &stream) {
+  if (stream.lseek(0) != 0)
+    return MR_ENV_ERROR;
+  TIFFSetErrorHandler(NULL);
+  TIFFSetWarningHandler(NULL);
+  TIFFSetErrorHandlerExt(NULL);  // don't show read error
+  scoped_tiff_handle pTIF(TIFFClientOpen(
+      "MINTIFF", "r", static_cast<thandle_t>(&stream),
+      MinimgioTIFFRead, MinimgioTIFFWrite, MinimgioTiffSeek,
+      MinimgioTIFFClose, MinimgioTIFFSize, MinimgioTIFFMap, MinimgioTIFFUnmap
+    ));
+  if (!pTIF)
+    return MR_ENV_ERROR;
+  const int tiff_pages = TIFFNumberOfDirectories(pTIF);
+  if (tiff_pages < 0)
+    return MR_INTERNAL_ERROR;
+  pages = tiff_pages;
+  return MR_SUCCESS;
+}
+
 namespace minimgio {
 namespace internal {
 MinResult SaveTiff(
@@ -738,7 +826,10 @@ MinResult SaveTiff(
       _TIFFGetField(pTIF, TIFFTAG_COMPRESSION, &data.compression_type, COMPRESSION_NONE);
       _TIFFGetField(pTIF, TIFFTAG_JPEGQUALITY, &data.jpeg_quality, 100);
       const tmsize_t scanLen = TIFFScanlineSize(pTIF);
-      data.scan_lines = new uint8_t[data.height * scanLen];
+      data.scan_lines = MinMemAllocArray<uint8_t>(
+          static_cast<size_t>(data.height) * scanLen, MMT_CODEC);
+      if (!data.scan_lines)
+        return MR_ENV_ERROR;
       data.scanLen = scanLen;
       for (int y = 0; y < data.height; y++)
       {
@@ -31,7 +31,6 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <cstdlib>
 #include <cstring>
-#include <vector>
 
 #include <webp/decode.h>
 #include <webp/encode.h>
@@ -39,6 +38,8 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <minutils/smartptr.h>
 #include <minimgio/minimgio.hpp>
 
+#include "decoder.h"
+
 
 static MinResult GetWebPPropsFromMemory(
     MinImg        &img,
@@ -63,23 +64,40 @@ static MinResult GetWebPPropsFromMemory(
   return MR_SUCCESS;
 }
 
+// Points `p_file_data` to the whole file: to the stream memory when the
+// stream exposes it, otherwise to a copy returned in `p_file_copy`, which the
+// caller frees.
 static MinResult ReadStreamToMemory(
-    std::vector<uint8_t> &file_data,
-    minimgio::BinaryStream& stream) {
-  int64_t file_size = stream.lseek(0, SEEK_END);
-  if (file_size < 0)
+    const uint8_t         *&p_file_data,
+    size_t                 &file_size,
+    uint8_t               *&p_file_copy,
+    minimgio::BinaryStream &stream) {
+  if (stream.lseek(0) != 0)
+    return MR_ENV_ERROR;
+  p_file_data = stream.peek(file_size);
+  if (p_file_data)
+    return file_size ? MR_SUCCESS : MR_ENV_ERROR;
+  const int64_t stream_size = stream.lseek(0, SEEK_END);
+  if (stream_size <= 0)
     return MR_ENV_ERROR;
   stream.lseek(0);
-  file_data.resize(static_cast<size_t>(file_size));
-  if (stream.read(&file_data[0], file_data.size()) != file_data.size())
+  file_size = static_cast<size_t>(stream_size);
+  p_file_copy = MinMemAllocArray<uint8_t>(file_size, MMT_CODEC);
+  if (!p_file_copy)
     return MR_ENV_ERROR;
+  if (stream.read(p_file_copy, file_size) != file_size) {
+    MinMemFree(p_file_copy);
+    p_file_copy = NULL;
+    return MR_ENV_ERROR;
+  }
+  p_file_data = p_file_copy;
   return MR_SUCCESS;
 }
 
 static MinResult DecodeWebPFromMemory(
-    const MinImg &img,
-    uint8_t      *ptr,
-    size_t        size) {
+    const MinImg  &img,
+    const uint8_t *ptr,
+    size_t         size) {
   if (!ptr || size == 0) {
     return MR_CONTRACT_VIOLATION;
   }
@@ -172,29 +190,55 @@ static MinResult min_webp_error(
   return ret;
 }
 
-namespace minimgio {namespace internal {
-MinResult GetPropsWebP(
+namespace {
+
+// Reads the file into memory once for both the properties and the pixels.
+class WebPDecoder : public minimgio::internal::Decoder {
+public:
+  explicit WebPDecoder(minimgio::BinaryStream &stream):
+    stream(stream), p_file_data(NULL), file_size(0), p_file_copy(NULL) {}
+  ~WebPDecoder() override {
+    MinMemFree(this->p_file_copy);
+  }
+  MinResult GetNumPages(int &num_pages) override {
+    num_pages = 1;
+    return MR_SUCCESS;
+  }
+  MinResult GetProps(MinImg &img, ExtImgProps *p_props, int page) override;
+  MinResult Load(const MinImg &img, int page) override;
+
+private:
+  MinResult ReadFile();
+
+  minimgio::BinaryStream &stream;
+  const uint8_t *p_file_data;  // NULL until the file is read
+  size_t file_size;
+  uint8_t *p_file_copy;
+};
+
+MinResult WebPDecoder::ReadFile() {
+  if (this->p_file_data)
+    return MR_SUCCESS;
+  const MinResult ret = ReadStreamToMemory(
+    this->p_file_data, this->file_size, this->p_file_copy, this->stream);
+  if (ret != MR_SUCCESS)
+    this->p_file_data = NULL;
+  return ret;
+}
+
+MinResult WebPDecoder::GetProps(
     MinImg       &img,
     ExtImgProps  *p_props,
-    BinaryStream &stream,
     int page) {
   if (page != 0)
     return MR_NOT_IMPLEMENTED;
-  std::vector<uint8_t> file_data;
-  MR_PROPAGATE_ERROR(ReadStreamToMemory(file_data, stream));
-  return GetWebPPropsFromMemory(img, p_props, &file_data[0], file_data.size());
-}
-
-MinResult GetNumPagesWebP(
-    int &num_pages,
-    BinaryStream &/*s*/) {
-  num_pages = 1;
-  return MR_SUCCESS;
+  MR_PROPAGATE_ERROR(this->ReadFile());
+  return GetWebPPropsFromMemory(
+    img, p_props, this->p_file_data, this->file_size);
 }
 
-MinResult LoadWebP(
+MinResult WebPDecoder::Load(
     const MinImg &img,
-    BinaryStream  &stream,
     int           page) {
   if (!img.p_zero_line)
     return MR_CONTRACT_VIOLATION;
@@ -204,10 +248,21 @@ MinResult LoadWebP(
     return MR_CONTRACT_VIOLATION;
   if (page != 0)
     return MR_NOT_IMPLEMENTED;
-  std::vector<uint8_t> file_data;
-  MR_PROPAGATE_ERROR(ReadStreamToMemory(file_data, stream));
-  return DecodeWebPFromMemory(img, &file_data[0], file_data.size());
+  MR_PROPAGATE_ERROR(this->ReadFile());
+  return DecodeWebPFromMemory(img, this->p_file_data, this->file_size);
 }
+
+} // anonymous namespace
+
+namespace minimgio {namespace internal {
+MinResult CreateDecoderWebP(
+    Decoder             *&p_decoder,
+    BinaryStream        &stream,
+    const DecodeOptions &/*options*/) {  // decodes full images only
+  p_decoder = new WebPDecoder(stream);
+  return MR_SUCCESS;
+}
+
 #ifdef MINIMGIO_GENERATE
 MinResult SaveWebP(
     BinaryStream      &stream,
@@ -36,6 +36,14 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <minbase/minresult.h>
 #include <minbase/minimg.h>
 
+#ifdef MINIMGIO_STOPWATCH
+#include <minstopwatch/stopwatch.hpp>
+# define MINIMGIO_DECLARE_STOPWATCH_CTL(sw, p_image) \
+    DECLARE_MINSTOPWATCH_CTL_EX(sw, p_image)
+#else
+# define MINIMGIO_DECLARE_STOPWATCH_CTL(sw, p_image)
+#endif
+
 MinResult ExtractMemoryLocation(
   const char  *fileName,
   uint8_t    **ptr,
@@ -226,6 +226,41 @@ protected:
   std::vector<uint8_t> inner_vec;
 };
 
+struct CountingBinaryStream : public TestBinaryStream {
+  CountingBinaryStream() : reads(0), seeks(0) {}
+  std::size_t read(void* buffer, std::size_t size) override {
+    ++this->reads;
+    return TestBinaryStream::read(buffer, size);
+  }
+  int64_t lseek(int64_t offset, int whence) override {
+    ++this->seeks;
+    return TestBinaryStream::lseek(offset, whence);
+  }
+  int reads;
+  int seeks;
+};
+
+// exposes its memory through `peek`, so codecs can decode in place
+struct CountingMemoryStream : public minimgio::BinaryMemoryReadonlyStream {
+  CountingMemoryStream(const std::vector<uint8_t> &vec)
+    : minimgio::BinaryMemoryReadonlyStream(vec.data(), vec.size()),
+      reads(0), read_bytes(0), peeks(0) {}
+  std::size_t read(void* buffer, std::size_t size) override {
+    ++this->reads;
+    const std::size_t n =
+      minimgio::BinaryMemoryReadonlyStream::read(buffer, size);
+    this->read_bytes += n;
+    return n;
+  }
+  const uint8_t* peek(std::size_t &size) override {
+    ++this->peeks;
+    return minimgio::BinaryMemoryReadonlyStream::peek(size);
+  }
+  int reads;
+  std::size_t read_bytes;
+  int peeks;
+};
+
 void minimgio_test_props(const ImgFileFormat iff) {
   DECLARE_GUARDED_MINIMG(img);
   create_test_image<uint8_t>(img);
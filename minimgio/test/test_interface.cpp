@@ -154,11 +154,132 @@ TEST(TestMinimgio, load_dir) {
   int num_pages = -1;
   ASSERT_EQ(MR_ENV_ERROR, minimgio::GetNumPages(num_pages, stream));
   ASSERT_EQ(-1, num_pages);
+  minimgio::BinaryMappedFileStream mapped_stream(".");
+  ASSERT_EQ(MR_ENV_ERROR, minimgio::GetFileProps(loaded_image, mapped_stream));
 //  ASSERT_EQ(FILE_ERROR, GetMinImageFileProps(&loaded_image, "."));
 //  ASSERT_EQ(FILE_ERROR, GetMinImageFilePages("."));
 }
 
 
+TEST(TestMinimgio, memory_stream_peek) {
+  const uint8_t data[] = {1, 2, 3, 4, 5};
+  minimgio::BinaryMemoryReadonlyStream stream(data, sizeof(data));
+  std::size_t size = 0;
+  ASSERT_EQ(data, stream.peek(size));
+  ASSERT_EQ(sizeof(data), size);
+  uint8_t byte = 0;
+  ASSERT_EQ(1U, stream.read(&byte, 1));
+  ASSERT_EQ(data + 1, stream.peek(size));
+  ASSERT_EQ(sizeof(data) - 1, size);
+  ASSERT_EQ(1U, stream.read(&byte, 1));  // peek does not move the position
+  ASSERT_EQ(2, byte);
+  stream.lseek(100, SEEK_SET);
+  ASSERT_NE(nullptr, stream.peek(size));
+  ASSERT_EQ(0U, size);
+
+  TestBinaryStream vector_stream;
+  ASSERT_EQ(nullptr, vector_stream.peek(size));
+}
+
+TEST(TestMinimgio, growable_memory_stream) {
+  minimgio::BinaryMemoryStream stream(16);
+  std::size_t size = 1;
+  ASSERT_EQ(0U, stream.size());
+  ASSERT_EQ(0U, stream.read(&size, sizeof(size)));
+  std::vector<uint8_t> data(10000);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i * 7 + 1);
+  // growing keeps what was written
+  ASSERT_EQ(10U, stream.write(&data[0], 10));
+  const uint8_t *p_small = stream.data();
+  ASSERT_EQ(data.size() - 10, stream.write(&data[10], data.size() - 10));
+  ASSERT_NE(p_small, stream.data());
+  ASSERT_EQ(data.size(), stream.size());
+  ASSERT_EQ(0, ::memcmp(stream.data(), &data[0], data.size()));
+  // reserving room leaves the data in place
+  ASSERT_EQ(MR_SUCCESS, stream.reserve(2 * data.size()));
+  const uint8_t *p_reserved = stream.data();
+  ASSERT_EQ(0, ::memcmp(p_reserved, &data[0], data.size()));
+  ASSERT_EQ(static_cast<int64_t>(data.size()), stream.lseek(0, SEEK_END));
+  ASSERT_EQ(data.size(), stream.write(&data[0], data.size()));
+  ASSERT_EQ(p_reserved, stream.data());
+
+  // overwriting in the middle, then reading back
+  ASSERT_EQ(5, stream.lseek(5, SEEK_SET));
+  ASSERT_EQ(3U, stream.write("abc", 3));
+  ASSERT_EQ(2 * data.size(), stream.size());
+  uint8_t chunk[8] = {};
+  ASSERT_EQ(4, stream.lseek(4, SEEK_SET));
+  ASSERT_EQ(5U, stream.read(chunk, 5));
+  ASSERT_EQ(data[4], chunk[0]);
+  ASSERT_EQ(0, ::memcmp(chunk + 1, "abc", 3));
+  ASSERT_EQ(data[8], chunk[4]);
+  const uint8_t *p_rest = stream.peek(size);
+  ASSERT_EQ(stream.data() + 9, p_rest);
+  ASSERT_EQ(2 * data.size() - 9, size);
+
+  // writes past the end fill the gap with zeros
+  ASSERT_EQ(-1, stream.lseek(-1, SEEK_SET));
+  const int64_t gap_start = stream.lseek(0, SEEK_END);
+  ASSERT_EQ(gap_start + 100, stream.lseek(100, SEEK_CUR));
+  ASSERT_EQ(1U, stream.write("z", 1));
+  ASSERT_EQ(static_cast<std::size_t>(gap_start + 101), stream.size());
+  for (int64_t i = gap_start; i < gap_start + 100; ++i)
+    ASSERT_EQ(0, stream.data()[i]);
+  ASSERT_EQ('z', stream.data()[gap_start + 100]);
+}
+
+TEST(TestMinimgio, buffered_stream) {
+  CountingBinaryStream inner;
+  std::vector<uint8_t> data(1000);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i * 7);
+  inner.write(&data[0], data.size());
+  inner.lseek(0, SEEK_SET);
+  inner.reads = inner.seeks = 0;
+
+  minimgio::BufferedBinaryStream stream(inner, 256);
+  uint8_t chunk[300] = {};
+  ASSERT_EQ(10U, stream.read(chunk, 10));
+  ASSERT_EQ(0, ::memcmp(chunk, &data[0], 10));
+  ASSERT_EQ(1, inner.reads);
+  // small reads and seeks inside the buffer do not reach the inner stream
+  ASSERT_EQ(100, stream.lseek(100, SEEK_SET));
+  ASSERT_EQ(50U, stream.read(chunk, 50));
+  ASSERT_EQ(0, ::memcmp(chunk, &data[100], 50));
+  ASSERT_EQ(2, stream.lseek(2, SEEK_SET));
+  ASSERT_EQ(4U, stream.read(chunk, 4));
+  ASSERT_EQ(0, ::memcmp(chunk, &data[2], 4));
+  ASSERT_EQ(1, inner.reads);
+  ASSERT_EQ(1, inner.seeks);  // the position sync before the first refill
+  // reads across the buffer end refill it
+  ASSERT_EQ(250, stream.lseek(250, SEEK_SET));
+  ASSERT_EQ(20U, stream.read(chunk, 20));
+  ASSERT_EQ(0, ::memcmp(chunk, &data[250], 20));
+  ASSERT_EQ(2, inner.reads);
+  // large reads go straight through
+  ASSERT_EQ(600, stream.lseek(600, SEEK_SET));
+  ASSERT_EQ(300U, stream.read(chunk, 300));
+  ASSERT_EQ(0, ::memcmp(chunk, &data[600], 300));
+  ASSERT_EQ(3, inner.reads);
+  ASSERT_EQ(1000, stream.lseek(0, SEEK_END));
+  ASSERT_EQ(0U, stream.read(chunk, 1));
+  ASSERT_EQ(-1, stream.lseek(-1, SEEK_SET));
+}
+
+#ifndef _WIN32
+TEST(TestMinimgio, mapped_stream_fallback) {
+  // character devices cannot be mapped and are read through the descriptor
+  minimgio::BinaryMappedFileStream stream("/dev/zero");
+  ASSERT_EQ(MR_SUCCESS, stream.initialize(MIS_READONLY));
+  ASSERT_EQ(nullptr, stream.mapped_data());
+  uint8_t block[16] = {1};
+  ASSERT_EQ(sizeof(block), stream.read(block, sizeof(block)));
+  for (uint8_t value : block)
+    ASSERT_EQ(0, value);
+}
+#endif
+
 TEST(TestMinimgio, lst_pages) {
   static char const ref_names[8][20] = {
     "orientation_1.jpg",
@@ -135,6 +135,504 @@ TEST(TestMinimgio, tiff_jpeg_focus) {
   ASSERT_EQ(65546U, props.focal_length_den);
 }
 
+TEST(TestMinimgio, jpeg_memory_stream) {
+  DECLARE_GUARDED_MINIMG(original_img);
+  create_test_image<uint8_t>(original_img, 3);
+  TestBinaryStream stream;
+  ASSERT_EQ(MR_SUCCESS, minimgio::Save(stream, original_img, IFF_JPEG));
+  std::vector<uint8_t> data(static_cast<size_t>(stream.lseek(0, SEEK_END)));
+  stream.lseek(0, SEEK_SET);
+  ASSERT_EQ(data.size(), stream.read(&data[0], data.size()));
+  DECLARE_GUARDED_MINIMG(expected_img);
+  ASSERT_EQ(NO_ERRORS, CloneMinImagePrototype(&expected_img, &original_img));
+  DECLARE_GUARDED_MINIMG(loaded_image);
+  ASSERT_EQ(NO_ERRORS, CloneMinImagePrototype(&loaded_image, &original_img));
+
+  // the zero-copy source decodes what the buffered one does, up to the end
+  // of truncated data
+  for (size_t size : {data.size(), data.size() / 2}) {
+    TestBinaryStream copying_stream;
+    copying_stream.write(&data[0], size);
+    ASSERT_EQ(MR_SUCCESS, minimgio::Load(expected_img, copying_stream));
+    minimgio::BinaryMemoryReadonlyStream memory_stream(&data[0], size);
+    ASSERT_EQ(MR_SUCCESS, minimgio::Load(loaded_image, memory_stream));
+    ASSERT_EQ(NO_ERRORS, CompareMinImages(&loaded_image, &expected_img));
+  }
+}
+
+TEST(TestMinimgio, jpeg_mapped_file) {
+  SKIP_IF(!images_dir);
+  std::string const fn = std::string(images_dir) + "orientation_6.jpg";
+  DECLARE_GUARDED_MINIMG(expected_img);
+  minimgio::BinaryFileStream file_stream(fn.c_str());
+  ASSERT_EQ(MR_SUCCESS, minimgio::GetFileProps(expected_img, file_stream));
+  ASSERT_EQ(NO_ERRORS, AllocMinImage(&expected_img));
+  ASSERT_EQ(MR_SUCCESS, minimgio::Load(expected_img, file_stream));
+
+  DECLARE_GUARDED_MINIMG(loaded_image);
+  minimgio::BinaryMappedFileStream stream(fn.c_str());
+  ASSERT_EQ(MR_SUCCESS, minimgio::GetFileProps(loaded_image, stream));
+  ASSERT_NE(nullptr, stream.mapped_data());
+  ASSERT_EQ(stream.mapped_size(),
+            static_cast<std::size_t>(stream.lseek(0, SEEK_END)));
+  ASSERT_EQ(NO_ERRORS, AllocMinImage(&loaded_image));
+  ASSERT_EQ(MR_SUCCESS, minimgio::Load(loaded_image, stream));
+  ASSERT_EQ(NO_ERRORS, CompareMinImages(&loaded_image, &expected_img));
+}
+
+TEST(TestMinimgio, jpeg_decoder_session) {
+  SKIP_IF(!images_dir);
+  std::string const fn = std::string(images_dir) + "orientation_6.jpg";
+  CountingBinaryStream stream;
+  {
+    minimgio::BinaryFileStream file_stream(fn.c_str());
+    ASSERT_EQ(MR_SUCCESS, file_stream.initialize(MIS_READONLY));
+    std::vector<uint8_t> data(
+      static_cast<size_t>(file_stream.lseek(0, SEEK_END)));
+    file_stream.lseek(0, SEEK_SET);
+    ASSERT_EQ(data.size(), file_stream.read(&data[0], data.size()));
+    stream.write(&data[0], data.size());
+  }
+  stream.reads = 0;
+  DECLARE_GUARDED_MINIMG(expected_img);
+  ExtImgProps expected_props = {};
+  ASSERT_EQ(MR_SUCCESS,
+            minimgio::GetFileProps(expected_img, stream, &expected_props));
+  ASSERT_EQ(NO_ERRORS, AllocMinImage(&expected_img));
+  ASSERT_EQ(MR_SUCCESS, minimgio::Load(expected_img, stream));
+  const int separate_reads = stream.reads;
+
+  // the load continues the decompression started by the props query
+  stream.reads = 0;
+  minimgio::DecoderSession session(stream);
+  DECLARE_GUARDED_MINIMG(loaded_image);
+  ExtImgProps props = {};
+  ASSERT_EQ(MR_SUCCESS, session.get_file_props(loaded_image, &props));
+  ASSERT_EQ(NO_ERRORS, CompareMinImagePrototypes(&loaded_image, &expected_img));
+  ASSERT_EQ(expected_props.xDPI, props.xDPI);
+  ASSERT_EQ(expected_props.yDPI, props.yDPI);
+  ASSERT_EQ(NO_ERRORS, AllocMinImage(&loaded_image));
+  ASSERT_EQ(MR_SUCCESS, session.load(loaded_image));
+  ASSERT_LT(stream.reads, separate_reads);
+  ASSERT_EQ(NO_ERRORS, CompareMinImages(&loaded_image, &expected_img));
+
+  // later queries start it over
+  ASSERT_EQ(NO_ERRORS, ZeroFillMinImage(&loaded_image));
+  ASSERT_EQ(MR_SUCCESS, session.load(loaded_image));
+  ASSERT_EQ(NO_ERRORS, CompareMinImages(&loaded_image, &expected_img));
+  int num_pages = 0;
+  ASSERT_EQ(MR_SUCCESS, session.get_num_pages(num_pages));
+  ASSERT_EQ(1, num_pages);
+}
+
+TEST(TestMinimgio, jpeg_scaled_decode) {
+  DECLARE_GUARDED_MINIMG(original_img);
+  create_test_image<uint8_t>(original_img, 3);
+  TestBinaryStream stream;
+  ASSERT_EQ(MR_SUCCESS, minimgio::Save(stream, original_img, IFF_JPEG));
+  ExtImgProps full_props = {};
+  DECLARE_GUARDED_MINIMG(full_img);
+  ASSERT_EQ(MR_SUCCESS, minimgio::GetFileProps(full_img, stream, &full_props));
+
+  // the sizes are rounded up, the resolution goes down with them
+  for (int denom : {1, 2, 4, 8}) {
+    DecodeOptions options = {};
+    options.scale_denom = denom;
+    DECLARE_GUARDED_MINIMG(loaded_image);
+    ExtImgProps props = {};
+    ASSERT_EQ(MR_SUCCESS, minimgio::GetFileProps(
+        loaded_image, stream, &props, 0, &options));
+    ASSERT_EQ((original_img.width + denom - 1) / denom, loaded_image.width);
+    ASSERT_EQ((original_img.height + denom - 1) / denom, loaded_image.height);
+    ASSERT_EQ(full_props.xDPI / denom, props.xDPI);
+    ASSERT_EQ(NO_ERRORS, AllocMinImage(&loaded_image));
+    ASSERT_EQ(MR_SUCCESS, minimgio::Load(loaded_image, stream, 0, &options));
+  }
+
+  // the limits pick the smallest reduction the image fits with
+  DecodeOptions limits = {};
+  limits.max_width = 200;
+  DECLARE_GUARDED_MINIMG(limited_img);
+  minimgio::DecoderSession session(stream, &limits);
+  ASSERT_EQ(MR_SUCCESS, session.get_file_props(limited_img));
+  ASSERT_EQ(150, limited_img.width);
+  ASSERT_EQ(75, limited_img.height);
+  ASSERT_EQ(NO_ERRORS, AllocMinImage(&limited_img));
+  ASSERT_EQ(MR_SUCCESS, session.load(limited_img));
+
+  DecodeOptions invalid = {};
+  invalid.scale_denom = 3;
+  ASSERT_EQ(MR_CONTRACT_VIOLATION,
+            minimgio::GetFileProps(limited_img, stream, nullptr, 0, &invalid));
+}
+
+TEST(TestMinimgio, jpeg_scaled_orientation) {
+  SKIP_IF(!images_dir);
+  std::string const fn = std::string(images_dir) + "orientation_6.jpg";
+  minimgio::BinaryFileStream stream(fn.c_str());
+  DECLARE_GUARDED_MINIMG(full_img);
+  ASSERT_EQ(MR_SUCCESS, minimgio::GetFileProps(full_img, stream));
+
+  // the limits apply to the image as it is shown
+  DecodeOptions options = {};
+  options.max_width = full_img.width / 2;
+  options.max_height = full_img.height / 2;
+  DECLARE_GUARDED_MINIMG(loaded_image);
+  MIStreamHandle handle = NULL;
+  ASSERT_EQ(MR_SUCCESS, MinImgIoCreateFileStream(&handle, fn.c_str()));
+  ASSERT_EQ(MR_SUCCESS,
+            MinImgIoGetFilePropsEx(&loaded_image, NULL, handle, 0, &options));
+  ASSERT_EQ(full_img.width / 2, loaded_image.width);
+  ASSERT_EQ(full_img.height / 2, loaded_image.height);
+  ASSERT_EQ(NO_ERRORS, AllocMinImage(&loaded_image, 16));
+  ASSERT_EQ(MR_SUCCESS, MinImgIoLoadEx(&loaded_image, handle, 0, &options));
+  ASSERT_EQ(MR_SUCCESS, MinImgIoFreeStream(&handle));
+  DECLARE_GUARDED_MINIMG(expected_img);
+  ASSERT_EQ(NO_ERRORS, create_f_image(&expected_img, 8, 1));
+  ASSERT_EQ(NO_ERRORS, CompareMinImages(&loaded_image, &expected_img));
+}
+
+// A region decoded on its own matches the same region of the full image, in
+// every orientation and at every scale.
+static void _test_region(std::string fn) {
+  SKIP_IF(!images_dir);
+  fn = images_dir + fn;
+  minimgio::BinaryFileStream stream(fn.c_str());
+  for (int denom : {1, 2}) {
+    DecodeOptions scale = {};
+    scale.scale_denom = denom;
+    DECLARE_GUARDED_MINIMG(full_img);
+    ASSERT_EQ(MR_SUCCESS,
+              minimgio::GetFileProps(full_img, stream, nullptr, 0, &scale));
+    ASSERT_EQ(NO_ERRORS, AllocMinImage(&full_img));
+    ASSERT_EQ(MR_SUCCESS, minimgio::Load(full_img, stream, 0, &scale));
+
+    const int x = full_img.width / 3 + 1, y = full_img.height / 2 + 3;
+    DecodeOptions options = scale;
+    options.region_x = x;
+    options.region_y = y;
+    options.region_width = full_img.width / 2 - 5;
+    options.region_height = full_img.height / 2 - 7;
+    DECLARE_GUARDED_MINIMG(loaded_image);
+    ASSERT_EQ(MR_SUCCESS,
+              minimgio::GetFileProps(loaded_image, stream, nullptr, 0, &options));
+    ASSERT_EQ(options.region_width, loaded_image.width);
+    ASSERT_EQ(options.region_height, loaded_image.height);
+    ASSERT_EQ(NO_ERRORS, AllocMinImage(&loaded_image));
+    ASSERT_EQ(MR_SUCCESS, minimgio::Load(loaded_image, stream, 0, &options));
+    MinImg expected_img = {};
+    ASSERT_EQ(NO_ERRORS, GetMinImageRegion(&expected_img, &full_img, x, y,
+        loaded_image.width, loaded_image.height, RO_REUSE_CONTAINER));
+    ASSERT_EQ(NO_ERRORS, CompareMinImages(&loaded_image, &expected_img));
+
+    options.region_x = full_img.width - options.region_width + 1;
+    ASSERT_EQ(MR_CONTRACT_VIOLATION,
+              minimgio::GetFileProps(loaded_image, stream, nullptr, 0, &options));
+  }
+}
+
+TEST(TestMinimgio, jpeg_region_orientation_1) {
+  _test_region("orientation_1.jpg");
+}
+TEST(TestMinimgio, jpeg_region_orientation_2) {
+  _test_region("orientation_2.jpg");
+}
+TEST(TestMinimgio, jpeg_region_orientation_3) {
+  _test_region("orientation 3.jpg");
+}
+TEST(TestMinimgio, jpeg_region_orientation_4) {
+  _test_region("orientation_4.jpg");
+}
+TEST(TestMinimgio, jpeg_region_orientation_5) {
+  _test_region("orientation_5.jpg");
+}
+TEST(TestMinimgio, jpeg_region_orientation_6) {
+  _test_region("orientation_6.jpg");
+}
+TEST(TestMinimgio, jpeg_region_orientation_7) {
+  _test_region("orientation_7.jpg");
+}
+TEST(TestMinimgio, jpeg_region_orientation_8) {
+  _test_region("orientation_8.jpg");
+}
+
+TEST(TestMinimgio, jpeg_region_photo) {
+  DECLARE_GUARDED_MINIMG(original_img);
+  create_test_image<uint8_t>(original_img, 3);
+  TestBinaryStream stream;
+  ASSERT_EQ(MR_SUCCESS, minimgio::Save(stream, original_img, IFF_JPEG));
+  DECLARE_GUARDED_MINIMG(full_img);
+  ASSERT_EQ(NO_ERRORS, CloneMinImagePrototype(&full_img, &original_img));
+  ASSERT_EQ(MR_SUCCESS, minimgio::Load(full_img, stream));
+
+  // chroma is upsampled across the borders of the region, as in the full image
+  DecodeOptions options = {};
+  options.region_x = 37;
+  options.region_y = 29;
+  options.region_width = 101;
+  options.region_height = 83;
+  DECLARE_GUARDED_MINIMG(loaded_image);
+  ASSERT_EQ(MR_SUCCESS,
+            minimgio::GetFileProps(loaded_image, stream, nullptr, 0, &options));
+  ASSERT_EQ(NO_ERRORS, AllocMinImage(&loaded_image));
+  ASSERT_EQ(MR_SUCCESS, minimgio::Load(loaded_image, stream, 0, &options));
+  MinImg expected_img = {};
+  ASSERT_EQ(NO_ERRORS, GetMinImageRegion(&expected_img, &full_img, 37, 29,
+      101, 83, RO_REUSE_CONTAINER));
+  ASSERT_EQ(NO_ERRORS, CompareMinImages(&loaded_image, &expected_img));
+
+  TestBinaryStream png_stream;
+  ASSERT_EQ(MR_SUCCESS, minimgio::Save(png_stream, original_img, IFF_PNG));
+  ASSERT_EQ(MR_NOT_IMPLEMENTED,
+            minimgio::GetFileProps(loaded_image, png_stream, nullptr, 0, &options));
+}
+
+// Inserts an EXIF block with the `orientation` tag right after the SOI marker.
+static std::vector<uint8_t> add_orientation(
+    const std::vector<uint8_t> &jpeg,
+    uint16_t                    orientation) {
+  const uint8_t app1[] = {
+    0xFF, 0xE1, 0, 34, 'E', 'x', 'i', 'f', 0, 0,
+    'I', 'I', 42, 0, 8, 0, 0, 0, 1, 0,
+    0x12, 0x01, 3, 0, 1, 0, 0, 0, static_cast<uint8_t>(orientation), 0, 0, 0,
+    0, 0, 0, 0
+  };
+  std::vector<uint8_t> result(jpeg);
+  result.insert(result.begin() + 2, app1, app1 + sizeof(app1));
+  return result;
+}
+
+TEST(TestMinimgio, jpeg_rgb_orientations) {
+  DECLARE_GUARDED_MINIMG(original_img);
+  create_test_image<uint8_t>(original_img, 3, 150, 70);
+  TestBinaryStream saved;
+  ASSERT_EQ(MR_SUCCESS, minimgio::Save(saved, original_img, IFF_JPEG));
+  std::vector<uint8_t> data(static_cast<size_t>(saved.lseek(0, SEEK_END)));
+  saved.lseek(0, SEEK_SET);
+  ASSERT_EQ(data.size(), saved.read(&data[0], data.size()));
+  DECLARE_GUARDED_MINIMG(stored_img);
+  ASSERT_EQ(NO_ERRORS, CloneMinImagePrototype(&stored_img, &original_img));
+  ASSERT_EQ(MR_SUCCESS, minimgio::Load(stored_img, saved));
+
+  for (uint16_t orientation = 1; orientation <= 8; ++orientation) {
+    const std::vector<uint8_t> oriented = add_orientation(data, orientation);
+    minimgio::BinaryMemoryReadonlyStream stream(&oriented[0], oriented.size());
+    DECLARE_GUARDED_MINIMG(loaded_image);
+    ASSERT_EQ(MR_SUCCESS, minimgio::GetFileProps(loaded_image, stream));
+    ASSERT_EQ(NO_ERRORS, AllocMinImage(&loaded_image));
+    ASSERT_EQ(MR_SUCCESS, minimgio::Load(loaded_image, stream));
+    const bool transposed = orientation > 4;
+    ASSERT_EQ(transposed ? stored_img.height : stored_img.width,
+              loaded_image.width);
+    // where the EXIF specification puts the stored pixel (x, y)
+    const int w = stored_img.width, h = stored_img.height;
+    for (int y = 0; y < h; ++y)
+      for (int x = 0; x < w; ++x) {
+        int dx = x, dy = y;
+        switch (orientation) {
+        case 2: dx = w - 1 - x; break;
+        case 3: dx = w - 1 - x; dy = h - 1 - y; break;
+        case 4: dy = h - 1 - y; break;
+        case 5: dx = y; dy = x; break;
+        case 6: dx = h - 1 - y; dy = x; break;
+        case 7: dx = h - 1 - y; dy = w - 1 - x; break;
+        case 8: dx = y; dy = w - 1 - x; break;
+        }
+        ASSERT_EQ(0, memcmp(
+          stored_img.p_zero_line + y * stored_img.stride + x * 3,
+          loaded_image.p_zero_line + dy * loaded_image.stride + dx * 3, 3))
+          << "orientation " << orientation << " at " << x << ", " << y;
+      }
+  }
+}
+
+// The JPEG which shows `original_img` as `orientation` turns it.
+static void save_oriented_jpeg(
+    std::vector<uint8_t> &jpeg,
+    const MinImg         &original_img,
+    uint16_t              orientation) {
+  TestBinaryStream saved;
+  ASSERT_EQ(MR_SUCCESS, minimgio::Save(saved, original_img, IFF_JPEG));
+  std::vector<uint8_t> data(static_cast<size_t>(saved.lseek(0, SEEK_END)));
+  saved.lseek(0, SEEK_SET);
+  ASSERT_EQ(data.size(), saved.read(&data[0], data.size()));
+  jpeg = add_orientation(data, orientation);
+}
+
+static void load_jpeg(MinImg &img, const std::vector<uint8_t> &jpeg) {
+  minimgio::BinaryMemoryReadonlyStream stream(&jpeg[0], jpeg.size());
+  ASSERT_EQ(MR_SUCCESS, minimgio::GetFileProps(img, stream));
+  ASSERT_EQ(NO_ERRORS, AllocMinImage(&img));
+  ASSERT_EQ(MR_SUCCESS, minimgio::Load(img, stream));
+}
+
+static void transform_jpeg(
+    std::vector<uint8_t>       &result,
+    const std::vector<uint8_t> &jpeg,
+    const TransformOptions     &options) {
+  minimgio::BinaryMemoryReadonlyStream src_stream(&jpeg[0], jpeg.size());
+  minimgio::BinaryMemoryStream dst_stream;
+  ASSERT_EQ(MR_SUCCESS,
+            minimgio::TransformJpeg(dst_stream, src_stream, &options));
+  result.assign(dst_stream.data(), dst_stream.data() + dst_stream.size());
+}
+
+// The transformed file has to show what the source shows with the EXIF
+// orientation of the transformation, which the decoder applies itself.
+TEST(TestMinimgio, jpeg_lossless_transform) {
+  static const uint16_t orientations[] = {1, 2, 4, 5, 7, 6, 3, 8};
+  for (int width : {160, 150}) {
+    DECLARE_GUARDED_MINIMG(original_img);
+    create_test_image<uint8_t>(original_img, 3, width, 96);
+    for (int transform = ITR_NONE; transform <= ITR_ROTATE_270; ++transform) {
+      std::vector<uint8_t> jpeg, oriented, transformed;
+      save_oriented_jpeg(jpeg, original_img, 1);
+      save_oriented_jpeg(oriented, original_img, orientations[transform]);
+      TransformOptions options = {};
+      options.transform = static_cast<ImgTransform>(transform);
+      transform_jpeg(transformed, jpeg, options);
+      DECLARE_GUARDED_MINIMG(expected_img);
+      load_jpeg(expected_img, oriented);
+      DECLARE_GUARDED_MINIMG(loaded_image);
+      load_jpeg(loaded_image, transformed);
+
+      // the partial iMCU column is dropped, where it would become the first
+      int x = 0, y = 0;
+      int w = expected_img.width, h = expected_img.height;
+      const int partial = width % 16;
+      switch (transform) {
+      case ITR_FLIP_HORIZONTAL: case ITR_ROTATE_180:
+        x = partial; w -= partial; break;
+      case ITR_TRANSVERSE: case ITR_ROTATE_270:
+        y = partial; h -= partial; break;
+      }
+      MinImg expected_part = {};
+      ASSERT_EQ(NO_ERRORS, GetMinImageRegion(&expected_part, &expected_img,
+                                             x, y, w, h, RO_REUSE_CONTAINER));
+      ASSERT_EQ(NO_ERRORS, CompareMinImagePrototypes(&expected_part,
+                                                     &loaded_image));
+      uint8_t the_diff = 0;
+      quantile_diff(&the_diff, loaded_image, expected_part);
+      ASSERT_GE(2, the_diff) << "transform " << transform << ", width " << width;
+    }
+  }
+}
+
+TEST(TestMinimgio, jpeg_lossless_transform_exif) {
+  DECLARE_GUARDED_MINIMG(original_img);
+  create_test_image<uint8_t>(original_img, 3, 160, 96);
+  std::vector<uint8_t> oriented, transformed, transformed_again;
+  save_oriented_jpeg(oriented, original_img, 6);
+  const TransformOptions options = {};
+  transform_jpeg(transformed, oriented, options);
+  // the orientation is applied and reset, so it is not applied twice
+  transform_jpeg(transformed_again, transformed, options);
+  DECLARE_GUARDED_MINIMG(expected_img);
+  load_jpeg(expected_img, oriented);
+  for (const std::vector<uint8_t> *p_jpeg : {&transformed, &transformed_again}) {
+    DECLARE_GUARDED_MINIMG(loaded_image);
+    load_jpeg(loaded_image, *p_jpeg);
+    ASSERT_EQ(NO_ERRORS, CompareMinImagePrototypes(&expected_img, &loaded_image));
+    uint8_t the_diff = 0;
+    quantile_diff(&the_diff, loaded_image, expected_img);
+    ASSERT_GE(2, the_diff);
+  }
+  ASSERT_EQ(transformed, transformed_again);
+}
+
+TEST(TestMinimgio, jpeg_lossless_crop) {
+  DECLARE_GUARDED_MINIMG(original_img);
+  create_test_image<uint8_t>(original_img, 3, 160, 96);
+  std::vector<uint8_t> jpeg, rotated, cropped;
+  save_oriented_jpeg(jpeg, original_img, 1);
+  TransformOptions options = {};
+  options.transform = ITR_ROTATE_90;
+  transform_jpeg(rotated, jpeg, options);
+  options.crop_x = 32;
+  options.crop_y = 48;
+  options.crop_width = 50;
+  options.crop_height = 70;
+  transform_jpeg(cropped, jpeg, options);
+
+  DECLARE_GUARDED_MINIMG(rotated_img);
+  load_jpeg(rotated_img, rotated);
+  DECLARE_GUARDED_MINIMG(cropped_img);
+  load_jpeg(cropped_img, cropped);
+  MinImg expected_img = {};
+  ASSERT_EQ(NO_ERRORS, GetMinImageRegion(&expected_img, &rotated_img,
+                                         32, 48, 50, 70, RO_REUSE_CONTAINER));
+  ASSERT_EQ(NO_ERRORS, CompareMinImagePrototypes(&expected_img, &cropped_img));
+  uint8_t the_diff = 0;
+  quantile_diff(&the_diff, cropped_img, expected_img);
+  ASSERT_GE(2, the_diff);
+
+  minimgio::BinaryMemoryReadonlyStream src_stream(&jpeg[0], jpeg.size());
+  minimgio::BinaryMemoryStream dst_stream;
+  options.crop_x = 8;  // off the 16-pixel iMCU grid
+  ASSERT_EQ(MR_CONTRACT_VIOLATION,
+            minimgio::TransformJpeg(dst_stream, src_stream, &options));
+  options.crop_x = 64;  // out of the image
+  ASSERT_EQ(MR_CONTRACT_VIOLATION,
+            minimgio::TransformJpeg(dst_stream, src_stream, &options));
+}
+
+struct FailingWriteStream : public TestBinaryStream {
+  std::size_t write(const void*, std::size_t) override {
+    return 0;
+  }
+};
+
+TEST(TestMinimgio, jpeg_lossless_transform_errors) {
+  const char not_jpeg[] = "not a jpeg file";
+  minimgio::BinaryMemoryReadonlyStream bad_stream(
+    reinterpret_cast<const uint8_t*>(not_jpeg), sizeof(not_jpeg));
+  TestBinaryStream out_stream;
+  const TransformOptions options = {};
+  ASSERT_EQ(MR_ENV_ERROR,
+            minimgio::TransformJpeg(out_stream, bad_stream, &options));
+  ASSERT_STRNE("", bad_stream.get_error());
+  ASSERT_STREQ("", out_stream.get_error());
+
+  DECLARE_GUARDED_MINIMG(original_img);
+  create_test_image<uint8_t>(original_img, 3, 160, 96);
+  std::vector<uint8_t> jpeg;
+  save_oriented_jpeg(jpeg, original_img, 1);
+  minimgio::BinaryMemoryReadonlyStream src_stream(&jpeg[0], jpeg.size());
+  FailingWriteStream failing_stream;
+  ASSERT_EQ(MR_ENV_ERROR,
+            minimgio::TransformJpeg(failing_stream, src_stream, &options));
+  ASSERT_STREQ("", src_stream.get_error());
+  ASSERT_STRNE("", failing_stream.get_error());
+}
+
+TEST(TestMinimgio, jpeg_lossless_transform_c_streams) {
+  DECLARE_GUARDED_MINIMG(original_img);
+  create_test_image<uint8_t>(original_img, 3, 160, 96);
+  std::vector<uint8_t> jpeg;
+  save_oriented_jpeg(jpeg, original_img, 1);
+
+  MIStreamHandle in_stream = NULL;
+  ASSERT_EQ(MR_SUCCESS,
+            MinImgIoCreateMemoryStream(&in_stream, &jpeg[0], jpeg.size()));
+  MIStreamHandle out_stream = NULL;
+  ASSERT_EQ(MR_SUCCESS, MinImgIoCreateGrowableMemoryStream(&out_stream, 0));
+  TransformOptions options = {};
+  options.transform = ITR_ROTATE_270;
+  ASSERT_EQ(MR_SUCCESS, MinImgIoTransformJpeg(out_stream, in_stream, &options));
+  ASSERT_EQ(MR_CONTRACT_VIOLATION,
+            MinImgIoTransformJpeg(NULL, in_stream, &options));
+  const uint8_t *p_data = NULL;
+  size_t data_size = 0;
+  ASSERT_EQ(MR_SUCCESS,
+            MinImgIoGetMemoryStreamData(&p_data, &data_size, out_stream));
+  DECLARE_GUARDED_MINIMG(loaded_image);
+  load_jpeg(loaded_image, std::vector<uint8_t>(p_data, p_data + data_size));
+  ASSERT_EQ(96, loaded_image.width);
+  ASSERT_EQ(160, loaded_image.height);
+  ASSERT_EQ(MR_SUCCESS, MinImgIoFreeStream(&in_stream));
+  ASSERT_EQ(MR_SUCCESS, MinImgIoFreeStream(&out_stream));
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   if (argc == 2)
@@ -44,6 +44,18 @@ static void test_png(MinImg const& original_img)
     ASSERT_EQ(MR_SUCCESS, minimgio::Load(loaded_image, stream));
     ASSERT_EQ(NO_ERRORS, CompareMinImages(&loaded_image, &original_img));
   }
+  {  // one session serves the props query and the loads after it
+    minimgio::DecoderSession session(stream);
+    DECLARE_GUARDED_MINIMG(loaded_image);
+    ASSERT_EQ(MR_SUCCESS, session.get_file_props(loaded_image));
+    ASSERT_EQ(NO_ERRORS, CompareMinImagePrototypes(&loaded_image, &original_img));
+    ASSERT_EQ(NO_ERRORS, AllocMinImage(&loaded_image));
+    for (int i = 0; i < 2; ++i) {
+      ASSERT_EQ(NO_ERRORS, ZeroFillMinImage(&loaded_image));
+      ASSERT_EQ(MR_SUCCESS, session.load(loaded_image));
+      ASSERT_EQ(NO_ERRORS, CompareMinImages(&loaded_image, &original_img));
+    }
+  }
   if (original_img.channels == 2 || original_img.channels == 4)
   {  // check that user can strip alpha channel
     DECLARE_GUARDED_MINIMG(loaded_image);
@@ -158,6 +170,39 @@ TEST(TestMinimgio, png_memory) {
   ASSERT_EQ(NO_ERRORS, CompareMinImages(&in_memory_img, &original_img));
 }
 
+TEST(TestMinimgio, png_c_memory_streams) {
+  DECLARE_GUARDED_MINIMG(original_img);
+  create_test_image<uint8_t>(original_img, 3);
+
+  MIStreamHandle out_stream = NULL;
+  ASSERT_EQ(MR_SUCCESS, MinImgIoCreateGrowableMemoryStream(&out_stream, 0));
+  ASSERT_EQ(MR_SUCCESS,
+            MinImgIoSave(out_stream, &original_img, IFF_PNG, NULL, 0));
+  const uint8_t *p_data = NULL;
+  size_t data_size = 0;
+  ASSERT_EQ(MR_SUCCESS,
+            MinImgIoGetMemoryStreamData(&p_data, &data_size, out_stream));
+  ASSERT_NE(nullptr, p_data);
+  ASSERT_LT(8U, data_size);
+
+  MIStreamHandle in_stream = NULL;
+  ASSERT_EQ(MR_SUCCESS, MinImgIoCreateMemoryStream(&in_stream, p_data, data_size));
+  // only growable streams own their data
+  const uint8_t *p_in_data = NULL;
+  size_t in_data_size = 0;
+  ASSERT_EQ(MR_CONTRACT_VIOLATION,
+            MinImgIoGetMemoryStreamData(&p_in_data, &in_data_size, in_stream));
+  DECLARE_GUARDED_MINIMG(loaded_image);
+  ASSERT_EQ(MR_SUCCESS, MinImgIoGetFileProps(&loaded_image, NULL, in_stream, 0));
+  ASSERT_EQ(NO_ERRORS, CompareMinImagePrototypes(&loaded_image, &original_img));
+  ASSERT_EQ(NO_ERRORS, AllocMinImage(&loaded_image));
+  ASSERT_EQ(MR_SUCCESS, MinImgIoLoad(&loaded_image, in_stream, 0));
+  ASSERT_EQ(NO_ERRORS, CompareMinImages(&loaded_image, &original_img));
+  ASSERT_EQ(MR_SUCCESS, MinImgIoFreeStream(&in_stream));
+  ASSERT_EQ(MR_SUCCESS, MinImgIoFreeStream(&out_stream));
+  ASSERT_EQ(NULL, out_stream);
+}
+
 TEST(TestMinimgio, png_props) {
   minimgio_test_props(IFF_PNG);
 }
@@ -249,6 +249,62 @@ TEST(TestMinimgio, tiff_memory_scheme) {
   ASSERT_EQ(NO_ERRORS, CompareMinImages(&original_img, &loaded_img));
 }
 
+TEST(TestMinimgio, tiff_peek_load) {
+  DECLARE_GUARDED_MINIMG(original_img);
+  create_test_image<uint8_t>(original_img, 3, 300, 200);
+  std::vector<uint8_t> memory;
+  VectorBinaryStream stream(memory);
+  ASSERT_EQ(MR_SUCCESS, minimgio::Save(stream, original_img, IFF_TIFF));
+
+  // the mapped file is decoded in place: only the header goes through `read`
+  CountingMemoryStream mapped_stream(memory);
+  DECLARE_GUARDED_MINIMG(loaded_img);
+  ASSERT_EQ(MR_SUCCESS, minimgio::GetFileProps(loaded_img, mapped_stream));
+  ASSERT_EQ(NO_ERRORS, AllocMinImage(&loaded_img));
+  mapped_stream.read_bytes = 0;
+  mapped_stream.peeks = 0;
+  ASSERT_EQ(MR_SUCCESS, minimgio::Load(loaded_img, mapped_stream));
+  ASSERT_EQ(NO_ERRORS, CompareMinImages(&original_img, &loaded_img));
+  ASSERT_LT(0, mapped_stream.peeks);
+  ASSERT_GT(std::size_t(64), mapped_stream.read_bytes);
+  ASSERT_STREQ("", mapped_stream.get_error());
+}
+
+TEST(TestMinimgio, tiff_session_pages) {
+  const int num_pages = 3;
+  DECLARE_GUARDED_MINIMG(page_0);
+  DECLARE_GUARDED_MINIMG(page_1);
+  DECLARE_GUARDED_MINIMG(page_2);
+  MinImg *pages[num_pages] = {&page_0, &page_1, &page_2};
+  TestBinaryStream stream;
+  for (int page = 0; page < num_pages; ++page) {
+    create_test_image<uint8_t>(*pages[page], 1 + page, 60 + 10 * page, 40);
+    ASSERT_EQ(MR_SUCCESS, minimgio::Save(
+      stream, *pages[page], IFF_TIFF, nullptr, page));
+  }
+
+  // one session serves every page, in any order and more than once
+  minimgio::DecoderSession session(stream);
+  int loaded_pages = 0;
+  ASSERT_EQ(MR_SUCCESS, session.get_num_pages(loaded_pages));
+  ASSERT_EQ(num_pages, loaded_pages);
+  const int order[] = {2, 0, 1, 2};
+  for (int i = 0; i < 4; ++i) {
+    const int page = order[i];
+    DECLARE_GUARDED_MINIMG(loaded_image);
+    ExtImgProps props = {};
+    ASSERT_EQ(MR_SUCCESS, session.get_file_props(loaded_image, &props, page));
+    ASSERT_EQ(IFF_TIFF, props.iff);
+    ASSERT_EQ(NO_ERRORS, CompareMinImagePrototypes(&loaded_image, pages[page]));
+    ASSERT_EQ(NO_ERRORS, AllocMinImage(&loaded_image));
+    ASSERT_EQ(MR_SUCCESS, session.load(loaded_image, page));
+    ASSERT_EQ(NO_ERRORS, CompareMinImages(&loaded_image, pages[page]));
+  }
+  ASSERT_STREQ("", stream.get_error());
+  for (int page = 0; page < num_pages; ++page)
+    FreeMinImage(pages[page]);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   if (argc == 2)
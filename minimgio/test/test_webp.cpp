@@ -50,6 +50,60 @@ TEST(TestMinimgio, webp_uint8_3ch) {
   ASSERT_STREQ("", stream.get_error());
 }
 
+TEST(TestMinimgio, webp_peek_load) {
+  DECLARE_GUARDED_MINIMG(test_image);
+  create_test_image<uint8_t>(test_image, 4, 100, 100);
+
+  std::vector<uint8_t> memory;
+  VectorBinaryStream stream(memory);
+  const ExtImgProps props = {
+    IFF_WEBP, IFC_NONE, 0.f, 0.f, 100
+  };
+  ASSERT_EQ(MR_SUCCESS, minimgio::Save(stream, test_image, IFF_WEBP, &props));
+
+  // the file is decoded from the stream memory: only the format tag is read
+  CountingMemoryStream mem_stream(memory);
+  DECLARE_GUARDED_MINIMG(loaded_image);
+  ASSERT_EQ(MR_SUCCESS, minimgio::GetFileProps(loaded_image, mem_stream));
+  ASSERT_EQ(NO_ERRORS, CompareMinImagePrototypes(&loaded_image, &test_image));
+  ASSERT_EQ(NO_ERRORS, AllocMinImage(&loaded_image));
+  mem_stream.read_bytes = 0;
+  mem_stream.peeks = 0;
+  ASSERT_EQ(MR_SUCCESS, minimgio::Load(loaded_image, mem_stream));
+  ASSERT_EQ(NO_ERRORS, CompareMinImages(&loaded_image, &test_image));
+  ASSERT_LT(0, mem_stream.peeks);
+  ASSERT_GT(std::size_t(64), mem_stream.read_bytes);
+  ASSERT_STREQ("", mem_stream.get_error());
+}
+
+TEST(TestMinimgio, webp_session) {
+  DECLARE_GUARDED_MINIMG(test_image);
+  create_test_image<uint8_t>(test_image, 3, 100, 100);
+  TestBinaryStream stream;
+  const ExtImgProps save_props = {
+    IFF_WEBP, IFC_NONE, 0.f, 0.f, 100
+  };
+  ASSERT_EQ(MR_SUCCESS, minimgio::Save(stream, test_image, IFF_WEBP, &save_props));
+
+  // one session serves the props query and the loads after it
+  minimgio::DecoderSession session(stream);
+  DECLARE_GUARDED_MINIMG(loaded_image);
+  ExtImgProps props = {};
+  ASSERT_EQ(MR_SUCCESS, session.get_file_props(loaded_image, &props));
+  ASSERT_EQ(IFF_WEBP, props.iff);
+  ASSERT_EQ(NO_ERRORS, CompareMinImagePrototypes(&loaded_image, &test_image));
+  ASSERT_EQ(NO_ERRORS, AllocMinImage(&loaded_image));
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(NO_ERRORS, ZeroFillMinImage(&loaded_image));
+    ASSERT_EQ(MR_SUCCESS, session.load(loaded_image));
+    ASSERT_EQ(NO_ERRORS, CompareMinImages(&loaded_image, &test_image));
+  }
+  int num_pages = 0;
+  ASSERT_EQ(MR_SUCCESS, session.get_num_pages(num_pages));
+  ASSERT_EQ(1, num_pages);
+  ASSERT_STREQ("", stream.get_error());
+}
+
 TEST(TestMinimgio, webp_invalid_channels) {
   DECLARE_GUARDED_MINIMG(test_image);
   TestBinaryStream stream;
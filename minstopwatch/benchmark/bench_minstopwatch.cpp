@@ -0,0 +1,80 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <benchmark/benchmark.h>
+#include <minstopwatch/minstopwatch.h>
+#include <minstopwatch/stopwatch.hpp>
+
+DECLARE_MINSTOPWATCH(swBench, "Bench");
+
+
+static void BM_StopwatchEnabled(benchmark::State &state) {
+  MinStopwatchEnable(1);
+  for (auto _ : state) {
+    DECLARE_MINSTOPWATCH_CTL(swBench);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_StopwatchEnabled);
+
+
+static void BM_StopwatchDisabled(benchmark::State &state) {
+  MinStopwatchEnable(0);
+  for (auto _ : state) {
+    DECLARE_MINSTOPWATCH_CTL(swBench);
+    benchmark::ClobberMemory();
+  }
+  MinStopwatchEnable(1);
+}
+BENCHMARK(BM_StopwatchDisabled);
+
+
+static void BM_StopwatchTracing(benchmark::State &state) {
+  MinStopwatchEnable(0);
+  MinStopwatchStartTrace(1 << 16);
+  for (auto _ : state) {
+    DECLARE_MINSTOPWATCH_CTL(swBench);
+    benchmark::ClobberMemory();
+  }
+  MinStopwatchStopTrace();
+  MinStopwatchEnable(1);
+}
+BENCHMARK(BM_StopwatchTracing);
+
+
+static void BM_Baseline(benchmark::State &state) {
+  for (auto _ : state)
+    benchmark::ClobberMemory();
+}
+BENCHMARK(BM_Baseline);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,195 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef MINSTOPWATCH_MINSTOPWATCH_H_INCLUDED
+#define MINSTOPWATCH_MINSTOPWATCH_H_INCLUDED
+
+#include <stdio.h>
+#include <stdint.h>
+#include <minbase/crossplat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined _MSC_VER && defined MINSTOPWATCH_EXPORTS
+# define MINSTOPWATCH_API __declspec(dllexport)
+#elif defined(__clang__) || defined(__GNUC__)
+# define MINSTOPWATCH_API __attribute__ ((visibility ("default")))
+#else
+# define MINSTOPWATCH_API
+#endif
+
+
+/**
+ * @defgroup MinStopwatch_API MinStopwatch Library API
+ * @brief    This section describes the C interface used to inspect the
+ *           timings collected by the stopwatches declared with
+ *           @c DECLARE_MINSTOPWATCH. Every timed call is accumulated in
+ *           thread-local counters, which are merged only when the statistics
+ *           are requested.
+ */
+
+
+/**
+ * @brief   Number of buckets in the latency histogram.
+ * @details Bucket @c i counts the calls whose duration @c d in ticks
+ *          satisfies @f$ 2^i \le d < 2^{i+1} @f$. Bucket @c 0 also counts
+ *          zero-tick calls, the last bucket is open-ended.
+ * @ingroup MinStopwatch_API
+ */
+#define MINSTOPWATCH_HISTOGRAM_BUCKETS 40
+
+
+/**
+ * @brief   Accumulated statistics of a single named stopwatch.
+ * @ingroup MinStopwatch_API
+ */
+typedef struct {
+  const char *name;        ///< The stopwatch name (owned by the library).
+  uint64_t    count;       ///< The number of timed calls.
+  double      total_ns;    ///< The total time of the calls in nanoseconds.
+  double      min_ns;      ///< The shortest call in nanoseconds.
+  double      max_ns;      ///< The longest call in nanoseconds.
+  double      ns_per_tick; ///< The duration of a histogram tick.
+  uint64_t    histogram[MINSTOPWATCH_HISTOGRAM_BUCKETS]; ///< Log2 buckets.
+} MinStopwatchStats;
+
+
+/**
+ * @brief   Turns the collection of statistics on or off at runtime.
+ * @param   enable The new state: nonzero to collect timings.
+ * @returns The previous state (@c 1 or @c 0).
+ * @details Stopwatches are enabled by default. While both statistics and
+ *          tracing are off, a timed scope costs a single relaxed load of a
+ *          global flag.
+ * @ingroup MinStopwatch_API
+ */
+MINSTOPWATCH_API int MinStopwatchEnable(
+    int enable);
+
+/**
+ * @brief   Tells whether the statistics are being collected.
+ * @returns @c 1 if the statistics are enabled and @c 0 otherwise.
+ * @ingroup MinStopwatch_API
+ */
+MINSTOPWATCH_API int MinStopwatchIsEnabled(void);
+
+/**
+ * @brief   Returns the number of registered stopwatches.
+ * @returns The number of distinct stopwatch names.
+ * @details Stopwatches with the same name, e.g. the ones declared in a header
+ *          included into several translation units, share one entry.
+ * @ingroup MinStopwatch_API
+ */
+MINSTOPWATCH_API int MinStopwatchGetCount(void);
+
+/**
+ * @brief   Collects the statistics of a stopwatch over all threads.
+ * @param   p_stats The pointer to the statistics to fill.
+ * @param   index   The stopwatch index in range [0, MinStopwatchGetCount()).
+ * @returns @c NO_ERRORS on success or an error code otherwise (see
+ *          @c #MinErr).
+ * @details The merge is done under a lock, so it can be called concurrently
+ *          with the timed code. Calls that finish during the merge may be
+ *          accounted partially.
+ * @ingroup MinStopwatch_API
+ */
+MINSTOPWATCH_API int MinStopwatchGetStats(
+    MinStopwatchStats *p_stats,
+    int                index);
+
+/**
+ * @brief   Prints the statistics of all the used stopwatches.
+ * @param   p_file The output stream, e.g. @c stderr.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see
+ *          @c #MinErr).
+ * @details Stopwatches are listed by decreasing total time, each followed by
+ *          the nonempty buckets of its latency histogram.
+ * @ingroup MinStopwatch_API
+ */
+MINSTOPWATCH_API int MinStopwatchDump(
+    FILE *p_file);
+
+/**
+ * @brief   Zeroes the statistics of all stopwatches in all threads.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see
+ *          @c #MinErr).
+ * @details Calls that are being timed concurrently may be lost.
+ * @ingroup MinStopwatch_API
+ */
+MINSTOPWATCH_API int MinStopwatchReset(void);
+
+/**
+ * @brief   Starts recording every timed call as a trace span.
+ * @param   events_per_thread The capacity of the per-thread ring buffer.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see
+ *          @c #MinErr).
+ * @details Each thread appends its spans to its own ring buffer without
+ *          locking, so only the last @p events_per_thread spans of a thread
+ *          are kept. A span holds the begin and end times and, for calls
+ *          annotated with @c DECLARE_MINSTOPWATCH_CTL_EX, the size, channel
+ *          count and type of the image. Spans recorded before the call are
+ *          discarded. The capacity applies to threads that have not traced
+ *          yet, existing buffers are reused.
+ * @ingroup MinStopwatch_API
+ */
+MINSTOPWATCH_API int MinStopwatchStartTrace(
+    int events_per_thread);
+
+/**
+ * @brief   Stops recording trace spans. Recorded spans are kept.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see
+ *          @c #MinErr).
+ * @ingroup MinStopwatch_API
+ */
+MINSTOPWATCH_API int MinStopwatchStopTrace(void);
+
+/**
+ * @brief   Writes the recorded spans in the Chrome trace event JSON format.
+ * @param   p_file The output stream.
+ * @returns @c NO_ERRORS on success or an error code otherwise (see
+ *          @c #MinErr).
+ * @details The output can be opened with Perfetto or chrome://tracing. Spans
+ *          are written as complete ("X") events with microsecond timestamps
+ *          counted from the library start. Tracing may go on during the call;
+ *          spans overwritten while being copied are dropped.
+ * @ingroup MinStopwatch_API
+ */
+MINSTOPWATCH_API int MinStopwatchWriteTrace(
+    FILE *p_file);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // #ifndef MINSTOPWATCH_MINSTOPWATCH_H_INCLUDED
@@ -0,0 +1,187 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef MINSTOPWATCH_STOPWATCH_HPP_INCLUDED
+#define MINSTOPWATCH_STOPWATCH_HPP_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+
+#include <minbase/crossplat.h>
+#include <minbase/minimg.h>
+
+#include "minstopwatch.h"
+
+#if !defined(MINSTOPWATCH_NO_RDTSC) && \
+    (defined(__x86_64__) || defined(__i386__) || \
+     defined(_M_X64) || defined(_M_IX86))
+# define MINSTOPWATCH_USE_RDTSC
+# ifdef _MSC_VER
+#   include <intrin.h>
+# else
+#   include <x86intrin.h>
+# endif
+#else
+# include <chrono>
+#endif
+
+
+namespace minstopwatch {
+
+/**
+ * @brief   Reads the timestamp counter.
+ * @details On x86 this is @c rdtsc (an invariant TSC is assumed), elsewhere
+ *          @c std::chrono::steady_clock in nanoseconds. Ticks are converted
+ *          to nanoseconds only when the statistics are collected.
+ */
+MUSTINLINE uint64_t ReadTicks() {
+#ifdef MINSTOPWATCH_USE_RDTSC
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+
+namespace internal {
+
+enum {
+  kCollectStats = 1,
+  kCollectTrace = 2
+};
+
+// Image shape attached to trace spans, width < 0 means no image.
+struct SpanArgs {
+  int32_t width;
+  int32_t height;
+  int32_t channels;
+  int32_t scalar_type;
+};
+
+MINSTOPWATCH_API extern std::atomic<int> g_flags;
+
+MINSTOPWATCH_API int RegisterStopwatch(const char *name);
+
+MINSTOPWATCH_API void RecordSpan(
+    int             id,
+    int             flags,
+    uint64_t        start,
+    uint64_t        end,
+    const SpanArgs &args);
+
+} // namespace internal
+
+
+/**
+ * @brief   A named timer. Objects with the same name share the statistics.
+ */
+class Stopwatch {
+public:
+  explicit Stopwatch(const char *name)
+    : id_(internal::RegisterStopwatch(name)) {}
+
+  int id() const {
+    return id_;
+  }
+
+private:
+  Stopwatch(const Stopwatch &);
+  Stopwatch &operator=(const Stopwatch &);
+
+  int id_;
+};
+
+
+/**
+ * @brief   Times the enclosing scope and accounts it to the stopwatch.
+ * @details When tracing is on, the scope is also recorded as a span; the
+ *          shape of @p p_image (if given) is captured on entry and attached
+ *          to the span.
+ */
+class StopwatchControl {
+public:
+  explicit StopwatchControl(const Stopwatch &stopwatch)
+    : flags_(internal::g_flags.load(std::memory_order_relaxed)) {
+    if (flags_)
+      Start(stopwatch, NULL);
+  }
+
+  StopwatchControl(const Stopwatch &stopwatch, const MinImg *p_image)
+    : flags_(internal::g_flags.load(std::memory_order_relaxed)) {
+    if (flags_)
+      Start(stopwatch, p_image);
+  }
+
+  ~StopwatchControl() {
+    if (flags_)
+      internal::RecordSpan(id_, flags_, start_, ReadTicks(), args_);
+  }
+
+private:
+  StopwatchControl(const StopwatchControl &);
+  StopwatchControl &operator=(const StopwatchControl &);
+
+  void Start(const Stopwatch &stopwatch, const MinImg *p_image) {
+    id_ = stopwatch.id();
+    if (id_ < 0) {
+      flags_ = 0;
+      return;
+    }
+    args_.width = p_image ? p_image->width : -1;
+    args_.height = p_image ? p_image->height : 0;
+    args_.channels = p_image ? p_image->channels : 0;
+    args_.scalar_type = p_image ? p_image->scalar_type : 0;
+    start_ = ReadTicks();
+  }
+
+  int                flags_;
+  int                id_;
+  uint64_t           start_;
+  internal::SpanArgs args_;
+};
+
+} // namespace minstopwatch
+
+
+#define DECLARE_MINSTOPWATCH(sw, name) \
+  static ::minstopwatch::Stopwatch sw(name)
+
+#define DECLARE_MINSTOPWATCH_CTL(sw) \
+  ::minstopwatch::StopwatchControl sw##_control(sw)
+
+#define DECLARE_MINSTOPWATCH_CTL_EX(sw, p_image) \
+  ::minstopwatch::StopwatchControl sw##_control(sw, p_image)
+
+
+#endif // #ifndef MINSTOPWATCH_STOPWATCH_HPP_INCLUDED
@@ -0,0 +1,665 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <minbase/minresult.h>
+#include <minbase/mintyp.h>
+#include <minstopwatch/minstopwatch.h>
+#include <minstopwatch/stopwatch.hpp>
+
+namespace minstopwatch {
+
+namespace internal {
+
+std::atomic<int> g_flags(kCollectStats);
+
+} // namespace internal
+
+namespace {
+
+const int kSlotsPerChunk = 64;
+const int kMaxChunks = 64;
+const int kMaxStopwatches = kSlotsPerChunk * kMaxChunks;
+const int kBuckets = MINSTOPWATCH_HISTOGRAM_BUCKETS;
+
+// Counters of one stopwatch in one thread. Only the owning thread updates
+// them, so plain relaxed loads and stores suffice; atomics just make the
+// concurrent reads of MinStopwatchGetStats() well-defined.
+struct Slot {
+  std::atomic<uint64_t> count;
+  std::atomic<uint64_t> total;
+  std::atomic<uint64_t> min;
+  std::atomic<uint64_t> max;
+  std::atomic<uint64_t> histogram[kBuckets];
+
+  Slot() {
+    Clear();
+  }
+
+  void Clear() {
+    count.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    min.store(UINT64_MAX, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < kBuckets; ++i)
+      histogram[i].store(0, std::memory_order_relaxed);
+  }
+};
+
+struct Chunk {
+  Slot slots[kSlotsPerChunk];
+};
+
+inline void Add(std::atomic<uint64_t> &counter, uint64_t value) {
+  counter.store(counter.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+}
+
+inline int GetBucket(uint64_t ticks) {
+#if defined(__GNUC__) || defined(__clang__)
+  int bucket = ticks ? 63 - __builtin_clzll(ticks) : 0;
+#else
+  int bucket = 0;
+  while (ticks >>= 1)
+    ++bucket;
+#endif
+  return std::min(bucket, kBuckets - 1);
+}
+
+// One trace span. Fields are atomic words so that a reader racing with the
+// owner sees a torn event instead of undefined behavior; TraceRing drops
+// the torn ones.
+struct TraceEvent {
+  std::atomic<uint64_t> start;
+  std::atomic<uint64_t> end;
+  std::atomic<uint64_t> id_and_type;
+  std::atomic<uint64_t> size;
+  std::atomic<uint64_t> channels;
+};
+
+struct PlainEvent {
+  uint64_t           start;
+  uint64_t           end;
+  int                id;
+  int                tid;
+  internal::SpanArgs args;
+};
+
+// Single-producer ring of spans. The owner never blocks: it announces the
+// slot it is going to overwrite in claim_, writes it and publishes it in
+// head_. A reader copies the slots and then checks claim_ to find out which
+// of the copied ones could have been overwritten meanwhile.
+class TraceRing {
+public:
+  explicit TraceRing(uint64_t capacity)
+    : events_(new TraceEvent[capacity]), capacity_(capacity),
+      claim_(0), head_(0) {}
+
+  ~TraceRing() {
+    delete[] events_;
+  }
+
+  void Push(int id, uint64_t start, uint64_t end,
+            const internal::SpanArgs &args) {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    claim_.store(head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    TraceEvent &event = events_[head % capacity_];
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    event.id_and_type.store(
+        static_cast<uint64_t>(static_cast<uint32_t>(id)) << 32 |
+        static_cast<uint32_t>(args.scalar_type), std::memory_order_relaxed);
+    event.size.store(
+        static_cast<uint64_t>(static_cast<uint32_t>(args.width)) << 32 |
+        static_cast<uint32_t>(args.height), std::memory_order_relaxed);
+    event.channels.store(static_cast<uint32_t>(args.channels),
+                         std::memory_order_relaxed);
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  // Appends the spans that started at or after `since`.
+  void Snapshot(int tid, uint64_t since,
+                std::vector<PlainEvent> &events) const {
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    const uint64_t first = head > capacity_ ? head - capacity_ : 0;
+    std::vector<PlainEvent> copied;
+    copied.reserve(static_cast<size_t>(head - first));
+    for (uint64_t i = first; i < head; ++i) {
+      const TraceEvent &event = events_[i % capacity_];
+      PlainEvent plain;
+      plain.start = event.start.load(std::memory_order_relaxed);
+      plain.end = event.end.load(std::memory_order_relaxed);
+      const uint64_t id_and_type =
+          event.id_and_type.load(std::memory_order_relaxed);
+      const uint64_t size = event.size.load(std::memory_order_relaxed);
+      plain.id = static_cast<int>(id_and_type >> 32);
+      plain.tid = tid;
+      plain.args.scalar_type = static_cast<int32_t>(id_and_type);
+      plain.args.width = static_cast<int32_t>(size >> 32);
+      plain.args.height = static_cast<int32_t>(size);
+      plain.args.channels = static_cast<int32_t>(
+          event.channels.load(std::memory_order_relaxed));
+      copied.push_back(plain);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t claim = claim_.load(std::memory_order_relaxed);
+    const uint64_t valid = claim > capacity_ ? claim - capacity_ : 0;
+    for (uint64_t i = std::max(first, valid); i < head; ++i) {
+      const PlainEvent &plain = copied[static_cast<size_t>(i - first)];
+      if (plain.start >= since)
+        events.push_back(plain);
+    }
+  }
+
+private:
+  TraceRing(const TraceRing &);
+  TraceRing &operator=(const TraceRing &);
+
+  TraceEvent            *events_;
+  const uint64_t         capacity_;
+  std::atomic<uint64_t>  claim_;
+  std::atomic<uint64_t>  head_;
+};
+
+std::atomic<int> g_trace_capacity(1 << 16);
+
+// Slots of all stopwatches for one thread. Chunks are allocated on the
+// first use of a stopwatch with an id in their range and published with
+// release semantics for the readers.
+class ThreadStats {
+public:
+  explicit ThreadStats(int tid) : ring_(NULL), tid_(tid) {
+    for (int i = 0; i < kMaxChunks; ++i)
+      chunks_[i].store(NULL, std::memory_order_relaxed);
+  }
+
+  ~ThreadStats() {
+    for (int i = 0; i < kMaxChunks; ++i)
+      delete chunks_[i].load(std::memory_order_relaxed);
+    delete ring_.load(std::memory_order_relaxed);
+  }
+
+  int tid() const {
+    return tid_;
+  }
+
+  const TraceRing *FindRing() const {
+    return ring_.load(std::memory_order_acquire);
+  }
+
+  TraceRing &GetRing() {
+    TraceRing *ring = ring_.load(std::memory_order_relaxed);
+    if (!ring) {
+      ring = new TraceRing(static_cast<uint64_t>(
+          g_trace_capacity.load(std::memory_order_relaxed)));
+      ring_.store(ring, std::memory_order_release);
+    }
+    return *ring;
+  }
+
+  const Slot *FindSlot(int id) const {
+    const Chunk *chunk =
+        chunks_[id / kSlotsPerChunk].load(std::memory_order_acquire);
+    return chunk ? &chunk->slots[id % kSlotsPerChunk] : NULL;
+  }
+
+  Slot &GetSlot(int id) {
+    std::atomic<Chunk *> &entry = chunks_[id / kSlotsPerChunk];
+    Chunk *chunk = entry.load(std::memory_order_relaxed);
+    if (!chunk) {
+      chunk = new Chunk;
+      entry.store(chunk, std::memory_order_release);
+    }
+    return chunk->slots[id % kSlotsPerChunk];
+  }
+
+  void Clear() {
+    for (int i = 0; i < kMaxChunks; ++i) {
+      Chunk *chunk = chunks_[i].load(std::memory_order_acquire);
+      if (chunk)
+        for (int j = 0; j < kSlotsPerChunk; ++j)
+          chunk->slots[j].Clear();
+    }
+  }
+
+private:
+  ThreadStats(const ThreadStats &);
+  ThreadStats &operator=(const ThreadStats &);
+
+  std::atomic<Chunk *>     chunks_[kMaxChunks];
+  std::atomic<TraceRing *> ring_;
+  const int                tid_;
+};
+
+struct Totals {
+  uint64_t count;
+  uint64_t total;
+  uint64_t min;
+  uint64_t max;
+  uint64_t histogram[kBuckets];
+
+  Totals() : count(0), total(0), min(UINT64_MAX), max(0) {
+    std::fill(histogram, histogram + kBuckets, 0);
+  }
+
+  void Merge(const Slot &slot) {
+    count += slot.count.load(std::memory_order_relaxed);
+    total += slot.total.load(std::memory_order_relaxed);
+    min = std::min(min, slot.min.load(std::memory_order_relaxed));
+    max = std::max(max, slot.max.load(std::memory_order_relaxed));
+    for (int i = 0; i < kBuckets; ++i)
+      histogram[i] += slot.histogram[i].load(std::memory_order_relaxed);
+  }
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::deque<std::string> names;  // deque keeps c_str() pointers stable
+  std::map<std::string, int> ids;
+  std::vector<ThreadStats *> live_threads;
+  ThreadStats retired_threads;
+  std::vector<PlainEvent> retired_events;
+  int next_tid;
+  uint64_t trace_start_ticks;
+  uint64_t start_ticks;
+  std::chrono::steady_clock::time_point start_time;
+
+  Registry()
+    : retired_threads(0),
+      next_tid(1),
+      trace_start_ticks(0),
+      start_ticks(ReadTicks()),
+      start_time(std::chrono::steady_clock::now()) {}
+};
+
+// The registry is never destroyed: stopwatches may still be hit from
+// thread_local and static destructors running after it would have been.
+Registry &GetRegistry() {
+  static Registry *registry = new Registry;
+  return *registry;
+}
+
+class ThreadStatsHolder {
+public:
+  ThreadStatsHolder() : stats_(NULL) {
+    Registry &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    stats_ = new ThreadStats(registry.next_tid++);
+    registry.live_threads.push_back(stats_);
+  }
+
+  // Moves the counters and spans of the exiting thread to the shared
+  // accumulators.
+  ~ThreadStatsHolder() {
+    Registry &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (const TraceRing *ring = stats_->FindRing())
+      ring->Snapshot(stats_->tid(), registry.trace_start_ticks,
+                     registry.retired_events);
+    for (int id = 0; id < static_cast<int>(registry.names.size()); ++id) {
+      const Slot *slot = stats_->FindSlot(id);
+      if (!slot || !slot->count.load(std::memory_order_relaxed))
+        continue;
+      Slot &retired = registry.retired_threads.GetSlot(id);
+      Add(retired.count, slot->count.load(std::memory_order_relaxed));
+      Add(retired.total, slot->total.load(std::memory_order_relaxed));
+      retired.min.store(std::min(retired.min.load(std::memory_order_relaxed),
+                                 slot->min.load(std::memory_order_relaxed)),
+                        std::memory_order_relaxed);
+      retired.max.store(std::max(retired.max.load(std::memory_order_relaxed),
+                                 slot->max.load(std::memory_order_relaxed)),
+                        std::memory_order_relaxed);
+      for (int i = 0; i < kBuckets; ++i)
+        Add(retired.histogram[i],
+            slot->histogram[i].load(std::memory_order_relaxed));
+    }
+    registry.live_threads.erase(std::find(registry.live_threads.begin(),
+                                          registry.live_threads.end(),
+                                          stats_));
+    delete stats_;
+  }
+
+  ThreadStats &stats() {
+    return *stats_;
+  }
+
+private:
+  ThreadStatsHolder(const ThreadStatsHolder &);
+  ThreadStatsHolder &operator=(const ThreadStatsHolder &);
+
+  ThreadStats *stats_;
+};
+
+ThreadStats &GetThreadStats() {
+  static thread_local ThreadStatsHolder holder;
+  return holder.stats();
+}
+
+Totals CollectTotals(Registry &registry, int id) {
+  Totals totals;
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  if (const Slot *slot = registry.retired_threads.FindSlot(id))
+    totals.Merge(*slot);
+  for (size_t i = 0; i < registry.live_threads.size(); ++i)
+    if (const Slot *slot = registry.live_threads[i]->FindSlot(id))
+      totals.Merge(*slot);
+  return totals;
+}
+
+// With rdtsc the tick length is measured against steady_clock over the
+// whole lifetime of the registry, which gives a precise ratio for free.
+double GetNsPerTick(Registry &registry) {
+#ifdef MINSTOPWATCH_USE_RDTSC
+  const std::chrono::nanoseconds min_period = std::chrono::milliseconds(10);
+  std::chrono::nanoseconds period;
+  uint64_t ticks = 0;
+  for (;;) {
+    ticks = ReadTicks();
+    period = std::chrono::steady_clock::now() - registry.start_time;
+    if (period >= min_period)
+      break;
+    std::this_thread::sleep_for(min_period - period);
+  }
+  if (ticks <= registry.start_ticks)
+    return 1.0;
+  return static_cast<double>(period.count()) /
+         static_cast<double>(ticks - registry.start_ticks);
+#else
+  (void)registry;
+  return 1.0;
+#endif
+}
+
+void FillStats(MinStopwatchStats *p_stats, Registry &registry, int id,
+               double ns_per_tick) {
+  const Totals totals = CollectTotals(registry, id);
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    p_stats->name = registry.names[id].c_str();
+  }
+  p_stats->count = totals.count;
+  p_stats->total_ns = static_cast<double>(totals.total) * ns_per_tick;
+  p_stats->min_ns =
+      totals.count ? static_cast<double>(totals.min) * ns_per_tick : 0.0;
+  p_stats->max_ns = static_cast<double>(totals.max) * ns_per_tick;
+  p_stats->ns_per_tick = ns_per_tick;
+  std::copy(totals.histogram, totals.histogram + kBuckets,
+            p_stats->histogram);
+}
+
+} // namespace
+
+namespace internal {
+
+int RegisterStopwatch(const char *name) {
+  Registry &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  const std::string key(name ? name : "");
+  std::map<std::string, int>::const_iterator it = registry.ids.find(key);
+  if (it != registry.ids.end())
+    return it->second;
+  if (static_cast<int>(registry.names.size()) >= kMaxStopwatches)
+    return -1;
+  const int id = static_cast<int>(registry.names.size());
+  registry.names.push_back(key);
+  registry.ids[key] = id;
+  return id;
+}
+
+void RecordSpan(
+    int             id,
+    int             flags,
+    uint64_t        start,
+    uint64_t        end,
+    const SpanArgs &args) {
+  ThreadStats &stats = GetThreadStats();
+  if (flags & kCollectStats) {
+    const uint64_t ticks = end - start;
+    Slot &slot = stats.GetSlot(id);
+    Add(slot.count, 1);
+    Add(slot.total, ticks);
+    if (ticks < slot.min.load(std::memory_order_relaxed))
+      slot.min.store(ticks, std::memory_order_relaxed);
+    if (ticks > slot.max.load(std::memory_order_relaxed))
+      slot.max.store(ticks, std::memory_order_relaxed);
+    Add(slot.histogram[GetBucket(ticks)], 1);
+  }
+  if (flags & kCollectTrace)
+    stats.GetRing().Push(id, start, end, args);
+}
+
+} // namespace internal
+
+} // namespace minstopwatch
+
+
+using namespace minstopwatch;
+
+
+MINSTOPWATCH_API int MinStopwatchEnable(
+    int enable) {
+  const int flags = enable ?
+      internal::g_flags.fetch_or(internal::kCollectStats) :
+      internal::g_flags.fetch_and(~internal::kCollectStats);
+  return flags & internal::kCollectStats ? 1 : 0;
+}
+
+
+MINSTOPWATCH_API int MinStopwatchIsEnabled(void) {
+  return internal::g_flags.load() & internal::kCollectStats ? 1 : 0;
+}
+
+
+MINSTOPWATCH_API int MinStopwatchGetCount(void) {
+  Registry &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  return static_cast<int>(registry.names.size());
+}
+
+
+MINSTOPWATCH_API int MinStopwatchGetStats(
+    MinStopwatchStats *p_stats,
+    int                index) {
+  if (!p_stats || index < 0 || index >= MinStopwatchGetCount())
+    return BAD_ARGS;
+
+  Registry &registry = GetRegistry();
+  FillStats(p_stats, registry, index, GetNsPerTick(registry));
+  return NO_ERRORS;
+}
+
+
+MINSTOPWATCH_API int MinStopwatchDump(
+    FILE *p_file) {
+  if (!p_file)
+    return BAD_ARGS;
+
+  Registry &registry = GetRegistry();
+  const double ns_per_tick = GetNsPerTick(registry);
+  const int count = MinStopwatchGetCount();
+  std::vector<MinStopwatchStats> stats;
+  for (int id = 0; id < count; ++id) {
+    MinStopwatchStats item;
+    FillStats(&item, registry, id, ns_per_tick);
+    if (item.count)
+      stats.push_back(item);
+  }
+  std::stable_sort(stats.begin(), stats.end(),
+                   [](const MinStopwatchStats &a, const MinStopwatchStats &b) {
+                     return a.total_ns > b.total_ns;
+                   });
+
+  fprintf(p_file, "%-40s %12s %12s %12s %12s %12s\n",
+          "stopwatch", "calls", "total,ms", "mean,us", "min,us", "max,us");
+  for (size_t i = 0; i < stats.size(); ++i) {
+    const MinStopwatchStats &item = stats[i];
+    fprintf(p_file, "%-40s %12llu %12.3f %12.3f %12.3f %12.3f\n",
+            item.name, static_cast<unsigned long long>(item.count),
+            item.total_ns * 1e-6,
+            item.total_ns * 1e-3 / static_cast<double>(item.count),
+            item.min_ns * 1e-3, item.max_ns * 1e-3);
+    for (int b = 0; b < kBuckets; ++b) {
+      if (!item.histogram[b])
+        continue;
+      const double lower = b ? static_cast<double>(1ULL << b) * ns_per_tick : 0;
+      if (b == kBuckets - 1)
+        fprintf(p_file, "    [%12.0f ns,          inf) %12llu\n", lower,
+                static_cast<unsigned long long>(item.histogram[b]));
+      else
+        fprintf(p_file, "    [%12.0f ns, %12.0f ns) %12llu\n", lower,
+                static_cast<double>(2ULL << b) * ns_per_tick,
+                static_cast<unsigned long long>(item.histogram[b]));
+    }
+  }
+  return ferror(p_file) ? FILE_ERROR : NO_ERRORS;
+}
+
+
+MINSTOPWATCH_API int MinStopwatchReset(void) {
+  Registry &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.retired_threads.Clear();
+  for (size_t i = 0; i < registry.live_threads.size(); ++i)
+    registry.live_threads[i]->Clear();
+  return NO_ERRORS;
+}
+
+
+MINSTOPWATCH_API int MinStopwatchStartTrace(
+    int events_per_thread) {
+  if (events_per_thread <= 0)
+    return BAD_ARGS;
+
+  Registry &registry = GetRegistry();
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.trace_start_ticks = ReadTicks();
+    registry.retired_events.clear();
+  }
+  g_trace_capacity.store(events_per_thread);
+  internal::g_flags.fetch_or(internal::kCollectTrace);
+  return NO_ERRORS;
+}
+
+
+MINSTOPWATCH_API int MinStopwatchStopTrace(void) {
+  internal::g_flags.fetch_and(~internal::kCollectTrace);
+  return NO_ERRORS;
+}
+
+
+static const char *GetTypeName(int scalar_type) {
+  static const char *const names[MINTYP_COUNT] = {
+    "TYP_UINT1", "TYP_UINT8", "TYP_UINT16", "TYP_UINT32", "TYP_UINT64",
+    "TYP_INT8", "TYP_INT16", "TYP_INT32", "TYP_INT64",
+    "TYP_REAL16", "TYP_REAL32", "TYP_REAL64"
+  };
+  return scalar_type >= 0 && scalar_type < MINTYP_COUNT ?
+         names[scalar_type] : "TYP_INVALID";
+}
+
+
+static void WriteJsonString(FILE *p_file, const char *str) {
+  fputc('"', p_file);
+  for (; *str; ++str) {
+    const unsigned char c = static_cast<unsigned char>(*str);
+    if (c == '"' || c == '\\')
+      fprintf(p_file, "\\%c", c);
+    else if (c < 0x20)
+      fprintf(p_file, "\\u%04x", c);
+    else
+      fputc(c, p_file);
+  }
+  fputc('"', p_file);
+}
+
+
+MINSTOPWATCH_API int MinStopwatchWriteTrace(
+    FILE *p_file) {
+  if (!p_file)
+    return BAD_ARGS;
+
+  Registry &registry = GetRegistry();
+  const double ns_per_tick = GetNsPerTick(registry);
+  std::vector<PlainEvent> events;
+  std::vector<const char *> names;
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    events = registry.retired_events;
+    for (size_t i = 0; i < registry.live_threads.size(); ++i) {
+      const ThreadStats &stats = *registry.live_threads[i];
+      if (const TraceRing *ring = stats.FindRing())
+        ring->Snapshot(stats.tid(), registry.trace_start_ticks, events);
+    }
+    for (size_t i = 0; i < registry.names.size(); ++i)
+      names.push_back(registry.names[i].c_str());
+  }
+  std::stable_sort(events.begin(), events.end(),
+                   [](const PlainEvent &a, const PlainEvent &b) {
+                     return a.tid != b.tid ? a.tid < b.tid :
+                                             a.start < b.start;
+                   });
+
+  const uint64_t origin = registry.start_ticks;
+  fprintf(p_file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  for (size_t i = 0; i < events.size(); ++i) {
+    const PlainEvent &event = events[i];
+    const double ts = static_cast<double>(event.start - origin) *
+                      ns_per_tick * 1e-3;
+    const double dur = static_cast<double>(event.end - event.start) *
+                       ns_per_tick * 1e-3;
+    fprintf(p_file, "%s\n{\"name\":", i ? "," : "");
+    WriteJsonString(p_file, event.id >= 0 &&
+                            event.id < static_cast<int>(names.size()) ?
+                            names[event.id] : "");
+    fprintf(p_file, ",\"cat\":\"minimg\",\"ph\":\"X\",\"pid\":1,"
+            "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", event.tid, ts, dur);
+    if (event.args.width >= 0)
+      fprintf(p_file, ",\"args\":{\"width\":%d,\"height\":%d,"
+              "\"channels\":%d,\"type\":\"%s\"}", event.args.width,
+              event.args.height, event.args.channels,
+              GetTypeName(event.args.scalar_type));
+    fputc('}', p_file);
+  }
+  fprintf(p_file, "\n]}\n");
+  return ferror(p_file) ? FILE_ERROR : NO_ERRORS;
+}
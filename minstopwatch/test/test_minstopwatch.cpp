@@ -0,0 +1,203 @@
+/*
+
+Copyright 2021 Smart Engines Service LLC
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+     may be used to endorse or promote products derived from this software
+     without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <minbase/minresult.h>
+#include <minstopwatch/minstopwatch.h>
+#include <minstopwatch/stopwatch.hpp>
+
+DECLARE_MINSTOPWATCH(swTestCounts, "TestCounts");
+DECLARE_MINSTOPWATCH(swTestThreads, "TestThreads");
+DECLARE_MINSTOPWATCH(swTestDisabled, "TestDisabled");
+DECLARE_MINSTOPWATCH(swTestTrace, "TestTrace");
+
+static void TimedCall(const minstopwatch::Stopwatch &sw) {
+  DECLARE_MINSTOPWATCH_CTL(sw);
+}
+
+static void TimedImageCall(const minstopwatch::Stopwatch &sw,
+                           const MinImg *p_image) {
+  DECLARE_MINSTOPWATCH_CTL_EX(sw, p_image);
+}
+
+static std::string ReadTrace() {
+  FILE *p_file = tmpfile();
+  if (!p_file)
+    return std::string();
+  std::string trace;
+  if (MinStopwatchWriteTrace(p_file) == NO_ERRORS) {
+    rewind(p_file);
+    char buffer[4096];
+    size_t size = 0;
+    while ((size = fread(buffer, 1, sizeof(buffer), p_file)) > 0)
+      trace.append(buffer, size);
+  }
+  fclose(p_file);
+  return trace;
+}
+
+static int CountOccurrences(const std::string &text, const char *pattern) {
+  int count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + 1))
+    ++count;
+  return count;
+}
+
+static int FindStopwatch(const char *name) {
+  for (int i = 0; i < MinStopwatchGetCount(); ++i) {
+    MinStopwatchStats stats;
+    if (MinStopwatchGetStats(&stats, i) == NO_ERRORS &&
+        !::strcmp(stats.name, name))
+      return i;
+  }
+  return -1;
+}
+
+static uint64_t HistogramSum(const MinStopwatchStats &stats) {
+  uint64_t sum = 0;
+  for (int i = 0; i < MINSTOPWATCH_HISTOGRAM_BUCKETS; ++i)
+    sum += stats.histogram[i];
+  return sum;
+}
+
+TEST(TestMinstopwatch, TestCounts) {
+  const int index = FindStopwatch("TestCounts");
+  ASSERT_GE(index, 0);
+  minstopwatch::Stopwatch twin("TestCounts");
+  EXPECT_EQ(swTestCounts.id(), twin.id());
+
+  ASSERT_EQ(NO_ERRORS, MinStopwatchReset());
+  for (int i = 0; i < 100; ++i)
+    TimedCall(i & 1 ? twin : swTestCounts);
+
+  MinStopwatchStats stats;
+  ASSERT_EQ(NO_ERRORS, MinStopwatchGetStats(&stats, index));
+  EXPECT_STREQ("TestCounts", stats.name);
+  EXPECT_EQ(100U, stats.count);
+  EXPECT_EQ(100U, HistogramSum(stats));
+  EXPECT_LE(stats.min_ns, stats.max_ns);
+  EXPECT_LE(stats.max_ns, stats.total_ns);
+  EXPECT_GT(stats.ns_per_tick, 0.0);
+
+  ASSERT_EQ(NO_ERRORS, MinStopwatchReset());
+  ASSERT_EQ(NO_ERRORS, MinStopwatchGetStats(&stats, index));
+  EXPECT_EQ(0U, stats.count);
+  EXPECT_EQ(0U, HistogramSum(stats));
+
+  EXPECT_EQ(BAD_ARGS, MinStopwatchGetStats(NULL, index));
+  EXPECT_EQ(BAD_ARGS, MinStopwatchGetStats(&stats, MinStopwatchGetCount()));
+  EXPECT_EQ(BAD_ARGS, MinStopwatchDump(NULL));
+}
+
+TEST(TestMinstopwatch, TestThreads) {
+  const int index = FindStopwatch("TestThreads");
+  ASSERT_GE(index, 0);
+  ASSERT_EQ(NO_ERRORS, MinStopwatchReset());
+
+  TimedCall(swTestThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.push_back(std::thread([] {
+      for (int i = 0; i < 1000; ++i)
+        TimedCall(swTestThreads);
+    }));
+  for (size_t t = 0; t < threads.size(); ++t)
+    threads[t].join();
+
+  // Counters of the exited threads must survive in the shared accumulator.
+  MinStopwatchStats stats;
+  ASSERT_EQ(NO_ERRORS, MinStopwatchGetStats(&stats, index));
+  EXPECT_EQ(4001U, stats.count);
+  EXPECT_EQ(4001U, HistogramSum(stats));
+}
+
+TEST(TestMinstopwatch, TestDisabled) {
+  const int index = FindStopwatch("TestDisabled");
+  ASSERT_GE(index, 0);
+  ASSERT_EQ(NO_ERRORS, MinStopwatchReset());
+
+  EXPECT_EQ(1, MinStopwatchEnable(0));
+  EXPECT_EQ(0, MinStopwatchIsEnabled());
+  TimedCall(swTestDisabled);
+  EXPECT_EQ(0, MinStopwatchEnable(1));
+  TimedCall(swTestDisabled);
+
+  MinStopwatchStats stats;
+  ASSERT_EQ(NO_ERRORS, MinStopwatchGetStats(&stats, index));
+  EXPECT_EQ(1U, stats.count);
+}
+
+TEST(TestMinstopwatch, TestTrace) {
+  MinImg image = {};
+  image.width = 3;
+  image.height = 2;
+  image.channels = 4;
+  image.scalar_type = TYP_UINT16;
+
+  EXPECT_EQ(BAD_ARGS, MinStopwatchStartTrace(0));
+  EXPECT_EQ(BAD_ARGS, MinStopwatchWriteTrace(NULL));
+  ASSERT_EQ(NO_ERRORS, MinStopwatchStartTrace(8));
+  for (int i = 0; i < 20; ++i)
+    TimedImageCall(swTestTrace, &image);
+  std::thread([] {
+    for (int i = 0; i < 5; ++i)
+      TimedCall(swTestTrace);
+  }).join();
+
+  // The ring keeps the last 8 spans of the main thread, the spans of the
+  // exited thread are kept in full.
+  std::string trace = ReadTrace();
+  EXPECT_EQ(0U, trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+  EXPECT_EQ(13, CountOccurrences(trace, "\"name\":\"TestTrace\""));
+  EXPECT_EQ(8, CountOccurrences(trace, "\"args\":{\"width\":3,\"height\":2,"
+                                       "\"channels\":4,\"type\":\"TYP_UINT16\"}"));
+
+  ASSERT_EQ(NO_ERRORS, MinStopwatchStopTrace());
+  TimedCall(swTestTrace);
+  trace = ReadTrace();
+  EXPECT_EQ(13, CountOccurrences(trace, "\"name\":\"TestTrace\""));
+
+  ASSERT_EQ(NO_ERRORS, MinStopwatchStartTrace(8));
+  ASSERT_EQ(NO_ERRORS, MinStopwatchStopTrace());
+  trace = ReadTrace();
+  EXPECT_EQ(0, CountOccurrences(trace, "\"name\":\"TestTrace\""));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -41,6 +41,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <cstdlib>
 #include <minbase/crossplat.h>
 #include <minbase/mintyp.h>
+#include <minbase/minmemory.h>
 
 /**
  * @defgroup MinUtils_SmartPtr Smart Pointers
@@ -97,6 +98,34 @@ DEFINE_SCOPED_OBJECT(scoped_c_array, free)
 
 DEFINE_SCOPED_OBJECT(scoped_cpp_array, delete[])
 
+/**
+ * @class   scoped_mem_array
+ * @brief   Specifies a class which will take care about freeing memory with
+ *          @c MinMemFree() function.
+ * @details The class takes care about freeing memory allocated with
+ *          @c MinMemAllocArray() or @c MinMemAlloc().
+ * @ingroup MinUtils_SmartPtr
+ */
+
+DEFINE_SCOPED_OBJECT(scoped_mem_array, MinMemFree)
+
+/**
+ * @brief   Allocates an accounted array of @c count elements of type @c T.
+ * @details The elements are not constructed, so @c T should be a trivial type.
+ *          Returns @c NULL on failure (see @c MinMemAlloc()).
+ * @ingroup MinUtils_SmartPtr
+ */
+template<typename T> static MUSTINLINE T *MinMemAllocArray
+(
+  size_t count,
+  MinMemTag tag
+)
+{
+  if (count > static_cast<size_t>(-1) / sizeof(T))
+    return NULL;
+  return static_cast<T *>(MinMemAlloc(count * sizeof(T), 16, tag));
+}
+
 template<typename TData, typename TShift> static MUSTINLINE TData *ShiftPtr
 (
   TData *ptr,
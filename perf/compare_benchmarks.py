@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+#
+# Copyright 2021 Smart Engines Service LLC
+#
+# Redistribution and use in source and binary forms, with or without modification,
+# are permitted provided that the following conditions are met:
+#
+#   1. Redistributions of source code must retain the above copyright notice,
+#      this list of conditions and the following disclaimer.
+#
+#   2. Redistributions in binary form must reproduce the above copyright notice,
+#      this list of conditions and the following disclaimer in the documentation
+#      and/or other materials provided with the distribution.
+#
+#   3. Neither the name of the copyright holder nor the names of its contributors
+#      may be used to endorse or promote products derived from this software
+#      without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+# SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+# OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+# ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+
+"""Runs a google-benchmark binary and compares it against a stored baseline.
+
+Both the baseline and the current results are google-benchmark JSON reports
+produced with repetitions and aggregates. The median of the repetitions is
+compared, so a single noisy run does not fail the gate. A benchmark fails
+when its median grows by more than the larger of --threshold percent and
+--noise-sigmas times the combined coefficient of variation of the baseline
+and the current run, so benchmarks that are noisy on the machine at hand
+get a proportionally wider limit.
+
+Baselines are machine specific: regenerate them on the machine that runs
+the gate with the perf_update_baselines target (configure with
+-DMINIMG_PERF_TESTS=ON and a Release build), then run ctest -L perf. A
+baseline recorded on another host, with another number of CPUs or another
+--threads cap is not compared at all.
+
+Exit codes: 0 - no regressions, 1 - regressions or missing benchmarks,
+2 - the benchmark could not be run or a file could not be read,
+77 - the baseline comes from another machine setup (skipped).
+"""
+
+import argparse
+import json
+import math
+import os
+import subprocess
+import sys
+
+SKIPPED = 77  # the CTest SKIP_RETURN_CODE of the perf tests
+
+# Timings are only comparable when these context entries match.
+MACHINE_KEYS = ('host_name', 'num_cpus', 'tbb_threads')
+
+
+def run_benchmark(binary, bench_filter, repetitions, min_time, threads):
+    command = [
+        binary,
+        '--benchmark_format=json',
+        '--benchmark_repetitions=%d' % repetitions,
+        '--benchmark_report_aggregates_only=true',
+        '--benchmark_min_time=%s' % min_time,
+    ]
+    if threads:
+        command.append('--threads=%d' % threads)
+    if bench_filter:
+        command.append('--benchmark_filter=%s' % bench_filter)
+    result = subprocess.run(command, stdout=subprocess.PIPE,
+                            universal_newlines=True)
+    if result.returncode != 0:
+        raise RuntimeError('%s exited with code %d'
+                           % (binary, result.returncode))
+    return json.loads(result.stdout)
+
+
+def load_report(path):
+    with open(path) as report_file:
+        return json.load(report_file)
+
+
+def aggregates(report, metric):
+    """Maps a benchmark name to (median time in nanoseconds, cv)."""
+    to_ns = {'ns': 1.0, 'us': 1e3, 'ms': 1e6, 's': 1e9}
+    medians = {}
+    cvs = {}
+    for entry in report.get('benchmarks', []):
+        if entry.get('error_occurred'):
+            continue
+        name = entry.get('run_name', entry['name'])
+        aggregate = entry.get('aggregate_name', 'median')
+        if aggregate == 'median':
+            medians[name] = \
+                entry[metric] * to_ns[entry.get('time_unit', 'ns')]
+        elif aggregate == 'cv':
+            cvs[name] = entry[metric]
+    return dict((name, (median, cvs.get(name, 0.0)))
+                for name, median in medians.items())
+
+
+def format_time(ns):
+    for unit, scale in (('s', 1e9), ('ms', 1e6), ('us', 1e3)):
+        if ns >= scale:
+            return '%.3f %s' % (ns / scale, unit)
+    return '%.1f ns' % ns
+
+
+def compare(baseline, current, threshold, noise_sigmas, metric):
+    base = aggregates(baseline, metric)
+    curr = aggregates(current, metric)
+    rows = []
+    failed = False
+    for name in sorted(set(base) | set(curr)):
+        if name not in curr:
+            rows.append((name, format_time(base[name][0]), '-', '-', '-',
+                         'MISSING'))
+            failed = True
+        elif name not in base:
+            rows.append((name, '-', format_time(curr[name][0]), '-', '-',
+                         'new'))
+        else:
+            base_median, base_cv = base[name]
+            curr_median, curr_cv = curr[name]
+            noise = noise_sigmas * math.hypot(base_cv, curr_cv) * 100.0
+            limit = max(threshold, noise)
+            change = (curr_median / base_median - 1.0) * 100.0 \
+                if base_median > 0 else 0.0
+            if change > limit:
+                status = 'REGRESSION'
+                failed = True
+            elif change < -limit:
+                status = 'faster'
+            else:
+                status = 'ok'
+            rows.append((name, format_time(base_median),
+                         format_time(curr_median), '%+.1f%%' % change,
+                         '%.1f%%' % limit, status))
+    return rows, failed
+
+
+def print_table(rows, out):
+    header = ('benchmark', 'baseline', 'current', 'change', 'limit',
+              'status')
+    widths = [max(len(row[i]) for row in rows + [header])
+              for i in range(len(header))]
+    line = '  '.join('%%-%ds' % w if i == 0 else '%%%ds' % w
+                     for i, w in enumerate(widths))
+    out.write(line % header + '\n')
+    out.write('  '.join('-' * w for w in widths) + '\n')
+    for row in rows:
+        out.write(line % row + '\n')
+
+
+def machine_mismatches(baseline, current):
+    """The context entries which make the timings incomparable."""
+    base_ctx = baseline.get('context', {})
+    curr_ctx = current.get('context', {})
+    return ['%s: %s vs %s' % (key, base_ctx.get(key), curr_ctx.get(key))
+            for key in MACHINE_KEYS if base_ctx.get(key) != curr_ctx.get(key)]
+
+
+def warn_on_context_mismatch(baseline, current):
+    base_ctx = baseline.get('context', {})
+    curr_ctx = current.get('context', {})
+    for key in ('library_build_type', 'mhz_per_cpu'):
+        if base_ctx.get(key) != curr_ctx.get(key):
+            sys.stderr.write('warning: %s differs from the baseline '
+                             '(%s vs %s)\n'
+                             % (key, base_ctx.get(key), curr_ctx.get(key)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--benchmark', help='benchmark binary to run')
+    parser.add_argument('--current',
+                        help='use this JSON report instead of running')
+    parser.add_argument('--baseline', required=True,
+                        help='baseline JSON report')
+    parser.add_argument('--filter', default='',
+                        help='--benchmark_filter regex')
+    parser.add_argument('--repetitions', type=int, default=5)
+    parser.add_argument('--min-time', default='0.1',
+                        help='--benchmark_min_time per repetition')
+    parser.add_argument('--threads', type=int, default=0,
+                        help='pass --threads to the benchmark to cap its '
+                             'TBB workers')
+    parser.add_argument('--threshold', type=float, default=10.0,
+                        help='allowed slowdown of the median, in percent')
+    parser.add_argument('--noise-sigmas', type=float, default=2.0,
+                        help='widen the limit to this many combined '
+                             'coefficients of variation')
+    parser.add_argument('--metric', choices=('cpu_time', 'real_time'),
+                        default='cpu_time')
+    parser.add_argument('--update', action='store_true',
+                        help='store the current results as the baseline')
+    args = parser.parse_args()
+
+    try:
+        if args.current:
+            current = load_report(args.current)
+        elif args.benchmark:
+            current = run_benchmark(args.benchmark, args.filter,
+                                    args.repetitions, args.min_time,
+                                    args.threads)
+        else:
+            parser.error('either --benchmark or --current is required')
+        if args.update:
+            directory = os.path.dirname(os.path.abspath(args.baseline))
+            if not os.path.isdir(directory):
+                os.makedirs(directory)
+            with open(args.baseline, 'w') as baseline_file:
+                json.dump(current, baseline_file, indent=2, sort_keys=True)
+                baseline_file.write('\n')
+            print('baseline written to %s' % args.baseline)
+            return 0
+        baseline = load_report(args.baseline)
+    except (OSError, RuntimeError, ValueError) as error:
+        sys.stderr.write('error: %s\n' % error)
+        return 2
+
+    mismatches = machine_mismatches(baseline, current)
+    if mismatches:
+        print('skipped: the baseline comes from another machine setup (%s); '
+              'regenerate it with perf_update_baselines'
+              % ', '.join(mismatches))
+        return SKIPPED
+    warn_on_context_mismatch(baseline, current)
+    rows, failed = compare(baseline, current, args.threshold,
+                           args.noise_sigmas, args.metric)
+    print_table(rows, sys.stdout)
+    if failed:
+        print('FAILED: median %s regressed beyond the limit or '
+              'benchmarks are missing' % args.metric)
+        return 1
+    print('passed: no median %s regressed beyond the limit' % args.metric)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())